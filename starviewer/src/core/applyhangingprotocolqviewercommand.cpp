@@ -19,6 +19,7 @@
 #include "hangingprotocolimageset.h"
 #include "voilutpresetstooldata.h"
 #include "q2dviewer.h"
+#include "volume.h"
 #include "logging.h"
 
 namespace udg {
@@ -30,6 +31,30 @@ ApplyHangingProtocolQViewerCommand::ApplyHangingProtocolQViewerCommand(Q2DViewer
     m_displaySet = displaySet;
 }
 
+int ApplyHangingProtocolQViewerCommand::getSliceToShow(Volume *volume) const
+{
+    // The slices of a reconstruction are not slices of the acquisition plane
+    if (!m_displaySet->getReconstruction().isEmpty())
+    {
+        return -1;
+    }
+
+    // Same criteria as applyDisplayTransformations()
+    int slice = m_displaySet->getSliceModifiedForVolumes() != -1 ? m_displaySet->getSliceModifiedForVolumes() : m_displaySet->getSlice();
+    int phase = m_displaySet->getPhase();
+
+    if (slice == -1 && phase == -1)
+    {
+        return -1;
+    }
+
+    slice = qBound(0, slice, volume->getNumberOfSlicesPerPhase() - 1);
+    phase = qBound(0, phase, volume->getNumberOfPhases() - 1);
+
+    // The slices of all the phases of each position are consecutive in the data
+    return slice * volume->getNumberOfPhases() + phase;
+}
+
 void ApplyHangingProtocolQViewerCommand::execute()
 {
     // HACK Així evitem el bug del ticket 1249 i tenim el mateix comportament que abans
@@ -32,6 +32,10 @@ Q_OBJECT
 public:
     ApplyHangingProtocolQViewerCommand(Q2DViewerWidget *viewer, HangingProtocolDisplaySet *displaySet, QObject *parent = 0);
 
+    /// Returns the index in the data of the given volume of the slice and phase of the display set, or -1 if the display set doesn't choose them or
+    /// applies a reconstruction
+    virtual int getSliceToShow(Volume *volume) const;
+
 public slots:
     void execute();
 
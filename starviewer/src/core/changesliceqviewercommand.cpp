@@ -15,6 +15,7 @@
 #include "changesliceqviewercommand.h"
 
 #include "q2dviewer.h"
+#include "volume.h"
 
 namespace udg {
 
@@ -34,6 +35,31 @@ ChangeSliceQViewerCommand::ChangeSliceQViewerCommand(Q2DViewer *viewer, int slic
     m_customSliceNumber = slice;
 }
 
+int ChangeSliceQViewerCommand::getSliceToShow(Volume *volume) const
+{
+    int maximumSlice = volume->getNumberOfSlicesPerPhase() - 1;
+    int slice = 0;
+
+    switch (m_slicePosition)
+    {
+        case MaximumSlice:
+            slice = maximumSlice;
+            break;
+        case MinimumSlice:
+            slice = 0;
+            break;
+        case MiddleSlice:
+            slice = maximumSlice / 2;
+            break;
+        case CustomSlice:
+            slice = qBound(0, m_customSliceNumber, maximumSlice);
+            break;
+    }
+
+    // The slices of all the phases of each position are consecutive in the data
+    return slice * volume->getNumberOfPhases();
+}
+
 void ChangeSliceQViewerCommand::execute()
 {
     switch (m_slicePosition)
@@ -36,6 +36,9 @@ public:
     /// la llesca assignada serà la mínima, i en cas que estigui per sobre del màxim, s'assignarà la màxima
     ChangeSliceQViewerCommand(Q2DViewer *viewer, int slice, QObject *parent = 0);
 
+    /// Returns the index in the data of the given volume of the slice that execute() will show, in the first phase
+    virtual int getSliceToShow(Volume *volume) const;
+
 public slots:
     void execute();
 
@@ -65,6 +65,7 @@ HEADERS += extensionfactory.h \
     zoomtool.h \
     qlogviewer.h \
     strokesegmentationmethod.h \
+    regiongrower.h \
     itkErfcLevelSetFunction.h \
     itkErfcLevelSetImageFilter.h \
     itkVolumeCalculatorImageFilter.h \
@@ -181,10 +182,12 @@ HEADERS += extensionfactory.h \
     vtkVolumeRayCastVoxelShaderCompositeFunction.h \
     sphereuniformpointcloudgenerator.h \
     obscurancemainthread.h \
+    obscurancetaskscheduler.h \
     obscurancethread.h \
     obscurancevoxelshader.h \
     vtk4dlinearregressiongradientestimator.h \
     combiningvoxelshader.h \
+    voxelshaderchain.h \
     vtkVolumeRayCastSingleVoxelShaderCompositeFunction.h \
     obscurance.h \
     viewpointgenerator.h \
@@ -193,6 +196,7 @@ HEADERS += extensionfactory.h \
     abortrendercommand.h \
     roitool.h \
     roidata.h \
+    quantilesketch.h \
     abstractroidataprinter.h \
     roidataprinter.h \
     petroidataprinter.h \
@@ -293,6 +297,7 @@ HEADERS += extensionfactory.h \
     diagnosistestfactory.h \
     diagnosistestfactoryregister.h \
     slicelocator.h \
+    slicepositionindex.h \
     slicehandler.h \
     automaticsynchronizationtool.h \
     automaticsynchronizationtooldata.h \
@@ -437,7 +442,10 @@ HEADERS += extensionfactory.h \
     externalapplicationsmanager.h \
     encapsulateddocument.h \
     encapsulateddocumentfillerstep.h \
-    qdpiconfigurationscreen.h
+    qdpiconfigurationscreen.h \
+    decodedvolumecache.h \
+    thumbnailservice.h \
+    recentlyusedslices.h
 
 SOURCES += extensionmediator.cpp \
     displayableid.cpp \
@@ -466,6 +474,7 @@ SOURCES += extensionmediator.cpp \
     editortooldata.cpp \
     qlogviewer.cpp \
     strokesegmentationmethod.cpp \
+    regiongrower.cpp \
     itkErfcLevelSetFunction.cpp \
     itkErfcLevelSetImageFilter.cpp \
     itkVolumeCalculatorImageFilter.cpp \
@@ -573,6 +582,7 @@ SOURCES += extensionmediator.cpp \
     vtkVolumeRayCastVoxelShaderCompositeFunction.cxx \
     sphereuniformpointcloudgenerator.cpp \
     obscurancemainthread.cpp \
+    obscurancetaskscheduler.cpp \
     obscurancethread.cpp \
     obscurancevoxelshader.cpp \
     vtk4dlinearregressiongradientestimator.cpp \
@@ -585,6 +595,7 @@ SOURCES += extensionmediator.cpp \
     abortrendercommand.cpp \
     roitool.cpp \
     roidata.cpp \
+    quantilesketch.cpp \
     abstractroidataprinter.cpp \
     roidataprinter.cpp \
     petroidataprinter.cpp \
@@ -680,6 +691,7 @@ SOURCES += extensionmediator.cpp \
     diagnosistestresult.cpp \
     applicationupdatechecker.cpp \
     slicelocator.cpp \
+    slicepositionindex.cpp \
     slicehandler.cpp \
     automaticsynchronizationtool.cpp \
     automaticsynchronizationtooldata.cpp \
@@ -820,7 +832,10 @@ SOURCES += extensionmediator.cpp \
     encapsulateddocument.cpp \
     encapsulateddocumentfillerstep.cpp \
     starviewerapplication.cpp \
-    qdpiconfigurationscreen.cpp
+    qdpiconfigurationscreen.cpp \
+    decodedvolumecache.cpp \
+    thumbnailservice.cpp \
+    recentlyusedslices.cpp
 
 win32 {
     HEADERS += windowsfirewallaccess.h \
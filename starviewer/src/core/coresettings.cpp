@@ -81,6 +81,9 @@ const QString CoreSettings::MammographyAutoOrientationExceptions("MammographyAut
 
 const QString CoreSettings::AllowAsynchronousVolumeLoading("AllowAsynchronousVolumeLoading");
 const QString CoreSettings::MaximumNumberOfVolumesLoadingConcurrently("MaximumNumberOfVolumesLoadingConcurrently");
+const QString CoreSettings::AllowProgressiveVolumeLoading("AllowProgressiveVolumeLoading");
+const QString CoreSettings::VolumeCacheMemoryBudget("VolumeCacheMemoryBudget");
+const QString CoreSettings::EnableDecodedVolumeCache("EnableDecodedVolumeCache");
 
 const QString CoreSettings::MaximumNumberOfVisibleVoiLutComboItems("MaximumNumberOfVisibleVoiLutComboItems");
 
@@ -146,6 +149,9 @@ void CoreSettings::init()
     settingsRegistry->addSetting(MammographyAutoOrientationExceptions, (QStringList() << "BAV" << "BAG" << "estereot"));
     settingsRegistry->addSetting(AllowAsynchronousVolumeLoading, true);
     settingsRegistry->addSetting(MaximumNumberOfVolumesLoadingConcurrently, 1);
+    settingsRegistry->addSetting(AllowProgressiveVolumeLoading, false);
+    settingsRegistry->addSetting(VolumeCacheMemoryBudget, 0);
+    settingsRegistry->addSetting(EnableDecodedVolumeCache, false);
     settingsRegistry->addSetting(MaximumNumberOfVisibleVoiLutComboItems, 50);
     settingsRegistry->addSetting(EnableQ2DViewerSliceScrollLoop, false);
     settingsRegistry->addSetting(EnableQ2DViewerPhaseScrollLoop, false);
@@ -93,6 +93,12 @@ public:
     static const QString AllowAsynchronousVolumeLoading;
     /// Indica quans volums poden estar-se carregant a la vegada com a màxim.
     static const QString MaximumNumberOfVolumesLoadingConcurrently;
+    /// If true, volumes are loaded from the slice shown first outward and the 2D viewer shows the loaded slices while the rest are still being loaded.
+    static const QString AllowProgressiveVolumeLoading;
+    /// Maximum amount of pixel data, in MiB, kept in memory for volumes that aren't displayed. 0 means no limit.
+    static const QString VolumeCacheMemoryBudget;
+    /// If true, decoded volumes of the local database are stored on disk so that they can be reopened without decoding their files again.
+    static const QString EnableDecodedVolumeCache;
 
     /// Defineix el nombre màxim d'ítems visibles al desplegar-se el combo de window/levels per defecte.
     /// Si tenim més presets que els que indiqui aquest setting, apareixerà un scroll vertical.
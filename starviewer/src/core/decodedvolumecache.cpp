@@ -0,0 +1,337 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "decodedvolumecache.h"
+
+#include "coresettings.h"
+#include "harddiskinformation.h"
+#include "logging.h"
+#include "settings.h"
+#include "volumepixeldata.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSysInfo>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+
+namespace udg {
+
+namespace {
+
+// Prefix and suffix of the cached volume files.
+const QString CacheFilePrefix("decodedvolume-");
+const QString CacheFileSuffix(".raw");
+
+// Identifies a cached volume file and the version of its format.
+const quint32 CacheFileMagic = 0x53564443;
+const quint32 CacheFileVersion = 1;
+
+// Size of the header, which is padded with zeros so that the voxels start at an aligned offset.
+const int HeaderSize = 512;
+
+// Geometry and size of a cached volume.
+struct CacheFileHeader {
+    qint32 scalarType;
+    qint32 numberOfComponents;
+    qint32 extent[6];
+    double spacing[3];
+    double origin[3];
+    qint64 dataSize;
+};
+
+// Number of times the cached volumes of each series directory have been invalidated. A volume is only stored if the generation of its directory hasn't
+// changed since its files were read, because the files may have been replaced or deleted while it was being decoded and written.
+QHash<QString, quint64> seriesDirectoryGenerations;
+// Protects seriesDirectoryGenerations and makes invalidate() and the commit of store() mutually exclusive.
+QMutex seriesDirectoryGenerationsMutex;
+
+// Returns the given directory as an absolute clean path, so that the same directory always gives the same generation.
+QString normalizeDirectory(const QString &directory)
+{
+    return QDir::cleanPath(QDir(directory).absolutePath());
+}
+
+// Returns a key that changes whenever the series, the files or their order change.
+QString computeKey(const QString &seriesInstanceUID, const QStringList &files, const QList<int> &frameNumbers)
+{
+    QByteArray keyData;
+    QDataStream stream(&keyData, QIODevice::WriteOnly);
+    stream << CacheFileVersion << seriesInstanceUID;
+
+    foreach (const QString &file, files)
+    {
+        QFileInfo fileInfo(file);
+        stream << fileInfo.fileName() << fileInfo.size() << fileInfo.lastModified().toMSecsSinceEpoch();
+    }
+
+    foreach (int frameNumber, frameNumbers)
+    {
+        stream << frameNumber;
+    }
+
+    return QCryptographicHash::hash(keyData, QCryptographicHash::Sha1).toHex();
+}
+
+// Writes the given header padded to HeaderSize bytes.
+QByteArray writeHeader(const CacheFileHeader &header)
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << CacheFileMagic << CacheFileVersion << static_cast<qint32>(QSysInfo::ByteOrder);
+    stream << header.scalarType << header.numberOfComponents;
+
+    for (int i = 0; i < 6; i++)
+    {
+        stream << header.extent[i];
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        stream << header.spacing[i] << header.origin[i];
+    }
+
+    stream << header.dataSize;
+
+    bytes.append(QByteArray(HeaderSize - bytes.size(), 0));
+    return bytes;
+}
+
+// Reads the header from the given bytes. Returns false if they aren't a valid header written by this version on a machine with the same byte order.
+bool readHeader(const QByteArray &bytes, CacheFileHeader &header)
+{
+    if (bytes.size() != HeaderSize)
+    {
+        return false;
+    }
+
+    QDataStream stream(bytes);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic, version;
+    qint32 byteOrder;
+    stream >> magic >> version >> byteOrder;
+
+    if (magic != CacheFileMagic || version != CacheFileVersion || byteOrder != static_cast<qint32>(QSysInfo::ByteOrder))
+    {
+        return false;
+    }
+
+    stream >> header.scalarType >> header.numberOfComponents;
+
+    for (int i = 0; i < 6; i++)
+    {
+        stream >> header.extent[i];
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        stream >> header.spacing[i] >> header.origin[i];
+    }
+
+    stream >> header.dataSize;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+}
+
+QString DecodedVolumeCache::m_cacheableDirectory;
+
+DecodedVolumeCache::DecodedVolumeCache(const QString &seriesInstanceUID, const QStringList &files, const QList<int> &frameNumbers)
+    : m_generation(0)
+{
+    if (m_cacheableDirectory.isEmpty() || seriesInstanceUID.isEmpty() || files.isEmpty())
+    {
+        return;
+    }
+
+    if (!Settings().getValue(CoreSettings::EnableDecodedVolumeCache).toBool())
+    {
+        return;
+    }
+
+    QString seriesDirectory = normalizeDirectory(QFileInfo(files.first()).absolutePath());
+    QString cacheableDirectory = normalizeDirectory(m_cacheableDirectory) + "/";
+
+    if (!seriesDirectory.startsWith(cacheableDirectory))
+    {
+        return;
+    }
+
+    foreach (const QString &file, files)
+    {
+        if (normalizeDirectory(QFileInfo(file).absolutePath()) != seriesDirectory)
+        {
+            return;
+        }
+    }
+
+    {
+        // Taken before the key, so an invalidation while the files are being examined prevents storing the volume
+        QMutexLocker locker(&seriesDirectoryGenerationsMutex);
+        m_generation = seriesDirectoryGenerations.value(seriesDirectory);
+    }
+
+    m_seriesDirectory = seriesDirectory;
+
+    m_cacheFilePath = seriesDirectory + "/" + CacheFilePrefix + computeKey(seriesInstanceUID, files, frameNumbers) + CacheFileSuffix;
+}
+
+void DecodedVolumeCache::setCacheableDirectory(const QString &directory)
+{
+    m_cacheableDirectory = directory;
+}
+
+QString DecodedVolumeCache::getCacheableDirectory()
+{
+    return m_cacheableDirectory;
+}
+
+void DecodedVolumeCache::invalidate(const QString &seriesDirectory)
+{
+    QMutexLocker locker(&seriesDirectoryGenerationsMutex);
+    seriesDirectoryGenerations[normalizeDirectory(seriesDirectory)]++;
+
+    QDir directory(seriesDirectory);
+    foreach (const QString &fileName, directory.entryList(QStringList(CacheFilePrefix + "*" + CacheFileSuffix), QDir::Files))
+    {
+        // Loaded volumes map their blob, and a mapped file can't be removed on Windows
+        VolumePixelData::releaseFileMappings(directory.filePath(fileName));
+
+        if (!directory.remove(fileName))
+        {
+            WARN_LOG(QString("Could not remove the cached volume %1").arg(directory.filePath(fileName)));
+        }
+    }
+}
+
+bool DecodedVolumeCache::isCacheable() const
+{
+    return !m_cacheFilePath.isEmpty();
+}
+
+QString DecodedVolumeCache::getCacheFilePath() const
+{
+    return m_cacheFilePath;
+}
+
+VolumePixelData* DecodedVolumeCache::load() const
+{
+    if (!isCacheable())
+    {
+        return 0;
+    }
+
+    QFile file(m_cacheFilePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+
+    CacheFileHeader header;
+    if (!readHeader(file.read(HeaderSize), header) || file.size() != HeaderSize + header.dataSize)
+    {
+        WARN_LOG(QString("Ignoring invalid cached volume %1").arg(m_cacheFilePath));
+        return 0;
+    }
+
+    qint64 numberOfPoints = static_cast<qint64>(header.extent[1] - header.extent[0] + 1) * (header.extent[3] - header.extent[2] + 1) *
+                            (header.extent[5] - header.extent[4] + 1);
+    if (numberOfPoints * header.numberOfComponents * vtkDataArray::GetDataTypeSize(header.scalarType) != header.dataSize)
+    {
+        WARN_LOG(QString("Cached volume %1 doesn't match its header").arg(m_cacheFilePath));
+        return 0;
+    }
+
+    file.close();
+
+    // The voxels are mapped instead of read, so the volume is available immediately and its pages are loaded as they are accessed
+    VolumePixelData *pixelData = new VolumePixelData();
+    if (!pixelData->setData(m_cacheFilePath, HeaderSize, header.extent, header.scalarType, header.numberOfComponents))
+    {
+        delete pixelData;
+        return 0;
+    }
+
+    pixelData->setSpacing(header.spacing);
+    pixelData->setOrigin(header.origin);
+    return pixelData;
+}
+
+bool DecodedVolumeCache::store(vtkImageData *imageData) const
+{
+    if (!isCacheable() || !imageData || !imageData->GetScalarPointer())
+    {
+        return false;
+    }
+
+    CacheFileHeader header;
+    header.scalarType = imageData->GetScalarType();
+    header.numberOfComponents = imageData->GetNumberOfScalarComponents();
+    imageData->GetExtent(header.extent);
+    imageData->GetSpacing(header.spacing);
+    imageData->GetOrigin(header.origin);
+    header.dataSize = static_cast<qint64>(imageData->GetNumberOfPoints()) * header.numberOfComponents * imageData->GetScalarSize();
+
+    // Don't let the cache fill the disk: keep at least as much free space as the volume takes
+    if (HardDiskInformation().getNumberOfFreeBytes(QFileInfo(m_cacheFilePath).absolutePath()) < 2 * static_cast<quint64>(header.dataSize))
+    {
+        INFO_LOG(QString("Not enough free space to cache the decoded volume %1").arg(m_cacheFilePath));
+        return false;
+    }
+
+    // QSaveFile writes to a temporary file and renames it on commit, so a partially written volume is never seen by load()
+    QSaveFile file(m_cacheFilePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        WARN_LOG(QString("Could not create the cached volume %1: %2").arg(m_cacheFilePath).arg(file.errorString()));
+        return false;
+    }
+
+    if (file.write(writeHeader(header)) != HeaderSize ||
+        file.write(static_cast<const char*>(imageData->GetScalarPointer()), header.dataSize) != header.dataSize)
+    {
+        WARN_LOG(QString("Could not write the cached volume %1: %2").arg(m_cacheFilePath).arg(file.errorString()));
+        file.cancelWriting();
+        return false;
+    }
+
+    // The series may have been invalidated while the volume was decoded or written, and then its files may not be the ones the volume was read from
+    QMutexLocker locker(&seriesDirectoryGenerationsMutex);
+
+    if (seriesDirectoryGenerations.value(m_seriesDirectory) != m_generation)
+    {
+        INFO_LOG(QString("Not caching the decoded volume %1 because its series has been invalidated").arg(m_cacheFilePath));
+        file.cancelWriting();
+        return false;
+    }
+
+    // A volume loaded from a previous blob would keep it mapped, and then the blob couldn't be replaced on Windows
+    VolumePixelData::releaseFileMappings(m_cacheFilePath);
+
+    return file.commit();
+}
+
+} // End namespace udg
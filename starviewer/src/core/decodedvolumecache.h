@@ -0,0 +1,80 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGDECODEDVOLUMECACHE_H
+#define UDGDECODEDVOLUMECACHE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class vtkImageData;
+
+namespace udg {
+
+class VolumePixelData;
+
+/**
+    Persistent on-disk cache of decoded pixel data, used to reopen a volume without decoding its DICOM files again.
+
+    The decoded voxels of a volume are stored as a raw blob, preceded by a header with the geometry, in the directory of the series the files belong to.
+    Only volumes whose files are all in the same directory under the cacheable directory (the local database cache) are cached, so that the blob is removed
+    together with the series. The blob name contains a hash of the series instance UID and the path, size and modification time of each file, in order, so
+    any change in the files of the volume results in a different blob. Stale blobs are removed with invalidate().
+
+    store() is usually executed in another thread after the volume has been read. Each call to invalidate() increases a generation counter of the series
+    directory, and store() only commits the blob if the generation is the same as when the cache object was created, so a volume read before an
+    invalidation is never stored after it.
+  */
+class DecodedVolumeCache {
+public:
+    DecodedVolumeCache(const QString &seriesInstanceUID, const QStringList &files, const QList<int> &frameNumbers);
+
+    /// Sets the root directory under which volumes may be cached. Files outside this directory are never cached. Empty by default, which disables the cache.
+    static void setCacheableDirectory(const QString &directory);
+    static QString getCacheableDirectory();
+
+    /// Removes all the cached volumes stored in the given series directory and prevents storing volumes whose cache objects were created before.
+    /// Volumes loaded from the removed blobs keep their data, copied into memory.
+    /// It can be called from any thread.
+    static void invalidate(const QString &seriesDirectory);
+
+    /// Returns true if the cache is enabled and the files given in the constructor can be cached.
+    bool isCacheable() const;
+
+    /// Returns the path of the file where the decoded volume is or would be stored. Empty if the volume is not cacheable.
+    QString getCacheFilePath() const;
+
+    /// Returns the cached pixel data for the files given in the constructor, or null if there isn't a valid cached copy. The caller takes ownership.
+    VolumePixelData* load() const;
+
+    /// Stores the given image data as the decoded volume of the files given in the constructor. Returns true if it has been stored. It can be called
+    /// from any thread.
+    bool store(vtkImageData *imageData) const;
+
+private:
+    /// Root directory under which volumes may be cached.
+    static QString m_cacheableDirectory;
+
+    /// Path of the cached volume file. Empty if the volume is not cacheable.
+    QString m_cacheFilePath;
+
+    /// Directory of the files of the volume and its generation when this object was created.
+    QString m_seriesDirectory;
+    quint64 m_generation;
+};
+
+} // End namespace udg
+
+#endif
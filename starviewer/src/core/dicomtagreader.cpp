@@ -29,6 +29,14 @@
 
 namespace {
 
+/// Maximum length in bytes of the values loaded when reading in LoadMetadataOnly mode; longer values are loaded when they are accessed.
+/// The biggest values read by the patient filler steps are person names (at most 3 component groups of 64 characters), UIDs (64),
+/// short strings and multi-valued DS/IS attributes such as Image Orientation (Patient) (6 values of 16 characters), so all of them fit
+/// in 256 bytes and are loaded in the single pass over the file. DCMTK's default of 4096 bytes also loads LUTs, overlays, icon images,
+/// long texts and private blobs of up to 4 KB, and the pixel data of small images, which the steps never read; each of them costs
+/// a seek and a read only if something asks for it later.
+const Uint32 MetadataOnlyMaxReadLength = 256;
+
 /// Returns true if the given tag contains text that is encoded with the Specific Character Set (0008,0005). See http://www.dabsoft.ch/dicom/3/C.12.1.1.2/.
 bool isEncodedText(const DcmTag &tag)
 {
@@ -69,6 +77,12 @@ DICOMTagReader::DICOMTagReader(const QString &filename)
     this->setFile(filename);
 }
 
+DICOMTagReader::DICOMTagReader(const QString &filename, LoadingMode loadingMode)
+{
+    initialize();
+    this->setFile(filename, loadingMode);
+}
+
 DICOMTagReader::~DICOMTagReader()
 {
     deleteDataLastLoadedFile();
@@ -94,13 +108,14 @@ void DICOMTagReader::deleteDataLastLoadedFile()
     }
 }
 
-bool DICOMTagReader::setFile(const QString &filename)
+bool DICOMTagReader::setFile(const QString &filename, LoadingMode loadingMode)
 {
     DcmFileFormat dicomFile;
 
     m_filename = filename;
 
-    OFCondition status = dicomFile.loadFile(qPrintable(filename));
+    Uint32 maxReadLength = loadingMode == LoadMetadataOnly ? MetadataOnlyMaxReadLength : DCM_MaxReadLength;
+    OFCondition status = dicomFile.loadFile(qPrintable(filename), EXS_Unknown, EGL_noChange, maxReadLength);
     if (status.good())
     {
         m_hasValidFile = true;
@@ -47,9 +47,16 @@ public:
     /// hem de retornar-los sense sel seu valor, estalviant-nos de llegir i carregar-los en memòria
     enum ReturnValueOfTags { AllTags, ExcludeHeavyTags };
 
+    /// Indicates which element values are loaded into memory when a file is read. LoadMetadataOnly only loads small values (the
+    /// attributes needed to fill patients, studies, series and images); bigger values such as PixelData, OverlayData, LUTs or private
+    /// blobs stay in the file and are transparently loaded by DCMTK the first time they are requested.
+    enum LoadingMode { LoadDefault, LoadMetadataOnly };
+
     DICOMTagReader();
     /// Constructor per nom de fitxer.
     DICOMTagReader(const QString &filename);
+    /// Constructor per nom de fitxer indicant quins valors s'han de carregar en memòria.
+    DICOMTagReader(const QString &filename, LoadingMode loadingMode);
     /// Constructor per nom de fitxer per si es té un DcmDataset ja llegit.
     /// D'aquesta forma no cal tornar-lo a llegir.
     DICOMTagReader(const QString &filename, DcmDataset *dcmDataset);
@@ -57,7 +64,8 @@ public:
     virtual ~DICOMTagReader();
 
     /// Nom de l'arxiu DICOM que es vol llegir. Torna cert si l'arxiu s'ha pogut carregar correctament, fals altrament.
-    bool setFile(const QString &filename);
+    /// With LoadMetadataOnly the file must remain accessible while big values may still be requested.
+    bool setFile(const QString &filename, LoadingMode loadingMode = LoadDefault);
 
     /// Ens diu si l'arxiu assignat és vàlid com a arxiu DICOM. Si no tenim arxiu assignat retornarà fals.
     bool canReadFile() const;
@@ -193,6 +193,7 @@ void Drawer::erasePrimitive(DrawerPrimitive *primitive)
             groupsIterator.remove();
         }
     }
+    m_disabledPrimitives.remove(primitive);
 
     // Busquem en el pla axial
     if (erasePrimitiveFromContainer(primitive, m_XYPlanePrimitives))
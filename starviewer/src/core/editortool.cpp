@@ -15,6 +15,7 @@
 #include "editortool.h"
 #include "editortooldata.h"
 #include "q2dviewer.h"
+#include "regiongrower.h"
 #include "voilut.h"
 #include "volume.h"
 #include "volumepixeldataiterator.h"
@@ -440,26 +441,12 @@ void EditorTool::eraseRegionMask()
     index[0] = (int)((((double)pos[0] - origin[0]) / spacing[0]) + 0.5);
     index[1] = (int)((((double)pos[1] - origin[1]) / spacing[1]) + 0.5);
     index[2] = m_2DViewer->getCurrentSlice();
-    eraseRegionMaskRecursive(index[0], index[1], index[2]);
-}
 
-void EditorTool::eraseRegionMaskRecursive(int a, int b, int c)
-{
-    int ext[6];
-    m_2DViewer->getMainInput()->getExtent(ext);
-    if ((a >= ext[0]) && (a <= ext[1]) && (b >= ext[2]) && (b <= ext[3]) && (c >= ext[4]) && (c <= ext[5]))
-    {
-        VolumePixelDataIterator it = m_2DViewer->getOverlayInput()->getIterator(a, b, c);
-        if (it.get<int>() == m_insideValue)
-        {
-            it.set(m_outsideValue);
-            m_volumeCont--;
-            eraseRegionMaskRecursive(a + 1, b, c);
-            eraseRegionMaskRecursive(a - 1, b, c);
-            eraseRegionMaskRecursive(a, b + 1, c);
-            eraseRegionMaskRecursive(a, b - 1, c);
-        }
-    }
+    // Només esborrem la regió connectada dins la llesca actual
+    int sliceExtent[6] = { ext[0], ext[1], ext[2], ext[3], index[2], index[2] };
+    RegionGrower regionGrower;
+    regionGrower.setExtent(sliceExtent);
+    m_volumeCont -= static_cast<int>(regionGrower.fill(m_2DViewer->getOverlayInput()->getVtkData(), index, m_insideValue, m_insideValue, m_outsideValue));
 }
 
 void EditorTool::increaseEditorSize()
@@ -20,6 +20,7 @@
 #include "drawerpolygon.h"
 #include "drawertext.h"
 #include "mathtools.h"
+#include "regiongrower.h"
 #include "voxel.h"
 
 #include <QApplication> // to check pressed mouse buttons
@@ -384,143 +385,33 @@ void MagicROITool::computeRegionMask(VolumePixelData *pixelData)
     getPickedPositionVoxelIndex(pixelData, x, y, z);
     this->computeLevelRange(pixelData, x, y, z);
 
-    // Creem la màscara
-    if (m_minX == 0 && m_minY == 0)
-    {
-        m_mask = QVector<bool>((m_maxX + 1) * (m_maxY + 1), false);
-    }
-    else
-    {
-        DEBUG_LOG("ERROR: extension no comença a 0");
-    }
-    
-    // TODO Desfà els índexs projectats a 2D als originals 3D per poder obtenir el valor
-    // Corretgir-ho d'una millor manera perquè no calgui fer servir aquest mètode (guardar els índexs x,y,z o d'una altra manera)
-    double value = this->getVoxelValue(x, y, z, pixelData);
-    
-    if ((value >= m_lowerLevel) && (value <= m_upperLevel))
-    {
-        int maskIndex = getMaskVectorIndex(x, y);
-        m_mask[maskIndex] = true;
-    }
-    else
-    {
-        DEBUG_LOG("Ha petat i sortim");
-        return;
-    }
-
-    // Comencem el Region Growing
-    QVector<int> movements;
-    // First movement \TODO Codi duplicat amb main loop
-    int i = 0;
-    bool found = false;
-    int maskIndex = 0;
-    while (i < 4 && !found)
-    {
-        this->doMovement(x, y, i);
-        // TODO Desfà els índexs projectats a 2D als originals 3D per poder obtenir el valor
-        // Corretgir-ho d'una millor manera perquè no calgui fer servir aquest mètode (guardar els índexs x,y,z o d'una altra manera)
-        value = this->getVoxelValue(x, y, z, pixelData);
-
-        if ((value >= m_lowerLevel) && (value <= m_upperLevel))
-        {
-            maskIndex = getMaskVectorIndex(x, y);
-            m_mask[maskIndex] = true;
-            found = true;
-            movements.push_back(i);
-        }
-        if (!found)
-        {
-            this->undoMovement(x, y, i);
-        }
-        ++i;
-    }
-
-    // Main loop
-    i = 0;
-    while (movements.size() > 0)
-    {
-        found = false;
-        while (i < 4 && !found)
-        {
-            this->doMovement(x, y, i);
-            if ((x > m_minX) && (x < m_maxX) && (y > m_minY) && (y < m_maxY))
-            {
-                // TODO Desfà els índexs projectats a 2D als originals 3D per poder obtenir el valor
-                // Corretgir-ho d'una millor manera perquè no calgui fer servir aquest mètode (guardar els índexs x,y,z o d'una altra manera)
-                value = this->getVoxelValue(x, y, z, pixelData);
-                maskIndex = getMaskVectorIndex(x, y);
-                if ((value >= m_lowerLevel) && (value <= m_upperLevel) && (!m_mask[maskIndex]))
-                {
-                    m_mask[maskIndex] = true;
-                    found = true;
-                    movements.push_back(i);
-                    i = 0;
-                }
-            }
-            if (!found)
-            {
-                this->undoMovement(x, y, i);
-                ++i;
-            }
-        }
-        if (!found)
-        {
-            this->undoMovement(x, y, movements.back());
-            i = movements.back();
-            ++i;
-            movements.pop_back();
-        }
-    }
-}
+    int xIndex, yIndex, zIndex;
+    m_2DViewer->getView().getXYZIndexes(xIndex, yIndex, zIndex);
 
-void MagicROITool::doMovement(int &x, int &y, int movement)
-{
-    switch (movement)
-    {
-        case MoveRight:
-            x++;
-            break;
-        case MoveLeft:
-            x--;
-            break;
-        case MoveUp:
-            y++;
-            break;
-        case MoveDown:
-            y--;
-            break;
-        default:
-            DEBUG_LOG("Invalid movement");
-    }
-}
+    int seed[3];
+    seed[xIndex] = x;
+    seed[yIndex] = y;
+    seed[zIndex] = z;
 
-void MagicROITool::undoMovement(int &x, int &y, int movement)
-{
-    switch (movement)
-    {
-        case MoveRight:
-            x--;
-            break;
-        case MoveLeft:
-            x++;
-            break;
-        case MoveUp:
-            y--;
-            break;
-        case MoveDown:
-            y++;
-            break;
-        default:
-            DEBUG_LOG("Invalid movement");
-    }
+    // The region grows in the current slice, discarding a border of 1 pixel around the image (workaround for #1949)
+    int extent[6];
+    extent[xIndex * 2] = m_minX + 1;
+    extent[xIndex * 2 + 1] = m_maxX - 1;
+    extent[yIndex * 2] = m_minY + 1;
+    extent[yIndex * 2 + 1] = m_maxY - 1;
+    extent[zIndex * 2] = z;
+    extent[zIndex * 2 + 1] = z;
+
+    RegionGrower regionGrower;
+    regionGrower.setExtent(extent);
+    m_mask.clear();
+    regionGrower.computeMask(pixelData->getVtkData(), seed, m_lowerLevel, m_upperLevel, m_mask);
 }
 
 void MagicROITool::computePolygon()
 {
     int i = m_minX;
     int j;
-    int maskIndex = 0;
     // Busquem el primer punt
     bool found = false;
     while ((i <= m_maxX) && !found)
@@ -528,8 +419,7 @@ void MagicROITool::computePolygon()
         j = m_minY;
         while ((j <= m_maxY) && !found)
         {
-            maskIndex = getMaskVectorIndex(i, j);
-            if (m_mask[maskIndex])
+            if (getMaskValue(i, j))
             {
                 found = true;
             }
@@ -718,12 +608,12 @@ double MagicROITool::getStandardDeviation(int x, int y, int z, VolumePixelData *
 
 int MagicROITool::getMaskVectorIndex(int x, int y) const
 {
-    return y * (m_maxX + 1) + x;
+    return (y - m_minY - 1) * (m_maxX - m_minX - 1) + (x - m_minX - 1);
 }
 
 bool MagicROITool::getMaskValue(int x, int y) const
 {
-    if (MathTools::isInsideRange(x, m_minX, m_maxX) && MathTools::isInsideRange(y, m_minY, m_maxY))
+    if (MathTools::isInsideRange(x, m_minX + 1, m_maxX - 1) && MathTools::isInsideRange(y, m_minY + 1, m_maxY - 1) && !m_mask.isEmpty())
     {
         int maskIndex = getMaskVectorIndex(x, y);
         return m_mask[maskIndex];
@@ -36,8 +36,6 @@ public:
     
     // Creixement
     enum { LeftDown, Down, RightDown, Right, RightUp, Up, LeftUp, Left };
-    // Moviments
-    enum { MoveRight, MoveLeft, MoveUp, MoveDown };
 
     MagicROITool(QViewer *viewer, QObject *parent = 0);
     ~MagicROITool();
@@ -60,19 +58,9 @@ private:
     /// Calcula el rang de valors d'intensitat vàlid a partir de \sa #m_magicSize i \see #m_magicFactor
     void computeLevelRange(VolumePixelData *pixelData, int x, int y, int z);
 
-    /// Versió iterativa del region Growing
+    /// Calcula la màscara de la regió connectada amb la llavor dins el rang de valors (region growing)
     void computeRegionMask(VolumePixelData *pixelData);
 
-    /// Fer un moviment des d'un índex cap a una direcció
-    /// @param a, @param b índex del volum de la màscara que estem mirant en cada crida
-    /// @param movement direcció en el moviment
-    void doMovement(int &a, int &b, int movement);
-
-    /// Desfer un moviment dses d'un índex cap a una direcció
-    /// @param a, @param b índex del volum de la màscara que estem mirant en cada crida
-    /// @param movement direcció en el moviment
-    void undoMovement(int &a, int &b, int movement);
-
     /// Genera el polígon a partir de la màscara
     void computePolygon();
 
@@ -105,7 +93,7 @@ private:
     /// Elimina la representacio temporal de la tool
     void deleteTemporalRepresentation();
 
-    /// Returns the mask index corresponding to the given x and y image indices.
+    /// Returns the mask index corresponding to the given x and y image indices. The mask doesn't include the border of 1 pixel around the image.
     int getMaskVectorIndex(int x, int y) const;
 
     /// Returns the mask value at the given x and y image indices. If the indices are out of bounds, returns false.
@@ -131,7 +119,7 @@ private:
     /// Màscara de la regió que formarà el polígon
     QVector<bool> m_mask;
 
-    /// Bounds de la màscara
+    /// Bounds de la imatge a la vista actual
     int m_minX, m_maxX, m_minY, m_maxY;
     
     /// Rang de valors que es tindran en compte pel region growing
@@ -28,11 +28,11 @@ Obscurance::Obscurance(unsigned int size, bool color, bool doublePrecision)
 {
     if (!m_color && !m_doublePrecision)
     {
-        m_floatObscurance = new float[m_size];
+        m_floatObscurance = new float[m_size]();
     }
     if (!m_color && m_doublePrecision)
     {
-        m_doubleObscurance = new double[m_size];
+        m_doubleObscurance = new double[m_size]();
     }
     if (m_color && !m_doublePrecision)
     {
@@ -52,6 +52,43 @@ Obscurance::~Obscurance()
     delete[] m_doubleColorBleeding;
 }
 
+void Obscurance::accumulate(const Obscurance &obscurance)
+{
+    Q_ASSERT(obscurance.m_size == m_size && obscurance.m_color == m_color && obscurance.m_doublePrecision == m_doublePrecision);
+
+    if (m_floatObscurance)
+    {
+        for (unsigned int i = 0; i < m_size; i++)
+        {
+            m_floatObscurance[i] += obscurance.m_floatObscurance[i];
+        }
+    }
+
+    if (m_doubleObscurance)
+    {
+        for (unsigned int i = 0; i < m_size; i++)
+        {
+            m_doubleObscurance[i] += obscurance.m_doubleObscurance[i];
+        }
+    }
+
+    if (m_floatColorBleeding)
+    {
+        for (unsigned int i = 0; i < m_size; i++)
+        {
+            m_floatColorBleeding[i] += obscurance.m_floatColorBleeding[i];
+        }
+    }
+
+    if (m_doubleColorBleeding)
+    {
+        for (unsigned int i = 0; i < m_size; i++)
+        {
+            m_doubleColorBleeding[i] += obscurance.m_doubleColorBleeding[i];
+        }
+    }
+}
+
 void Obscurance::normalize()
 {
     if (!m_color)
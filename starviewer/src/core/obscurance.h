@@ -35,6 +35,8 @@ public:
     /// Retorna fals si són floats i cert si són doubles.
     bool isDoublePrecision() const;
 
+    /// Suma a aquestes obscurances les d'un altre objecte de la mateixa mida, tipus i precisió.
+    void accumulate(const Obscurance &obscurance);
     /// Normalitza les obscurances.
     void normalize();
 
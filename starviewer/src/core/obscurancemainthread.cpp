@@ -14,21 +14,38 @@
 
 #include "obscurancemainthread.h"
 
+#include <new>
+
 #include <vtkDataArray.h>
 #include <vtkEncodedGradientEstimator.h>
 #include <vtkImageData.h>
-#include <vtkMultiThreader.h>
 #include <vtkPointData.h>
 #include <vtkVolume.h>
 #include <vtkVolumeRayCastMapper.h>
 
 #include "logging.h"
+#include "obscurancetaskscheduler.h"
 #include "obscurancethread.h"
 #include "vector3.h"
 #include "viewpointgenerator.h"
 
 namespace udg {
 
+namespace {
+
+// Nombre màxim de línies de cada tasca
+const int LinesPerTask = 64;
+
+// Nombre màxim de direccions afegides al planificador que encara no s'han acabat. N'hi ha d'haver més d'una perquè els threads passin a la direcció següent
+// sense esperar els altres, i el límit fita la memòria dels començaments de línia.
+const int MaximumUnfinishedDirections = 3;
+
+// Memòria màxima, en bytes, dels buffers d'obscurances dels threads a part del primer. Cada thread acumula en un buffer de la mida del volum, i per tant
+// la memòria extra creix amb el nombre de threads; es limita el nombre de threads perquè no la superi.
+const qint64 MaximumExtraThreadBuffersMemory = Q_INT64_C(1024) * 1024 * 1024;
+
+}
+
 bool ObscuranceMainThread::hasColor(Variant variant)
 {
     return variant >= OpacityColorBleeding;
@@ -40,7 +57,9 @@ ObscuranceMainThread::ObscuranceMainThread(int numberOfDirections, double maximu
    m_numberOfDirections(numberOfDirections), m_maximumDistance(maximumDistance), m_function(function), m_variant(variant),
    m_doublePrecision(doublePrecision),
    m_volume(0),
-   m_obscurance(0)
+   m_obscurance(0),
+   m_numberOfThreads(0),
+   m_scheduler(0)
 {
 }
 
@@ -76,6 +95,24 @@ void ObscuranceMainThread::setSaliency(const double *saliency, double fxSaliency
     m_fxSaliencyHigh = fxSaliencyHigh;
 }
 
+void ObscuranceMainThread::setNumberOfThreads(int numberOfThreads)
+{
+    m_numberOfThreads = numberOfThreads;
+}
+
+int ObscuranceMainThread::getMaximumNumberOfThreads(unsigned int dataSize, bool color, bool doublePrecision)
+{
+    int idealThreadCount = qMax(1, QThread::idealThreadCount());
+    qint64 bufferMemory = static_cast<qint64>(dataSize) * (color ? 3 : 1) * static_cast<qint64>(doublePrecision ? sizeof(double) : sizeof(float));
+
+    if (bufferMemory == 0)
+    {
+        return idealThreadCount;
+    }
+
+    return static_cast<int>(qMin(static_cast<qint64>(idealThreadCount), 1 + MaximumExtraThreadBuffersMemory / bufferMemory));
+}
+
 Obscurance* ObscuranceMainThread::getObscurance() const
 {
     return m_obscurance;
@@ -84,6 +121,12 @@ Obscurance* ObscuranceMainThread::getObscurance() const
 void ObscuranceMainThread::stop()
 {
     m_stopped = true;
+
+    QMutexLocker locker(&m_schedulerMutex);
+    if (m_scheduler)
+    {
+        m_scheduler->cancel();
+    }
 }
 
 void ObscuranceMainThread::run()
@@ -97,11 +140,6 @@ void ObscuranceMainThread::run()
     /// \TODO fent això aquí crec que va més ràpid, però s'hauria de comprovar i provar també amb l'Update()
     gradientEstimator->GetEncodedNormals();
 
-    // Creem els threads
-    /// \todo QThread::idealThreadCount() amb Qt >= 4.3
-    int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
-    QVector<ObscuranceThread*> threads(numberOfThreads);
-
     // Variables necessàries
     vtkImageData *image = mapper->GetInput();
     unsigned short *data = reinterpret_cast<unsigned short*>(image->GetPointData()->GetScalars()->GetVoidPointer(0));
@@ -116,147 +154,211 @@ void ObscuranceMainThread::run()
     increments[1] = vtkIncrements[1];
     increments[2] = vtkIncrements[2];
 
-    m_obscurance = new Obscurance(dataSize, hasColor(), m_doublePrecision);
+    int numberOfThreads = m_numberOfThreads;
+    if (numberOfThreads <= 0)
+    {
+        numberOfThreads = getMaximumNumberOfThreads(dataSize, hasColor(), m_doublePrecision);
+    }
+
+    // Cada thread té el seu buffer d'obscurances. Si no hi ha memòria per a tots, es fan servir menys threads
+    QVector<Obscurance*> obscurances;
+    try
+    {
+        while (obscurances.size() < numberOfThreads)
+        {
+            obscurances << new Obscurance(dataSize, hasColor(), m_doublePrecision);
+        }
+    }
+    catch (std::bad_alloc &e)
+    {
+        if (obscurances.isEmpty())
+        {
+            ERROR_LOG(QString("No hi ha prou memòria per calcular les obscurances de %1 vòxels: %2").arg(dataSize).arg(e.what()));
+            emit progress(0);
+            m_obscurance = 0;
+            return;
+        }
+
+        WARN_LOG(QString("No hi ha prou memòria per %1 threads d'obscurances, se'n faran servir %2: %3").arg(numberOfThreads).arg(obscurances.size())
+                 .arg(e.what()));
+        numberOfThreads = obscurances.size();
+    }
+
+    ObscuranceTaskScheduler scheduler(numberOfThreads);
+    {
+        QMutexLocker locker(&m_schedulerMutex);
+        m_scheduler = &scheduler;
+        if (m_stopped)
+        {
+            scheduler.cancel();
+        }
+    }
+
+    // Creem els threads, cadascun amb el seu buffer d'obscurances
+    QVector<ObscuranceThread*> threads(numberOfThreads);
 
     for (int i = 0; i < numberOfThreads; i++)
     {
-        ObscuranceThread * thread = new ObscuranceThread(i, numberOfThreads, m_transferFunction);
+        ObscuranceThread * thread = new ObscuranceThread(i, &scheduler, m_transferFunction);
         thread->setGradientEstimator(gradientEstimator);
         thread->setData(data, dataSize, dimensions, increments);
-        thread->setObscuranceParameters(m_maximumDistance, m_function, m_variant, m_obscurance);
+        thread->setObscuranceParameters(m_maximumDistance, m_function, m_variant, obscurances[i]);
         thread->setSaliency(m_saliency, m_fxSaliencyA, m_fxSaliencyB, m_fxSaliencyLow, m_fxSaliencyHigh);
         threads[i] = thread;
+        thread->start();
     }
 
-    // Estructures de dades reaprofitables
-    QVector<Vector3> lineStarts;
-
     const QVector<Vector3> directions = getDirections();
     int nDirections = directions.size();
+    int nFinishedDirections = 0;
 
-    // Iterem per les direccions
+    // Afegim les direccions a mesura que s'acaben les anteriors, sense esperar que s'acabin totes les tasques d'una direcció per començar la següent
     for (int i = 0; i < nDirections && !m_stopped; i++)
     {
-        const Vector3 &direction = directions.at(i);
-
-        DEBUG_LOG(QString("Direcció %1: %2").arg(i).arg(direction.toString()));
-
-        // Direcció dominant (0 = x, 1 = y, 2 = z)
-        int dominant;
-        Vector3 absDirection(qAbs(direction.x), qAbs(direction.y), qAbs(direction.z));
-        if (absDirection.x >= absDirection.y)
+        int finishedDirections = scheduler.waitForDirections(MaximumUnfinishedDirections);
+        if (finishedDirections > nFinishedDirections)
         {
-            if (absDirection.x >= absDirection.z)
-            {
-                dominant = 0;
-            }
-            else
-            {
-                dominant = 2;
-            }
-        }
-        else
-        {
-            if (absDirection.y >= absDirection.z)
-            {
-                dominant = 1;
-            }
-            else
-            {
-                dominant = 2;
-            }
+            nFinishedDirections = finishedDirections;
+            emit progress(100 * nFinishedDirections / nDirections);
         }
 
-        // Vector per avançar
-        Vector3 forward;
-        switch (dominant)
-        {
-            case 0:
-                forward = Vector3(direction.x, direction.y, direction.z);
-                break;
-            case 1:
-                forward = Vector3(direction.y, direction.z, direction.x);
-                break;
-            case 2: 
-                forward = Vector3(direction.z, direction.x, direction.y);
-                break;
-        }
-        // La direcció x passa a ser 1 o -1
-        forward /= qAbs(forward.x);
-        DEBUG_LOG(QString("forward = ") + forward.toString());
-
-        // Dimensions i increments segons la direcció dominant
-        int x = dominant, y = (dominant + 1) % 3, z = (dominant + 2) % 3;
-        int dimX = dimensions[x], dimY = dimensions[y], dimZ = dimensions[z];
-        int incX = increments[x], incY = increments[y], incZ = increments[z];
-        int sX = 1, sY = 1, sZ = 1;
-        qptrdiff startDelta = 0;
-        if (forward.x < 0.0)
-        {
-            startDelta += incX * (dimX - 1);
-//             incX = -incX;
-            forward.x = -forward.x;
-            sX = -1;
-        }
-        if (forward.y < 0.0)
-        {
-            startDelta += incY * (dimY - 1);
-//             incY = -incY;
-            forward.y = -forward.y;
-            sY = -1;
-        }
-        if (forward.z < 0.0)
-        {
-            startDelta += incZ * (dimZ - 1);
-//             incZ = -incZ;
-            forward.z = -forward.z;
-            sZ = -1;
-        }
-        DEBUG_LOG(QString("forward = ") + forward.toString());
-        // Ara els 3 components són positius
-
-        // Llista dels vòxels que són començament de línia
-        getLineStarts(lineStarts, dimX, dimY, dimZ, forward);
-
-//         int incXYZ[3] = { incX, incY, incZ };
-        int xyz[3] = { x, y, z };
-        int sXYZ[3] = { sX, sY, sZ };
-
-        // Iniciem els threads
-        for (int j = 0; j < numberOfThreads; j++)
-        {
-            ObscuranceThread * thread = threads[j];
-            thread->setPerDirectionParameters(direction, forward, xyz, sXYZ, lineStarts, startDelta);
-            thread->start();
-        }
+        DEBUG_LOG(QString("Direcció %1: %2").arg(i).arg(directions.at(i).toString()));
+        scheduler.addDirection(computeDirection(directions.at(i), dimensions, increments), LinesPerTask);
+    }
 
-        // Esperem que acabin els threads
-        for (int j = 0; j < numberOfThreads; j++)
-        {
-            threads[j]->wait();
-        }
+    scheduler.finish();
 
-        emit progress(100 * (i + 1) / nDirections);
+    // Esperem que s'acabin les direccions que queden
+    while (!m_stopped && nFinishedDirections < nDirections)
+    {
+        nFinishedDirections = scheduler.waitForDirections(nDirections - nFinishedDirections);
+        emit progress(100 * nFinishedDirections / nDirections);
     }
 
-    // Destruïm els threads
+    // Esperem que acabin els threads i els destruïm
     for (int j = 0; j < numberOfThreads; j++)
     {
+        threads[j]->wait();
         delete threads[j];
     }
+
+    {
+        QMutexLocker locker(&m_schedulerMutex);
+        m_scheduler = 0;
+    }
+
     // Si han cancel·lat el procés ja podem plegar
     if (m_stopped)
     {
         emit progress(0);
-        delete m_obscurance; m_obscurance = 0;
+        qDeleteAll(obscurances);
+        m_obscurance = 0;
         return;
     }
 
+    // Sumem les obscurances de tots els threads
+    m_obscurance = obscurances.first();
+    for (int j = 1; j < numberOfThreads; j++)
+    {
+        m_obscurance->accumulate(*obscurances[j]);
+        delete obscurances[j];
+    }
+
     m_obscurance->normalize();
 
     emit computed();
 }
 
+QSharedPointer<ObscuranceDirection> ObscuranceMainThread::computeDirection(const Vector3 &direction, const int dimensions[3], const int increments[3])
+{
+    // Direcció dominant (0 = x, 1 = y, 2 = z)
+    int dominant;
+    Vector3 absDirection(qAbs(direction.x), qAbs(direction.y), qAbs(direction.z));
+    if (absDirection.x >= absDirection.y)
+    {
+        if (absDirection.x >= absDirection.z)
+        {
+            dominant = 0;
+        }
+        else
+        {
+            dominant = 2;
+        }
+    }
+    else
+    {
+        if (absDirection.y >= absDirection.z)
+        {
+            dominant = 1;
+        }
+        else
+        {
+            dominant = 2;
+        }
+    }
+
+    // Vector per avançar
+    Vector3 forward;
+    switch (dominant)
+    {
+        case 0:
+            forward = Vector3(direction.x, direction.y, direction.z);
+            break;
+        case 1:
+            forward = Vector3(direction.y, direction.z, direction.x);
+            break;
+        case 2: 
+            forward = Vector3(direction.z, direction.x, direction.y);
+            break;
+    }
+    // La direcció x passa a ser 1 o -1
+    forward /= qAbs(forward.x);
+    DEBUG_LOG(QString("forward = ") + forward.toString());
+
+    // Dimensions i increments segons la direcció dominant
+    int x = dominant, y = (dominant + 1) % 3, z = (dominant + 2) % 3;
+    int dimX = dimensions[x], dimY = dimensions[y], dimZ = dimensions[z];
+    int incX = increments[x], incY = increments[y], incZ = increments[z];
+    int sX = 1, sY = 1, sZ = 1;
+    qptrdiff startDelta = 0;
+    if (forward.x < 0.0)
+    {
+        startDelta += incX * (dimX - 1);
+        forward.x = -forward.x;
+        sX = -1;
+    }
+    if (forward.y < 0.0)
+    {
+        startDelta += incY * (dimY - 1);
+        forward.y = -forward.y;
+        sY = -1;
+    }
+    if (forward.z < 0.0)
+    {
+        startDelta += incZ * (dimZ - 1);
+        forward.z = -forward.z;
+        sZ = -1;
+    }
+    DEBUG_LOG(QString("forward = ") + forward.toString());
+    // Ara els 3 components són positius
+
+    QSharedPointer<ObscuranceDirection> obscuranceDirection(new ObscuranceDirection());
+    obscuranceDirection->direction = direction;
+    obscuranceDirection->forward = forward;
+    obscuranceDirection->xyz[0] = x;
+    obscuranceDirection->xyz[1] = y;
+    obscuranceDirection->xyz[2] = z;
+    obscuranceDirection->sXYZ[0] = sX;
+    obscuranceDirection->sXYZ[1] = sY;
+    obscuranceDirection->sXYZ[2] = sZ;
+    obscuranceDirection->startDelta = startDelta;
+
+    // Llista dels vòxels que són començament de línia
+    getLineStarts(obscuranceDirection->lineStarts, dimX, dimY, dimZ, forward);
+
+    return obscuranceDirection;
+}
+
 void ObscuranceMainThread::getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward)
 {
     lineStarts.resize(0);
@@ -15,6 +15,8 @@
 #ifndef UDGOBSCURANCEMAINTHREAD_H
 #define UDGOBSCURANCEMAINTHREAD_H
 
+#include <QMutex>
+#include <QSharedPointer>
 #include <QThread>
 
 #include <QVector>
@@ -26,8 +28,14 @@ class vtkVolume;
 
 namespace udg {
 
+struct ObscuranceDirection;
+class ObscuranceTaskScheduler;
+
 /**
     Thread principal per al càlcul d'obscurances. Controla els altres threads.
+
+    Cada direcció es divideix en tasques de poques línies que els threads executen amb robatori de feina, sense esperar-se entre direccions.
+    Com que les línies de direccions diferents es creuen, cada thread acumula les obscurances en el seu propi buffer i al final se sumen tots.
   */
 class ObscuranceMainThread : public QThread {
 Q_OBJECT
@@ -49,6 +57,13 @@ public:
     void setVolume(vtkVolume *volume);
     void setTransferFunction(const TransferFunction &transferFunction);
     void setSaliency(const double *saliency, double fxSaliencyA, double fxSaliencyB, double fxSaliencyLow, double fxSaliencyHigh);
+    /// Assigna el nombre de threads de càlcul. Si és 0 (per defecte) es fa servir el nombre ideal de threads de la màquina, limitat per
+    /// getMaximumNumberOfThreads(). Cada thread acumula en un buffer d'obscurances propi de la mida del volum, que se sumen al final.
+    void setNumberOfThreads(int numberOfThreads);
+
+    /// Retorna el nombre de threads que es fan servir per defecte per un volum de dataSize vòxels: el nombre ideal de threads de la màquina, però com a
+    /// màxim tants com permeti un límit de memòria pels buffers d'obscurances dels threads a part del primer, i almenys un.
+    static int getMaximumNumberOfThreads(unsigned int dataSize, bool color, bool doublePrecision);
 
     Obscurance* getObscurance() const;
 
@@ -63,6 +78,8 @@ protected:
     virtual void run();
 
 private:
+    /// Calcula els paràmetres i els començaments de línia de la direcció donada.
+    static QSharedPointer<ObscuranceDirection> computeDirection(const Vector3 &direction, const int dimensions[3], const int increments[3]);
     static void getLineStarts(QVector<Vector3> &lineStarts, int dimX, int dimY, int dimZ, const Vector3 &forward);
     QVector<Vector3> getDirections() const;
 
@@ -78,8 +95,12 @@ private:
     const double *m_saliency;
     double m_fxSaliencyA, m_fxSaliencyB;
     double m_fxSaliencyLow, m_fxSaliencyHigh;
+    int m_numberOfThreads;
 
     bool m_stopped;
+    /// Planificador del càlcul en curs, per poder-lo cancel·lar. Protegit per m_schedulerMutex.
+    ObscuranceTaskScheduler *m_scheduler;
+    QMutex m_schedulerMutex;
 
 };
 
@@ -0,0 +1,197 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "obscurancetaskscheduler.h"
+
+namespace udg {
+
+ObscuranceTaskScheduler::ObscuranceTaskScheduler(int numberOfThreads)
+ : m_numberOfQueuedTasks(0), m_numberOfAddedDirections(0), m_numberOfFinishedDirections(0), m_finished(false), m_cancelled(false), m_nextQueue(0)
+{
+    for (int i = 0; i < numberOfThreads; i++)
+    {
+        TaskQueue *queue = new TaskQueue();
+        queue->first = 0;
+        m_queues << queue;
+    }
+}
+
+ObscuranceTaskScheduler::~ObscuranceTaskScheduler()
+{
+    qDeleteAll(m_queues);
+}
+
+void ObscuranceTaskScheduler::addDirection(const QSharedPointer<ObscuranceDirection> &direction, int linesPerTask)
+{
+    int numberOfTasks = (direction->lineStarts.size() + linesPerTask - 1) / linesPerTask;
+    direction->numberOfUnfinishedTasks.store(numberOfTasks);
+
+    QMutexLocker locker(&m_mutex);
+    m_numberOfAddedDirections++;
+
+    if (m_cancelled || numberOfTasks == 0)
+    {
+        m_numberOfFinishedDirections++;
+        m_condition.wakeAll();
+        return;
+    }
+
+    // Cada cua rep un bloc de tasques consecutives, perquè cada thread comenci per línies veïnes. La primera cua va rotant perquè les direccions amb
+    // poques tasques no carreguin sempre els mateixos threads.
+    int numberOfQueues = m_queues.size();
+    for (int i = 0; i < numberOfQueues; i++)
+    {
+        int firstTask = i * numberOfTasks / numberOfQueues;
+        int endTask = (i + 1) * numberOfTasks / numberOfQueues;
+        if (firstTask == endTask)
+        {
+            continue;
+        }
+
+        TaskQueue *queue = m_queues[(m_nextQueue + i) % numberOfQueues];
+        QMutexLocker queueLocker(&queue->mutex);
+
+        // Les tasques es treuen pel final, per tant s'afegeixen en ordre invers
+        for (int j = endTask - 1; j >= firstTask; j--)
+        {
+            Task task;
+            task.direction = direction;
+            task.firstLine = j * linesPerTask;
+            task.endLine = qMin((j + 1) * linesPerTask, direction->lineStarts.size());
+            queue->tasks << task;
+        }
+    }
+
+    m_nextQueue = (m_nextQueue + 1) % numberOfQueues;
+    m_numberOfQueuedTasks.fetchAndAddOrdered(numberOfTasks);
+    m_condition.wakeAll();
+}
+
+void ObscuranceTaskScheduler::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    m_finished = true;
+    m_condition.wakeAll();
+}
+
+void ObscuranceTaskScheduler::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cancelled = true;
+
+    foreach (TaskQueue *queue, m_queues)
+    {
+        QMutexLocker queueLocker(&queue->mutex);
+        queue->tasks.clear();
+        queue->first = 0;
+    }
+
+    m_numberOfQueuedTasks.store(0);
+    m_condition.wakeAll();
+}
+
+bool ObscuranceTaskScheduler::takeTask(int threadId, Task &task)
+{
+    int numberOfQueues = m_queues.size();
+
+    forever
+    {
+        if (takeTaskFromQueue(threadId, false, task))
+        {
+            return true;
+        }
+
+        for (int i = 1; i < numberOfQueues; i++)
+        {
+            if (takeTaskFromQueue((threadId + i) % numberOfQueues, true, task))
+            {
+                return true;
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+
+        if (m_cancelled)
+        {
+            return false;
+        }
+
+        // Si el comptador diu que hi ha tasques és que algú les acaba d'afegir o de treure: tornem a mirar les cues
+        if (m_numberOfQueuedTasks.load() <= 0)
+        {
+            if (m_finished)
+            {
+                return false;
+            }
+
+            m_condition.wait(&m_mutex);
+        }
+    }
+}
+
+void ObscuranceTaskScheduler::finishTask(const Task &task)
+{
+    if (!task.direction->numberOfUnfinishedTasks.deref())
+    {
+        QMutexLocker locker(&m_mutex);
+        m_numberOfFinishedDirections++;
+        m_condition.wakeAll();
+    }
+}
+
+int ObscuranceTaskScheduler::waitForDirections(int maximumUnfinishedDirections)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_cancelled && m_numberOfAddedDirections - m_numberOfFinishedDirections >= maximumUnfinishedDirections)
+    {
+        m_condition.wait(&m_mutex);
+    }
+
+    return m_numberOfFinishedDirections;
+}
+
+bool ObscuranceTaskScheduler::takeTaskFromQueue(int queueIndex, bool steal, Task &task)
+{
+    TaskQueue *queue = m_queues[queueIndex];
+    QMutexLocker locker(&queue->mutex);
+
+    if (queue->first >= queue->tasks.size())
+    {
+        return false;
+    }
+
+    if (steal)
+    {
+        task = queue->tasks[queue->first];
+        queue->tasks[queue->first] = Task();
+        queue->first++;
+    }
+    else
+    {
+        task = queue->tasks.last();
+        queue->tasks.removeLast();
+    }
+
+    if (queue->first >= queue->tasks.size())
+    {
+        queue->tasks.resize(0);
+        queue->first = 0;
+    }
+
+    m_numberOfQueuedTasks.deref();
+    return true;
+}
+
+}
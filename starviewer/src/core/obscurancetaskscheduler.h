@@ -0,0 +1,114 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGOBSCURANCETASKSCHEDULER_H
+#define UDGOBSCURANCETASKSCHEDULER_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "vector3.h"
+
+namespace udg {
+
+/**
+    Paràmetres d'una direcció de càlcul d'obscurances, compartits per totes les tasques de la direcció.
+  */
+struct ObscuranceDirection {
+    /// Direcció i vector per avançar al llarg de les línies, amb tots els components positius.
+    Vector3 direction, forward;
+    /// Eixos del volum corresponents a la direcció dominant i les altres dues, i signe de l'avanç en cadascun.
+    int xyz[3];
+    int sXYZ[3];
+    /// Començaments de les línies que recorren el volum en aquesta direcció.
+    QVector<Vector3> lineStarts;
+    /// Desplaçament del primer vòxel segons el signe de l'avanç.
+    qptrdiff startDelta;
+    /// Nombre de tasques de la direcció que encara no s'han acabat.
+    QAtomicInt numberOfUnfinishedTasks;
+};
+
+/**
+    Planificador de les tasques de càlcul d'obscurances amb robatori de feina.
+
+    Cada direcció es divideix en tasques de com a molt un nombre fix de línies, que es reparteixen entre les cues dels threads. Cada thread treu tasques
+    de la seva cua i, quan la té buida, en roba de les cues dels altres, de manera que cap thread no s'espera mentre quedin tasques de qualsevol direcció.
+    Les tasques de direccions diferents es poden executar alhora, per tant cada thread ha d'acumular les obscurances en el seu propi buffer.
+  */
+class ObscuranceTaskScheduler {
+public:
+    /// Tasca: un rang de línies d'una direcció.
+    struct Task {
+        QSharedPointer<ObscuranceDirection> direction;
+        int firstLine, endLine;
+    };
+
+    explicit ObscuranceTaskScheduler(int numberOfThreads);
+    ~ObscuranceTaskScheduler();
+
+    /// Afegeix les tasques d'una direcció, de com a molt linesPerTask línies cadascuna, repartint-les entre les cues dels threads.
+    void addDirection(const QSharedPointer<ObscuranceDirection> &direction, int linesPerTask);
+
+    /// Indica que ja no s'afegiran més direccions, de manera que els threads acabaran quan no quedin tasques.
+    void finish();
+
+    /// Cancel·la les tasques pendents i fa acabar els threads.
+    void cancel();
+
+    /// Treu una tasca per al thread donat, de la seva cua o robada d'una altra. Si no n'hi ha cap, s'espera fins que n'hi hagi.
+    /// Retorna fals quan ja no n'hi haurà més, perquè s'ha acabat o s'ha cancel·lat.
+    bool takeTask(int threadId, Task &task);
+
+    /// Indica que la tasca donada s'ha acabat.
+    void finishTask(const Task &task);
+
+    /// S'espera fins que hi hagi menys de maximumUnfinishedDirections direccions afegides sense acabar o fins que es cancel·li.
+    /// Retorna el nombre de direccions acabades.
+    int waitForDirections(int maximumUnfinishedDirections);
+
+private:
+    /// Cua de tasques d'un thread. El propietari treu les tasques pel final i els altres threads les roben pel principi.
+    struct TaskQueue {
+        QMutex mutex;
+        QVector<Task> tasks;
+        int first;
+    };
+
+    /// Treu una tasca de la cua donada, pel final si és del propietari o pel principi si és robada. Retorna fals si la cua és buida.
+    bool takeTaskFromQueue(int queueIndex, bool steal, Task &task);
+
+private:
+    QVector<TaskQueue*> m_queues;
+
+    /// Nombre de tasques a les cues.
+    QAtomicInt m_numberOfQueuedTasks;
+
+    /// Protegeix l'estat global i s'utilitza per esperar tasques o direccions acabades.
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    int m_numberOfAddedDirections;
+    int m_numberOfFinishedDirections;
+    bool m_finished;
+    bool m_cancelled;
+
+    /// Cua on s'afegirà la propera tasca.
+    int m_nextQueue;
+};
+
+}
+
+#endif
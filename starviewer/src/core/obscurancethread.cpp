@@ -28,8 +28,8 @@
 
 namespace udg {
 
-ObscuranceThread::ObscuranceThread(int id, int numberOfThreads, const TransferFunction &transferFunction, QObject *parent)
- : QThread(parent), m_id(id), m_numberOfThreads(numberOfThreads), m_transferFunction(transferFunction), m_obscurance(0), m_saliency(0)
+ObscuranceThread::ObscuranceThread(int id, ObscuranceTaskScheduler *scheduler, const TransferFunction &transferFunction, QObject *parent)
+ : QThread(parent), m_id(id), m_scheduler(scheduler), m_transferFunction(transferFunction), m_obscurance(0), m_saliency(0)
 {
 }
 
@@ -68,21 +68,38 @@ void ObscuranceThread::setSaliency(const double * saliency, double fxSaliencyA,
     m_fxSaliencyHigh = fxSaliencyHigh;
 }
 
-void ObscuranceThread::setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
-                                                 const QVector<Vector3> &lineStarts, qptrdiff startDelta)
+void ObscuranceThread::setTask(const ObscuranceTaskScheduler::Task &task)
 {
-    m_direction = direction;
-    m_forward = forward;
-    m_xyz = xyz;
-    m_sXYZ = sXYZ;
-    m_lineStarts = lineStarts;
-    m_startDelta = startDelta;
+    m_currentDirection = task.direction;
+    m_direction = task.direction->direction;
+    m_forward = task.direction->forward;
+    m_xyz = task.direction->xyz;
+    m_sXYZ = task.direction->sXYZ;
+    m_lineStarts = task.direction->lineStarts;
+    m_startDelta = task.direction->startDelta;
+    m_firstLine = task.firstLine;
+    m_endLine = task.endLine;
 }
 
 void ObscuranceThread::run()
 {
     DEBUG_LOG(QString("%1: run()").arg(m_id));
 
+    ObscuranceTaskScheduler::Task task;
+    while (m_scheduler->takeTask(m_id, task))
+    {
+        setTask(task);
+        runTask();
+        m_scheduler->finishTask(task);
+    }
+
+    // Alliberem la darrera direcció
+    m_currentDirection.clear();
+    m_lineStarts.clear();
+}
+
+void ObscuranceThread::runTask()
+{
     switch (m_obscuranceVariant)
     {
         case ObscuranceMainThread::Density:
@@ -125,10 +142,9 @@ void ObscuranceThread::runDensity()
     unresolvedVoxels.reserve(dimX);
 
     const ushort *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -197,10 +213,9 @@ void ObscuranceThread::runDensitySmooth()
     QLinkedList<QPair<ushort, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -347,10 +362,9 @@ void ObscuranceThread::runOpacity()
     QStack<QPair<double, Vector3> > unresolvedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -416,10 +430,9 @@ void ObscuranceThread::runOpacitySmooth()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -567,10 +580,9 @@ void ObscuranceThread::runOpacitySaliency()
     QStack<QPair<double, Vector3> > unresolvedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -637,10 +649,9 @@ void ObscuranceThread::runOpacitySmoothSaliency()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -805,10 +816,9 @@ void ObscuranceThread::runOpacityColorBleeding()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    int nLineStarts = m_lineStarts.size();
 
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
@@ -960,11 +970,10 @@ void ObscuranceThread::runOpacitySmoothColorBleeding()
     QLinkedList<QPair<double, Vector3> > postponedVoxels;
 
     const unsigned short *dataPtr = m_data + m_startDelta;
-    const int nLineStarts = m_lineStarts.size();
 
     // u és el tapat, v és el que tapa
     // Iterar per cada línia
-    for (int j = m_id; j < nLineStarts; j += m_numberOfThreads)
+    for (int j = m_firstLine; j < m_endLine; j++)
     {
         Vector3 rv = m_lineStarts.at(j);
         Voxel v = { qRound(rv.x), qRound(rv.y), qRound(rv.z) };
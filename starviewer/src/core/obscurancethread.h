@@ -19,6 +19,7 @@
 #include <QVector>
 
 #include "obscurancemainthread.h"
+#include "obscurancetaskscheduler.h"
 #include "transferfunction.h"
 #include "vector3.h"
 
@@ -32,13 +33,15 @@ class Obscurance;
 /**
     Thread que implementa els mètodes de càlcul d'obscurances.
 
+    Executa les tasques que treu del planificador fins que no n'hi ha més, i acumula les obscurances de totes les direccions en el seu propi buffer.
+
     \author Grup de Gràfics de Girona (GGG) <vismed@ima.udg.edu>
   */
 class ObscuranceThread : public QThread {
 Q_OBJECT
 
 public:
-    ObscuranceThread(int id, int numberOfThreads, const TransferFunction &transferFunction, QObject *parent = 0);
+    ObscuranceThread(int id, ObscuranceTaskScheduler *scheduler, const TransferFunction &transferFunction, QObject *parent = 0);
     virtual ~ObscuranceThread();
 
     /// Assigna l'estimador del gradient, d'on es treuran les normals.
@@ -47,8 +50,6 @@ public:
     void setObscuranceParameters(double obscuranceMaximumDistance, ObscuranceMainThread::Function obscuranceFunction,
                                  ObscuranceMainThread::Variant obscuranceVariant, Obscurance *obscurance);
     void setSaliency(const double *saliency, double fxSaliencyA, double fxSaliencyB, double fxSaliencyLow, double fxSaliencyHigh);
-    void setPerDirectionParameters(const Vector3 &direction, const Vector3 &forward, const int xyz[3], const int sXYZ[3],
-                                   const QVector<Vector3> &lineStarts, qptrdiff startDelta);
 
 protected:
     virtual void run();
@@ -58,6 +59,10 @@ private:
     typedef ObscuranceMainThread::Function Function;
     typedef ObscuranceMainThread::Variant Variant;
 
+    /// Assigna els paràmetres de la direcció i el rang de línies de la tasca donada.
+    void setTask(const ObscuranceTaskScheduler::Task &task);
+    /// Calcula les obscurances de les línies de la tasca actual.
+    void runTask();
     void runDensity();
     void runDensitySmooth();
     void runOpacity();
@@ -69,7 +74,8 @@ private:
     double obscurance(double distance) const;
     bool smoothBlocking(const Vector3 &blocking, const Vector3 &blocked, double distance, const float *blockedGradient) const;
 
-    int m_id, m_numberOfThreads;
+    int m_id;
+    ObscuranceTaskScheduler *m_scheduler;
     const TransferFunction &m_transferFunction;
     vtkDirectionEncoder *m_directionEncoder;
     const ushort *m_encodedNormals;
@@ -90,6 +96,10 @@ private:
     const int *m_sXYZ;
     QVector<Vector3> m_lineStarts;
     qptrdiff m_startDelta;
+    /// Rang de línies de la tasca actual.
+    int m_firstLine, m_endLine;
+    /// Direcció de la tasca actual, que es manté mentre se n'utilitzen els paràmetres.
+    QSharedPointer<ObscuranceDirection> m_currentDirection;
 
 };
 
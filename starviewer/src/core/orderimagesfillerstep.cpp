@@ -21,8 +21,23 @@
 #include "image.h"
 #include "mathtools.h"
 
+#include <QStringList>
+
+#include <algorithm>
+#include <limits>
+
 namespace udg {
 
+namespace {
+
+// Retorna cert si els dos vectors són exactament iguals (l'operador == de QVector3D fa una comparació aproximada)
+bool isSameVector(const QVector3D &vector1, const QVector3D &vector2)
+{
+    return vector1.x() == vector2.x() && vector1.y() == vector2.y() && vector1.z() == vector2.z();
+}
+
+}
+
 OrderImagesFillerStep::OrderImagesFillerStep()
 : PatientFillerStep()
 {
@@ -30,135 +45,42 @@ OrderImagesFillerStep::OrderImagesFillerStep()
 
 OrderImagesFillerStep::~OrderImagesFillerStep()
 {
-    QMap<unsigned long, Image*> *instanceNumberSet;
-    QMap<double, QMap<unsigned long, Image*>*> *imagePositionSet;
-    QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*> *orderedImageSet;
-    QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*> *normalVectorImageSet;
-    QMap<int, QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>*> *volumesInSeries;
-
-    foreach (Series *key, m_orderImagesInternalInfo.keys())
-    {
-        volumesInSeries = m_orderImagesInternalInfo.take(key);
-        foreach (int volumeNumber, volumesInSeries->keys())
-        {
-            normalVectorImageSet = volumesInSeries->take(volumeNumber);
-            foreach (double normalVectorKey, normalVectorImageSet->keys())
-            {
-                orderedImageSet = normalVectorImageSet->take(normalVectorKey);
-                foreach (const QString &key, orderedImageSet->keys())
-                {
-                    imagePositionSet = orderedImageSet->take(key);
-                    foreach (double distanceKey, imagePositionSet->keys())
-                    {
-                        instanceNumberSet = imagePositionSet->take(distanceKey);
-                        delete instanceNumberSet;
-                    }
-                    delete imagePositionSet;
-                }
-                delete orderedImageSet;
-            }
-            delete normalVectorImageSet;
-        }
-        delete volumesInSeries;
-    }
-
-    foreach (Series *series, m_phasesPerPositionEvaluation.keys())
-    {
-        QHash<int, PhasesPerPositionHashType*> *volumeHash = m_phasesPerPositionEvaluation.take(series);
-        foreach (int volumeNumber, volumeHash->keys())
-        {
-            PhasesPerPositionHashType *phasesPerPositionHash = volumeHash->take(volumeNumber);
-            delete phasesPerPositionHash;
-        }
-        delete volumeHash;
-    }
-
-    QHash<Series*, QHash<int, bool>* > m_sameNumberOfPhasesPerPositionPerVolumeInSeriesHash;
-    foreach (Series *series, m_sameNumberOfPhasesPerPositionPerVolumeInSeriesHash.keys())
-    {
-        QHash<int, bool> *volumeHash = m_sameNumberOfPhasesPerPositionPerVolumeInSeriesHash.take(series);
-        delete volumeHash;
-    }
-    foreach (Series *series, m_acquisitionNumberEvaluation.keys())
-    {
-        QHash<int, QPair<QString, bool>*> volumeHash = m_acquisitionNumberEvaluation.take(series);
-        foreach (int volumeNumber, volumeHash.keys())
-        {
-            QPair<QString, bool> *pair = volumeHash.take(volumeNumber);
-            delete pair;
-        }
-    }
 }
 
 bool OrderImagesFillerStep::fillIndividually()
 {
-    QMap<int, QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>*> *volumesInSeries;
-
-    if (m_orderImagesInternalInfo.contains(m_input->getCurrentSeries()))
-    {
-        volumesInSeries = m_orderImagesInternalInfo.value(m_input->getCurrentSeries());
-        if (volumesInSeries->contains(m_input->getCurrentVolumeNumber()))
-        {
-            m_orderedNormalsSet = volumesInSeries->value(m_input->getCurrentVolumeNumber());
-        }
-        else
-        {
-            DEBUG_LOG(QString("Llista nul·la pel volum %1 de la serie %2. En creem una de nova.").arg(m_input->getCurrentVolumeNumber()).arg(
-                      m_input->getCurrentSeries()->getInstanceUID()));
-            m_orderedNormalsSet = new QMap<double,QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>();
-            volumesInSeries->insert(m_input->getCurrentVolumeNumber(), m_orderedNormalsSet);
-        }
-    }
-    else
-    {
-        DEBUG_LOG(QString("Llista nul·la en creem una de nova per la serie %1.").arg(m_input->getCurrentSeries()->getInstanceUID()));
-        volumesInSeries = new QMap<int, QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>*>();
-        m_orderedNormalsSet = new QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>();
+    Series *currentSeries = m_input->getCurrentSeries();
+    int currentVolumeNumber = m_input->getCurrentVolumeNumber();
+    const QList<Image*> &currentImages = m_input->getCurrentImages();
 
-        volumesInSeries->insert(m_input->getCurrentVolumeNumber(), m_orderedNormalsSet);
-        m_orderImagesInternalInfo.insert(m_input->getCurrentSeries(), volumesInSeries);
-    }
-
-    foreach (Image * image, m_input->getCurrentImages())
-    {
-        processImage(image);
-        // Avaluació del nombre de fases per posició
-        processPhasesPerPositionEvaluation(image);
-    }
+    QMap<int, VolumeInfo> &volumesInSeries = m_volumesInfo[currentSeries];
+    bool isNewVolume = !volumesInSeries.contains(currentVolumeNumber);
+    VolumeInfo &volumeInfo = volumesInSeries[currentVolumeNumber];
 
     // Avaluació dels AcquisitionNumbers
     QString acquisitionNumber;
-    if (!m_input->getCurrentImages().isEmpty())
+    if (!currentImages.isEmpty())
     {
-        acquisitionNumber = m_input->getCurrentImages().first()->getAcquisitionNumber();
+        acquisitionNumber = currentImages.first()->getAcquisitionNumber();
     }
-    if (m_acquisitionNumberEvaluation.contains(m_input->getCurrentSeries()))
+
+    if (isNewVolume)
     {
-        if (m_acquisitionNumberEvaluation.value(m_input->getCurrentSeries()).contains(m_input->getCurrentVolumeNumber()))
-        {
-            // Comparem els Acquisition Numbers
-            QPair<QString, bool> *pair = m_acquisitionNumberEvaluation[m_input->getCurrentSeries()][m_input->getCurrentVolumeNumber()];
-            if (!pair->second)
-            {
-                if (pair->first != acquisitionNumber)
-                {
-                    pair->second = true;
-                }
-            }
-        }
-        else
-        {
-            QPair<QString, bool> *acquisitionPair = new QPair<QString, bool>(acquisitionNumber, false);
-            m_acquisitionNumberEvaluation[m_input->getCurrentSeries()].insert(m_input->getCurrentVolumeNumber(), acquisitionPair);
-        }
+        DEBUG_LOG(QString("Nova llista pel volum %1 de la serie %2.").arg(currentVolumeNumber).arg(currentSeries->getInstanceUID()));
+        volumeInfo.lastPlaneGroup = -1;
+        volumeInfo.firstAcquisitionNumber = acquisitionNumber;
+        volumeInfo.multipleAcquisitionNumbers = false;
     }
-    else
+    else if (!volumeInfo.multipleAcquisitionNumbers && volumeInfo.firstAcquisitionNumber != acquisitionNumber)
     {
-        QHash<int, QPair<QString, bool>*> volumeHash;
-        QPair<QString, bool> *acquisitionPair = new QPair<QString, bool>(acquisitionNumber, false);
-        volumeHash.insert(m_input->getCurrentVolumeNumber(), acquisitionPair);
+        volumeInfo.multipleAcquisitionNumbers = true;
+    }
 
-        m_acquisitionNumberEvaluation.insert(m_input->getCurrentSeries(), volumeHash);
+    foreach (Image * image, currentImages)
+    {
+        processImage(volumeInfo, image);
+        // Avaluació del nombre de fases per posició
+        processPhasesPerPositionEvaluation(volumeInfo, image);
     }
 
     return true;
@@ -166,204 +88,114 @@ bool OrderImagesFillerStep::fillIndividually()
 
 void OrderImagesFillerStep::postProcessing()
 {
-    // Per cada subvolum de cada sèrie, comprovem si aquestes tenen el mateix nombre de fases per posició
-    foreach (Series *currentSeries, m_phasesPerPositionEvaluation.keys())
-    {
-        // <VolumeNumber, SameNumberOfPhasesPerPosition?>
-        QHash<int, bool> *volumeNumberPhaseCountHash = new QHash<int, bool>();
-        foreach (int currentVolumeNumber, m_phasesPerPositionEvaluation.value(currentSeries)->keys())
-        {
-            PhasesPerPositionHashType *phasesPerPositionHash = m_phasesPerPositionEvaluation.value(currentSeries)->value(currentVolumeNumber);
-            // Si passem la llista de valors a un QSet i aquest té mida 1, vol dir que totes les posicions tenen el mateix nombre de fases
-            // (Un QSet no admet duplicats). S'ha de tenir en compte que si només hi ha una posició amb diferents fases no cal fer res ja que serà correcte
-            QList<int> phasesList = phasesPerPositionHash->values();
-            int listSize = phasesList.count();
-            bool sameNumberOfPhases = true;
-            if (listSize > 1 && phasesList.toSet().count() > 1)
-            {
-                sameNumberOfPhases = false;
-            }
-            volumeNumberPhaseCountHash->insert(currentVolumeNumber, sameNumberOfPhases);
-        }
-        m_sameNumberOfPhasesPerPositionPerVolumeInSeriesHash.insert(currentSeries, volumeNumberPhaseCountHash);
-    }
-    
-    foreach (Series *key, m_orderImagesInternalInfo.keys())
+    foreach (Series *key, m_volumesInfo.keys())
     {
         setOrderedImagesIntoSeries(key);
     }
 }
 
-void OrderImagesFillerStep::processImage(Image *image)
+void OrderImagesFillerStep::processImage(VolumeInfo &volumeInfo, Image *image)
 {
-    // Obtenim el vector normal del pla, que ens determina també a quin "stack" pertany la imatge
-    QVector3D planeNormalVector3D = image->getImageOrientationPatient().getNormalVector();
-    // El passem a string que ens serà més fàcil de comparar,perquè així és com es guarda a l'estructura d'ordenació
-    QString planeNormalString = QString("%1\\%2\\%3").arg(planeNormalVector3D.x(), 0, 'f', 5).arg(planeNormalVector3D.y(), 0, 'f', 5)
-                                   .arg(planeNormalVector3D.z(), 0, 'f', 5);
-
-    QMap<double, QMap<unsigned long, Image*>*> *imagePositionSet;
-    QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*> *orderedImageSet;
-    QMap<unsigned long, Image*> *instanceNumberSet;
-
-    double distance = Image::distance(image);
-
-    // Primer busquem quina és la key (normal del pla) més semblant de totes les que hi ha
-    // Cada key és la normal de cada pla guardat com a string.
-    // En cas que tinguem diferents normals, indicaria que tenim per exemple, diferents stacks en el mateix volum
+    ImageSortKey sortKey;
+    sortKey.image = image;
+    // Obtenim el vector normal del pla, que ens determina a quin "stack" pertany la imatge
+    sortKey.planeGroup = getPlaneGroup(volumeInfo, image->getImageOrientationPatient().getNormalVector());
+    sortKey.distance = Image::distance(image);
+    sortKey.instanceNumberKey = QString("%1%2%3").arg(image->getInstanceNumber()).arg("0").arg(image->getFrameNumber()).toULong();
+    sortKey.index = volumeInfo.images.size();
+
+    volumeInfo.images.append(sortKey);
+}
 
-    // TODO WARN BUG: We are doing insertMulti() in another place, so there may be keys with multiple values,
-    //                but we are getting only the last value for each key, so some plane normals can be missed.
-    //                We should iterate over the values instead of the unique keys and use a QSet for planeNormals.
-    QStringList planeNormals;
-    foreach (double key, m_orderedNormalsSet->uniqueKeys())
+int OrderImagesFillerStep::getPlaneGroup(VolumeInfo &volumeInfo, const QVector3D &planeNormalVector3D)
+{
+    // Normalment les imatges consecutives tenen la mateixa normal
+    if (volumeInfo.lastPlaneGroup >= 0 && isSameVector(planeNormalVector3D, volumeInfo.lastNormal))
     {
-        planeNormals << m_orderedNormalsSet->value(key)->uniqueKeys();
+        return volumeInfo.lastPlaneGroup;
     }
 
-    // Aquest bucle serveix per trobar si la normal de la nova imatge
-    // coincideix amb alguna normal de les imatges ja processada
-    QString keyPlaneNormal;
-    foreach (const QString &normal, planeNormals)
+    // El passem a string que ens serà més fàcil de comparar
+    QString planeNormalString = QString("%1\\%2\\%3").arg(planeNormalVector3D.x(), 0, 'f', 5).arg(planeNormalVector3D.y(), 0, 'f', 5)
+                                   .arg(planeNormalVector3D.z(), 0, 'f', 5);
+
+    // Busquem per ordre d'angle la primera agrupació amb la mateixa normal. En cas que tinguem diferents normals, indicaria que tenim per exemple,
+    // diferents stacks en el mateix volum
+    int planeGroupIndex = -1;
+    foreach (int index, volumeInfo.searchablePlaneGroups)
     {
-        if (normal == planeNormalString)
+        const PlaneGroup &planeGroup = volumeInfo.planeGroups.at(index);
+
+        // Tot i que siguin diferents, pot ser que siguin gairebé iguals ja que a vegades només hi ha petites imprecisions.
+        // Si l'angle entre les normals està dins d'un threshold, les podem considerar iguals
+        // TODO definir millor aquest threshold
+        if (planeGroup.normalString == planeNormalString || MathTools::angleInDegrees(planeGroup.normal, planeNormalVector3D) < 1.0)
         {
-            // La normal d'aquest pla ja existeix (cas més típic)
-            keyPlaneNormal = normal;
+            planeGroupIndex = index;
             break;
         }
-        // Les normals són diferents, comprovar si ho són completament o no
-        else
-        {
-            if (normal.isEmpty())
-            {
-                keyPlaneNormal = planeNormalString;
-                break;
-            }
-            else
-            {
-                // Tot i que siguin diferents, pot ser que siguin gairebé iguals
-                // llavors cal comprovar que de fet són prou diferents
-                // ja que a vegades només hi ha petites imprecisions simplement
-                QStringList normalSplitted = normal.split("\\");
-                QVector3D normalVector(normalSplitted.at(0).toDouble(), normalSplitted.at(1).toDouble(), normalSplitted.at(2).toDouble());
-
-                double angle = MathTools::angleInDegrees(normalVector, planeNormalVector3D);
-
-                if (angle < 1.0)
-                {
-                    // Si l'angle entre les normals
-                    // està dins d'un threshold,
-                    // les podem considerar iguals
-                    // TODO definir millor aquest threshold
-                    keyPlaneNormal = normal;
-                    break;
-                }
-            }
-        }
     }
-    // Ara cal inserir la imatge a la llista ordenada
-    // Si no hem posat cap valor, vol dir que la normal és nova i no existia fins el moment
-    if (keyPlaneNormal.isEmpty())
-    {
-        // Assignem la clau
-        keyPlaneNormal = planeNormalString;
-        // Ara cal inserir la nova clau
-        instanceNumberSet = new QMap<unsigned long, Image*>();
-        instanceNumberSet->insert(QString("%1%2%3").arg(image->getInstanceNumber()).arg("0").arg(image->getFrameNumber()).toULong(), image);
-
-        imagePositionSet = new QMap<double, QMap<unsigned long, Image*>*>();
-        imagePositionSet->insert(distance, instanceNumberSet);
-        
-        orderedImageSet = new QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>();
-        orderedImageSet->insert(keyPlaneNormal, imagePositionSet);
-
-        double angle = 0;
 
-        if (m_orderedNormalsSet->isEmpty())
+    // Si no l'hem trobat, vol dir que la normal és nova i no existia fins el moment
+    if (planeGroupIndex < 0)
+    {
+        PlaneGroup planeGroup;
+        planeGroup.normalString = planeNormalString;
+        QStringList normalSplitted = planeNormalString.split("\\");
+        planeGroup.normal = QVector3D(normalSplitted.at(0).toDouble(), normalSplitted.at(1).toDouble(), normalSplitted.at(2).toDouble());
+        planeGroup.angle = 0;
+        planeGroup.minimumDistance = 0.0;
+        planeGroup.maximumDistance = 0.0;
+        planeGroup.rank = 0;
+
+        if (volumeInfo.planeGroups.isEmpty())
         {
             m_firstPlaneVector3D = planeNormalVector3D;
         }
         else
         {
-            if (m_orderedNormalsSet->size() == 1) // Busquem la normal per saber la direcció per on s'han d'ordenar
+            if (volumeInfo.planeGroups.size() == 1) // Busquem la normal per saber la direcció per on s'han d'ordenar
             {
                 m_direction = QVector3D::crossProduct(m_firstPlaneVector3D, planeNormalVector3D);
                 m_direction = QVector3D::crossProduct(m_direction, m_firstPlaneVector3D);
             }
-            
-            angle = MathTools::angleInRadians(m_firstPlaneVector3D, planeNormalVector3D);
 
-            if (QVector3D::dotProduct(planeNormalVector3D, m_direction) <= 0) // Direcció d'ordenació
-            {
-                angle = 2 * MathTools::PiNumber - angle;
-            }
-        }
-        m_orderedNormalsSet->insertMulti(angle, orderedImageSet);
+            planeGroup.angle = MathTools::angleInRadians(m_firstPlaneVector3D, planeNormalVector3D);
 
-    }
-    // La normal ja existia [m_orderedImageSet->contains(keyPlaneNormal) == true], per tant només cal actualitzar l'estructura
-    else
-    {
-        // TODO WARN BUG: We are doing insertMulti() in another place, so there may be keys with multiple values,
-        //                but we are getting only the last value for each key, so some plane normals can be missed.
-        //                We should iterate over the values instead of the unique keys.
-        foreach (double key, m_orderedNormalsSet->keys())
-        {
-            if (m_orderedNormalsSet->value(key)->contains(keyPlaneNormal))
+            if (QVector3D::dotProduct(planeNormalVector3D, m_direction) <= 0) // Direcció d'ordenació
             {
-                orderedImageSet = m_orderedNormalsSet->value(key);
+                planeGroup.angle = 2 * MathTools::PiNumber - planeGroup.angle;
             }
         }
 
-        imagePositionSet = orderedImageSet->value(keyPlaneNormal);
-        if (imagePositionSet->contains(distance))
+        planeGroupIndex = volumeInfo.planeGroups.size();
+        volumeInfo.planeGroups.append(planeGroup);
+
+        // Si ja hi ha una agrupació amb el mateix angle, a partir d'ara es busca a la nova
+        const QVector<PlaneGroup> &planeGroups = volumeInfo.planeGroups;
+        QVector<int>::iterator position = std::lower_bound(volumeInfo.searchablePlaneGroups.begin(), volumeInfo.searchablePlaneGroups.end(),
+                                                           planeGroup.angle, [&planeGroups](int index, double angle)
+                                                                             {
+                                                                                 return planeGroups.at(index).angle < angle;
+                                                                             });
+        if (position != volumeInfo.searchablePlaneGroups.end() && !(planeGroup.angle < planeGroups.at(*position).angle))
         {
-            // Hi ha series on les imatges comparteixen el mateix instance number.
-            // Per evitar el problema es fa un insertMulti.
-            imagePositionSet->value(distance)->insertMulti(QString("%1%2%3").arg(image->getInstanceNumber()).arg("0")
-                                                              .arg(image->getFrameNumber()).toULong(), image);
+            *position = planeGroupIndex;
         }
         else
         {
-            instanceNumberSet = new QMap<unsigned long, Image*>();
-            instanceNumberSet->insert(QString("%1%2%3").arg(image->getInstanceNumber()).arg("0").arg(image->getFrameNumber()).toULong(), image);
-            imagePositionSet->insert(distance, instanceNumberSet);
+            volumeInfo.searchablePlaneGroups.insert(position, planeGroupIndex);
         }
     }
-}
 
-void OrderImagesFillerStep::processPhasesPerPositionEvaluation(Image *image)
-{
-    Series *currentSeries = m_input->getCurrentSeries();
-    
-    // Comprovem si tenim hash per la sèrie actual i l'assignem en cas que sigui necessari
-    QHash<int, PhasesPerPositionHashType*> *volumeNumberPhasesPerPositionHash = 0;
-    if (m_phasesPerPositionEvaluation.contains(currentSeries))
-    {
-        volumeNumberPhasesPerPositionHash = m_phasesPerPositionEvaluation.value(currentSeries);
-    }
-    else
-    {
-        volumeNumberPhasesPerPositionHash = new QHash<int, PhasesPerPositionHashType*>();
-        m_phasesPerPositionEvaluation.insert(currentSeries, volumeNumberPhasesPerPositionHash);
-    }
+    volumeInfo.lastNormal = planeNormalVector3D;
+    volumeInfo.lastPlaneGroup = planeGroupIndex;
 
-    // Ara comprovem si el segon hash té l'actual número de volum i li assignem els valors en cas que sigui necessari
-    int currentVolumeNumber = m_input->getCurrentVolumeNumber();
-    PhasesPerPositionHashType *phasesPerPositionHash = 0;
-    if (volumeNumberPhasesPerPositionHash->contains(currentVolumeNumber))
-    {
-        phasesPerPositionHash = volumeNumberPhasesPerPositionHash->value(currentVolumeNumber);
-    }
-    else
-    {
-        phasesPerPositionHash = new PhasesPerPositionHashType;
-        volumeNumberPhasesPerPositionHash->insert(currentVolumeNumber, phasesPerPositionHash);
-    }
+    return planeGroupIndex;
+}
 
-    // Ara ja tenim el hash de les fases per posició corresponent a l'actual sèrie i número de volum
-    // Procedim a inserir la informació corresponent
+void OrderImagesFillerStep::processPhasesPerPositionEvaluation(VolumeInfo &volumeInfo, Image *image)
+{
     const double *imagePositionPatient = image->getImagePositionPatient();
 
     if (!(imagePositionPatient[0] == 0. && imagePositionPatient[1] == 0. && imagePositionPatient[2] == 0.))
@@ -372,42 +204,27 @@ void OrderImagesFillerStep::processPhasesPerPositionEvaluation(Image *image)
                                                                     .arg(imagePositionPatient[1])
                                                                     .arg(imagePositionPatient[2]);
 
-        if (phasesPerPositionHash->contains(imagePositionPatientString))
-        {
-            // Ja el tenim, augmentem el nombre de fases per aquella posició
-            phasesPerPositionHash->insert(imagePositionPatientString, phasesPerPositionHash->value(imagePositionPatientString) + 1);
-        }
-        else
-        {
-            // Creem la nova entrada, inicialment seria la primera fase
-            phasesPerPositionHash->insert(imagePositionPatientString, 1);
-        }
-        // TODO L'if anterior en principi es podria resumir en aquesta sola línia
-        // m_phasesPerPositionHash.insert(imagePositionPatientString, m_phasesPerPositionHash.value(imagePositionPatientString, 0) + 1);
+        // Augmentem el nombre de fases per aquella posició, que inicialment serà la primera fase
+        volumeInfo.phasesPerPosition.insert(imagePositionPatientString, volumeInfo.phasesPerPosition.value(imagePositionPatientString, 0) + 1);
     }
 }
 
 void OrderImagesFillerStep::setOrderedImagesIntoSeries(Series *series)
 {
     QList<Image*> imageSet;
-    QMap<unsigned long, Image*> *instanceNumberSet;
-    QMap<double, QMap<unsigned long, Image*>*> *imagePositionSet;
-    QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*> *orderedImageSet;
-    QMap<double, QMap<double, QMap<double, QMap<unsigned long, Image*>*>*>*> lastOrderedImageSetDistanceAngle;
-    QMap<double, QMap<double, QMap<double, QMap<unsigned long, Image*>*>*>*> lastOrderedImageSetDistanceStack;
-    QMap<double, QMap<double, QMap<unsigned long, Image*>*>*> *lastOrderedImageSetDistance;
-    QMap<int, QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>*> *volumesInSeries;
-
-    Image *currentImage;
-    int orderNumberInVolume;
+    QMap<int, VolumeInfo> volumesInSeries = m_volumesInfo.take(series);
 
-    volumesInSeries = m_orderImagesInternalInfo.take(series);
-
-    foreach (int currentVolumeNumber, volumesInSeries->keys())
+    for (QMap<int, VolumeInfo>::iterator iterator = volumesInSeries.begin(); iterator != volumesInSeries.end(); ++iterator)
     {
+        int currentVolumeNumber = iterator.key();
+        VolumeInfo &volumeInfo = iterator.value();
+
         bool orderByInstanceNumber = false;
         // Diferent número d'imatges per fase
-        if (!m_sameNumberOfPhasesPerPositionPerVolumeInSeriesHash.value(series)->value(currentVolumeNumber))
+        // Si passem la llista de valors a un QSet i aquest té mida 1, vol dir que totes les posicions tenen el mateix nombre de fases
+        // (Un QSet no admet duplicats). S'ha de tenir en compte que si només hi ha una posició amb diferents fases no cal fer res ja que serà correcte
+        QList<int> phasesList = volumeInfo.phasesPerPosition.values();
+        if (phasesList.count() > 1 && phasesList.toSet().count() > 1)
         {
             orderByInstanceNumber = true;
             DEBUG_LOG(QString("No totes les imatges tenen el mateix nombre de fases. Ordenem el volume %1 de la serie %2 per Instance Number").arg(
@@ -416,7 +233,7 @@ void OrderImagesFillerStep::setOrderedImagesIntoSeries(Series *series)
                      currentVolumeNumber).arg(series->getInstanceUID()));
         }
         // Multiple acquisition number
-        if (m_acquisitionNumberEvaluation[series][currentVolumeNumber]->second)
+        if (volumeInfo.multipleAcquisitionNumbers)
         {
             orderByInstanceNumber = true;
             DEBUG_LOG(QString("No totes les imatges tenen el mateix AcquisitionNumber. Ordenem el volume %1 de la serie %2 per Instance Number").arg(
@@ -427,110 +244,152 @@ void OrderImagesFillerStep::setOrderedImagesIntoSeries(Series *series)
 
         if (orderByInstanceNumber)
         {
-            m_orderedNormalsSet = volumesInSeries->take(currentVolumeNumber);
-            QMap<unsigned long, Image*> sortedImagesByInstanceNumber;
+            sortByInstanceNumber(volumeInfo);
+        }
+        else
+        {
+            sortByPosition(volumeInfo);
+        }
 
-            foreach (double key, m_orderedNormalsSet->keys())
-            {
-                orderedImageSet = m_orderedNormalsSet->take(key);
-                foreach (const QString &key, orderedImageSet->keys())
-                {
-                    imagePositionSet = orderedImageSet->take(key);
-                    foreach (double key2, imagePositionSet->keys())
-                    {
-                        instanceNumberSet = imagePositionSet->take(key2);
-                        foreach (unsigned long key3, instanceNumberSet->keys())
-                        {
-                            currentImage = instanceNumberSet->take(key3);
-                            sortedImagesByInstanceNumber.insertMulti(key3, currentImage);
-                        }
-                    }
-                }
-            }
+        int orderNumberInVolume = 0;
 
-            orderNumberInVolume = 0;
+        foreach (const ImageSortKey &sortKey, volumeInfo.images)
+        {
+            sortKey.image->setOrderNumberInVolume(orderNumberInVolume);
+            sortKey.image->setVolumeNumberInSeries(currentVolumeNumber);
+            orderNumberInVolume++;
 
-            foreach (Image *image, sortedImagesByInstanceNumber.values())
-            {
-                image->setOrderNumberInVolume(orderNumberInVolume);
-                image->setVolumeNumberInSeries(currentVolumeNumber);
-                orderNumberInVolume++;
+            imageSet += sortKey.image;
+        }
+    }
+    series->setImages(imageSet);
+}
 
-                imageSet += image;
-            }
+void OrderImagesFillerStep::sortByInstanceNumber(VolumeInfo &volumeInfo)
+{
+    const QVector<PlaneGroup> &planeGroups = volumeInfo.planeGroups;
+
+    // Les imatges amb el mateix instance number queden ordenades per angle decreixent, ordre de creació de l'agrupació, distància decreixent i ordre
+    // de processament, que és l'ordre invers en què les recorria l'estructura de mapes que s'utilitzava abans
+    std::sort(volumeInfo.images.begin(), volumeInfo.images.end(), [&planeGroups](const ImageSortKey &sortKey1, const ImageSortKey &sortKey2)
+    {
+        if (sortKey1.instanceNumberKey != sortKey2.instanceNumberKey)
+        {
+            return sortKey1.instanceNumberKey < sortKey2.instanceNumberKey;
+        }
+
+        double angle1 = planeGroups.at(sortKey1.planeGroup).angle;
+        double angle2 = planeGroups.at(sortKey2.planeGroup).angle;
+        if (angle1 != angle2)
+        {
+            return angle1 > angle2;
+        }
+
+        if (sortKey1.planeGroup != sortKey2.planeGroup)
+        {
+            return sortKey1.planeGroup < sortKey2.planeGroup;
+        }
+
+        if (sortKey1.distance != sortKey2.distance)
+        {
+            return sortKey1.distance > sortKey2.distance;
+        }
+
+        return sortKey1.index < sortKey2.index;
+    });
+}
+
+void OrderImagesFillerStep::sortByPosition(VolumeInfo &volumeInfo)
+{
+    QVector<PlaneGroup> &planeGroups = volumeInfo.planeGroups;
+
+    for (int i = 0; i < planeGroups.size(); i++)
+    {
+        planeGroups[i].minimumDistance = std::numeric_limits<double>::max();
+        planeGroups[i].maximumDistance = -std::numeric_limits<double>::max();
+    }
+
+    foreach (const ImageSortKey &sortKey, volumeInfo.images)
+    {
+        PlaneGroup &planeGroup = planeGroups[sortKey.planeGroup];
+        planeGroup.minimumDistance = qMin(planeGroup.minimumDistance, sortKey.distance);
+        planeGroup.maximumDistance = qMax(planeGroup.maximumDistance, sortKey.distance);
+    }
+
+    // Cal ordenar les agrupacions d'imatges. Si la distància entre la primera i la darrera imatge és de més d'1 mm és un stack, si no és un dels plans
+    // d'una adquisició rotacional
+    QVector<int> stacks;
+    QVector<int> rotationals;
+    for (int i = 0; i < planeGroups.size(); i++)
+    {
+        if (qAbs(planeGroups.at(i).maximumDistance - planeGroups.at(i).minimumDistance) > 1.0)
+        {
+            stacks << i;
         }
         else
         {
-            m_orderedNormalsSet = volumesInSeries->take(currentVolumeNumber);
+            rotationals << i;
+        }
+    }
 
-            // Cal ordernar les agrupacions d'imatges
-            foreach (double angle, m_orderedNormalsSet->keys())
-            {
-                orderedImageSet = m_orderedNormalsSet->take(angle);
-                lastOrderedImageSetDistance = new QMap<double, QMap<double, QMap<unsigned long, Image*>*>*>();
-                bool isRotational = true;
-
-                foreach (const QString &normal, orderedImageSet->keys())
-                {
-                    imagePositionSet = orderedImageSet->take(normal);
-                    
-                    Image *firstImage = (*(*imagePositionSet->begin())->begin());
-                    double distance = Image::distance(firstImage);
-                    lastOrderedImageSetDistance->insertMulti(distance, imagePositionSet);
-
-                    if (imagePositionSet->size() > 1)
-                    {
-                        int pos = (imagePositionSet->size())-1;
-                        double key = imagePositionSet->keys().at(pos);
-                        Image *lastImage = (*(imagePositionSet->value(key))->begin());
-                        double distanceToFirstImage = qAbs(Image::distance(lastImage)-distance);
-                        if (distanceToFirstImage > 1.0) 
-                        {
-                            isRotational = false;
-                        }
-                    }
-                }
-
-                if (isRotational)//Rotacionals
-                {
-                    lastOrderedImageSetDistanceAngle.insertMulti(angle, lastOrderedImageSetDistance);
-                }
-                else //Stacks
-                {
-                    Image *image = (*(*imagePositionSet->begin())->begin());
-                    lastOrderedImageSetDistanceStack.insertMulti(Image::distance(image), lastOrderedImageSetDistance);
-                }
-            }
-            
-            QList<QMap<double, QMap<double, QMap<unsigned long, Image*>*>*>*> orderedSet = lastOrderedImageSetDistanceStack.values();
-            orderedSet.append(lastOrderedImageSetDistanceAngle.values());
-            
-            orderNumberInVolume = 0;
+    // Primer van els stacks ordenats per la distància de la primera imatge i després els rotacionals ordenats per angle
+    std::sort(stacks.begin(), stacks.end(), [&planeGroups](int index1, int index2)
+    {
+        const PlaneGroup &planeGroup1 = planeGroups.at(index1);
+        const PlaneGroup &planeGroup2 = planeGroups.at(index2);
 
-            for (int position = 0; position < orderedSet.size(); position++)
-            {
-                lastOrderedImageSetDistance = orderedSet.value(position);
-                foreach (double key2, lastOrderedImageSetDistance->keys())
-                {
-                    imagePositionSet = lastOrderedImageSetDistance->take(key2);
-                    foreach (double key3, imagePositionSet->keys())
-                    {
-                        instanceNumberSet = imagePositionSet->take(key3);
-                        foreach (unsigned long key4, instanceNumberSet->keys())
-                        {
-                            currentImage = instanceNumberSet->take(key4);
-                            currentImage->setOrderNumberInVolume(orderNumberInVolume);
-                            currentImage->setVolumeNumberInSeries(currentVolumeNumber);
-                            orderNumberInVolume++;
-
-                            imageSet += currentImage;
-                        }
-                    }
-                }
-            }
+        if (planeGroup1.minimumDistance != planeGroup2.minimumDistance)
+        {
+            return planeGroup1.minimumDistance < planeGroup2.minimumDistance;
         }
+
+        if (planeGroup1.angle != planeGroup2.angle)
+        {
+            return planeGroup1.angle > planeGroup2.angle;
+        }
+
+        return index1 < index2;
+    });
+
+    std::sort(rotationals.begin(), rotationals.end(), [&planeGroups](int index1, int index2)
+    {
+        if (planeGroups.at(index1).angle != planeGroups.at(index2).angle)
+        {
+            return planeGroups.at(index1).angle < planeGroups.at(index2).angle;
+        }
+
+        return index1 < index2;
+    });
+
+    int rank = 0;
+    foreach (int index, stacks + rotationals)
+    {
+        planeGroups[index].rank = rank++;
     }
-    series->setImages(imageSet);
+
+    // Dins de cada agrupació, les imatges s'ordenen per distància i instance number. Les que tenen la mateixa distància i instance number queden en
+    // l'ordre invers al de processament.
+    std::sort(volumeInfo.images.begin(), volumeInfo.images.end(), [&planeGroups](const ImageSortKey &sortKey1, const ImageSortKey &sortKey2)
+    {
+        int rank1 = planeGroups.at(sortKey1.planeGroup).rank;
+        int rank2 = planeGroups.at(sortKey2.planeGroup).rank;
+        if (rank1 != rank2)
+        {
+            return rank1 < rank2;
+        }
+
+        if (sortKey1.distance != sortKey2.distance)
+        {
+            return sortKey1.distance < sortKey2.distance;
+        }
+
+        if (sortKey1.instanceNumberKey != sortKey2.instanceNumberKey)
+        {
+            return sortKey1.instanceNumberKey < sortKey2.instanceNumberKey;
+        }
+
+        return sortKey1.index > sortKey2.index;
+    });
 }
 
 }
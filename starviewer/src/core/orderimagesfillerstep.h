@@ -19,6 +19,7 @@
 #include <QMap>
 #include <QHash>
 #include <QString>
+#include <QVector>
 #include <QVector3D>
 
 namespace udg {
@@ -30,6 +31,9 @@ class Image;
 /**
     Mòdul que s'encarrega d'ordenar correctament les imatges de les sèries. Un dels seus requisits és que es tingui l'etiqueta de DICOMClassified,
     la ImageFillerStep i el TemporalDimensionFillerStep.
+
+    Per cada subvolum es guarda una clau d'ordenació compacta per imatge (agrupació de plans, distància i instance number) i al post processat
+    s'ordenen totes amb una sola ordenació.
   */
 class OrderImagesFillerStep : public PatientFillerStep {
 public:
@@ -42,43 +46,83 @@ public:
     void postProcessing();
 
 private:
+    /// Agrupació de les imatges d'un subvolum que tenen la mateixa normal del pla: un stack o un dels plans d'una adquisició rotacional.
+    struct PlaneGroup
+    {
+        /// Normal del pla com a string amb 5 decimals, que és com es comparen les normals.
+        QString normalString;
+        /// Normal del pla obtinguda de normalString.
+        QVector3D normal;
+        /// Angle de la normal respecte la normal de la primera agrupació del subvolum.
+        double angle;
+        /// Distàncies mínima i màxima de les imatges de l'agrupació, calculades al post processat.
+        double minimumDistance;
+        double maximumDistance;
+        /// Posició de l'agrupació en l'ordre final, calculada al post processat.
+        int rank;
+    };
+
+    /// Clau d'ordenació d'una imatge.
+    struct ImageSortKey
+    {
+        Image *image;
+        /// Índex de l'agrupació de plans de la imatge.
+        int planeGroup;
+        double distance;
+        /// Instance number i número de frame concatenats amb un 0 entremig.
+        unsigned long instanceNumberKey;
+        /// Ordre en què s'ha processat la imatge dins del subvolum.
+        int index;
+    };
+
+    /// Tipus per definir un hash per comptar les fases corresponents a cada posició
+    /// La clau del hash és un string amb la posició de la imatge (ImagePositionPatient) i el valor associat compta les ocurrències (fases) d'aquesta posició.
+    /// Si tenim igual nombre de fases a totes les posicions, podem dir que és un volum amb fases
+    typedef QHash<QString, int> PhasesPerPositionHashType;
+
+    /// Informació d'ordenació d'un subvolum d'una sèrie.
+    struct VolumeInfo
+    {
+        /// Agrupacions de plans en ordre de creació.
+        QVector<PlaneGroup> planeGroups;
+        /// Agrupacions on es busquen les normals de les noves imatges, ordenades per angle. Si dues agrupacions tenen el mateix angle només hi és la
+        /// darrera que s'ha creat.
+        QVector<int> searchablePlaneGroups;
+        /// Claus d'ordenació de les imatges en ordre de processament.
+        QVector<ImageSortKey> images;
+        /// Normal de la darrera imatge processada i la seva agrupació, per no haver de buscar-la per cada imatge d'un stack.
+        QVector3D lastNormal;
+        int lastPlaneGroup;
+        /// Nombre de fases per posició, per decidir al post processat si el subvolum s'ha d'ordenar per instance number.
+        PhasesPerPositionHashType phasesPerPosition;
+        /// Acquisition number de la primera imatge i si n'hi ha de diferents. En cas que n'hi hagi, el subvolum s'ordena per instance number.
+        QString firstAcquisitionNumber;
+        bool multipleAcquisitionNumbers;
+    };
+
     /// Mètodes per processar la informació específica de series
-    void processImage(Image *image);
+    void processImage(VolumeInfo &volumeInfo, Image *image);
+
+    /// Retorna l'índex de l'agrupació de plans a la qual pertany una imatge amb la normal donada, creant-la si no existeix.
+    int getPlaneGroup(VolumeInfo &volumeInfo, const QVector3D &planeNormalVector3D);
 
     /// Mètode per calcular quantes fases per posició té realment cada imatge dins de cada sèrie i subvolum.
-    void processPhasesPerPositionEvaluation(Image *image);
-    
-    /// Mètode que transforma l'estructura d'imatges ordenades a una llista i l'insereix a la sèrie.
+    void processPhasesPerPositionEvaluation(VolumeInfo &volumeInfo, Image *image);
+
+    /// Mètode que ordena les imatges de cada subvolum i les insereix a la sèrie.
     void setOrderedImagesIntoSeries(Series *series);
 
-    //  Angle       NormalVector    Distance    InstanceNumber0FrameNumber
-    QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*> *m_orderedNormalsSet;
+    /// Ordena les imatges del subvolum per instance number.
+    void sortByInstanceNumber(VolumeInfo &volumeInfo);
+
+    /// Ordena les imatges del subvolum per agrupació de plans, distància i instance number.
+    void sortByPosition(VolumeInfo &volumeInfo);
 
-    //    Series        Volume     Angle     NormalVector    Distance  InstanceNumber0FrameNumber
-    QHash<Series*, QMap<int, QMap<double, QMap<QString, QMap<double, QMap<unsigned long, Image*>*>*>*>*>*> m_orderImagesInternalInfo;
-   
-    //    Series       Volume     AcqNumber MultipleAcqNumbers?
-    QHash<Series*, QHash<int, QPair<QString, bool>*> > m_acquisitionNumberEvaluation;
+    //    Series       Volume
+    QHash<Series*, QMap<int, VolumeInfo> > m_volumesInfo;
 
     QVector3D m_firstPlaneVector3D;
     QVector3D m_direction;
-
-    /// Tipus per definir un hash per comptar les fases corresponents a cada posició
-    /// La clau del hash és un string amb la posició de la imatge (ImagePositionPatient) i el valor associat compta les ocurrències (fases) d'aquesta posició.
-    /// Si tenim igual nombre de fases a totes les posicions, podem dir que és un volum amb fases
-    typedef QHash<QString, int> PhasesPerPositionHashType;
-
-    /// Hash en el que per cada sèrie, mapejem un hash que indica per cada volume number, quantes fases per posició té
-    /// Aquest ens servirà en el post processat per decidir quins subvolums s'han d'ordenar per instance number 
-    /// en cas que no totes les imatges d'un mateix subvolum no tinguin el mateix nombre de fases
-    /// <Sèrie, <VolumeNumber, <PhasesPerPositionHash> > >
-    QHash<Series*, QHash<int, PhasesPerPositionHashType*>*> m_phasesPerPositionEvaluation;
-
-    /// Hash amb que per cada sèrie mapejem un hash on s'indica per cada número de subvolum, si totes les posicions tenen el mateix nombre de fases.
-    /// En cas que no, cal ordenar el corresponent subvolum per instance number com en el cas dels m_acquisitionNumberEvaluation
-    /// TODO Potser amb aquesta avaluació seria suficient i la que es fa per Acquisition Number es podria eliminar
-    /// <Sèrie, <VolumeNumber, SameNumberOfPhasesPerPosition?> >
-    QHash<Series*, QHash<int, bool>*> m_sameNumberOfPhasesPerPositionPerVolumeInSeriesHash;
 };
 
 }
@@ -23,6 +23,8 @@
 #include "volume.h"
 #include "volumerepository.h"
 #include "screenmanager.h"
+#include "thumbnailcreator.h"
+#include "thumbnailservice.h"
 
 #include "patientbrowsermenugroup.h"
 
@@ -38,6 +40,8 @@ PatientBrowserMenu::PatientBrowserMenu(QWidget *parent)
     m_currentScreenID = m_leftScreenID = m_rightScreenID = -1;
 
     m_showFusionOptions = false;
+
+    connect(ThumbnailService::instance(), SIGNAL(thumbnailReady(QString, QImage)), SLOT(updateItemThumbnail(QString, QImage)));
 }
 
 PatientBrowserMenu::~PatientBrowserMenu()
@@ -164,7 +168,7 @@ void PatientBrowserMenu::updateActiveItemView(const QString &identifier)
             {
                 // Actualitzem les dades de l'item amb informació adicional
                 PatientBrowserMenuExtendedItem *item = new PatientBrowserMenuExtendedItem(m_patientAdditionalInfo);
-                item->setPixmap(volume->getThumbnail());
+                setVolumeThumbnail(volume, item);
                 Series *series = volume->getImage(0)->getParentSeries();
                 item->setText(QString(tr("%1\n%2\n%3\n%4 Images"))
                               .arg(series->getDescription().trimmed())
@@ -185,7 +189,7 @@ void PatientBrowserMenu::updateActiveItemView(const QString &identifier)
         {
             // Actualitzem les dades de l'item amb informació adicional
             PatientBrowserMenuExtendedItem *item = new PatientBrowserMenuExtendedItem(m_patientAdditionalInfo);
-            item->setPixmap(volume->getThumbnail());
+            setVolumeThumbnail(volume, item);
             Series *series = volume->getImage(0)->getParentSeries();
             item->setText(QString(tr("%1\n%2\n%3\n%4 Images"))
                                             .arg(series->getDescription().trimmed())
@@ -397,6 +401,56 @@ void PatientBrowserMenu::placeAdditionalInfoWidget()
     m_patientAdditionalInfo->move(menuXPosition + menuXShift, menuYPosition);
 }
 
+void PatientBrowserMenu::setVolumeThumbnail(Volume *volume, PatientBrowserMenuExtendedItem *item)
+{
+    QList<Image*> images = volume->getImages();
+    if (volume->getThumbnail().isNull() && !images.isEmpty())
+    {
+        // El thumbnail del volum és el de la seva imatge del mig
+        ThumbnailService *thumbnailService = ThumbnailService::instance();
+        QString thumbnailKey = thumbnailService->requestThumbnail(images.at(images.count() / 2), ThumbnailService::HighPriority);
+
+        QImage thumbnail;
+        if (thumbnailService->getThumbnail(thumbnailKey, thumbnail))
+        {
+            volume->setThumbnail(QPixmap::fromImage(thumbnail));
+        }
+        else
+        {
+            ItemWaitingForThumbnail itemWaitingForThumbnail;
+            itemWaitingForThumbnail.volume = volume;
+            itemWaitingForThumbnail.item = item;
+            m_itemsWaitingForThumbnail.insert(thumbnailKey, itemWaitingForThumbnail);
+            item->setPixmap(QPixmap::fromImage(ThumbnailCreator::makeEmptyThumbnailWithCustomText(tr("Loading..."), 100)));
+            return;
+        }
+    }
+
+    item->setPixmap(volume->getThumbnail());
+}
+
+void PatientBrowserMenu::updateItemThumbnail(const QString &thumbnailKey, const QImage &thumbnail)
+{
+    if (!m_itemsWaitingForThumbnail.contains(thumbnailKey))
+    {
+        return;
+    }
+
+    ItemWaitingForThumbnail itemWaitingForThumbnail = m_itemsWaitingForThumbnail.take(thumbnailKey);
+    QPixmap pixmap = QPixmap::fromImage(thumbnail);
+
+    // El volum es queda el thumbnail perquè no s'hagi de tornar a demanar
+    if (itemWaitingForThumbnail.volume)
+    {
+        itemWaitingForThumbnail.volume->setThumbnail(pixmap);
+    }
+
+    if (itemWaitingForThumbnail.item)
+    {
+        itemWaitingForThumbnail.item->setPixmap(pixmap);
+    }
+}
+
 void PatientBrowserMenu::processSelectedItem(const QString &identifier)
 {
     m_patientAdditionalInfo->hide();
@@ -16,6 +16,8 @@
 #define UDGPATIENTBROWERMENU_H
 
 #include <QWidget>
+#include <QHash>
+#include <QPointer>
 
 class QPoint;
 
@@ -24,6 +26,7 @@ namespace udg {
 class Patient;
 class Volume;
 class PatientBrowserMenuExtendedInfo;
+class PatientBrowserMenuExtendedItem;
 class PatientBrowserMenuList;
 
 /**
@@ -59,6 +62,9 @@ private slots:
     /// En aquest cas s'encarrega d'obtenir el volum seleccionat per l'usuari i notificar-ho
     void processSelectedItem(const QString &identifier);
 
+    /// Posa el thumbnail generat a l'ítem que l'esperava, si encara existeix
+    void updateItemThumbnail(const QString &thumbnailKey, const QImage &thumbnail);
+
 private:
     /// Crea els widgets dels que es composa el menú
     void createWidgets();
@@ -74,6 +80,10 @@ private:
     /// Col·loca el widget d'informació adicional all lloc més adient depenent de la posició del menú principal
     void placeAdditionalInfoWidget();
 
+    /// Assigna el thumbnail del volum a l'ítem. Si encara no està generat en demana la generació amb prioritat alta i hi posa un thumbnail provisional
+    /// que se substituirà quan estigui llest
+    void setVolumeThumbnail(Volume *volume, PatientBrowserMenuExtendedItem *item);
+
 private:
     /// Atribut que guarda el punter al menú basic que representa les dades del pacient
     PatientBrowserMenuList *m_patientBrowserList;
@@ -81,6 +91,15 @@ private:
     /// Atribut que guarda el punter al menú amb informació addicional de l'ítem seleccionat
     PatientBrowserMenuExtendedInfo *m_patientAdditionalInfo;
 
+    /// Ítem que espera el thumbnail del seu volum. Quan arriba el thumbnail s'assigna a tots dos, si encara existeixen
+    struct ItemWaitingForThumbnail {
+        QPointer<Volume> volume;
+        QPointer<PatientBrowserMenuExtendedItem> item;
+    };
+
+    /// Ítems que esperen el seu thumbnail, per la clau del thumbnail al ThumbnailService. Els ítems s'esborren cada cop que canvia l'ítem actiu
+    QHash<QString, ItemWaitingForThumbnail> m_itemsWaitingForThumbnail;
+
     /// Identificadors de les pantalles respecte on es troba desplegat el menú
     /// L'ID de la pantalla actual, i les pantalles annexes, es calcularà cada cop que es faci el popup del menú
     int m_currentScreenID;
@@ -29,6 +29,10 @@
 #include "temporaldimensionfillerstep.h"
 #include "volumefillerstep.h"
 
+#include <QQueue>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
 namespace udg {
 
 namespace {
@@ -39,6 +43,13 @@ bool containsMHDFiles(const QStringList &files)
     return !files.isEmpty() && files.first().endsWith(".mhd", Qt::CaseInsensitive);
 }
 
+// Reads the given DICOM file. It's executed in the global thread pool.
+// Only the metadata is needed to fill the patient, so big values such as the pixel data are not loaded unless a step asks for them.
+DICOMTagReader* readDICOMFile(const QString &file)
+{
+    return new DICOMTagReader(file, DICOMTagReader::LoadMetadataOnly);
+}
+
 }
 
 PatientFiller::PatientFiller(DICOMSource dicomSource, QObject *parent)
@@ -162,11 +173,24 @@ QList<Patient*> PatientFiller::processMHDFiles(const QStringList &files)
 
 QList<Patient*> PatientFiller::processDICOMFiles(const QStringList &files)
 {
-    foreach (const QString &dicomFile, files)
+    // Reading and parsing the files is the most expensive part of the first stage, so it's done in parallel ahead of the steps.
+    // The steps share the patients, studies and series being built, so they are executed in this thread in the order of the files,
+    // which gives the same result as processing the files one after another.
+    // The number of files read ahead is bounded to keep only a few parsed files in memory at the same time.
+    const int maximumNumberOfFilesReadAhead = 4 * qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    QQueue<QFuture<DICOMTagReader*>> pendingFiles;
+    int nextFileToRead = 0;
+
+    while (nextFileToRead < files.size() || !pendingFiles.isEmpty())
     {
+        while (nextFileToRead < files.size() && pendingFiles.size() < maximumNumberOfFilesReadAhead)
+        {
+            pendingFiles.enqueue(QtConcurrent::run(readDICOMFile, files.at(nextFileToRead)));
+            nextFileToRead++;
+        }
+
         // The DICOMTagReader is deleted by the PatientFillerInput
-        DICOMTagReader *dicomTagReader = new DICOMTagReader(dicomFile);
-        this->processDICOMFile(dicomTagReader);
+        this->processDICOMFile(pendingFiles.dequeue().result());
     }
 
     this->finishDICOMFilesProcess();
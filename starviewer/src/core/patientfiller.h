@@ -69,6 +69,7 @@ private:
     QList<Patient*> processMHDFiles(const QStringList &files);
 
     /// Processes the given DICOM files and returns the generated patients.
+    /// The files are read in parallel, but the steps are executed in the order of the list in the calling thread.
     QList<Patient*> processDICOMFiles(const QStringList &files);
 
 private:
@@ -46,6 +46,7 @@
 // Qt
 #include <QResizeEvent>
 // Include's bàsics vtk
+#include <vtkImageData.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
@@ -59,20 +60,32 @@
 
 namespace udg {
 
+namespace {
+
+// Nombre de llesques a cada costat de l'actual de les quals es carreguen els overlays per endavant
+const int OverlaysPrefetchSlices = 2;
+// Nombre màxim de llesques de les quals es mantenen els overlays carregats
+const int MaximumNumberOfSlicesWithLoadedOverlays = 16;
+
+}
+
 const QString Q2DViewer::OverlaysDrawerGroup("Overlays");
 const QString Q2DViewer::DummyVolumeObjectName("Dummy Volume");
 
 Q2DViewer::Q2DViewer(QWidget *parent)
 : QViewer(parent), m_overlayVolume(0), m_blender(0), m_overlapMethod(Q2DViewer::Blend), m_rotateFactor(0), m_applyFlip(false),
-  m_isImageFlipped(false), m_slabProjectionMode(AccumulatorFactory::Maximum), m_fusionBalance(50)
+  m_isImageFlipped(false), m_slabProjectionMode(AccumulatorFactory::Maximum),
+  m_recentlyUsedOverlaySlices(MaximumNumberOfSlicesWithLoadedOverlays), m_fusionBalance(50)
 {
     m_displayUnitsFactory = new VolumeDisplayUnitHandlerFactory;
     initializeDummyDisplayUnit();
     m_volumeReaderManager = new VolumeReaderManager(this);
+    m_firstSliceToLoad = -1;
     m_inputFinishedCommand = NULL;
 
     connect(m_volumeReaderManager, SIGNAL(readingFinished()), SLOT(volumeReaderJobFinished()));
     connect(m_volumeReaderManager, SIGNAL(progress(int)), m_workInProgressWidget, SLOT(updateProgress(int)));
+    connect(m_volumeReaderManager, SIGNAL(sliceLoaded(int, int)), SLOT(updateLoadingPreview(int, int)));
     connect(m_patientBrowserMenu, SIGNAL(selectedVolumes(QList<Volume*>)), this, SLOT(setInputAndRender(QList<Volume*>)));
 
     // Creem anotacions i actors
@@ -483,7 +496,9 @@ void Q2DViewer::loadVolumesAsynchronously(const QList<Volume*> &volumes)
 {
     setViewerStatus(LoadingVolume);
 
-    m_volumeReaderManager->readVolumes(volumes);
+    // When loading progressively, start from the slice that will be shown when the volume is loaded
+    m_firstSliceToLoad = Settings().getValue(CoreSettings::AllowProgressiveVolumeLoading).toBool() ? getFirstSliceToShow(volumes.first()) : -1;
+    m_volumeReaderManager->readVolumes(volumes, m_firstSliceToLoad);
 
     // TODO: De moment no tenim cap més remei que especificar un volume fals. La resta del viewer (i els que en depenen) s'esperen
     // tenir un volum carregat després de cridar a setInput.
@@ -498,6 +513,15 @@ void Q2DViewer::loadVolumesAsynchronously(const QList<Volume*> &volumes)
     setNewVolumes(dummies, false);
 }
 
+int Q2DViewer::getFirstSliceToShow(Volume *volume) const
+{
+    // The command executed once the input is set may choose the slice, e.g. the one of a hanging protocol display set
+    int slice = m_inputFinishedCommand ? m_inputFinishedCommand->getSliceToShow(volume) : -1;
+
+    // Otherwise resetViewToAcquisitionPlane() shows slice 0 of the first phase, which is the first slice of the volume data
+    return slice >= 0 ? slice : 0;
+}
+
 void Q2DViewer::volumeReaderJobFinished()
 {
     if (m_volumeReaderManager->readingSuccess())
@@ -511,6 +535,67 @@ void Q2DViewer::volumeReaderJobFinished()
     }
 }
 
+void Q2DViewer::updateLoadingPreview(int volumeIndex, int slice)
+{
+    // Fusion inputs are only shown when all the volumes have been loaded
+    if (volumeIndex != 0 || m_volumeReaderManager->getNumberOfVolumesToRead() != 1)
+    {
+        return;
+    }
+
+    if (!Settings().getValue(CoreSettings::AllowProgressiveVolumeLoading).toBool())
+    {
+        return;
+    }
+
+    vtkSmartPointer<vtkImageData> previewData = m_volumeReaderManager->getPreviewData(volumeIndex);
+
+    if (!previewData)
+    {
+        return;
+    }
+
+    if (m_loadingPreviewVolume.isNull() || m_loadingPreviewVolume->getVtkData() != previewData)
+    {
+        // First loaded slice, or the reader has started again with a new buffer. The pending slices are blank until they are loaded.
+        Volume *volume = m_volumeReaderManager->getVolumeToRead(volumeIndex);
+        Volume *previewVolume = new Volume(this);
+        previewVolume->setObjectName(DummyVolumeObjectName);
+        previewVolume->setImages(volume->getImages());
+        previewVolume->setNumberOfPhases(volume->getNumberOfPhases());
+        previewVolume->setNumberOfSlicesPerPhase(volume->getNumberOfSlicesPerPhase());
+        previewVolume->setIdentifier(volume->getIdentifier());
+        previewVolume->setData(previewData);
+
+        setNewVolumes(QList<Volume*>() << previewVolume);
+        m_loadingPreviewVolume = previewVolume;
+
+        // Show the slice that is loaded first, which is the one that will be shown when the volume is loaded
+        int numberOfPhases = previewVolume->getNumberOfPhases();
+        if (getCurrentViewPlane() == OrthogonalPlane::XYPlane && m_firstSliceToLoad >= 0)
+        {
+            if (getCurrentPhase() != m_firstSliceToLoad % numberOfPhases)
+            {
+                setPhase(m_firstSliceToLoad % numberOfPhases);
+            }
+            if (getCurrentSlice() != m_firstSliceToLoad / numberOfPhases)
+            {
+                setSlice(m_firstSliceToLoad / numberOfPhases);
+            }
+        }
+    }
+    else
+    {
+        // The buffer has been written by the reader, so the pipeline must be executed again
+        previewData->Modified();
+
+        if (getCurrentViewPlane() == OrthogonalPlane::XYPlane && slice / m_loadingPreviewVolume->getNumberOfPhases() == getCurrentSlice())
+        {
+            render();
+        }
+    }
+}
+
 void Q2DViewer::setNewVolumesAndExecuteCommand(const QList<Volume*> &volumes)
 {
     try
@@ -587,6 +672,7 @@ void Q2DViewer::setNewVolumes(const QList<Volume*> &volumes, bool setViewerStatu
     // Init new input
     removeImageActors();
     m_displayUnitsHandler = m_displayUnitsFactory->createVolumeDisplayUnitHandler(volumes);
+    setDisplayedVolumes(volumes);
 
     getDisplayUnit(0)->setVoiLutData(getVoiLutData());
     for (int i = 1; i < getNumberOfInputs(); i++)
@@ -609,9 +695,7 @@ void Q2DViewer::setNewVolumes(const QList<Volume*> &volumes, bool setViewerStatu
 
     m_annotationsHandler->updateAnnotations(MainInformationAnnotation | AdditionalInformationAnnotation);
 
-    loadOverlays(volumes.first());
-
-    // Reset the view to the acquisition plane
+    // Reset the view to the acquisition plane. This also loads the overlays of the slice that is shown
     resetViewToAcquisitionPlane();
 
     // HACK
@@ -626,75 +710,113 @@ void Q2DViewer::setNewVolumes(const QList<Volume*> &volumes, bool setViewerStatu
 void Q2DViewer::removeViewerBitmaps()
 {
     // Eliminem els bitmaps que teníem fins ara
-    foreach (DrawerBitmap *bitmap, m_viewerBitmaps)
+    foreach (int sliceIndex, m_overlayBitmapsBySlice.keys())
     {
-        bitmap->decreaseReferenceCount();
-        delete bitmap;
+        removeOverlayBitmaps(sliceIndex);
     }
-    m_viewerBitmaps.clear();
+    m_recentlyUsedOverlaySlices.clear();
 }
 
-void Q2DViewer::loadOverlays(Volume *volume)
+void Q2DViewer::loadOverlaysAroundCurrentSlice()
 {
-    if (!volume)
+    Volume *volume = getMainInput();
+
+    if (!volume || volume->objectName() == DummyVolumeObjectName)
     {
         return;
     }
 
-    if (volume->objectName() == DummyVolumeObjectName)
+    // Els overlays només es dibuixen en el pla d'adquisició
+    if (getCurrentViewPlane() != OrthogonalPlane::XYPlane)
     {
         return;
     }
 
+    // Amb el thick slab no es dibuixen overlays perquè no es poden associar a l'slab. S'alliberen tots per no mostrar els de llesques concretes
+    if (isThickSlabActive())
+    {
+        removeViewerBitmaps();
+        return;
+    }
+
+    bool overlaysHaveBeenCreated = false;
+
+    foreach (int sliceIndex, m_recentlyUsedOverlaySlices.useSlicesAround(getCurrentSlice(), OverlaysPrefetchSlices, volume->getNumberOfSlicesPerPhase()))
+    {
+        if (!m_overlayBitmapsBySlice.contains(sliceIndex))
+        {
+            QList<DrawerBitmap*> bitmaps = createOverlayBitmaps(volume, sliceIndex);
+            overlaysHaveBeenCreated = overlaysHaveBeenCreated || !bitmaps.isEmpty();
+            // Les llesques sense overlays també es guarden per no haver-les de tornar a consultar
+            m_overlayBitmapsBySlice.insert(sliceIndex, bitmaps);
+        }
+    }
+
+    foreach (int sliceIndex, m_recentlyUsedOverlaySlices.takeLeastRecentlyUsedSlices())
+    {
+        removeOverlayBitmaps(sliceIndex);
+    }
+
+    if (overlaysHaveBeenCreated && !m_overlaysAreEnabled)
+    {
+        showImageOverlays(m_overlaysAreEnabled);
+    }
+}
+
+QList<DrawerBitmap*> Q2DViewer::createOverlayBitmaps(Volume *volume, int sliceIndex)
+{
+    QList<DrawerBitmap*> bitmaps;
+
     double volumeSpacing[3];
     volume->getSpacing(volumeSpacing);
     double volumeOrigin[3];
     volume->getOrigin(volumeOrigin);
-    
-    int numberOfSlices = volume->getNumberOfSlicesPerPhase();
+
+    // Calculem l'origen del bitmap corresponent a aquesta llesca
+    double imageOrigin[3];
+    imageOrigin[0] = volumeOrigin[0];
+    imageOrigin[1] = volumeOrigin[1];
+    imageOrigin[2] = volumeOrigin[2] + sliceIndex * volumeSpacing[2];
+
     int numberOfPhases = volume->getNumberOfPhases();
-    for (int sliceIndex = 0; sliceIndex < numberOfSlices; ++sliceIndex)
+    for (int phaseIndex = 0; phaseIndex < numberOfPhases; ++phaseIndex)
     {
-        for (int phaseIndex = 0; phaseIndex < numberOfPhases; ++ phaseIndex)
+        Image *image = volume->getImage(sliceIndex, phaseIndex);
+        if (!image)
         {
-            Image *image = volume->getImage(sliceIndex, phaseIndex);
-            if (!image)
-            {
-                ERROR_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
-                    .arg(sliceIndex).arg(phaseIndex));
-                DEBUG_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
-                    .arg(sliceIndex).arg(phaseIndex));
-            }
-            else
+            ERROR_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
+                .arg(sliceIndex).arg(phaseIndex));
+            DEBUG_LOG(QString("Error inesperat intentant accedir a la imatge amb índexs: %1(slice), %2(phase) del volum actual")
+                .arg(sliceIndex).arg(phaseIndex));
+        }
+        else if (image->hasOverlays())
+        {
+            // Creem els bitmaps
+            foreach (const ImageOverlay &overlay, image->getOverlaysSplit())
             {
-                if (image->hasOverlays())
-                {
-                    // Calculem l'origen del bitmap corresponent a aquesta imatge
-                    double imageOrigin[3];
-                    imageOrigin[0] = volumeOrigin[0];
-                    imageOrigin[1] = volumeOrigin[1];
-                    imageOrigin[2] = volumeOrigin[2] + sliceIndex * volumeSpacing[2];
-                    // Creem els bitmaps
-                    foreach(const ImageOverlay &overlay, image->getOverlaysSplit())
-                    {
-                        DrawerBitmap *overlayBitmap = overlay.getAsDrawerBitmap(imageOrigin, volumeSpacing);
-                        // Inicialment no serà, segons la llesca en que ens trobem el Drawer decidirà sobre la seva visibilitat
-                        overlayBitmap->setVisibility(false);
-                        // La primitiva no es podrà esborrar amb les tools
-                        overlayBitmap->setErasable(false);
-                        overlayBitmap->increaseReferenceCount();
-                        getDrawer()->draw(overlayBitmap, OrthogonalPlane::XYPlane, sliceIndex);
-                        getDrawer()->addToGroup(overlayBitmap, OverlaysDrawerGroup);
-                        m_viewerBitmaps << overlayBitmap;
-                    }
-                }
+                DrawerBitmap *overlayBitmap = overlay.getAsDrawerBitmap(imageOrigin, volumeSpacing);
+                // Inicialment no serà, segons la llesca en que ens trobem el Drawer decidirà sobre la seva visibilitat
+                overlayBitmap->setVisibility(false);
+                // La primitiva no es podrà esborrar amb les tools
+                overlayBitmap->setErasable(false);
+                overlayBitmap->increaseReferenceCount();
+                getDrawer()->draw(overlayBitmap, OrthogonalPlane::XYPlane, sliceIndex);
+                getDrawer()->addToGroup(overlayBitmap, OverlaysDrawerGroup);
+                bitmaps << overlayBitmap;
             }
         }
     }
 
-    if (!m_overlaysAreEnabled)
+    return bitmaps;
+}
+
+void Q2DViewer::removeOverlayBitmaps(int sliceIndex)
+{
+    // En esborrar-los, els bitmaps avisen al Drawer perquè deixi de pintar-los
+    foreach (DrawerBitmap *bitmap, m_overlayBitmapsBySlice.take(sliceIndex))
     {
-        showImageOverlays(m_overlaysAreEnabled);
+        bitmap->decreaseReferenceCount();
+        delete bitmap;
     }
 }
 
@@ -993,6 +1115,7 @@ void Q2DViewer::updateSliceToDisplay(int value, SliceDimension dimension)
         if (dimension == SpatialDimension)
         {
             m_annotationsHandler->updateAnnotations();
+            loadOverlaysAroundCurrentSlice();
 
             if (isThickSlabActive())
             {
@@ -1544,6 +1667,7 @@ void Q2DViewer::setSlabThickness(int thickness)
 
         mainDisplayUnit->setSlabThickness(thickness);
         updateImageSlices();
+        loadOverlaysAroundCurrentSlice();
 
         updateCurrentImageDefaultPresetsInAllInputsOnOriginalAcquisitionPlane();
         m_annotationsHandler->updateAnnotations(MainInformationAnnotation | AdditionalInformationAnnotation | SliceAnnotation);
@@ -18,7 +18,9 @@
 #include "qviewer.h"
 #include "annotationflags.h"
 #include "anatomicalplane.h"
+#include "recentlyusedslices.h"
 
+#include <QHash>
 #include <QPointer>
 
 // Fordward declarations
@@ -475,6 +477,9 @@ private:
     void loadVolumeAsynchronously(Volume *volume);
     void loadVolumesAsynchronously(const QList<Volume *> &volumes);
 
+    /// Returns the index in the data of the given volume of the slice that will be shown when it is set as input
+    int getFirstSliceToShow(Volume *volume) const;
+
     /// Retorna un volum "dummy"
     Volume* getDummyVolumeFromVolume(Volume *volume);
 
@@ -496,8 +501,16 @@ private:
     /// Elimina els bitmaps que s'hagin creat per aquest viewer
     void removeViewerBitmaps();
     
-    /// Carrega en memòria els ImageOverlays del volum passat per paràmetre (sempre que no sigui un dummy) i els afegeix al Drawer
-    void loadOverlays(Volume *volume);
+    /// Carrega els ImageOverlays de la llesca actual del volum principal i de les seves veïnes, si no s'han carregat ja, i els afegeix al Drawer.
+    /// Només es mantenen els overlays de les darreres llesques visitades, els de la resta s'alliberen. Amb el thick slab actiu no es mostren overlays, ja que
+    /// no es poden associar a l'slab, i s'alliberen tots
+    void loadOverlaysAroundCurrentSlice();
+
+    /// Crea els bitmaps dels ImageOverlays de totes les fases de la llesca indicada del volum donat i els afegeix al Drawer
+    QList<DrawerBitmap*> createOverlayBitmaps(Volume *volume, int sliceIndex);
+
+    /// Allibera els bitmaps dels overlays de la llesca indicada
+    void removeOverlayBitmaps(int sliceIndex);
 
     /// Enum to define the different dimensions an image slice could be associated to
     enum SliceDimension { SpatialDimension, TemporalDimension };
@@ -530,6 +543,10 @@ private slots:
 
     void volumeReaderJobFinished();
 
+    /// Called when a slice of a volume being read has been loaded. If progressive loading is allowed, the first time it replaces the dummy volume by a preview
+    /// volume that shares the buffer being filled, and afterwards it renders again when the loaded slice is the one being shown.
+    void updateLoadingPreview(int volumeIndex, int slice);
+
 protected:
     /// Aquest és el segon volum afegit a solapar
     Volume *m_overlayVolume;
@@ -574,10 +591,17 @@ private:
     /// Manager of the reading of volumes
     VolumeReaderManager *m_volumeReaderManager;
 
+    /// Volume shown while the main volume is being loaded progressively. It's a dummy, so it's deleted when the loaded volume is set.
+    QPointer<Volume> m_loadingPreviewVolume;
+
+    /// Index in the volume data of the slice that is loaded first when loading progressively, or -1 if the volumes are not loaded progressively
+    int m_firstSliceToLoad;
+
     QViewerCommand *m_inputFinishedCommand;
 
-    /// Llistat d'overlays
-    QList<DrawerBitmap*> m_viewerBitmaps;
+    /// Bitmaps dels overlays carregats, per llesca, i llesques amb overlays carregats ordenades de la visitada fa més temps a la més recent
+    QHash<int, QList<DrawerBitmap*> > m_overlayBitmapsBySlice;
+    RecentlyUsedSlices m_recentlyUsedOverlaySlices;
 
     /// Controla si els overlays estan habilitats o no
     bool m_overlaysAreEnabled;
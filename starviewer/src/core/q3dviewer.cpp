@@ -393,6 +393,7 @@ void Q3DViewer::setInput(Volume *volume)
         m_clippingPlanes = 0;
     }
     m_mainVolume = volume;
+    setDisplayedVolumes(QList<Volume*>() << volume);
 
     setVolumeTransformation();
 
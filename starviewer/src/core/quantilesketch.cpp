@@ -0,0 +1,145 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "quantilesketch.h"
+
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+#include <functional>
+
+namespace udg {
+
+namespace {
+
+// Values whose absolute value is below this one are counted as zero
+const double MinimumIndexableValue = 1.0e-9;
+
+}
+
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+{
+    m_gamma = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+    m_logGamma = qLn(m_gamma);
+    clear();
+}
+
+void QuantileSketch::clear()
+{
+    m_positiveCounts.clear();
+    m_negativeCounts.clear();
+    m_zeroCount = 0;
+    m_count = 0;
+    m_minimum = 0.0;
+    m_maximum = 0.0;
+}
+
+void QuantileSketch::add(double value)
+{
+    if (value >= MinimumIndexableValue)
+    {
+        ++m_positiveCounts[getKey(value)];
+    }
+    else if (value <= -MinimumIndexableValue)
+    {
+        ++m_negativeCounts[getKey(-value)];
+    }
+    else
+    {
+        ++m_zeroCount;
+    }
+
+    if (m_count == 0)
+    {
+        m_minimum = m_maximum = value;
+    }
+    else
+    {
+        m_minimum = qMin(m_minimum, value);
+        m_maximum = qMax(m_maximum, value);
+    }
+    ++m_count;
+}
+
+qint64 QuantileSketch::getCount() const
+{
+    return m_count;
+}
+
+double QuantileSketch::getQuantile(double quantile) const
+{
+    if (m_count == 0)
+    {
+        return 0.0;
+    }
+
+    // Values are visited in ascending order: negative buckets from the largest absolute value, zeros and positive buckets from the smallest value
+    double rank = qBound(0.0, quantile, 1.0) * (m_count - 1);
+    qint64 accumulatedCount = 0;
+    double estimation = m_maximum;
+    bool found = false;
+
+    QList<int> negativeKeys = m_negativeCounts.keys();
+    std::sort(negativeKeys.begin(), negativeKeys.end(), std::greater<int>());
+    foreach (int key, negativeKeys)
+    {
+        accumulatedCount += m_negativeCounts.value(key);
+        if (accumulatedCount > rank)
+        {
+            estimation = -getValue(key);
+            found = true;
+            break;
+        }
+    }
+
+    if (!found)
+    {
+        accumulatedCount += m_zeroCount;
+        if (accumulatedCount > rank)
+        {
+            estimation = 0.0;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        QList<int> positiveKeys = m_positiveCounts.keys();
+        std::sort(positiveKeys.begin(), positiveKeys.end());
+        foreach (int key, positiveKeys)
+        {
+            accumulatedCount += m_positiveCounts.value(key);
+            if (accumulatedCount > rank)
+            {
+                estimation = getValue(key);
+                break;
+            }
+        }
+    }
+
+    return qBound(m_minimum, estimation, m_maximum);
+}
+
+int QuantileSketch::getKey(double value) const
+{
+    return qCeil(qLn(value) / m_logGamma);
+}
+
+double QuantileSketch::getValue(int key) const
+{
+    // Value with the same relative distance to both bounds of the bucket, (gamma^(key-1), gamma^key]
+    return 2.0 * qPow(m_gamma, key) / (m_gamma + 1.0);
+}
+
+} // End namespace udg
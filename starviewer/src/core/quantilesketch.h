@@ -0,0 +1,72 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGQUANTILESKETCH_H
+#define UDGQUANTILESKETCH_H
+
+#include <QHash>
+
+namespace udg {
+
+/**
+    Summary of a stream of values that allows to estimate their quantiles (median, percentiles...) without storing them.
+
+    Values are counted in buckets whose bounds grow geometrically (as in the DDSketch algorithm), so every estimated quantile is within the relative accuracy
+    given on construction of a real value at that quantile, and the memory used depends on the range of the values instead of on their number.
+ */
+class QuantileSketch {
+public:
+    /// Creates an empty sketch whose estimations have the given relative accuracy, which must be between 0 and 1.
+    explicit QuantileSketch(double relativeAccuracy = 0.005);
+
+    /// Removes all the added values.
+    void clear();
+
+    /// Adds the given value to the sketch.
+    void add(double value);
+
+    /// Returns the number of added values.
+    qint64 getCount() const;
+
+    /// Returns an estimation of the given quantile, between 0 and 1, of the added values. Returns 0 if no values have been added.
+    double getQuantile(double quantile) const;
+
+private:
+    /// Returns the key of the bucket where the given positive value is counted.
+    int getKey(double value) const;
+
+    /// Returns the value that represents the bucket with the given key.
+    double getValue(int key) const;
+
+private:
+    /// Ratio between the upper and lower bounds of each bucket, and its logarithm.
+    double m_gamma;
+    double m_logGamma;
+
+    /// Counts of the positive values and of the absolute value of the negative values, by bucket key.
+    QHash<int, qint64> m_positiveCounts;
+    QHash<int, qint64> m_negativeCounts;
+
+    /// Count of the values too close to zero to be counted in a bucket.
+    qint64 m_zeroCount;
+
+    /// Number of added values and their minimum and maximum, which are used to bound the estimations.
+    qint64 m_count;
+    double m_minimum;
+    double m_maximum;
+};
+
+} // End namespace udg
+
+#endif
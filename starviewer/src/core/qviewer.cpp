@@ -26,6 +26,7 @@
 #include "mathtools.h"
 #include "starviewerapplication.h"
 #include "coresettings.h"
+#include "volumerepository.h"
 
 // TODO: Ouch! SuperGuarrada (tm). Per poder fer sortir el menú i tenir accés al Patient principal. S'ha d'arreglar en quan es tregui les dependències de
 // interface, pacs, etc.etc.!!
@@ -100,6 +101,8 @@ QViewer::QViewer(QWidget *parent)
 
 QViewer::~QViewer()
 {
+    setDisplayedVolumes(QList<Volume*>());
+
     // Cal que la eliminació del vtkWidget sigui al final ja que els altres
     // objectes que eliminem en poden fer ús durant la seva destrucció
     delete m_toolProxy;
@@ -911,6 +914,32 @@ void QViewer::setCurrentViewPlane(const OrthogonalPlane &viewPlane)
     m_currentViewPlane = viewPlane;
 }
 
+void QViewer::setDisplayedVolumes(const QList<Volume*> &volumes)
+{
+    VolumeRepository *volumeRepository = VolumeRepository::getRepository();
+
+    // The new volumes are registered first so that a volume that is still displayed is never released in between
+    foreach (Volume *volume, volumes)
+    {
+        volumeRepository->volumeDisplayed(volume);
+    }
+
+    foreach (const QPointer<Volume> &volume, m_displayedVolumes)
+    {
+        if (!volume.isNull())
+        {
+            volumeRepository->volumeNoLongerDisplayed(volume);
+        }
+    }
+
+    m_displayedVolumes.clear();
+
+    foreach (Volume *volume, volumes)
+    {
+        m_displayedVolumes << volume;
+    }
+}
+
 void QViewer::handleNotEnoughMemoryForVisualizationError()
 {
     setViewerStatus(VisualizingError);
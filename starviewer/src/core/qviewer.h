@@ -21,6 +21,7 @@
 #include <QWidget>
 // Llista de captures de pantalla
 #include <QList>
+#include <QPointer>
 #include <vtkImageData.h>
 
 // Fordward declarations
@@ -287,6 +288,9 @@ protected:
     /// Handles errors produced by lack of memory space for visualization.
     void handleNotEnoughMemoryForVisualizationError();
 
+    /// Tells the volume repository which volumes this viewer is displaying from now on, so that their pixel data is not released while displayed.
+    void setDisplayedVolumes(const QList<Volume*> &volumes);
+
 private slots:
     /// Slot que s'utilitza quan s'ha seleccionat una sèrie amb el PatientBrowserMenu
     /// Mètode que especifica un input seguit d'una crida al mètode render()
@@ -359,6 +363,9 @@ private:
 
     /// Layout que ens permet crear widgets diferents per els estats diferents del visor.
     QStackedLayout *m_stackedLayout;
+
+    /// Volumes displayed by this viewer, as told to the volume repository.
+    QList<QPointer<Volume> > m_displayedVolumes;
 };
 
 };  // End namespace udg
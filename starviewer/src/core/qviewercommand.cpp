@@ -25,4 +25,10 @@ QViewerCommand::~QViewerCommand()
 {
 }
 
+int QViewerCommand::getSliceToShow(Volume *volume) const
+{
+    Q_UNUSED(volume)
+    return -1;
+}
+
 } // End namespace udg
@@ -19,6 +19,8 @@
 
 namespace udg {
 
+class Volume;
+
 /**
     Classe que segueix el patró Command i és la classe base de tots els Command dels QViewer.
     Serveix per encapsular comandes que s'han de fer sobre un viewer.
@@ -33,6 +35,10 @@ Q_OBJECT
 public:
     virtual ~QViewerCommand();
 
+    /// Returns the index in the data of the given volume of the slice that the viewer will show in the acquisition plane after executing the command, or -1
+    /// if the command doesn't choose the slice. It's used to load that slice first when the volume is loaded progressively. By default returns -1.
+    virtual int getSliceToShow(Volume *volume) const;
+
 public slots:
     virtual void execute() = 0;
 
@@ -0,0 +1,78 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "recentlyusedslices.h"
+
+#include <QtGlobal>
+
+namespace udg {
+
+RecentlyUsedSlices::RecentlyUsedSlices(int maximumNumberOfSlices)
+    : m_maximumNumberOfSlices(maximumNumberOfSlices)
+{
+}
+
+QList<int> RecentlyUsedSlices::useSlicesAround(int slice, int distance, int numberOfSlices)
+{
+    QList<int> usedSlices;
+
+    if (slice < 0 || slice >= numberOfSlices)
+    {
+        return usedSlices;
+    }
+
+    // The given slice is used the last one so that it becomes the most recent and it's the last one to be released
+    int firstSlice = qMax(0, slice - distance);
+    int lastSlice = qMin(numberOfSlices - 1, slice + distance);
+    for (int sliceIndex = firstSlice; sliceIndex <= lastSlice; ++sliceIndex)
+    {
+        if (sliceIndex != slice)
+        {
+            usedSlices << sliceIndex;
+        }
+    }
+    usedSlices << slice;
+
+    foreach (int sliceIndex, usedSlices)
+    {
+        m_slices.removeOne(sliceIndex);
+        m_slices.append(sliceIndex);
+    }
+
+    return usedSlices;
+}
+
+QList<int> RecentlyUsedSlices::takeLeastRecentlyUsedSlices()
+{
+    QList<int> leastRecentlyUsedSlices;
+
+    while (m_slices.size() > m_maximumNumberOfSlices)
+    {
+        leastRecentlyUsedSlices << m_slices.takeFirst();
+    }
+
+    return leastRecentlyUsedSlices;
+}
+
+const QList<int>& RecentlyUsedSlices::getSlices() const
+{
+    return m_slices;
+}
+
+void RecentlyUsedSlices::clear()
+{
+    m_slices.clear();
+}
+
+}
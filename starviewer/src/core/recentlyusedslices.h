@@ -0,0 +1,56 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGRECENTLYUSEDSLICES_H
+#define UDGRECENTLYUSEDSLICES_H
+
+#include <QList>
+
+namespace udg {
+
+/**
+    Keeps the slices for which some data is loaded, ordered from the least to the most recently used, so that the data of the least recently used ones can
+    be released when there are more than a given maximum.
+
+    Each time a slice is visited, useSlicesAround() marks it and its neighbours as used, and then takeLeastRecentlyUsedSlices() returns the slices whose data
+    has to be released.
+  */
+class RecentlyUsedSlices {
+public:
+    RecentlyUsedSlices(int maximumNumberOfSlices);
+
+    /// Marks as used the given slice and the ones at most at the given distance from it, between 0 and numberOfSlices - 1. The given slice becomes the
+    /// most recently used one. Returns the marked slices in the order they have been marked, so the given slice is the last one.
+    QList<int> useSlicesAround(int slice, int distance, int numberOfSlices);
+
+    /// Removes and returns the least recently used slices that exceed the maximum number of slices, from the least to the most recently used.
+    QList<int> takeLeastRecentlyUsedSlices();
+
+    /// Returns the used slices, from the least to the most recently used.
+    const QList<int>& getSlices() const;
+
+    /// Forgets all the used slices.
+    void clear();
+
+private:
+    /// Maximum number of slices that are kept after takeLeastRecentlyUsedSlices()
+    int m_maximumNumberOfSlices;
+
+    /// Used slices, from the least to the most recently used
+    QList<int> m_slices;
+};
+
+}
+
+#endif
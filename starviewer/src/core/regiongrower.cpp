@@ -0,0 +1,357 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "regiongrower.h"
+
+#include "logging.h"
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <vtkImageData.h>
+
+#include <algorithm>
+
+namespace udg {
+
+namespace {
+
+// Number of consecutive slices along the partition axis that are assigned to the same thread
+const int SlicesPerBlock = 8;
+
+// Voxels from x0 to x1 of the row (y, z) that have to be checked
+struct Span {
+    int x0, x1, y, z;
+};
+
+// Image, criterion and partition shared by all the threads that grow a region
+template <class T>
+struct GrowingContext {
+    // First component of the voxel at the origin of the extent and increments between voxels along each axis
+    T *scalars;
+    vtkIdType increments[3];
+    int extent[6];
+    double lowerValue;
+    double upperValue;
+    // Mask of the extent, or null if the region is written in the image with fillValue
+    bool *mask;
+    T fillValue;
+    // Axis whose slices are split among the threads (1 or 2) and number of threads
+    int partitionAxis;
+    int numberOfThreads;
+
+    T* getRow(int y, int z) const
+    {
+        return scalars + (y - extent[2]) * increments[1] + (z - extent[4]) * increments[2];
+    }
+
+    bool* getMaskRow(int y, int z) const
+    {
+        int width = extent[1] - extent[0] + 1;
+        int height = extent[3] - extent[2] + 1;
+        return mask + (static_cast<qint64>(z - extent[4]) * height + (y - extent[2])) * width;
+    }
+
+    int getOwner(int y, int z) const
+    {
+        int slice = partitionAxis == 2 ? z - extent[4] : y - extent[2];
+        return (slice / SlicesPerBlock) % numberOfThreads;
+    }
+};
+
+// Grows the spans of the rows owned by one thread and keeps the spans that fall on the rows of other threads to hand them over
+template <class T>
+class GrowingWorker {
+public:
+    GrowingWorker()
+     : m_index(0), m_numberOfVoxels(0)
+    {
+    }
+
+    void initialize(int index, int numberOfThreads)
+    {
+        m_index = index;
+        m_handedOverSpans.resize(numberOfThreads);
+    }
+
+    void run(const GrowingContext<T> &context)
+    {
+        while (!m_pendingSpans.isEmpty())
+        {
+            Span span = m_pendingSpans.last();
+            m_pendingSpans.removeLast();
+            growSpan(context, span);
+        }
+    }
+
+    void addSpan(const GrowingContext<T> &context, int x0, int x1, int y, int z)
+    {
+        if (y < context.extent[2] || y > context.extent[3] || z < context.extent[4] || z > context.extent[5])
+        {
+            return;
+        }
+
+        Span span = { x0, x1, y, z };
+        int owner = context.getOwner(y, z);
+        if (owner == m_index)
+        {
+            m_pendingSpans << span;
+        }
+        else
+        {
+            m_handedOverSpans[owner] << span;
+        }
+    }
+
+    // Pending spans of this thread and spans to hand over to each other thread in the next wavefront
+    QVector<Span> m_pendingSpans;
+    QVector<QVector<Span> > m_handedOverSpans;
+
+    int m_index;
+    qint64 m_numberOfVoxels;
+
+private:
+    void growSpan(const GrowingContext<T> &context, const Span &span)
+    {
+        T *row = context.getRow(span.y, span.z);
+        bool *maskRow = context.mask ? context.getMaskRow(span.y, span.z) : 0;
+        int firstX = context.extent[0];
+        int lastX = context.extent[1];
+        vtkIdType increment = context.increments[0];
+
+        auto isAccepted = [&](int x) {
+            if (maskRow && maskRow[x - firstX])
+            {
+                return false;
+            }
+
+            double value = row[(x - firstX) * increment];
+            return value >= context.lowerValue && value <= context.upperValue;
+        };
+
+        int x = span.x0;
+        while (x <= span.x1)
+        {
+            if (!isAccepted(x))
+            {
+                ++x;
+                continue;
+            }
+
+            int first = x;
+            while (first > firstX && isAccepted(first - 1))
+            {
+                --first;
+            }
+
+            int last = x;
+            while (last < lastX && isAccepted(last + 1))
+            {
+                ++last;
+            }
+
+            for (int i = first; i <= last; ++i)
+            {
+                if (maskRow)
+                {
+                    maskRow[i - firstX] = true;
+                }
+                else
+                {
+                    row[(i - firstX) * increment] = context.fillValue;
+                }
+            }
+
+            m_numberOfVoxels += last - first + 1;
+
+            addSpan(context, first, last, span.y - 1, span.z);
+            addSpan(context, first, last, span.y + 1, span.z);
+            addSpan(context, first, last, span.y, span.z - 1);
+            addSpan(context, first, last, span.y, span.z + 1);
+
+            // The voxel after the last one is not accepted
+            x = last + 2;
+        }
+    }
+};
+
+template <class T>
+qint64 growRegion(vtkImageData *image, const int extent[6], const int seed[3], double lowerValue, double upperValue, bool *mask, double fillValue,
+                  int numberOfThreads)
+{
+    GrowingContext<T> context;
+    context.scalars = static_cast<T*>(image->GetScalarPointer(extent[0], extent[2], extent[4]));
+    image->GetIncrements(context.increments);
+    std::copy(extent, extent + 6, context.extent);
+    context.lowerValue = lowerValue;
+    context.upperValue = upperValue;
+    context.mask = mask;
+    context.fillValue = static_cast<T>(fillValue);
+
+    if (!mask && context.fillValue >= lowerValue && context.fillValue <= upperValue)
+    {
+        DEBUG_LOG(QString("The fill value %1 is inside the growing range [%2, %3]").arg(fillValue).arg(lowerValue).arg(upperValue));
+        return 0;
+    }
+
+    // Split the slowest axis that has more than one slice
+    context.partitionAxis = extent[5] > extent[4] ? 2 : 1;
+    int numberOfBlocks = (extent[context.partitionAxis * 2 + 1] - extent[context.partitionAxis * 2]) / SlicesPerBlock + 1;
+    context.numberOfThreads = qBound(1, numberOfThreads, numberOfBlocks);
+
+    QVector<GrowingWorker<T> > workers(context.numberOfThreads);
+    for (int i = 0; i < workers.size(); i++)
+    {
+        workers[i].initialize(i, workers.size());
+    }
+
+    workers[context.getOwner(seed[1], seed[2])].addSpan(context, seed[0], seed[0], seed[1], seed[2]);
+
+    bool hasPendingSpans = true;
+    while (hasPendingSpans)
+    {
+        if (workers.size() == 1)
+        {
+            workers[0].run(context);
+        }
+        else
+        {
+            QtConcurrent::blockingMap(workers, [&context](GrowingWorker<T> &worker) { worker.run(context); });
+        }
+
+        hasPendingSpans = false;
+        for (int i = 0; i < workers.size(); i++)
+        {
+            for (int j = 0; j < workers.size(); j++)
+            {
+                workers[j].m_pendingSpans += workers[i].m_handedOverSpans[j];
+                workers[i].m_handedOverSpans[j].clear();
+            }
+        }
+
+        for (int i = 0; i < workers.size(); i++)
+        {
+            hasPendingSpans = hasPendingSpans || !workers[i].m_pendingSpans.isEmpty();
+        }
+    }
+
+    qint64 numberOfVoxels = 0;
+    foreach (const GrowingWorker<T> &worker, workers)
+    {
+        numberOfVoxels += worker.m_numberOfVoxels;
+    }
+
+    return numberOfVoxels;
+}
+
+bool isInside(const int index[3], const int extent[6])
+{
+    return index[0] >= extent[0] && index[0] <= extent[1] && index[1] >= extent[2] && index[1] <= extent[3] && index[2] >= extent[4] && index[2] <= extent[5];
+}
+
+}
+
+RegionGrower::RegionGrower()
+ : m_hasExtent(false), m_numberOfThreads(1)
+{
+}
+
+RegionGrower::~RegionGrower()
+{
+}
+
+void RegionGrower::setExtent(const int extent[6])
+{
+    std::copy(extent, extent + 6, m_extent);
+    m_hasExtent = true;
+}
+
+void RegionGrower::setNumberOfThreads(int numberOfThreads)
+{
+    m_numberOfThreads = numberOfThreads;
+}
+
+bool RegionGrower::getGrowingExtent(vtkImageData *image, int extent[6]) const
+{
+    if (!image || !image->GetScalarPointer())
+    {
+        return false;
+    }
+
+    image->GetExtent(extent);
+
+    if (m_hasExtent)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            extent[i * 2] = qMax(extent[i * 2], m_extent[i * 2]);
+            extent[i * 2 + 1] = qMin(extent[i * 2 + 1], m_extent[i * 2 + 1]);
+        }
+    }
+
+    return extent[0] <= extent[1] && extent[2] <= extent[3] && extent[4] <= extent[5];
+}
+
+qint64 RegionGrower::fill(vtkImageData *image, const int seed[3], double lowerValue, double upperValue, double fillValue) const
+{
+    int extent[6];
+    if (!getGrowingExtent(image, extent) || !isInside(seed, extent))
+    {
+        return 0;
+    }
+
+    int numberOfThreads = m_numberOfThreads > 0 ? m_numberOfThreads : QThread::idealThreadCount();
+    qint64 numberOfVoxels = 0;
+
+    switch (image->GetScalarType())
+    {
+        vtkTemplateMacro(numberOfVoxels = growRegion<VTK_TT>(image, extent, seed, lowerValue, upperValue, 0, fillValue, numberOfThreads));
+    }
+
+    image->Modified();
+    return numberOfVoxels;
+}
+
+qint64 RegionGrower::computeMask(vtkImageData *image, const int seed[3], double lowerValue, double upperValue, QVector<bool> &mask) const
+{
+    int extent[6];
+    if (!getGrowingExtent(image, extent))
+    {
+        mask.clear();
+        return 0;
+    }
+
+    int maskSize = (extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+    if (mask.size() != maskSize)
+    {
+        mask = QVector<bool>(maskSize, false);
+    }
+
+    if (!isInside(seed, extent))
+    {
+        return 0;
+    }
+
+    int numberOfThreads = m_numberOfThreads > 0 ? m_numberOfThreads : QThread::idealThreadCount();
+    qint64 numberOfVoxels = 0;
+
+    switch (image->GetScalarType())
+    {
+        vtkTemplateMacro(numberOfVoxels = growRegion<VTK_TT>(image, extent, seed, lowerValue, upperValue, mask.data(), 0.0, numberOfThreads));
+    }
+
+    return numberOfVoxels;
+}
+
+} // End namespace udg
@@ -0,0 +1,69 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGREGIONGROWER_H
+#define UDGREGIONGROWER_H
+
+#include <QVector>
+
+class vtkImageData;
+
+namespace udg {
+
+/**
+    Iterative region growing over the first component of the voxels of a vtkImageData.
+
+    Starting from a seed, it finds the voxels whose value is inside a range and that are connected to the seed by their faces (6-connectivity, which
+    becomes 4-connectivity when the growing extent is a single slice). The region is grown by scanlines along the x axis using an explicit work list, so
+    the stack depth doesn't depend on the size of the region, and voxels are accessed through typed pointers instead of one virtual call per voxel.
+
+    Optionally, the growing can be spread among several threads. Then the rows of the growing extent are split in blocks of slices that are assigned to the
+    threads in turn, each thread only touches the voxels of its blocks, and the spans that reach the blocks of another thread are handed over to it in the
+    next wavefront, until no thread has pending spans.
+ */
+class RegionGrower {
+public:
+    RegionGrower();
+    ~RegionGrower();
+
+    /// Restricts the growing to the given extent, which is intersected with the extent of the image. By default the whole image is used.
+    void setExtent(const int extent[6]);
+
+    /// Sets the number of threads used to grow the region. 1 by default. If it's 0, the ideal number of threads for this machine is used.
+    void setNumberOfThreads(int numberOfThreads);
+
+    /// Grows the region from the seed over the voxels with a value between lowerValue and upperValue and sets them to fillValue, which must be out of the
+    /// range. Returns the number of filled voxels, which is 0 if the seed is out of the growing extent or its value is out of the range.
+    qint64 fill(vtkImageData *image, const int seed[3], double lowerValue, double upperValue, double fillValue) const;
+
+    /// Grows the region from the seed over the voxels with a value between lowerValue and upperValue without modifying the image, and sets to true the
+    /// elements of the mask corresponding to them. The mask has an element for each voxel of the growing extent, with x varying fastest. If it already has
+    /// this size its contents are kept and the voxels that are already true are not grown through, so successive calls can accumulate regions; otherwise
+    /// it's resized and cleared. Returns the number of voxels added to the mask.
+    qint64 computeMask(vtkImageData *image, const int seed[3], double lowerValue, double upperValue, QVector<bool> &mask) const;
+
+    /// Computes the growing extent for the given image. Returns false if it's empty.
+    bool getGrowingExtent(vtkImageData *image, int extent[6]) const;
+
+private:
+    /// Extent set with setExtent() and whether it has been set.
+    int m_extent[6];
+    bool m_hasExtent;
+
+    int m_numberOfThreads;
+};
+
+} // End namespace udg
+
+#endif
@@ -15,11 +15,11 @@
 #include "roidata.h"
 
 #include <QtCore/qmath.h>
-#include <cfloat>
 
 namespace udg {
 
 ROIData::ROIData()
+ : m_keepVoxels(false)
 {
     clear();
 }
@@ -31,10 +31,12 @@ ROIData::~ROIData()
 void ROIData::clear()
 {
     m_voxels.clear();
-    m_statisticsAreOutdated = false;
+    m_numberOfVoxels = 0;
     m_mean = 0.0;
-    m_standardDeviation = 0.0;
+    m_sumOfSquaredDeviations = 0.0;
+    m_minimum = 0.0;
     m_maximum = 0.0;
+    m_quantileSketch.clear();
     m_units = "";
     m_modality = "";
 }
@@ -43,105 +45,116 @@ void ROIData::addVoxel(const Voxel &voxel)
 {
     if (!voxel.isEmpty())
     {
+        if (m_keepVoxels)
+        {
+            m_voxels << voxel;
+        }
+
+        addValueToStatistics(voxel.getComponent(0));
+    }
+}
+
+void ROIData::addValue(double value)
+{
+    if (m_keepVoxels)
+    {
+        Voxel voxel;
+        voxel.addComponent(value);
         m_voxels << voxel;
-        m_statisticsAreOutdated = true;
     }
+
+    addValueToStatistics(value);
+}
+
+qint64 ROIData::getNumberOfVoxels() const
+{
+    return m_numberOfVoxels;
 }
 
-double ROIData::getMean()
+double ROIData::getMean() const
 {
-    computeStatistics();
     return m_mean;
 }
 
-double ROIData::getStandardDeviation()
+double ROIData::getStandardDeviation() const
 {
-    computeStatistics();
-    return m_standardDeviation;
+    if (m_numberOfVoxels == 0)
+    {
+        return 0.0;
+    }
+
+    return qSqrt(m_sumOfSquaredDeviations / m_numberOfVoxels);
 }
 
-double ROIData::getMaximum()
+double ROIData::getMinimum() const
 {
-    computeStatistics();
-    return m_maximum;
+    return m_minimum;
 }
 
-void ROIData::setUnits(const QString &units)
+double ROIData::getMaximum() const
 {
-    m_units = units;
+    return m_maximum;
 }
 
-QString ROIData::getUnits() const
+double ROIData::getMedian() const
 {
-    return m_units;
+    return getPercentile(50.0);
 }
 
-void ROIData::setModality(const QString &modality)
+double ROIData::getPercentile(double percentile) const
 {
-    m_modality = modality;
+    return m_quantileSketch.getQuantile(percentile / 100.0);
 }
 
-QString ROIData::getModality() const
+void ROIData::setKeepVoxels(bool keep)
 {
-    return m_modality;
+    m_keepVoxels = keep;
 }
 
-void ROIData::computeStatistics()
+const QVector<Voxel>& ROIData::getVoxels() const
 {
-    if (!m_statisticsAreOutdated)
-    {
-        return;
-    }
+    return m_voxels;
+}
 
-    computeMean();
-    computeStandardDeviation();
-    computeMaximum();
+void ROIData::setUnits(const QString &units)
+{
+    m_units = units;
+}
 
-    m_statisticsAreOutdated = false;
+QString ROIData::getUnits() const
+{
+    return m_units;
 }
 
-void ROIData::computeMean()
+void ROIData::setModality(const QString &modality)
 {
-    m_mean = 0.0;
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        m_mean += voxel.getComponent(0);
-    }
+    m_modality = modality;
+}
 
-    m_mean = m_mean / m_voxels.size();
+QString ROIData::getModality() const
+{
+    return m_modality;
 }
 
-void ROIData::computeStandardDeviation()
+void ROIData::addValueToStatistics(double value)
 {
-    m_standardDeviation = 0.0;
-    QList<double> deviations;
-    foreach (const Voxel &voxel, m_voxels)
+    if (m_numberOfVoxels == 0)
     {
-        double individualDeviation = voxel.getComponent(0) - m_mean;
-        deviations << (individualDeviation * individualDeviation);
+        m_minimum = m_maximum = value;
     }
-
-    foreach (double deviation, deviations)
+    else
     {
-        m_standardDeviation += deviation;
+        m_minimum = qMin(m_minimum, value);
+        m_maximum = qMax(m_maximum, value);
     }
 
-    m_standardDeviation /= deviations.size();
-    m_standardDeviation = qSqrt(m_standardDeviation);
-}
+    // Welford's algorithm updates the mean and the sum of squared deviations without keeping the values and without the cancellation of a sum of squares
+    ++m_numberOfVoxels;
+    double deviation = value - m_mean;
+    m_mean += deviation / m_numberOfVoxels;
+    m_sumOfSquaredDeviations += deviation * (value - m_mean);
 
-void ROIData::computeMaximum()
-{
-    m_maximum = -DBL_MAX;
-
-    foreach (const Voxel &voxel, m_voxels)
-    {
-        double value = voxel.getComponent(0);
-        if (value > m_maximum)
-        {
-            m_maximum = value;
-        }
-    }
+    m_quantileSketch.add(value);
 }
 
 } // End namespace udg
@@ -15,32 +15,54 @@
 #ifndef UDGROIDATA_H
 #define UDGROIDATA_H
 
+#include "quantilesketch.h"
 #include "voxel.h"
 
 #include <QString>
+#include <QVector>
 
 namespace udg {
 
 /**
-    Class to save voxel data contained in a ROI and compute statistics from it.
+    Class to compute statistics of the voxels contained in a ROI.
     Currently it only takes into account the first component of the voxel,
     i.e. if the voxel is an RGB color voxel, it only will take into account the red channel
+
+    Statistics are accumulated as the voxels are added, so the voxels themselves are not stored unless setKeepVoxels(true) is called.
+    Mean, standard deviation, minimum and maximum are exact. Median and percentiles are estimated with a QuantileSketch.
  */
 class ROIData {
 public:
     ROIData();
     ~ROIData();
 
-    /// Clears all the contained data and reinitializes the corresponding values
+    /// Clears all the contained data and reinitializes the corresponding values. Whether voxels are kept or not doesn't change.
     void clear();
     
     /// Adds a voxel unless Voxel::isEmpty() is true
     void addVoxel(const Voxel &voxel);
 
-    /// Gets the mean/standard deviation/maximum corresponding to the current voxels
-    double getMean();
-    double getStandardDeviation();
-    double getMaximum();
+    /// Adds the value of a single-component voxel. Cheaper than addVoxel() when the value is already at hand.
+    void addValue(double value);
+
+    /// Returns the number of added voxels
+    qint64 getNumberOfVoxels() const;
+
+    /// Gets the mean/standard deviation/minimum/maximum corresponding to the current voxels
+    double getMean() const;
+    double getStandardDeviation() const;
+    double getMinimum() const;
+    double getMaximum() const;
+
+    /// Gets an estimation of the median or the given percentile (between 0 and 100) of the current voxels
+    double getMedian() const;
+    double getPercentile(double percentile) const;
+
+    /// Sets whether the added voxels have to be kept so that they can be retrieved with getVoxels(). False by default.
+    void setKeepVoxels(bool keep);
+
+    /// Returns the added voxels, if they have been kept
+    const QVector<Voxel>& getVoxels() const;
 
     /// Sets/gets the units of the voxels of this ROI
     void setUnits(const QString &units);
@@ -51,30 +73,24 @@ public:
     QString getModality() const;
 
 private:
-    /// Computes all statistics data if needed
-    void computeStatistics();
-
-    /// Computes voxels mean
-    void computeMean();
-
-    /// Computes voxels standard deviation. Requires mean to be computed before, as it uses the m_mean value
-    void computeStandardDeviation();
-
-    /// Computes voxels maximum value
-    void computeMaximum();
+    /// Updates the statistics with the given voxel value
+    void addValueToStatistics(double value);
 
 private:
-    /// The container of the ROI voxels
+    /// The container of the ROI voxels, only filled if m_keepVoxels is true
     QVector<Voxel> m_voxels;
-    
-    /// Statistic data members
+    bool m_keepVoxels;
+
+    /// Number of voxels, running mean and sum of squared deviations from the mean (Welford's algorithm), minimum and maximum
+    qint64 m_numberOfVoxels;
     double m_mean;
-    double m_standardDeviation;
+    double m_sumOfSquaredDeviations;
+    double m_minimum;
     double m_maximum;
 
-    /// Used to control whether the statistics data has to be computed or not when requested
-    bool m_statisticsAreOutdated;
-    
+    /// Summary of the voxel values to estimate the median and percentiles
+    QuantileSketch m_quantileSketch;
+
     /// Additional optional information of the ROI regarding the units of the voxels and their modality
     QString m_units;
     QString m_modality;
@@ -245,7 +245,12 @@ void ROITool::addVoxelsFromIntersections(const QList<double*> &intersectionPoint
                 Point3D voxelCoordinate(currentScanLinePoint.getAsDoubleArray());
                 voxelCoordinate[zIndex] = currentZDepth;
                 
-                roiData.addVoxel(pixelData->getVoxelValue(voxelCoordinate.getAsDoubleArray(), phaseIndex));
+                double value;
+                if (pixelData->getFirstComponentValue(voxelCoordinate.getAsDoubleArray(), value, phaseIndex))
+                {
+                    roiData.addValue(value);
+                }
+
                 currentScanLinePoint[scanDirectionIndex] += scanDirectionIncrement;
             }
         }
@@ -0,0 +1,162 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "slicepositionindex.h"
+
+#include "imageplane.h"
+#include "mathtools.h"
+#include "volume.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace udg {
+
+namespace {
+
+// Slices whose normals differ less than this in each component are considered parallel
+const double ParallelNormalsTolerance = 1e-4;
+
+double dotProduct(const double a[3], const double b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+}
+
+SlicePositionIndex::SlicePositionIndex()
+ : m_slicesAreParallel(true)
+{
+    m_normal[0] = m_normal[1] = m_normal[2] = 0.0;
+}
+
+void SlicePositionIndex::build(Volume *volume, const OrthogonalPlane &plane)
+{
+    m_slicePlanes.clear();
+    m_slicesAreParallel = true;
+
+    if (!volume)
+    {
+        return;
+    }
+
+    int maximumSlice = volume->getMaximumSlice(plane);
+    m_slicePlanes.reserve(maximumSlice + 1);
+
+    for (int i = 0; i <= maximumSlice; ++i)
+    {
+        ImagePlane *imagePlane = volume->getImagePlane(i, plane);
+        if (imagePlane)
+        {
+            SlicePlane slicePlane;
+            slicePlane.slice = i;
+            imagePlane->getOrigin(slicePlane.origin);
+            imagePlane->getNormalVector(slicePlane.normal);
+            m_slicePlanes.append(slicePlane);
+
+            delete imagePlane;
+        }
+    }
+
+    if (m_slicePlanes.isEmpty())
+    {
+        return;
+    }
+
+    std::copy(m_slicePlanes.first().normal, m_slicePlanes.first().normal + 3, m_normal);
+
+    for (int i = 0; i < m_slicePlanes.size() && m_slicesAreParallel; ++i)
+    {
+        const double *normal = m_slicePlanes.at(i).normal;
+        m_slicesAreParallel = std::abs(normal[0] - m_normal[0]) < ParallelNormalsTolerance && std::abs(normal[1] - m_normal[1]) < ParallelNormalsTolerance &&
+                              std::abs(normal[2] - m_normal[2]) < ParallelNormalsTolerance;
+    }
+
+    if (m_slicesAreParallel)
+    {
+        for (int i = 0; i < m_slicePlanes.size(); ++i)
+        {
+            m_slicePlanes[i].position = dotProduct(m_slicePlanes.at(i).origin, m_normal);
+        }
+
+        // Stable sort so that slices at the same position stay in slice order
+        std::stable_sort(m_slicePlanes.begin(), m_slicePlanes.end(), [](const SlicePlane &a, const SlicePlane &b) { return a.position < b.position; });
+    }
+}
+
+int SlicePositionIndex::getNumberOfSlices() const
+{
+    return m_slicePlanes.size();
+}
+
+bool SlicePositionIndex::areSlicesParallel() const
+{
+    return m_slicesAreParallel;
+}
+
+int SlicePositionIndex::getNearestSlice(const double point[3], double &distanceToSlice) const
+{
+    int nearestSlice = -1;
+    distanceToSlice = MathTools::DoubleMaximumValue;
+
+    if (m_slicePlanes.isEmpty())
+    {
+        return nearestSlice;
+    }
+
+    int first = 0;
+    int last = m_slicePlanes.size() - 1;
+
+    if (m_slicesAreParallel)
+    {
+        // The nearest slices are the ones right before and after the position of the point, and any other slice at the same positions as them
+        double position = dotProduct(point, m_normal);
+        QVector<SlicePlane>::const_iterator after = std::lower_bound(m_slicePlanes.constBegin(), m_slicePlanes.constEnd(), position,
+                                                                     [](const SlicePlane &slicePlane, double value) { return slicePlane.position < value; });
+        int afterIndex = after - m_slicePlanes.constBegin();
+        first = qMax(0, afterIndex - 1);
+        last = qMin(m_slicePlanes.size() - 1, afterIndex);
+
+        while (first > 0 && m_slicePlanes.at(first - 1).position == m_slicePlanes.at(first).position)
+        {
+            --first;
+        }
+        while (last < m_slicePlanes.size() - 1 && m_slicePlanes.at(last + 1).position == m_slicePlanes.at(last).position)
+        {
+            ++last;
+        }
+    }
+
+    for (int i = first; i <= last; ++i)
+    {
+        const SlicePlane &slicePlane = m_slicePlanes.at(i);
+        double distance = getDistance(slicePlane, point);
+        if (distance < distanceToSlice || (distance == distanceToSlice && slicePlane.slice < nearestSlice))
+        {
+            distanceToSlice = distance;
+            nearestSlice = slicePlane.slice;
+        }
+    }
+
+    return nearestSlice;
+}
+
+double SlicePositionIndex::getDistance(const SlicePlane &slicePlane, const double point[3])
+{
+    // Computed like vtkPlane::DistanceToPlane() so that the results are the same as with the image planes
+    double originToPoint[3] = { point[0] - slicePlane.origin[0], point[1] - slicePlane.origin[1], point[2] - slicePlane.origin[2] };
+    return std::abs(dotProduct(originToPoint, slicePlane.normal));
+}
+
+} // End namespace udg
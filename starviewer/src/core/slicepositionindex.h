@@ -0,0 +1,75 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGSLICEPOSITIONINDEX_H
+#define UDGSLICEPOSITIONINDEX_H
+
+#include "orthogonalplane.h"
+
+#include <QVector>
+
+namespace udg {
+
+class Volume;
+
+/**
+    Index of the positions of the slices of a volume in one orthogonal plane, used to find the slice nearest to a point without going through all of them.
+
+    The origin and normal of the plane of each slice are computed once when the index is built. When all the slices are parallel, each slice is represented
+    by the projection of its origin on the common normal and the slices are kept sorted by it, so the nearest slice is found with a binary search.
+    Otherwise the nearest slice is found by computing the distance to each slice plane, like it would be done with the volume image planes.
+ */
+class SlicePositionIndex {
+public:
+    SlicePositionIndex();
+
+    /// Builds the index with the slices of the given volume in the given plane.
+    void build(Volume *volume, const OrthogonalPlane &plane);
+
+    /// Returns the number of indexed slices.
+    int getNumberOfSlices() const;
+
+    /// Returns true if all the indexed slices are parallel and can be searched with a binary search.
+    bool areSlicesParallel() const;
+
+    /// Returns the slice whose plane is nearest to the given point and sets in distanceToSlice the distance from the point to that plane.
+    /// If there are several slices at the same distance, the one with the lowest index is returned. If there are no slices, returns -1.
+    int getNearestSlice(const double point[3], double &distanceToSlice) const;
+
+private:
+    /// Origin and normal of the plane of a slice and the position of the slice along the common normal.
+    struct SlicePlane {
+        int slice;
+        double origin[3];
+        double normal[3];
+        double position;
+    };
+
+    /// Returns the distance from the given point to the plane of the given slice.
+    static double getDistance(const SlicePlane &slicePlane, const double point[3]);
+
+private:
+    /// Planes of the indexed slices. When the slices are parallel they are sorted by position, otherwise they are in slice order.
+    QVector<SlicePlane> m_slicePlanes;
+
+    /// Normal of the first slice, on which the positions are projected.
+    double m_normal[3];
+
+    /// True if all the slices are parallel.
+    bool m_slicesAreParallel;
+};
+
+} // End namespace udg
+
+#endif
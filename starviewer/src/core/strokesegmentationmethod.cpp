@@ -16,6 +16,7 @@
 
 #include "itkErfcLevelSetImageFilter.h"
 #include "itkVolumeCalculatorImageFilter.h"
+#include "regiongrower.h"
 
 // Per la utilització de clock()
 #include <ctime>
@@ -193,7 +194,9 @@ double StrokeSegmentationMethod::applyMethodVTK()
     index[2] = (int)(((double)m_pz - origin[2]) / spacing[2]);
     DEBUG_LOG(QString("Tractant llesca %1").arg(index[2]));
 
-    applyMethodVTKRecursive(imMask, index[0], index[1], index[2], 0);
+    RegionGrower regionGrower;
+    regionGrower.setNumberOfThreads(0);
+    m_cont = static_cast<int>(regionGrower.fill(imMask, index, m_insideMaskValue - 100, m_insideMaskValue - 100, m_insideMaskValue));
 
     DEBUG_LOG(QString("Tractant llesca %1").arg(index[2]));
 
@@ -203,26 +206,6 @@ double StrokeSegmentationMethod::applyMethodVTK()
     return m_cont * spacing[0] * spacing[1] * spacing[2];
 }
 
-void StrokeSegmentationMethod::applyMethodVTKRecursive(vtkImageData* imMask, int a, int b, int c, int prof)
-{
-    if ((a >= m_Volume->getExtent()[0]) && (a <= m_Volume->getExtent()[1]) && (b >= m_Volume->getExtent()[2]) && (b <=
-        m_Volume->getExtent()[3]) && (c >= m_Volume->getExtent()[4]) && (c <= m_Volume->getExtent()[5]))
-    {
-        double maskValue = imMask->GetScalarComponentAsDouble(a, b, c, 0);
-        if (maskValue == m_insideMaskValue - 100)
-        {
-            imMask->SetScalarComponentFromDouble(a, b, c, 0, m_insideMaskValue);
-            m_cont++;
-            applyMethodVTKRecursive(imMask, a, b, c + 1, prof + 1);
-            applyMethodVTKRecursive(imMask, a, b, c - 1, prof + 1);
-            applyMethodVTKRecursive(imMask, a + 1, b, c, prof + 1);
-            applyMethodVTKRecursive(imMask, a - 1, b, c, prof + 1);
-            applyMethodVTKRecursive(imMask, a, b + 1, c, prof + 1);
-            applyMethodVTKRecursive(imMask, a, b - 1, c, prof + 1);
-        }
-    }
-}
-
 double StrokeSegmentationMethod::applyCleanSkullMethod()
 {
     DEBUG_LOG("Clean Skull!!");
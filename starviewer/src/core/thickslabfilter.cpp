@@ -24,6 +24,9 @@ namespace udg {
 ThickSlabFilter::ThickSlabFilter()
 {
     m_filter = vtkProjectionImageFilter::New();
+    // Scrolling the slab one slice at a time only needs to update the projection with the slices that enter and leave it.
+    // Slabs whose state would exceed the memory limit of the filter are projected entirely in each update.
+    m_filter->IncrementalUpdateOn();
 }
 
 ThickSlabFilter::~ThickSlabFilter()
@@ -34,11 +37,13 @@ ThickSlabFilter::~ThickSlabFilter()
 void ThickSlabFilter::setInput(vtkImageData *input)
 {
     m_filter->SetInputData(input);
+    m_filter->ReleaseIncrementalUpdateState();
 }
 
 void ThickSlabFilter::setInput(FilterOutput input)
 {
     m_filter->SetInputConnection(input.getVtkAlgorithmOutput());
+    m_filter->ReleaseIncrementalUpdateState();
 }
 
 void ThickSlabFilter::setProjectionAxis(const OrthogonalPlane &axis)
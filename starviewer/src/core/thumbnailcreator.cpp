@@ -29,6 +29,7 @@
 #include <dcmimage.h>
 #include <ofbmanip.h>
 #include <dcdatset.h>
+#include <dcdeftag.h>
 // Necessari per suportar imatges de color
 #include <diregist.h>
 
@@ -40,7 +41,12 @@ QImage ThumbnailCreator::getThumbnail(const Series *series, int resolution)
 {
     QImage thumbnail;
 
-    if (series->getModality() == "KO")
+    QString imageFileName = getThumbnailImageFileName(series);
+    if (!imageFileName.isEmpty())
+    {
+        thumbnail = createImageThumbnail(imageFileName, resolution);
+    }
+    else if (series->getModality() == "KO")
     {
         thumbnail = createIconThumbnail(":/images/icons/mime-ko.svg", resolution);
     }
@@ -54,18 +60,10 @@ QImage ThumbnailCreator::getThumbnail(const Series *series, int resolution)
     }
     else
     {
-        int numberOfImages = series->getImages().size();
-        if (numberOfImages > 0)
-        {
-            thumbnail = createImageThumbnail(series->getImages()[numberOfImages / 2]->getPath(), resolution);
-        }
-        else
-        {
-            thumbnail = createIconThumbnail(":/images/icons/mime-unknown.svg", resolution);
+        thumbnail = createIconThumbnail(":/images/icons/mime-unknown.svg", resolution);
 
-            // Si la sèrie no conté imatges en el thumbnail ho indicarem
-            //thumbnail = makeEmptyThumbnailWithCustomText(QObject::tr("No Images Available"));
-        }
+        // Si la sèrie no conté imatges en el thumbnail ho indicarem
+        //thumbnail = makeEmptyThumbnailWithCustomText(QObject::tr("No Images Available"));
     }
 
     return thumbnail;
@@ -81,6 +79,25 @@ QImage ThumbnailCreator::getThumbnail(const DICOMTagReader *reader, int resoluti
     return createThumbnail(reader, resolution);
 }
 
+QImage ThumbnailCreator::getThumbnail(const QString &imageFileName, int resolution, bool *ok)
+{
+    return createImageThumbnail(imageFileName, resolution, ok);
+}
+
+QString ThumbnailCreator::getThumbnailImageFileName(const Series *series)
+{
+    QString modality = series->getModality();
+    // Les sèries consultades a la base de dades poden tenir imatges sense tenir-les carregades
+    QList<Image*> images = series->getImages();
+    if (modality == "KO" || modality == "PR" || modality == "SR" || images.isEmpty())
+    {
+        return QString();
+    }
+
+    // Fem servir la imatge del mig de la sèrie
+    return images.at(images.size() / 2)->getPath();
+}
+
 QImage ThumbnailCreator::makeEmptyThumbnailWithCustomText(const QString &text, int resolution)
 {
     QImage thumbnail;
@@ -95,10 +112,12 @@ QImage ThumbnailCreator::makeEmptyThumbnailWithCustomText(const QString &text, i
     return thumbnail;
 }
 
-QImage ThumbnailCreator::createImageThumbnail(const QString &imageFileName, int resolution)
+QImage ThumbnailCreator::createImageThumbnail(const QString &imageFileName, int resolution, bool *ok)
 {
-    DICOMTagReader reader(imageFileName);
-    return createThumbnail(&reader, resolution);
+    // Només carreguem les metadades: les dades de píxel es llegeixen quan la DicomImage les necessita, i només les del primer frame.
+    // Si fem servir la icona del fitxer no es llegeixen mai
+    DICOMTagReader reader(imageFileName, DICOMTagReader::LoadMetadataOnly);
+    return createThumbnail(&reader, resolution, ok);
 }
 
 QImage ThumbnailCreator::createIconThumbnail(const QString &iconFileName, int resolution)
@@ -109,18 +128,28 @@ QImage ThumbnailCreator::createIconThumbnail(const QString &iconFileName, int re
     return thumbnail;
 }
 
-QImage ThumbnailCreator::createThumbnail(const DICOMTagReader *reader, int resolution)
+QImage ThumbnailCreator::createThumbnail(const DICOMTagReader *reader, int resolution, bool *ok)
 {
     QImage thumbnail;
 
+    if (ok)
+    {
+        *ok = false;
+    }
+
     if (isSuitableForThumbnailCreation(reader))
     {
         try
         {
-            // Carreguem el fitxer dicom a escalar
-            // Fem que en el cas que sigui una imatge multiframe, només carregui la primera imatge i prou, estalviant allotjar memòria innecessàriament
-            DicomImage *dicomImage = new DicomImage(reader->getDcmDataset(), reader->getDcmDataset()->getOriginalXfer(), CIF_UsePartialAccessToPixelData, 0, 1);
-            thumbnail = createThumbnail(dicomImage, resolution);
+            // Si el fitxer té una icona prou gran la fem servir, així ens estalviem descodificar la imatge sencera
+            DicomImage *dicomImage = createIconDicomImage(reader->getDcmDataset(), resolution);
+            if (!dicomImage)
+            {
+                // Carreguem el fitxer dicom a escalar
+                // Fem que en el cas que sigui una imatge multiframe, només carregui la primera imatge i prou, estalviant allotjar memòria innecessàriament
+                dicomImage = new DicomImage(reader->getDcmDataset(), reader->getDcmDataset()->getOriginalXfer(), CIF_UsePartialAccessToPixelData, 0, 1);
+            }
+            thumbnail = createThumbnail(dicomImage, resolution, ok);
 
             // Cal esborrar la DicomImage per no tenir fugues de memòria
             if (dicomImage)
@@ -132,6 +161,10 @@ QImage ThumbnailCreator::createThumbnail(const DICOMTagReader *reader, int resol
         {
             ERROR_LOG(QString("No s'ha pogut generar el thumbnail per falta de memòria: %1").arg(e.what()));
             thumbnail = makeEmptyThumbnailWithCustomText(PreviewNotAvailableText);
+            if (ok)
+            {
+                *ok = false;
+            }
         }
     }
     else
@@ -143,7 +176,7 @@ QImage ThumbnailCreator::createThumbnail(const DICOMTagReader *reader, int resol
     return thumbnail;
 }
 
-QImage ThumbnailCreator::createThumbnail(DicomImage *dicomImage, int resolution)
+QImage ThumbnailCreator::createThumbnail(DicomImage *dicomImage, int resolution, bool *thumbnailCreated)
 {
     QImage thumbnail;
     bool ok = false;
@@ -155,23 +188,20 @@ QImage ThumbnailCreator::createThumbnail(DicomImage *dicomImage, int resolution)
     }
     else if (dicomImage->getStatus() == EIS_Normal)
     {
-        dicomImage->hideAllOverlays();
-        dicomImage->setMinMaxWindow(1);
-        // Escalem la imatge
-        DicomImage *scaledImage;
-        // Escalem pel cantó més gran
-        unsigned long width, height;
-        if (dicomImage->getWidth() < dicomImage->getHeight())
-        {
-            width = 0;
-            height = resolution;
-        }
-        else
+        // Retallem la part central de la imatge per fer-la quadrada, tenint en compte la relació d'aspecte dels píxels,
+        // i l'escalem directament a la mida del thumbnail en un sol pas
+        double pixelAspectRatio = dicomImage->getWidthHeightRatio();
+        if (pixelAspectRatio <= 0.0)
         {
-            width = resolution;
-            height = 0;
+            pixelAspectRatio = 1.0;
         }
-        scaledImage = dicomImage->createScaledImage(width, height, 1, 1);
+        double side = qMin(dicomImage->getWidth() * pixelAspectRatio, static_cast<double>(dicomImage->getHeight()));
+        unsigned long clipWidth = qBound(1ul, static_cast<unsigned long>(qRound(side / pixelAspectRatio)), dicomImage->getWidth());
+        unsigned long clipHeight = qBound(1ul, static_cast<unsigned long>(qRound(side)), dicomImage->getHeight());
+        signed long left = (dicomImage->getWidth() - clipWidth) / 2;
+        signed long top = (dicomImage->getHeight() - clipHeight) / 2;
+
+        DicomImage *scaledImage = dicomImage->createScaledImage(left, top, clipWidth, clipHeight, resolution, resolution, 1, 0);
         if (scaledImage == NULL)
         {
             ok = false;
@@ -179,34 +209,19 @@ QImage ThumbnailCreator::createThumbnail(DicomImage *dicomImage, int resolution)
         }
         else if (scaledImage->getStatus() == EIS_Normal)
         {
-            QPixmap pixmap = convertToQPixmap(scaledImage);
-            if (pixmap.isNull())
+            scaledImage->hideAllOverlays();
+            // La finestra es calcula amb els píxels de la imatge escalada, que és com fer-ho amb un histograma submostrejat de l'original
+            // i ens estalvia recórrer tots els píxels de la imatge sencera
+            scaledImage->setMinMaxWindow(1);
+
+            thumbnail = convertToQImage(scaledImage);
+            if (thumbnail.isNull())
             {
                 DEBUG_LOG("No s'ha pogut convertir la DicomImage a QImage. Es crea un thumbnail de Preview not available.");
                 ok = false;
             }
             else
             {
-                // The smallest side will be of "resolution" size.
-                pixmap = pixmap.scaled(resolution,resolution, Qt::AspectRatioMode::KeepAspectRatioByExpanding, Qt::TransformationMode::SmoothTransformation);
-
-                // By cropping the longer side, a squared image is made.
-                int width = pixmap.width();
-                int height = pixmap.height();
-                if (width > height) // heigth == resolution
-                {
-                    pixmap = pixmap.copy((width-resolution) / 2, 0, height, height);
-                }
-                else if (height > width) // width == resolution
-                {
-                    pixmap = pixmap.copy(0, (height-resolution) / 2, width, width);
-                }
-                else
-                {
-                    // A perfect square, nothing to do
-                }
-
-                thumbnail = pixmap.toImage();
                 ok = true;
             }
 
@@ -231,9 +246,41 @@ QImage ThumbnailCreator::createThumbnail(DicomImage *dicomImage, int resolution)
         thumbnail = makeEmptyThumbnailWithCustomText(PreviewNotAvailableText);
     }
 
+    if (thumbnailCreated)
+    {
+        *thumbnailCreated = ok;
+    }
+
     return thumbnail;
 }
 
+DicomImage* ThumbnailCreator::createIconDicomImage(DcmDataset *dataset, int resolution)
+{
+    DcmItem *iconItem = NULL;
+    if (dataset->findAndGetSequenceItem(DCM_IconImageSequence, iconItem).bad() || !iconItem)
+    {
+        return NULL;
+    }
+
+    // Una icona més petita que el thumbnail quedaria borrosa
+    Uint16 rows = 0;
+    Uint16 columns = 0;
+    if (iconItem->findAndGetUint16(DCM_Rows, rows).bad() || iconItem->findAndGetUint16(DCM_Columns, columns).bad() || qMin(rows, columns) < resolution)
+    {
+        return NULL;
+    }
+
+    DicomImage *iconImage = new DicomImage(iconItem, dataset->getOriginalXfer());
+    if (iconImage->getStatus() != EIS_Normal)
+    {
+        DEBUG_LOG(QString("No s'ha pogut carregar la icona del fitxer. Error: %1").arg(DicomImage::getString(iconImage->getStatus())));
+        delete iconImage;
+        return NULL;
+    }
+
+    return iconImage;
+}
+
 bool ThumbnailCreator::isSuitableForThumbnailCreation(const DICOMTagReader *reader) const
 {
     if (!reader)
@@ -251,7 +298,7 @@ bool ThumbnailCreator::isSuitableForThumbnailCreation(const DICOMTagReader *read
     return true;
 }
 
-QPixmap ThumbnailCreator::convertToQPixmap(DicomImage *dicomImage)
+QImage ThumbnailCreator::convertToQImage(DicomImage *dicomImage)
 {
     Q_ASSERT(dicomImage);
 
@@ -279,8 +326,8 @@ QPixmap ThumbnailCreator::convertToQPixmap(DicomImage *dicomImage)
     const int height = (int)(dicomImage->getHeight());
     imageHeader += QString("\n%1 %2\n255\n").arg(width).arg(height);
 
-    // QPixmap en la que carregarem el buffer de dades
-    QPixmap thumbnail;
+    // QImage en la que carregarem el buffer de dades
+    QImage thumbnail;
     // Create output buffer for DicomImage class
     const int offset = imageHeader.size();
     const unsigned int length = (width * height) * bytesPerComponent + offset;
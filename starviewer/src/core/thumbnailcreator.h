@@ -16,9 +16,9 @@
 #define UDGTHUMBNAILCREATOR_H
 
 class QImage;
-class QPixmap;
 class QString;
 class DicomImage;
+class DcmDataset;
 
 namespace udg {
 
@@ -37,28 +37,39 @@ public:
     /// Obté el thumbnail a partir del DICOMTagReader
     QImage getThumbnail(const DICOMTagReader *reader, int resolution = 96);
 
+    /// Crea el thumbnail del fitxer DICOM donat. Com que no fa servir QPixmap ni QIcon es pot cridar des de qualsevol thread.
+    /// Si no s'ha pogut crear es retorna un thumbnail que indica que no hi ha previsualització disponible; si es dona ok, hi posa si s'ha pogut crear
+    QImage getThumbnail(const QString &imageFileName, int resolution = 96, bool *ok = 0);
+
+    /// Retorna el fitxer de la imatge a partir del qual es crea el thumbnail de la sèrie, o un string buit si el thumbnail de la sèrie és una icona
+    /// o no en té cap imatge carregada
+    static QString getThumbnailImageFileName(const Series *series);
+
     /// Crea un thumbnail buit personalitzat amb el text que li donem
     static QImage makeEmptyThumbnailWithCustomText(const QString &text, int resolution = 96);
 
 private:
     /// Crea el thumbnail d'un objecte dicom que sigui una imatge
-    QImage createImageThumbnail(const QString &imageFileName, int resolution);
+    QImage createImageThumbnail(const QString &imageFileName, int resolution, bool *ok = 0);
 
     /// Creates a thumbnail from an icon file to the specified resolution
     QImage createIconThumbnail(const QString &iconFileName, int resolution);
 
-    /// Crea el thumbnail a partir d'un DICOMTagReader
-    QImage createThumbnail(const DICOMTagReader *reader, int resolution);
+    /// Crea el thumbnail a partir d'un DICOMTagReader. Si es dona ok, hi posa si s'ha pogut crear
+    QImage createThumbnail(const DICOMTagReader *reader, int resolution, bool *ok = 0);
+
+    /// Crea el thumbnail a partir d'una DicomImage. Si es dona thumbnailCreated, hi posa si s'ha pogut crear
+    QImage createThumbnail(DicomImage *dicomImage, int resolution, bool *thumbnailCreated = 0);
 
-    /// Crea el thumbnail a partir d'una DicomImage
-    QImage createThumbnail(DicomImage *dicomImage, int resolution);
+    /// Retorna la icona (Icon Image Sequence) del dataset com a DicomImage si n'hi ha una que no és més petita que la resolució donada, o nul altrament
+    DicomImage* createIconDicomImage(DcmDataset *dataset, int resolution);
 
     /// Comprova que el dataset compleixi els requisitis necessaris per poder fer un thumbnail
     /// Retorna true si és un dataset vàlid, false altrament
     bool isSuitableForThumbnailCreation(const DICOMTagReader *reader) const;
 
-    /// Converteix la DicomImage a una QPixmap
-    QPixmap convertToQPixmap(DicomImage *dicomImage);
+    /// Converteix la DicomImage a una QImage
+    QImage convertToQImage(DicomImage *dicomImage);
 };
 
 }
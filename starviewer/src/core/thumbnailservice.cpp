@@ -0,0 +1,310 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#include "thumbnailservice.h"
+
+#include "image.h"
+#include "logging.h"
+#include "series.h"
+#include "thumbnailcreator.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+
+namespace udg {
+
+namespace {
+
+// Resolutions of the thumbnails, the same ones used by Series::getThumbnail() and Image::getThumbnail().
+const int SeriesThumbnailResolution = 96;
+const int VolumeThumbnailResolution = 100;
+
+// Bits of the queue key used by the order of arrival. The priority goes in the bits above.
+const int SequenceNumberBits = 56;
+
+// Returns true if the given file is inside the given directory, which may be empty.
+bool isInsideDirectory(const QString &filePath, const QString &directory)
+{
+    return !directory.isEmpty() && QFileInfo(filePath).absolutePath().startsWith(QDir(directory).absolutePath() + "/");
+}
+
+}
+
+// Serves pending requests until there are none left.
+class ThumbnailService::Worker : public QRunnable {
+public:
+    Worker(ThumbnailService *service)
+        : m_service(service)
+    {
+    }
+
+    virtual void run()
+    {
+        Request request;
+        while (m_service->takeRequest(request))
+        {
+            QImage thumbnail = m_service->createThumbnail(request);
+            QMetaObject::invokeMethod(m_service, "storeThumbnail", Qt::QueuedConnection, Q_ARG(QString, request.key), Q_ARG(QImage, thumbnail));
+        }
+    }
+
+private:
+    ThumbnailService *m_service;
+};
+
+Q_GLOBAL_STATIC(ThumbnailService, thumbnailService)
+
+ThumbnailService::ThumbnailService(QObject *parent)
+    : QObject(parent), m_nextSequenceNumber(0), m_numberOfWorkers(0)
+{
+    m_memoryCache.setMaxCost(512);
+    m_threadPool.setMaxThreadCount(2);
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingRequests.clear();
+        m_pendingQueue.clear();
+    }
+
+    m_threadPool.waitForDone();
+}
+
+ThumbnailService* ThumbnailService::instance()
+{
+    return thumbnailService();
+}
+
+void ThumbnailService::setPersistentCacheDirectory(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_persistentCacheDirectory = directory;
+}
+
+QString ThumbnailService::getPersistentCacheDirectory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_persistentCacheDirectory;
+}
+
+void ThumbnailService::setMemoryCacheSize(int numberOfThumbnails)
+{
+    QMutexLocker locker(&m_mutex);
+    m_memoryCache.setMaxCost(numberOfThumbnails);
+}
+
+void ThumbnailService::setMaximumThreadCount(int numberOfThreads)
+{
+    QMutexLocker locker(&m_mutex);
+    m_threadPool.setMaxThreadCount(qMax(1, numberOfThreads));
+}
+
+QString ThumbnailService::requestThumbnail(const Series *series, Priority priority)
+{
+    QString imageFilePath = ThumbnailCreator::getThumbnailImageFileName(series);
+    if (imageFilePath.isEmpty())
+    {
+        return QString();
+    }
+
+    Request request;
+    request.key = "series:" + imageFilePath;
+    request.imageFilePath = imageFilePath;
+    request.resolution = SeriesThumbnailResolution;
+    request.priority = priority;
+
+    // Only the directories of the local database contain a single series, elsewhere thumbnail.png may belong to another series in the same directory
+    QString thumbnailFilePath = QFileInfo(imageFilePath).absolutePath() + "/thumbnail.png";
+    if (isInsideDirectory(thumbnailFilePath, getPersistentCacheDirectory()))
+    {
+        request.thumbnailFilePaths << thumbnailFilePath;
+    }
+
+    return addRequest(request);
+}
+
+QString ThumbnailService::requestThumbnail(const Image *image, Priority priority)
+{
+    Request request;
+    request.key = QString("volume:%1:%2").arg(image->getPath()).arg(image->getVolumeNumberInSeries());
+    request.imageFilePath = image->getPath();
+    request.resolution = VolumeThumbnailResolution;
+    request.priority = priority;
+
+    // The same files used by Image::getThumbnail(): first the one of the volume and then the one of the series
+    QString thumbnailDirectory = QFileInfo(image->getPath()).absolutePath();
+    request.thumbnailFilePaths << QString("%1/thumbnail%2.png").arg(thumbnailDirectory).arg(image->getVolumeNumberInSeries());
+    request.thumbnailFilePaths << QString("%1/thumbnail.png").arg(thumbnailDirectory);
+
+    return addRequest(request);
+}
+
+void ThumbnailService::setPriority(const QString &key, Priority priority)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<QString, Request>::iterator request = m_pendingRequests.find(key);
+    if (request != m_pendingRequests.end())
+    {
+        changePriority(request.value(), priority);
+    }
+}
+
+void ThumbnailService::cancelRequest(const QString &key)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pendingRequests.contains(key))
+    {
+        m_pendingQueue.remove(m_pendingRequests.take(key).queueKey);
+    }
+}
+
+bool ThumbnailService::getThumbnail(const QString &key, QImage &thumbnail) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QImage *cachedThumbnail = m_memoryCache.object(key);
+    if (!cachedThumbnail)
+    {
+        return false;
+    }
+
+    thumbnail = *cachedThumbnail;
+    return true;
+}
+
+void ThumbnailService::waitForDone()
+{
+    m_threadPool.waitForDone();
+}
+
+quint64 ThumbnailService::getQueueKey(Priority priority)
+{
+    // Higher priorities get lower keys so that they are first in the queue
+    return (static_cast<quint64>(HighPriority - priority) << SequenceNumberBits) | m_nextSequenceNumber++;
+}
+
+void ThumbnailService::changePriority(Request &request, Priority priority)
+{
+    m_pendingQueue.remove(request.queueKey);
+    request.priority = priority;
+    request.queueKey = getQueueKey(priority);
+    m_pendingQueue.insert(request.queueKey, request.key);
+}
+
+QString ThumbnailService::addRequest(const Request &request)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_memoryCache.contains(request.key) || m_runningRequests.contains(request.key))
+    {
+        return request.key;
+    }
+
+    QHash<QString, Request>::iterator pendingRequest = m_pendingRequests.find(request.key);
+    if (pendingRequest != m_pendingRequests.end())
+    {
+        if (request.priority > pendingRequest->priority)
+        {
+            changePriority(pendingRequest.value(), request.priority);
+        }
+
+        return request.key;
+    }
+
+    Request newRequest = request;
+    newRequest.queueKey = getQueueKey(request.priority);
+    m_pendingRequests.insert(newRequest.key, newRequest);
+    m_pendingQueue.insert(newRequest.queueKey, newRequest.key);
+
+    if (m_numberOfWorkers < m_threadPool.maxThreadCount())
+    {
+        m_numberOfWorkers++;
+        m_threadPool.start(new Worker(this));
+    }
+
+    return request.key;
+}
+
+bool ThumbnailService::takeRequest(Request &request)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pendingQueue.isEmpty())
+    {
+        m_numberOfWorkers--;
+        return false;
+    }
+
+    request = m_pendingRequests.take(m_pendingQueue.take(m_pendingQueue.firstKey()));
+    m_runningRequests.insert(request.key);
+
+    return true;
+}
+
+QImage ThumbnailService::createThumbnail(const Request &request) const
+{
+    foreach (const QString &thumbnailFilePath, request.thumbnailFilePaths)
+    {
+        if (QFileInfo(thumbnailFilePath).exists())
+        {
+            QImage thumbnail(thumbnailFilePath);
+            if (!thumbnail.isNull())
+            {
+                return thumbnail;
+            }
+        }
+    }
+
+    bool ok;
+    QImage thumbnail = decodeThumbnail(request.imageFilePath, request.resolution, ok);
+
+    // The thumbnail that says that there isn't a preview isn't saved, so that it's decoded again next time
+    if (ok && !request.thumbnailFilePaths.isEmpty() && isInsideDirectory(request.thumbnailFilePaths.first(), getPersistentCacheDirectory()))
+    {
+        // Written atomically because other workers may be reading it
+        QSaveFile thumbnailFile(request.thumbnailFilePaths.first());
+        if (!thumbnailFile.open(QIODevice::WriteOnly) || !thumbnail.save(&thumbnailFile, "PNG") || !thumbnailFile.commit())
+        {
+            WARN_LOG(QString("Could not save the thumbnail %1").arg(request.thumbnailFilePaths.first()));
+        }
+    }
+
+    return thumbnail;
+}
+
+QImage ThumbnailService::decodeThumbnail(const QString &imageFilePath, int resolution, bool &ok) const
+{
+    return ThumbnailCreator().getThumbnail(imageFilePath, resolution, &ok);
+}
+
+void ThumbnailService::storeThumbnail(const QString &key, const QImage &thumbnail)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_runningRequests.remove(key);
+        m_memoryCache.insert(key, new QImage(thumbnail));
+    }
+
+    emit thumbnailReady(key, thumbnail);
+}
+
+} // End namespace udg
@@ -0,0 +1,152 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGTHUMBNAILSERVICE_H
+#define UDGTHUMBNAILSERVICE_H
+
+#include <QObject>
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+namespace udg {
+
+class Image;
+class Series;
+
+/**
+    Creates series and volume thumbnails in the background so that decoding DICOM files never blocks the GUI thread.
+
+    Thumbnails are identified by a key returned by requestThumbnail(). A request is served from three tiers: an in-memory LRU cache, the thumbnail*.png
+    files next to the images, and finally decoding the image in a thread pool. Pending requests are deduplicated by key and taken from the pool in priority
+    order, first come first served within a priority, so that the thumbnails of visible widgets are created before prefetched ones. Decoded thumbnails are
+    written back as thumbnail*.png files only under the persistent cache directory (the local database cache). LocalDatabaseManager creates the thumbnails
+    of the series it saves this way too, at low priority.
+
+    The public interface may be used from any thread. thumbnailReady() is emitted from the thread of the service, the GUI thread for instance().
+  */
+class ThumbnailService : public QObject {
+Q_OBJECT
+public:
+    /// Priority of a request. Requests for thumbnails that are being shown should use HighPriority.
+    enum Priority { LowPriority, NormalPriority, HighPriority };
+
+    ThumbnailService(QObject *parent = 0);
+    ~ThumbnailService();
+
+    /// Returns the service shared by the whole application. It belongs to the thread that calls this first, which must be the GUI thread; main() does it
+    /// at startup.
+    static ThumbnailService* instance();
+
+    /// Sets the root directory under which created thumbnails may be saved. Empty by default, which disables saving them.
+    void setPersistentCacheDirectory(const QString &directory);
+    QString getPersistentCacheDirectory() const;
+
+    /// Sets the maximum number of thumbnails kept in memory. Default is 512.
+    void setMemoryCacheSize(int numberOfThumbnails);
+
+    /// Sets the maximum number of threads used to decode thumbnails. Default is 2, so that it doesn't compete with loading volumes.
+    void setMaximumThreadCount(int numberOfThreads);
+
+    /// Requests the thumbnail of the given series and returns its key. If the thumbnail is already in memory it can be taken with getThumbnail() right away,
+    /// otherwise thumbnailReady() will be emitted when it is available. Requesting a thumbnail that is already pending only raises its priority if needed.
+    /// Returns an empty key if the thumbnail of the series is an icon instead of an image, which is cheap to create with Series::getThumbnail().
+    QString requestThumbnail(const Series *series, Priority priority = NormalPriority);
+
+    /// Requests the thumbnail of the volume of the given image, as above. It's the thumbnail shown for a volume, so image should be its middle image.
+    QString requestThumbnail(const Image *image, Priority priority = NormalPriority);
+
+    /// Changes the priority of a pending request. Does nothing if there isn't a pending request with the given key.
+    void setPriority(const QString &key, Priority priority);
+
+    /// Cancels a pending request. A thumbnail that is already being created will be cached and notified anyway.
+    void cancelRequest(const QString &key);
+
+    /// Returns true and fills thumbnail if the thumbnail with the given key is in memory.
+    bool getThumbnail(const QString &key, QImage &thumbnail) const;
+
+    /// Waits until all the pending requests have been served. Results are delivered once the event loop processes them.
+    void waitForDone();
+
+signals:
+    /// Emitted when the thumbnail of a request is available.
+    void thumbnailReady(const QString &key, const QImage &thumbnail);
+
+private:
+    /// Request waiting for or being processed by a worker.
+    struct Request {
+        QString key;
+        /// DICOM file to decode if none of the thumbnail files exists.
+        QString imageFilePath;
+        /// Existing thumbnail files that may be used, in order of preference. The created thumbnail is saved to the first one.
+        QStringList thumbnailFilePaths;
+        int resolution;
+        Priority priority;
+        /// Position in the queue of pending requests, from the priority and the order of arrival.
+        quint64 queueKey;
+    };
+
+    class Worker;
+
+    /// Returns the position in the queue of a request with the given priority that arrives now.
+    quint64 getQueueKey(Priority priority);
+
+    /// Moves the given pending request to the end of the requests with the given priority. m_mutex must be locked.
+    void changePriority(Request &request, Priority priority);
+
+    /// Adds the given request unless it is cached, pending or running, and starts a worker if needed.
+    QString addRequest(const Request &request);
+
+    /// Takes the pending request with the highest priority and marks it as running. Returns false and retires the calling worker if there are none.
+    bool takeRequest(Request &request);
+
+    /// Returns the thumbnail of the given request, read from a thumbnail file or decoded. A decoded thumbnail is saved if the request has a thumbnail file
+    /// under the persistent cache directory. Called from the workers.
+    QImage createThumbnail(const Request &request) const;
+
+protected:
+    /// Decodes the thumbnail of the given DICOM file with ThumbnailCreator and sets ok to whether it could be decoded. If it couldn't, the returned thumbnail
+    /// says that there isn't a preview available, and it's not saved. Called from the workers.
+    virtual QImage decodeThumbnail(const QString &imageFilePath, int resolution, bool &ok) const;
+
+private slots:
+    /// Caches the thumbnail created for the request with the given key and notifies it.
+    void storeThumbnail(const QString &key, const QImage &thumbnail);
+
+private:
+    /// Protects the members below, which are shared with the workers.
+    mutable QMutex m_mutex;
+
+    /// In-memory LRU cache of the delivered thumbnails. Looking up a thumbnail makes it the most recently used one.
+    mutable QCache<QString, QImage> m_memoryCache;
+    QHash<QString, Request> m_pendingRequests;
+    /// Keys of the pending requests by their position in the queue.
+    QMap<quint64, QString> m_pendingQueue;
+    QSet<QString> m_runningRequests;
+    quint64 m_nextSequenceNumber;
+    int m_numberOfWorkers;
+    QString m_persistentCacheDirectory;
+
+    QThreadPool m_threadPool;
+};
+
+} // End namespace udg
+
+#endif
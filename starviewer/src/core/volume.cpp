@@ -55,11 +55,13 @@ vtkImageData* Volume::getVtkData()
 void Volume::setData(ItkImageTypePointer itkImage)
 {
     m_volumePixelData->setData(itkImage);
+    invalidateSlicePositionIndexes();
 }
 
 void Volume::setData(vtkImageData *vtkImage)
 {
     m_volumePixelData->setData(vtkImage);
+    invalidateSlicePositionIndexes();
 }
 
 void Volume::setPixelData(VolumePixelData *pixelData)
@@ -68,6 +70,7 @@ void Volume::setPixelData(VolumePixelData *pixelData)
     m_volumePixelData = pixelData;
     // Set the number of phases to the new pixel data
     m_volumePixelData->setNumberOfPhases(m_numberOfPhases);
+    invalidateSlicePositionIndexes();
 }
 
 VolumePixelData* Volume::getPixelData()
@@ -91,6 +94,27 @@ bool Volume::isPixelDataLoaded() const
     return m_volumePixelData && m_volumePixelData->isLoaded();
 }
 
+qint64 Volume::getPixelDataMemorySize() const
+{
+    if (!isPixelDataLoaded() || m_volumePixelData->isMemoryMapped())
+    {
+        return 0;
+    }
+
+    // VTK gives the size in kibibytes
+    return static_cast<qint64>(m_volumePixelData->getVtkData()->GetActualMemorySize()) * 1024;
+}
+
+void Volume::releasePixelData()
+{
+    if (isPixelDataLoaded())
+    {
+        delete m_volumePixelData;
+        m_volumePixelData = new VolumePixelData(this);
+        m_volumePixelData->setNumberOfPhases(m_numberOfPhases);
+    }
+}
+
 void Volume::getOrigin(double xyz[3])
 {
     getVtkData()->GetOrigin(xyz);
@@ -167,6 +191,8 @@ void Volume::setNumberOfPhases(int phases)
         {
             getPixelData()->setNumberOfPhases(m_numberOfPhases);
         }
+
+        invalidateSlicePositionIndexes();
     }
 }
 
@@ -212,6 +238,7 @@ QList<Image*> Volume::getPhaseImages(int index)
 void Volume::setNumberOfSlicesPerPhase(int slicesPerPhase)
 {
     m_numberOfSlicesPerPhase = slicesPerPhase;
+    invalidateSlicePositionIndexes();
 }
 
 int Volume::getNumberOfSlicesPerPhase() const
@@ -245,6 +272,7 @@ void Volume::addImage(Image *image)
         }
 
         m_checkedImagesAnatomicalPlane = false;
+        invalidateSlicePositionIndexes();
     }
 }
 
@@ -261,6 +289,7 @@ void Volume::setImages(const QList<Image*> &imageList)
     }
 
     m_checkedImagesAnatomicalPlane = false;
+    invalidateSlicePositionIndexes();
 }
 
 QList<Image*> Volume::getImages() const
@@ -373,6 +402,19 @@ Image* Volume::getImage(int sliceNumber, int phaseNumber) const
     return image;
 }
 
+const SlicePositionIndex& Volume::getSlicePositionIndex(const OrthogonalPlane &plane)
+{
+    if (!m_slicePositionIndexes.contains(plane))
+    {
+        // Built apart because building it may load the pixel data, which invalidates the indexes
+        SlicePositionIndex slicePositionIndex;
+        slicePositionIndex.build(this, plane);
+        m_slicePositionIndexes.insert(plane, slicePositionIndex);
+    }
+
+    return m_slicePositionIndexes[plane];
+}
+
 QString Volume::getPixelUnits()
 {
     QString units;
@@ -487,6 +529,11 @@ QString Volume::getPTPixelUnits(const Image *image)
     return m_PTPixelUnits;
 }
 
+void Volume::invalidateSlicePositionIndexes()
+{
+    m_slicePositionIndexes.clear();
+}
+
 ImagePlane* Volume::getImagePlane(int sliceNumber, const OrthogonalPlane &plane, bool vtkReconstructionHack)
 {
     ImagePlane *imagePlane = 0;
@@ -21,7 +21,9 @@
 #include "volumepixeldata.h"
 #include "anatomicalplane.h"
 #include "orthogonalplane.h"
+#include "slicepositionindex.h"
 // Qt
+#include <QHash>
 #include <QPixmap>
 #include <QVector>
 // FWD declarations
@@ -73,6 +75,13 @@ public:
     /// Si no el té els mètodes que pregunten sobre dades del volum poden donar respostes incorrectes.
     bool isPixelDataLoaded() const;
 
+    /// Returns the memory used by the loaded pixel data in bytes, or 0 if it's not loaded.
+    /// Memory-mapped pixel data is not counted, because the operating system can discard its pages when memory is needed.
+    qint64 getPixelDataMemorySize() const;
+
+    /// Releases the loaded pixel data, so that it will be read again the next time it's requested. Nobody can be using the current pixel data when it's called.
+    void releasePixelData();
+
     /// Obté l'origen del volum
     void getOrigin(double xyz[3]);
     double* getOrigin();
@@ -147,6 +156,10 @@ public:
     /// @return The corresponding image plane
     ImagePlane* getImagePlane(int sliceNumber, const OrthogonalPlane &plane, bool vtkReconstructionHack = false);
     
+    /// Returns an index of the positions of the slices in the given plane, to find the slice nearest to a point.
+    /// It's built the first time it's requested and kept until the images, the phases or the pixel data of the volume change.
+    const SlicePositionIndex& getSlicePositionIndex(const OrthogonalPlane &plane);
+
     /// Returns the pixel units for this volume. If the units cannot be specified, an empty string will be returned
     QString getPixelUnits();
     
@@ -229,6 +242,9 @@ private:
     /// Lazy loading of the units of the pixels of PT series
     QString getPTPixelUnits(const Image *image);
 
+    /// Discards the slice position indexes, which have to be built again the next time they are requested
+    void invalidateSlicePositionIndexes();
+
 private:
 
     /// Conjunt d'imatges que composen el volum
@@ -253,6 +269,9 @@ private:
 
     /// Stores the units of the pixel values of PT series. getPTPixelUnits should always be used to get this value
     QString m_PTPixelUnits;
+
+    /// Slice position indexes already built, by orthogonal plane
+    QHash<int, SlicePositionIndex> m_slicePositionIndexes;
 };
 
 }  // End namespace udg
@@ -18,13 +18,56 @@
 #include "voxel.h"
 #include "mathtools.h"
 
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageData.h>
+#include <vtkPointData.h>
 
 #include "logging.h"
 
 namespace udg {
 
+namespace {
+
+// A file region mapped as the scalars of an image data.
+struct MappedFile {
+    /// Absolute path of the file, used to find the mappings of a file that has to be deleted or replaced.
+    QString fileName;
+    /// The open file. Deleting it unmaps the region and closes the file.
+    QFile *file;
+    /// Size in bytes of the mapped region.
+    qint64 size;
+};
+
+// Mapped files by the data array that wraps them. An array is removed when it's destroyed or when its file is released.
+QHash<vtkObject*, MappedFile> mappedFiles;
+// Protects mappedFiles. It can be accessed from any thread that destroys an array or releases a file.
+QMutex mappedFilesMutex;
+
+// Called when a data array is destroyed. If it still wraps a mapped file, deleting the file unmaps it.
+void unmapFileOnDelete(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    Q_UNUSED(eventId);
+    Q_UNUSED(clientData);
+    Q_UNUSED(callData);
+
+    QMutexLocker locker(&mappedFilesMutex);
+    // If the file has already been released the array owns a copy of the data and there is nothing to do
+    delete mappedFiles.take(caller).file;
+}
+
+}
+
 VolumePixelData::VolumePixelData(QObject *parent) :
     QObject(parent), m_loaded(false)
 {
@@ -114,6 +157,119 @@ void VolumePixelData::setData(unsigned char *data, int extent[6], int bytesPerPi
     imageData->Delete();
 }
 
+bool VolumePixelData::setData(const QString &fileName, qint64 offset, int extent[6], int scalarType, int numberOfComponents, FileMappingMode mode)
+{
+    if (numberOfComponents < 1)
+    {
+        DEBUG_LOG("Number of components should be > 0");
+        return false;
+    }
+
+    vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(scalarType));
+    if (!scalars)
+    {
+        DEBUG_LOG(QString("Unsupported scalar type %1").arg(scalarType));
+        return false;
+    }
+
+    vtkIdType numberOfValues = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1) * numberOfComponents;
+    qint64 size = static_cast<qint64>(numberOfValues) * scalars->GetDataTypeSize();
+
+    QFile *file = new QFile(fileName);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < offset + size)
+    {
+        WARN_LOG(QString("Can't map %1 bytes at offset %2 of %3").arg(size).arg(offset).arg(fileName));
+        delete file;
+        return false;
+    }
+
+    uchar *data = file->map(offset, size, mode == CopyOnWriteMapping ? QFileDevice::MapPrivateOption : QFileDevice::NoOptions);
+    if (!data)
+    {
+        WARN_LOG(QString("Can't map %1: %2").arg(fileName).arg(file->errorString()));
+        delete file;
+        return false;
+    }
+
+    // The array doesn't own the memory (save = 1); the file is unmapped by the observer when the array is destroyed,
+    // which may be after this object if some VTK or ITK consumer still references the scalars
+    scalars->SetNumberOfComponents(numberOfComponents);
+    scalars->SetVoidArray(data, numberOfValues, 1);
+
+    vtkSmartPointer<vtkCallbackCommand> unmapCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+    unmapCommand->SetCallback(unmapFileOnDelete);
+    scalars->AddObserver(vtkCommand::DeleteEvent, unmapCommand);
+
+    {
+        QMutexLocker locker(&mappedFilesMutex);
+        MappedFile mappedFile = { QFileInfo(fileName).absoluteFilePath(), file, size };
+        mappedFiles.insert(scalars, mappedFile);
+    }
+
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetExtent(extent);
+    imageData->GetPointData()->SetScalars(scalars);
+
+    this->setData(imageData);
+
+    return true;
+}
+
+bool VolumePixelData::isMemoryMapped() const
+{
+    vtkDataArray *scalars = m_imageDataVTK ? m_imageDataVTK->GetPointData()->GetScalars() : 0;
+
+    if (!scalars)
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&mappedFilesMutex);
+    return mappedFiles.contains(scalars);
+}
+
+bool VolumePixelData::releaseFileMappings(const QString &fileName)
+{
+    QString absoluteFileName = QFileInfo(fileName).absoluteFilePath();
+    bool allReleased = true;
+
+    QMutexLocker locker(&mappedFilesMutex);
+    QMutableHashIterator<vtkObject*, MappedFile> iterator(mappedFiles);
+
+    while (iterator.hasNext())
+    {
+        iterator.next();
+
+        if (iterator.value().fileName != absoluteFileName)
+        {
+            continue;
+        }
+
+        vtkDataArray *scalars = static_cast<vtkDataArray*>(iterator.key());
+        const MappedFile &mappedFile = iterator.value();
+
+        // VTK frees arrays that own their memory with free()
+        void *copy = std::malloc(mappedFile.size);
+
+        if (!copy)
+        {
+            WARN_LOG(QString("Not enough memory to copy the %1 bytes mapped from %2").arg(mappedFile.size).arg(absoluteFileName));
+            allReleased = false;
+            continue;
+        }
+
+        std::memcpy(copy, scalars->GetVoidPointer(0), mappedFile.size);
+        scalars->SetVoidArray(copy, scalars->GetNumberOfTuples() * scalars->GetNumberOfComponents(), 0);
+        // Its data has changed even if the values are the same
+        scalars->Modified();
+
+        delete mappedFile.file;
+        iterator.remove();
+    }
+
+    return allReleased;
+}
+
 void VolumePixelData::setNumberOfPhases(int numberOfPhases)
 {
     if (numberOfPhases > 0)
@@ -225,6 +381,18 @@ Voxel VolumePixelData::getVoxelValue(int index[3])
     return voxelValue;
 }
 
+bool VolumePixelData::getFirstComponentValue(const double coordinate[3], double &value, int phaseNumber)
+{
+    int index[3];
+    if (!this->computeCoordinateIndex(coordinate, index, phaseNumber))
+    {
+        return false;
+    }
+
+    value = m_imageDataVTK->GetScalarComponentAsDouble(index[0], index[1], index[2], 0);
+    return true;
+}
+
 void VolumePixelData::convertToNeutralPixelData()
 {
     // Creem un objecte vtkImageData "neutre"
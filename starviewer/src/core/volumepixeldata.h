@@ -49,6 +49,9 @@ public:
     typedef itk::Image<ItkPixelType, VDimension> ItkImageType;
     typedef ItkImageType::Pointer ItkImageTypePointer;
 
+    /// Ways in which a file can be mapped to be used as pixel data.
+    enum FileMappingMode { ReadOnlyMapping, CopyOnWriteMapping };
+
     explicit VolumePixelData(QObject *parent = 0);
 
     /// Assignem/Retornem les dades en format ITK
@@ -66,6 +69,22 @@ public:
     /// Les característiques d'spacing i origin no s'assignaran amb aquest mètode. Això caldrà fer-ho accedint posteriorment a les dades vtk
     void setData(unsigned char *data, int extent[6], int bytesPerPixel, bool deleteData = false);
 
+    /// Uses the region of the given file starting at offset as pixel data without reading it: the file is mapped into memory, so the operating system only
+    /// loads the pages that are accessed and can discard them under memory pressure. VTK and ITK data wrap the mapped memory without copying it.
+    /// With ReadOnlyMapping the pixel data must not be modified; with CopyOnWriteMapping modifications are private and never written to the file.
+    /// The file stays mapped, and open, until the VTK scalars are destroyed or releaseFileMappings() is called for it. As with the buffer variant, spacing and
+    /// origin are not assigned. Returns false, leaving the current data untouched, if the file can't be mapped.
+    bool setData(const QString &fileName, qint64 offset, int extent[6], int scalarType, int numberOfComponents, FileMappingMode mode = CopyOnWriteMapping);
+
+    /// Returns true if the pixel data is a memory-mapped file.
+    bool isMemoryMapped() const;
+
+    /// Copies into memory the data of every VTK array that maps the given file and unmaps it, so that the file can be deleted or replaced (an open mapping
+    /// prevents both on Windows). It must be called before deleting or overwriting a file that may be mapped. The scalar pointers of the affected arrays
+    /// change, so it must not be called while they are being accessed from another thread. Returns false if some mapping couldn't be released because
+    /// there wasn't enough memory for the copy.
+    static bool releaseFileMappings(const QString &fileName);
+
     /// Sets the number of phases of this pixel data.
     /// This information is needed to be able to access to the right pixels when accessing through world coordinate
     /// The minimum value must be 1, is less than, the method will do nothing
@@ -100,6 +119,10 @@ public:
     /// Returns the voxel corresponding to the given index. If index is out of range, a default constructed value will be returned.
     Voxel getVoxelValue(int index[3]);
 
+    /// Given a world coordinate, sets in value the first component of the corresponding voxel without building a Voxel.
+    /// Returns true if the coordinate is inside the volume, false otherwise. Meant for loops that only need scalar values, like ROI statistics.
+    bool getFirstComponentValue(const double coordinate[3], double &value, int phaseNumber = 0);
+
     /// S'encarrega de convertir el VolumePixelData en un pixel data neutre que permet que es faci servir en casos en
     /// els que ens quedem sense memòria o ens trobem amb altres problemes a l'hora d'intentar allotjar-ne un en memòria
     void convertToNeutralPixelData();
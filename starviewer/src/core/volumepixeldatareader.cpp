@@ -13,13 +13,18 @@
  *************************************************************************************/
 
 #include "volumepixeldatareader.h"
+
+#include <QMutexLocker>
+
 #include <vtkImageData.h>
+
 namespace udg {
 
 VolumePixelDataReader::VolumePixelDataReader(QObject *parent)
 : QObject(parent)
 {
     m_volumePixelData = NULL;
+    m_firstSliceToLoad = -1;
 }
 
 VolumePixelDataReader::~VolumePixelDataReader()
@@ -31,9 +36,20 @@ void VolumePixelDataReader::setFrameNumbers(const QList<int> &frameNumbers)
     m_frameNumbers = frameNumbers;
 }
 
+void VolumePixelDataReader::setFirstSliceToLoad(int slice)
+{
+    m_firstSliceToLoad = slice;
+}
+
 VolumePixelData* VolumePixelDataReader::getVolumePixelData()
 {
     return m_volumePixelData;
 }
 
+vtkSmartPointer<vtkImageData> VolumePixelDataReader::getPreviewData()
+{
+    QMutexLocker locker(&m_previewDataMutex);
+    return m_previewData;
+}
+
 } // End namespace udg
@@ -15,8 +15,13 @@
 #ifndef UDGVOLUMEPIXELDATAREADER_H
 #define UDGVOLUMEPIXELDATAREADER_H
 
+#include <QMutex>
 #include <QObject>
 
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
 namespace udg {
 
 class VolumePixelData;
@@ -40,6 +45,10 @@ public:
     /// Sets the list of frame numbers in the order they must be read from a multiframe file.
     void setFrameNumbers(const QList<int> &frameNumbers);
 
+    /// Sets the index of the slice that has to be loaded first, so that it can be shown while the rest are being loaded. A negative value means that slices
+    /// are loaded in their natural order. Readers that can't load slices progressively ignore it.
+    void setFirstSliceToLoad(int slice);
+
     /// Donada una llista de noms de fitxer, la llegeix i omple
     /// l'estructura d'imatge que fem servir internament.
     /// Ens retorna un enter que ens indicarà si hi ha hagut alguna mena d'error en el
@@ -54,14 +63,28 @@ public:
     /// Ens retorna les dades llegides
     VolumePixelData* getVolumePixelData();
 
+    /// Returns the image data that is being filled by the current read, sharing its buffer, or null if no slice has been loaded yet. Slices notified with
+    /// sliceLoaded() can be shown from it while the read goes on. It can be called from any thread.
+    vtkSmartPointer<vtkImageData> getPreviewData();
+
 signals:
     /// Ens indica el progrés del procés de lectura
     void progress(int progress);
+    /// Emitted from the reading thread each time the slice with the given index has been loaded into the preview data. Only emitted when a first slice to
+    /// load has been set.
+    void sliceLoaded(int slice);
 
 protected:
     /// List of frame numbers in the order they must be read from a multiframe file. Can be ignored for single-frame files.
     QList<int> m_frameNumbers;
 
+    /// Index of the slice that has to be loaded first. Negative to load slices in their natural order.
+    int m_firstSliceToLoad;
+
+    /// Image data being filled by the current read. Must be accessed with m_previewDataMutex locked.
+    vtkSmartPointer<vtkImageData> m_previewData;
+    QMutex m_previewDataMutex;
+
     /// Les dades d'imatge en format vtk
     VolumePixelData *m_volumePixelData;
 
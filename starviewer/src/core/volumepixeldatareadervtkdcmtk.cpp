@@ -18,9 +18,12 @@
 #include "volumepixeldata.h"
 #include "vtkdcmtkimagereader.h"
 
+#include <QMutexLocker>
 #include <QStringList>
 
 #include <vtkEventQtSlotConnect.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
 #include <vtkStringArray.h>
 
 namespace udg {
@@ -33,6 +36,8 @@ VolumePixelDataReaderVTKDCMTK::VolumePixelDataReaderVTKDCMTK(QObject *parent) :
     // VTK progress
     m_vtkQtConnections = vtkEventQtSlotConnect::New();
     m_vtkQtConnections->Connect(m_reader, vtkCommand::ProgressEvent, this, SLOT(progressSlot()));
+    m_vtkQtConnections->Connect(m_reader, VtkDcmtkImageReader::SliceLoadedEvent, this,
+                                SLOT(sliceLoadedSlot(vtkObject*, unsigned long, void*, void*)));
 }
 
 VolumePixelDataReaderVTKDCMTK::~VolumePixelDataReaderVTKDCMTK()
@@ -74,6 +79,12 @@ int VolumePixelDataReaderVTKDCMTK::read(const QStringList &filenames)
 
     // Set frame numbers to the reader (needed for multiframe files)
     m_reader->setFrameNumbers(m_frameNumbers);
+    m_reader->setFirstSliceToLoad(m_firstSliceToLoad);
+
+    {
+        QMutexLocker locker(&m_previewDataMutex);
+        m_previewData = 0;
+    }
 
     try
     {
@@ -126,4 +137,27 @@ void VolumePixelDataReaderVTKDCMTK::progressSlot()
     emit progress(static_cast<int>(m_reader->GetProgress() * 100));
 }
 
+void VolumePixelDataReaderVTKDCMTK::sliceLoadedSlot(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    Q_UNUSED(caller)
+    Q_UNUSED(eventId)
+    Q_UNUSED(clientData)
+
+    vtkImageData *output = m_reader->GetOutput();
+
+    {
+        QMutexLocker locker(&m_previewDataMutex);
+
+        // The preview shares the output buffer. If the reader has had to allocate a new one (because the scalar type changed) a new preview is created, while
+        // the old buffer is kept alive by the previous preview for anyone still using it.
+        if (!m_previewData || m_previewData->GetPointData()->GetScalars() != output->GetPointData()->GetScalars())
+        {
+            m_previewData = vtkSmartPointer<vtkImageData>::New();
+            m_previewData->ShallowCopy(output);
+        }
+    }
+
+    emit sliceLoaded(*static_cast<int*>(callData));
+}
+
 } // end namespace udg
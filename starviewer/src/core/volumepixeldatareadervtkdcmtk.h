@@ -18,6 +18,7 @@
 #include "volumepixeldatareader.h"
 
 class vtkEventQtSlotConnect;
+class vtkObject;
 
 namespace udg {
 
@@ -45,6 +46,8 @@ private slots:
 
     /// Receives the VTK progress event from the reader and emits the Qt progress signal.
     void progressSlot();
+    /// Receives the slice loaded event from the reader, updates the preview data and emits the Qt sliceLoaded signal.
+    void sliceLoadedSlot(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
 
 private:
 
@@ -14,9 +14,11 @@
 
 #include "volumereader.h"
 
+#include "decodedvolumecache.h"
 #include "image.h"
 #include "logging.h"
 #include "postprocessor.h"
+#include "series.h"
 #include "starviewerapplication.h"
 #include "volume.h"
 #include "volumepixeldatareader.h"
@@ -24,6 +26,9 @@
 
 #include <QMessageBox>
 #include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <vtkImageData.h>
 
 namespace udg {
 
@@ -38,7 +43,7 @@ int getFrameNumber(const Image *image)
 }
 
 VolumeReader::VolumeReader(QObject *parent)
-    : QObject(parent), m_volumePixelDataReader(0), m_abortRequested(false)
+    : QObject(parent), m_volumePixelDataReader(0), m_abortRequested(false), m_firstSliceToLoad(-1)
 {
      m_lastError = VolumePixelDataReader::NoError;
 }
@@ -83,16 +88,41 @@ void VolumeReader::executePixelDataReader(Volume *volume)
         // Set the frame numbers to the pixel data reader (needed for multiframe files)
         QList<int> frameNumbers = QtConcurrent::blockingMapped(volume->getImages(), getFrameNumber);
         m_volumePixelDataReader->setFrameNumbers(frameNumbers);
+        m_volumePixelDataReader->setFirstSliceToLoad(m_firstSliceToLoad);
+
+        Image *firstImage = volume->getImage(0);
+        QString seriesInstanceUID = firstImage && firstImage->getParentSeries() ? firstImage->getParentSeries()->getInstanceUID() : QString();
+        DecodedVolumeCache decodedVolumeCache(seriesInstanceUID, fileList, frameNumbers);
+        VolumePixelData *cachedPixelData = decodedVolumeCache.load();
 
         if (m_abortRequested)
         {
+            delete cachedPixelData;
             m_lastError = VolumePixelDataReader::ReadAborted;
         }
+        else if (cachedPixelData)
+        {
+            // The decoded voxels were cached: the postprocessors still have to be run because the cache holds the data as read
+            DEBUG_LOG("Volume read from the decoded volume cache: " + decodedVolumeCache.getCacheFilePath());
+            volume->setPixelData(cachedPixelData);
+            runPostprocessors(volume);
+            fixSpacingIssues(volume);
+            emit progress(100);
+        }
         else
         {
             m_lastError = m_volumePixelDataReader->read(fileList);
             if (m_lastError == VolumePixelDataReader::NoError)
             {
+                if (decodedVolumeCache.isCacheable())
+                {
+                    // The copy shares the voxels, so they are kept alive while they are written even if the volume releases them,
+                    // and keeps the geometry as read, before the postprocessors change it
+                    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+                    imageData->ShallowCopy(m_volumePixelDataReader->getVolumePixelData()->getVtkData());
+                    QtConcurrent::run([decodedVolumeCache, imageData]() { decodedVolumeCache.store(imageData); });
+                }
+
                 // Tot ha anat ok, assignem les dades al volum
                 volume->setPixelData(m_volumePixelDataReader->getVolumePixelData());
                 runPostprocessors(volume);
@@ -130,6 +160,21 @@ void VolumeReader::requestAbort()
     m_abortRequested = true;
 }
 
+void VolumeReader::setFirstSliceToLoad(int slice)
+{
+    m_firstSliceToLoad = slice;
+}
+
+vtkSmartPointer<vtkImageData> VolumeReader::getPreviewData() const
+{
+    if (m_volumePixelDataReader)
+    {
+        return m_volumePixelDataReader->getPreviewData();
+    }
+
+    return 0;
+}
+
 void VolumeReader::showMessageBoxWithLastError() const
 {
     if (m_lastError == VolumePixelDataReader::NoError)
@@ -252,6 +297,7 @@ void VolumeReader::setUpReader(Volume *volume)
 
     // Connectem les senyals de notificació de progrés
     connect(m_volumePixelDataReader, SIGNAL(progress(int)), SIGNAL(progress(int)));
+    connect(m_volumePixelDataReader, SIGNAL(sliceLoaded(int)), SIGNAL(sliceLoaded(int)));
 }
 
 void VolumeReader::runPostprocessors(Volume *volume)
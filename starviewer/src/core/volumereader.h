@@ -20,6 +20,10 @@
 #include <QQueue>
 #include <QSharedPointer>
 
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
 namespace udg {
 
 class Postprocessor;
@@ -57,11 +61,19 @@ public:
     /// Si no hi ha cap "últim error" es retorna un QString buit.
     QString getLastErrorMessageToUser() const;
 
+    /// Sets the index of the slice that has to be loaded first when reading progressively. A negative value (the default) means natural order.
+    void setFirstSliceToLoad(int slice);
+
+    /// Returns the image data that is being filled by the current read, or null if there is none yet. See VolumePixelDataReader::getPreviewData().
+    vtkSmartPointer<vtkImageData> getPreviewData() const;
+
 signals:
     /// Ens indica el progrés del procés de lectura
     /// TODO: De moment quan es vulgui llegir només un fitxer, p.ex. multiframes, mamos, etc. per limitacions de la lectura,
     /// no tindrem cap tipus de progrés.
     void progress(int progress);
+    /// Emitted from the reading thread each time the slice with the given index has been loaded into the preview data.
+    void sliceLoaded(int slice);
 
 private:
     /// Executa el pixel reader i llegeix el volume
@@ -98,6 +110,9 @@ private:
     /// Used to know that abort has been requested before having the pixel data reader.
     bool m_abortRequested;
 
+    /// Index of the slice that has to be loaded first. Negative to load slices in their natural order.
+    int m_firstSliceToLoad;
+
 };
 
 } // End namespace udg
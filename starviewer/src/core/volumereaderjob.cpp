@@ -18,6 +18,8 @@
 #include "volume.h"
 #include "logging.h"
 
+#include <vtkImageData.h>
+
 namespace udg {
 
 VolumeReaderJob::VolumeReaderJob(Volume *volume, QObject *parent)
@@ -28,6 +30,7 @@ VolumeReaderJob::VolumeReaderJob(Volume *volume, QObject *parent)
     m_volumeReadSuccessfully = false;
     m_lastErrorMessageToUser = "";
     m_abortRequested = false;
+    m_firstSliceToLoad = -1;
 }
 
 VolumeReaderJob::~VolumeReaderJob()
@@ -69,6 +72,18 @@ const Identifier& VolumeReaderJob::getVolumeIdentifier() const
     return m_volumeIdentifier;
 }
 
+void VolumeReaderJob::setFirstSliceToLoad(int slice)
+{
+    QMutexLocker locker(&m_volumeReaderToAbortMutex);
+    m_firstSliceToLoad = slice;
+}
+
+vtkSmartPointer<vtkImageData> VolumeReaderJob::getPreviewData()
+{
+    QMutexLocker locker(&m_previewDataMutex);
+    return m_previewData;
+}
+
 void VolumeReaderJob::run(ThreadWeaver::JobPointer self, ThreadWeaver::Thread *thread)
 {
     Q_UNUSED(self)
@@ -85,9 +100,12 @@ void VolumeReaderJob::run(ThreadWeaver::JobPointer self, ThreadWeaver::Thread *t
         // assegurar-nos que si salta una excepció s'alliberarà el lock.
         QMutexLocker locker(&m_volumeReaderToAbortMutex);
         m_volumeReaderToAbort = volumeReader;
+        volumeReader->setFirstSliceToLoad(m_firstSliceToLoad);
     }
 
     connect(volumeReader, SIGNAL(progress(int)), SLOT(updateProgress(int)));
+    // The preview has to be taken from the reader in this thread, before the reader is destroyed
+    connect(volumeReader, SIGNAL(sliceLoaded(int)), SLOT(updatePreview(int)), Qt::DirectConnection);
     m_volumeReadSuccessfully = volumeReader->readWithoutShowingError(m_volumeToRead);
     m_lastErrorMessageToUser = volumeReader->getLastErrorMessageToUser();
 
@@ -117,4 +135,17 @@ void VolumeReaderJob::updateProgress(int value)
     emit progress(this, value);
 }
 
+void VolumeReaderJob::updatePreview(int slice)
+{
+    VolumeReader *volumeReader = qobject_cast<VolumeReader*>(sender());
+
+    if (volumeReader)
+    {
+        QMutexLocker locker(&m_previewDataMutex);
+        m_previewData = volumeReader->getPreviewData();
+    }
+
+    emit sliceLoaded(this, slice);
+}
+
 } // End namespace udg
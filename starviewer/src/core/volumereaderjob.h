@@ -22,6 +22,10 @@
 #include <QPointer>
 #include <QMutex>
 
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
 namespace udg {
 
 class Volume;
@@ -56,9 +60,19 @@ public:
     /// Returns the identifier of the volume, even if the volume is destructed.
     const Identifier& getVolumeIdentifier() const;
 
+    /// Sets the index of the slice that has to be loaded first, so that it can be shown while the rest are being loaded. It only has effect if called before
+    /// the job starts running. By default slices are loaded in their natural order and no slice is notified.
+    void setFirstSliceToLoad(int slice);
+
+    /// Returns the image data that is being filled while the job runs, or null if no slice has been loaded yet. Slices notified with sliceLoaded() can be
+    /// shown from it before the job finishes.
+    vtkSmartPointer<vtkImageData> getPreviewData();
+
 signals:
     /// Signal que s'emet amb el progrés de lectura
     void progress(VolumeReaderJob*, int progress);
+    /// Emitted from the job thread each time the slice with the given index has been loaded into the preview data.
+    void sliceLoaded(VolumeReaderJob*, int slice);
     void done(ThreadWeaver::JobPointer);
 
 protected:
@@ -69,6 +83,8 @@ protected:
 private slots:
     /// Slot to emit the current progress
     void updateProgress(int value);
+    /// Keeps the current preview data of the reader and emits sliceLoaded(). Called from the job thread.
+    void updatePreview(int slice);
 private:
     Volume *m_volumeToRead;
     /// Keeps the identifier of the volume to have access to it even if the volume is deleted.
@@ -86,6 +102,13 @@ private:
 
     /// Mutex per protegir els canvis de referència a m_volumeReaderToAbort en escenaris de multithreading.
     QMutex m_volumeReaderToAbortMutex;
+
+    /// Index of the slice that has to be loaded first. Negative to load slices in their natural order.
+    int m_firstSliceToLoad;
+
+    /// Image data being filled while the job runs. Must be accessed with m_previewDataMutex locked.
+    vtkSmartPointer<vtkImageData> m_previewData;
+    QMutex m_previewDataMutex;
 };
 
 } // End namespace udg
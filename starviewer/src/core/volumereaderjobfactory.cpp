@@ -88,7 +88,7 @@ VolumeReaderJobFactory::~VolumeReaderJobFactory()
     DEBUG_LOG("VolumeReaderJobFactory is closed");
 }
 
-QSharedPointer<VolumeReaderJob> VolumeReaderJobFactory::read(Volume *volume)
+QSharedPointer<VolumeReaderJob> VolumeReaderJobFactory::read(Volume *volume, int firstSliceToLoad)
 {
     DEBUG_LOG(QString("AsynchronousVolumeReader::read Begin volume: %1").arg(volume->getIdentifier().getValue()));
 
@@ -101,6 +101,7 @@ QSharedPointer<VolumeReaderJob> VolumeReaderJobFactory::read(Volume *volume)
 
     VolumeReaderJob *volumeReaderJob = new VolumeReaderJob(volume);
     QSharedPointer<VolumeReaderJob> jobPointer(volumeReaderJob);
+    volumeReaderJob->setFirstSliceToLoad(firstSliceToLoad);
     assignResourceRestrictionPolicy(volumeReaderJob);
 
     connect(volumeReaderJob, SIGNAL(done(ThreadWeaver::JobPointer)), SLOT(unmarkVolumeFromJobAsLoading(ThreadWeaver::JobPointer)));
@@ -218,6 +219,10 @@ void VolumeReaderJobFactory::unmarkVolumeFromJobAsLoading(ThreadWeaver::JobPoint
     if (volumeReaderJob)
     {
         this->unmarkVolumeAsLoading(volumeReaderJob->getVolumeIdentifier());
+
+        // The new pixel data may exceed the memory budget. It's checked once the pending notifications of the job have been delivered, so that the viewers
+        // waiting for this volume are already displaying it.
+        QMetaObject::invokeMethod(VolumeRepository::getRepository(), "enforceMemoryBudget", Qt::QueuedConnection);
     }
 }
 
@@ -44,12 +44,17 @@ class VolumeReaderJobFactory : public QObject, public SingletonPointer<VolumeRea
 Q_OBJECT
 public:
     /// Starts reading the given volume asynchronously. Returns the job that performs the reading.
-    QSharedPointer<VolumeReaderJob> read(Volume *volume);
+    /// If firstSliceToLoad is not negative the volume is loaded progressively starting from that slice (see VolumeReaderJob::setFirstSliceToLoad()).
+    /// If the volume is already being read, the running job is returned and firstSliceToLoad is ignored.
+    QSharedPointer<VolumeReaderJob> read(Volume *volume, int firstSliceToLoad = -1);
 
     /// Cancel·la la càrrega de volume i, un cop cancel·lada, esborra volume.
     /// Si volume no s'està carregant, l'esborrarà directament.
     void cancelLoadingAndDeleteVolume(Volume *volume);
 
+    /// Ens indica si el volume que se li passa s'està carregant
+    bool isVolumeLoading(Volume *volume) const;
+
 protected:
     friend class SingletonPointer<VolumeReaderJobFactory>;
     explicit VolumeReaderJobFactory(QObject *parent = 0);
@@ -60,8 +65,6 @@ private slots:
     void unmarkVolumeFromJobAsLoading(ThreadWeaver::JobPointer job);
 
 private:
-    /// Ens indica si el volume que se li passa s'està carregant
-    bool isVolumeLoading(Volume *volume) const;
 
     /// Marca el volume que se li passa conforme s'està carregant amb el job volumeReaderJob
     void markVolumeAsLoadingByJob(Volume *volume, QSharedPointer<VolumeReaderJob> volumeReaderJob);
@@ -18,6 +18,8 @@
 #include "volumereaderjob.h"
 #include "volume.h"
 
+#include <vtkImageData.h>
+
 namespace udg {
 
 VolumeReaderManager::VolumeReaderManager(QObject *parent) :
@@ -35,6 +37,7 @@ void VolumeReaderManager::initialize()
     m_volumeReaderJobs.clear();
     m_jobsProgress.clear();
     m_volumes.clear();
+    m_volumesToRead.clear();
     m_success = true;
     m_lastError = "";
     m_numberOfFinishedJobs = 0;
@@ -48,19 +51,21 @@ void VolumeReaderManager::readVolume(Volume *volume)
     readVolumes(volumes);
 }
 
-void VolumeReaderManager::readVolumes(const QList<Volume*> &volumes)
+void VolumeReaderManager::readVolumes(const QList<Volume*> &volumes, int firstSliceToLoad)
 {
     initialize();
 
     foreach (Volume *volume, volumes)
     {
         VolumeReaderJobFactory *volumeReader = VolumeReaderJobFactory::instance();
-        QSharedPointer<VolumeReaderJob> job = volumeReader->read(volume);
+        QSharedPointer<VolumeReaderJob> job = volumeReader->read(volume, firstSliceToLoad);
         m_volumeReaderJobs << job;
         m_jobsProgress.insert(job.data(), 0);
         m_volumes << NULL;
+        m_volumesToRead << volume;
         connect(job.data(), SIGNAL(done(ThreadWeaver::JobPointer)), SLOT(jobFinished(ThreadWeaver::JobPointer)));
         connect(job.data(), SIGNAL(progress(VolumeReaderJob*, int)), SLOT(updateProgress(VolumeReaderJob*, int)));
+        connect(job.data(), SIGNAL(sliceLoaded(VolumeReaderJob*, int)), SLOT(notifySliceLoaded(VolumeReaderJob*, int)));
     }
 }
 
@@ -75,6 +80,7 @@ void VolumeReaderManager::cancelReading()
         {
             disconnect(job.data(), SIGNAL(done(ThreadWeaver::JobPointer)), this, SLOT(jobFinished(ThreadWeaver::JobPointer)));
             disconnect(job.data(), SIGNAL(progress(VolumeReaderJob*, int)), this, SLOT(updateProgress(VolumeReaderJob*, int)));
+            disconnect(job.data(), SIGNAL(sliceLoaded(VolumeReaderJob*, int)), this, SLOT(notifySliceLoaded(VolumeReaderJob*, int)));
         }
         m_volumeReaderJobs[i].clear();
     }
@@ -102,6 +108,33 @@ QString VolumeReaderManager::getLastErrorMessageToUser()
     return m_lastError;
 }
 
+int VolumeReaderManager::getNumberOfVolumesToRead() const
+{
+    return m_volumesToRead.size();
+}
+
+Volume* VolumeReaderManager::getVolumeToRead(int index) const
+{
+    return m_volumesToRead.value(index);
+}
+
+vtkSmartPointer<vtkImageData> VolumeReaderManager::getPreviewData(int index) const
+{
+    if (index < 0 || index >= m_volumeReaderJobs.size())
+    {
+        return 0;
+    }
+
+    QSharedPointer<VolumeReaderJob> job = m_volumeReaderJobs.at(index).toStrongRef().dynamicCast<VolumeReaderJob>();
+
+    if (job.isNull())
+    {
+        return 0;
+    }
+
+    return job->getPreviewData();
+}
+
 bool VolumeReaderManager::isReading()
 {
     return m_numberOfFinishedJobs < m_volumeReaderJobs.size();
@@ -122,6 +155,18 @@ void VolumeReaderManager::updateProgress(VolumeReaderJob *job, int value)
     emit progress(currentProgress);
 }
 
+void VolumeReaderManager::notifySliceLoaded(VolumeReaderJob *job, int slice)
+{
+    for (int i = 0; i < m_volumeReaderJobs.size(); i++)
+    {
+        if (m_volumeReaderJobs.at(i).data() == job)
+        {
+            emit sliceLoaded(i, slice);
+            return;
+        }
+    }
+}
+
 void VolumeReaderManager::jobFinished(ThreadWeaver::JobPointer job)
 {
     QSharedPointer<VolumeReaderJob> volumeReaderJob = job.dynamicCast<VolumeReaderJob>();
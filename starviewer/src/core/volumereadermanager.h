@@ -21,6 +21,10 @@
 
 #include "volumereaderjob.h"
 
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
 namespace udg {
 
 class Volume;
@@ -38,7 +42,8 @@ public:
     void readVolume(Volume *volume);
 
     ///Starts the reading of n volumes
-    void readVolumes(const QList<Volume *> &volumes);
+    /// If firstSliceToLoad is not negative the volumes are loaded progressively starting from that slice, and sliceLoaded() is emitted for each slice.
+    void readVolumes(const QList<Volume *> &volumes, int firstSliceToLoad = -1);
 
     /// Cancels the reading
     void cancelReading();
@@ -56,15 +61,26 @@ public:
     /// Returns the last error messege. An empty string is retured if no error.
     QString getLastErrorMessageToUser();
 
+    /// Returns the number of volumes being read.
+    int getNumberOfVolumesToRead() const;
+    /// Returns the volume being read at the given index.
+    Volume* getVolumeToRead(int index) const;
+    /// Returns the image data that is being filled for the volume at the given index, or null if no slice of it has been loaded yet.
+    vtkSmartPointer<vtkImageData> getPreviewData(int index) const;
+
 signals:
     /// Signal emitted during the reading to report progress
     void progress(int progress);
     /// Signal emitted at the end of the reading
     void readingFinished();
+    /// Signal emitted each time the slice with the given index has been loaded into the preview data of the volume at the given index.
+    void sliceLoaded(int volumeIndex, int slice);
 
 private slots:
     /// Updates the progress of the job and emits the global progress
     void updateProgress(VolumeReaderJob*, int);
+    /// Emits sliceLoaded() with the index of the volume of the given job
+    void notifySliceLoaded(VolumeReaderJob *job, int slice);
     /// Slot executed when a job finished. It emits the signal readingFinished() if no jobs are reading.
     void jobFinished(ThreadWeaver::JobPointer job);
 
@@ -81,6 +97,8 @@ private:
 
     /// List of readed volumes
     QList<Volume*> m_volumes;
+    /// List of volumes being read, in the same order as the jobs
+    QList<Volume*> m_volumesToRead;
 
     /// It says if the reading ended successfully
     int m_success;
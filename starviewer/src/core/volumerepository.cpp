@@ -16,11 +16,15 @@
 #include "volume.h"
 #include "logging.h"
 #include "volumereaderjobfactory.h"
+#include "coresettings.h"
+#include "settings.h"
 
 namespace udg {
 
 VolumeRepository::VolumeRepository()
 {
+    m_memoryBudget = Settings().getValue(CoreSettings::VolumeCacheMemoryBudget).toLongLong() * 1024 * 1024;
+    resetCacheStatistics();
 }
 
 Identifier VolumeRepository::addVolume(Volume *model)
@@ -28,6 +32,7 @@ Identifier VolumeRepository::addVolume(Volume *model)
     Identifier id;
 
     id = this->addItem(model);
+    m_leastRecentlyUsed.append(id);
     emit itemAdded(id);
     INFO_LOG("S'ha afegit al repositori el volum amb id: " + QString::number(id.getValue()));
     return id;
@@ -50,6 +55,10 @@ void VolumeRepository::deleteVolume(Identifier id)
 
     // El treiem de la llista
     this->removeItem(id);
+    m_leastRecentlyUsed.removeAll(id);
+    m_displayCount.remove(id);
+    m_pinCount.remove(id);
+    m_evictedVolumes.remove(id.getValue());
 
     // I l'eliminem
     VolumeReaderJobFactory *volumeReader = VolumeReaderJobFactory::instance();
@@ -64,4 +73,171 @@ int VolumeRepository::getNumberOfVolumes()
     return this->getNumberOfItems();
 }
 
+void VolumeRepository::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = qMax(Q_INT64_C(0), bytes);
+    enforceMemoryBudget();
+}
+
+qint64 VolumeRepository::getMemoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+qint64 VolumeRepository::getMemoryUsage() const
+{
+    qint64 memoryUsage = 0;
+
+    foreach (Volume *volume, this->getItems())
+    {
+        memoryUsage += volume->getPixelDataMemorySize();
+    }
+
+    return memoryUsage;
+}
+
+void VolumeRepository::volumeDisplayed(Volume *volume)
+{
+    if (!contains(volume))
+    {
+        return;
+    }
+
+    Identifier id = volume->getIdentifier();
+
+    if (m_displayCount.value(id) == 0)
+    {
+        if (m_evictedVolumes.remove(id.getValue()))
+        {
+            m_cacheStatistics.misses++;
+        }
+        else if (volume->isPixelDataLoaded())
+        {
+            m_cacheStatistics.hits++;
+        }
+    }
+
+    m_displayCount[id]++;
+    markAsMostRecentlyUsed(id);
+}
+
+void VolumeRepository::volumeNoLongerDisplayed(Volume *volume)
+{
+    if (!contains(volume))
+    {
+        return;
+    }
+
+    Identifier id = volume->getIdentifier();
+
+    if (m_displayCount.value(id) > 1)
+    {
+        m_displayCount[id]--;
+    }
+    else
+    {
+        m_displayCount.remove(id);
+    }
+
+    markAsMostRecentlyUsed(id);
+    enforceMemoryBudget();
+}
+
+void VolumeRepository::pinPixelData(Volume *volume)
+{
+    if (!contains(volume))
+    {
+        return;
+    }
+
+    m_pinCount[volume->getIdentifier()]++;
+}
+
+void VolumeRepository::unpinPixelData(Volume *volume)
+{
+    if (!contains(volume))
+    {
+        return;
+    }
+
+    Identifier id = volume->getIdentifier();
+
+    if (m_pinCount.value(id) > 1)
+    {
+        m_pinCount[id]--;
+    }
+    else
+    {
+        m_pinCount.remove(id);
+        enforceMemoryBudget();
+    }
+}
+
+bool VolumeRepository::isPixelDataPinned(Volume *volume) const
+{
+    return volume && m_pinCount.contains(volume->getIdentifier());
+}
+
+const VolumeRepository::CacheStatistics& VolumeRepository::getCacheStatistics() const
+{
+    return m_cacheStatistics;
+}
+
+void VolumeRepository::resetCacheStatistics()
+{
+    m_cacheStatistics.hits = 0;
+    m_cacheStatistics.misses = 0;
+    m_cacheStatistics.evictions = 0;
+    m_cacheStatistics.bytesEvicted = 0;
+}
+
+void VolumeRepository::enforceMemoryBudget()
+{
+    if (m_memoryBudget <= 0)
+    {
+        return;
+    }
+
+    qint64 memoryUsage = getMemoryUsage();
+    VolumeReaderJobFactory *volumeReaderJobFactory = VolumeReaderJobFactory::instance();
+
+    foreach (const Identifier &id, m_leastRecentlyUsed)
+    {
+        if (memoryUsage <= m_memoryBudget)
+        {
+            break;
+        }
+
+        Volume *volume = this->getVolume(id);
+
+        if (!volume || m_displayCount.contains(id) || m_pinCount.contains(id) || !volume->isPixelDataLoaded() ||
+            volumeReaderJobFactory->isVolumeLoading(volume))
+        {
+            continue;
+        }
+
+        qint64 size = volume->getPixelDataMemorySize();
+        volume->releasePixelData();
+        memoryUsage -= size;
+
+        m_evictedVolumes.insert(id.getValue());
+        m_cacheStatistics.evictions++;
+        m_cacheStatistics.bytesEvicted += size;
+
+        INFO_LOG(QString("S'ha alliberat el pixel data del volum amb id %1 (%2 bytes). Memòria en ús: %3 bytes, pressupost: %4 bytes.")
+                 .arg(id.getValue()).arg(size).arg(memoryUsage).arg(m_memoryBudget));
+    }
+}
+
+void VolumeRepository::markAsMostRecentlyUsed(const Identifier &id)
+{
+    m_leastRecentlyUsed.removeAll(id);
+    m_leastRecentlyUsed.append(id);
+}
+
+bool VolumeRepository::contains(Volume *volume) const
+{
+    return volume && this->getItem(volume->getIdentifier()) == volume;
+}
+
 }
@@ -20,6 +20,8 @@
 #include "identifier.h"
 
 #include <QObject>
+#include <QMap>
+#include <QSet>
 
 namespace udg {
 
@@ -41,10 +43,30 @@ namespace udg {
     ...
     Volume* m_volume = m_volumeRepository->getVolume(id);
     \endcode
+
+    The repository also works as a memory-budgeted cache of pixel data. Viewers tell it which volumes they are displaying. When the pixel data of all the
+    volumes exceeds the budget, the pixel data of the least recently displayed volumes that aren't displayed, pinned nor being loaded is released. It will be
+    read again, through VolumeReaderJobFactory or Volume::getPixelData(), the next time it's needed.
+
+    Releasing the pixel data deletes the VolumePixelData of the volume, so code that keeps it, its VTK or ITK data or a pipeline built on them while the
+    volume isn't displayed by a viewer must pin the volume with pinPixelData() and unpin it with unpinPixelData() when it's done.
   */
 class VolumeRepository : public Repository<Volume> {
 Q_OBJECT
 public:
+    /// Statistics of the pixel data cache.
+    struct CacheStatistics
+    {
+        /// Number of times a volume has been displayed again with its pixel data still in memory.
+        int hits;
+        /// Number of times a volume has been displayed again after its pixel data had been released.
+        int misses;
+        /// Number of times the pixel data of a volume has been released.
+        int evictions;
+        /// Total number of bytes released.
+        qint64 bytesEvicted;
+    };
+
     /// Afegeix un volum al repositori.
     /// Ens retorna l'id del volum afegit per poder-lo obtenir més endavant.
     Identifier addVolume(Volume *model);
@@ -58,6 +80,36 @@ public:
     /// Retorna el nombre de volums que hi ha al repositori
     int getNumberOfVolumes();
 
+    /// Sets the maximum number of bytes of pixel data to keep in memory. 0 means no limit. Releases pixel data if needed.
+    void setMemoryBudget(qint64 bytes);
+    /// Returns the maximum number of bytes of pixel data to keep in memory. 0 means no limit.
+    qint64 getMemoryBudget() const;
+
+    /// Returns the number of bytes of pixel data currently in memory.
+    qint64 getMemoryUsage() const;
+
+    /// Must be called by a viewer when it starts displaying the given volume. Volumes not in the repository are ignored.
+    void volumeDisplayed(Volume *volume);
+    /// Must be called by a viewer when it stops displaying the given volume. Volumes not in the repository are ignored.
+    void volumeNoLongerDisplayed(Volume *volume);
+
+    /// Prevents the pixel data of the given volume from being released until unpinPixelData() is called as many times as this method.
+    /// Volumes not in the repository are ignored.
+    void pinPixelData(Volume *volume);
+    /// Undoes a call to pinPixelData() and releases pixel data if needed. Volumes not in the repository are ignored.
+    void unpinPixelData(Volume *volume);
+    /// Returns true if the pixel data of the given volume is pinned.
+    bool isPixelDataPinned(Volume *volume) const;
+
+    /// Returns the statistics of the pixel data cache.
+    const CacheStatistics& getCacheStatistics() const;
+    /// Resets the statistics of the pixel data cache.
+    void resetCacheStatistics();
+
+public slots:
+    /// Releases the pixel data of the least recently displayed volumes that aren't displayed, pinned nor being loaded until the memory budget is respected.
+    void enforceMemoryBudget();
+
     /// Ens retorna l'única instància del repositori.
     static VolumeRepository* getRepository()
     {
@@ -75,6 +127,26 @@ signals:
 private:
     /// Ha de quedar amagat perquè no poguem crear instàncies
     VolumeRepository();
+
+    /// Moves the volume with the given id to the most recently used end of the LRU list.
+    void markAsMostRecentlyUsed(const Identifier &id);
+
+    /// Returns true if the given volume is in the repository.
+    bool contains(Volume *volume) const;
+
+private:
+    /// Maximum number of bytes of pixel data to keep in memory. 0 means no limit.
+    qint64 m_memoryBudget;
+    /// Volume ids ordered from the least to the most recently displayed.
+    QList<Identifier> m_leastRecentlyUsed;
+    /// Number of viewers that are displaying each volume.
+    QMap<Identifier, int> m_displayCount;
+    /// Number of pins of each pinned volume.
+    QMap<Identifier, int> m_pinCount;
+    /// Ids of the volumes whose pixel data has been released and not displayed again yet.
+    QSet<int> m_evictedVolumes;
+    /// Statistics of the pixel data cache.
+    CacheStatistics m_cacheStatistics;
 };
 
 }
@@ -0,0 +1,175 @@
+/*************************************************************************************
+  Copyright (C) 2014 Laboratori de Gràfics i Imatge, Universitat de Girona &
+  Institut de Diagnòstic per la Imatge.
+  Girona 2014. All rights reserved.
+  http://starviewer.udg.edu
+
+  This file is part of the Starviewer (Medical Imaging Software) open source project.
+  It is subject to the license terms in the LICENSE file found in the top-level
+  directory of this distribution and at http://starviewer.udg.edu/license. No part of
+  the Starviewer (Medical Imaging Software) open source project, including this file,
+  may be copied, modified, propagated, or distributed except according to the
+  terms contained in the LICENSE file.
+ *************************************************************************************/
+
+#ifndef UDGVOXELSHADERCHAIN_H
+#define UDGVOXELSHADERCHAIN_H
+
+#include "voxelshader.h"
+
+#include "trilinearinterpolator.h"
+
+#include <QStringList>
+
+#include <tuple>
+
+namespace udg {
+
+namespace VoxelShaderChainPrivate {
+
+/// Aplica els voxel shaders de la tupla des de la posició Index fins al final. La recursió es resol en temps de compilació.
+template <int Index, int Size>
+struct Step {
+    template <class Tuple>
+    static HdrColor shade(const Tuple &voxelShaders, const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity,
+                          const HdrColor &baseColor)
+    {
+        Q_ASSERT(std::get<Index>(voxelShaders));
+
+        HdrColor color = std::get<Index>(voxelShaders)->nvShade(position, offset, direction, remainingOpacity, baseColor);
+        return Step<Index + 1, Size>::shade(voxelShaders, position, offset, direction, remainingOpacity, color);
+    }
+
+    template <class Tuple>
+    static HdrColor shade(const Tuple &voxelShaders, const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator,
+                          float remainingOpacity, const HdrColor &baseColor)
+    {
+        Q_ASSERT(std::get<Index>(voxelShaders));
+
+        HdrColor color = std::get<Index>(voxelShaders)->nvShade(position, direction, interpolator, remainingOpacity, baseColor);
+        return Step<Index + 1, Size>::shade(voxelShaders, position, direction, interpolator, remainingOpacity, color);
+    }
+
+    template <class Tuple>
+    static void toString(const Tuple &voxelShaders, QStringList &strings)
+    {
+        strings << (std::get<Index>(voxelShaders) ? std::get<Index>(voxelShaders)->toString() : "null");
+        Step<Index + 1, Size>::toString(voxelShaders, strings);
+    }
+};
+
+template <int Size>
+struct Step<Size, Size> {
+    template <class Tuple>
+    static HdrColor shade(const Tuple&, const Vector3&, int, const Vector3&, float, const HdrColor &baseColor)
+    {
+        return baseColor;
+    }
+
+    template <class Tuple>
+    static HdrColor shade(const Tuple&, const Vector3&, const Vector3&, const TrilinearInterpolator*, float, const HdrColor &baseColor)
+    {
+        return baseColor;
+    }
+
+    template <class Tuple>
+    static void toString(const Tuple&, QStringList&)
+    {
+    }
+};
+
+}
+
+/**
+    És un voxel shader que n'encadena un nombre qualsevol, aplicant-los en l'ordre dels paràmetres del template.
+
+    Generalitza CombiningVoxelShader: la cadena es resol en temps de compilació, de manera que amb vtkVolumeRayCastSingleVoxelShaderCompositeFunction
+    tots els nvShade de la cadena es poden fer inline dins el bucle de ray casting en lloc de fer una crida virtual per shader i per mostra com fa
+    vtkVolumeRayCastVoxelShaderCompositeFunction. Els voxel shaders encadenats han d'implementar els mètodes nvShade.
+  */
+template <class... VS>
+class VoxelShaderChain : public VoxelShader {
+
+public:
+    VoxelShaderChain();
+    virtual ~VoxelShaderChain();
+
+    /// Assigna els voxel shaders que s'encadenaran.
+    void setVoxelShaders(VS*... voxelShaders);
+
+    /// Retorna el color corresponent al vòxel a la posició offset.
+    virtual HdrColor shade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor = HdrColor());
+    /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
+    virtual HdrColor shade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
+                            const HdrColor &baseColor = HdrColor());
+    /// Retorna el color corresponent al vòxel a la posició offset.
+    HdrColor nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor = HdrColor());
+    /// Retorna el color corresponent al vòxel a la posició position, fent servir valors interpolats.
+    HdrColor nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator, float remainingOpacity,
+                      const HdrColor &baseColor = HdrColor());
+    /// Retorna un string representatiu del voxel shader.
+    virtual QString toString() const;
+
+private:
+    typedef std::tuple<VS*...> VoxelShaders;
+    typedef VoxelShaderChainPrivate::Step<0, sizeof...(VS)> FirstStep;
+
+    VoxelShaders m_voxelShaders;
+
+};
+
+template <class... VS>
+VoxelShaderChain<VS...>::VoxelShaderChain()
+ : VoxelShader(), m_voxelShaders()
+{
+}
+
+template <class... VS>
+VoxelShaderChain<VS...>::~VoxelShaderChain()
+{
+}
+
+template <class... VS>
+void VoxelShaderChain<VS...>::setVoxelShaders(VS*... voxelShaders)
+{
+    m_voxelShaders = VoxelShaders(voxelShaders...);
+}
+
+template <class... VS>
+inline HdrColor VoxelShaderChain<VS...>::shade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity, const HdrColor &baseColor)
+{
+    return nvShade(position, offset, direction, remainingOpacity, baseColor);
+}
+
+template <class... VS>
+inline HdrColor VoxelShaderChain<VS...>::shade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator,
+                                                float remainingOpacity, const HdrColor &baseColor)
+{
+    return nvShade(position, direction, interpolator, remainingOpacity, baseColor);
+}
+
+template <class... VS>
+inline HdrColor VoxelShaderChain<VS...>::nvShade(const Vector3 &position, int offset, const Vector3 &direction, float remainingOpacity,
+                                                  const HdrColor &baseColor)
+{
+    return FirstStep::shade(m_voxelShaders, position, offset, direction, remainingOpacity, baseColor);
+}
+
+template <class... VS>
+inline HdrColor VoxelShaderChain<VS...>::nvShade(const Vector3 &position, const Vector3 &direction, const TrilinearInterpolator *interpolator,
+                                                  float remainingOpacity, const HdrColor &baseColor)
+{
+    return FirstStep::shade(m_voxelShaders, position, direction, interpolator, remainingOpacity, baseColor);
+}
+
+template <class... VS>
+QString VoxelShaderChain<VS...>::toString() const
+{
+    QStringList strings;
+    FirstStep::toString(m_voxelShaders, strings);
+    return "VoxelShaderChain<" + strings.join(", ") + ">";
+}
+
+}
+
+#endif
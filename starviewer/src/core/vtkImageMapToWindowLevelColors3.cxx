@@ -41,6 +41,8 @@
 #include "vtkScalarsToColors.h"
 #include "vtkPointData.h"
 
+#include <limits>
+
 vtkStandardNewMacro(vtkImageMapToWindowLevelColors3)
 
 // Constructor sets default values
@@ -48,6 +50,10 @@ vtkImageMapToWindowLevelColors3::vtkImageMapToWindowLevelColors3()
 {
   this->Window = 255;
   this->Level  = 127.5;
+  this->UseWindowLevelTable = 1;
+  this->WindowLevelTableWindow = 0.0;
+  this->WindowLevelTableLevel = 0.0;
+  this->WindowLevelTableScalarType = -1;
 }
 
 vtkImageMapToWindowLevelColors3::~vtkImageMapToWindowLevelColors3()
@@ -95,6 +101,8 @@ int vtkImageMapToWindowLevelColors3::RequestData(
       this->DataWasPassed = 0;
       }
 
+    this->UpdateWindowLevelTable(inData);
+
     return this->vtkThreadedImageAlgorithm::RequestData(request, inputVector,
                                                         outputVector);
     }
@@ -403,6 +411,245 @@ void vtkImageMapToWindowLevelColors3Execute(
     }
 }
 
+//----------------------------------------------------------------------------
+// Returns true if values of the given scalar type can index a window / level
+// table, i.e. if it is an integer type of at most 16 bits.
+static bool vtkWindowLevelTableSupportsScalarType3(int scalarType)
+{
+  switch (scalarType)
+    {
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR:
+    case VTK_UNSIGNED_CHAR:
+    case VTK_SHORT:
+    case VTK_UNSIGNED_SHORT:
+      return true;
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Fills the table with the window / level result of every value of type T,
+// computed with the same clamps and helper as the per pixel kernel so that
+// both modes give exactly the same output.
+template <class T>
+void vtkBuildWindowLevelTable3(vtkImageData *inData, double window,
+                               double level, std::vector<unsigned char> &table)
+{
+  double shift = window / 2.0 - level;
+  double scale = 255.0 / window;
+
+  T lower, upper;
+  unsigned char lower_val, upper_val;
+  vtkImageMapToWindowLevelClamps3( inData, window, level,
+                                  lower, upper, lower_val, upper_val );
+
+  const int minimum = static_cast<int>(std::numeric_limits<T>::min());
+  const int maximum = static_cast<int>(std::numeric_limits<T>::max());
+  table.resize(maximum - minimum + 1);
+
+  for (int value = minimum; value <= maximum; value++)
+    {
+    T typedValue = static_cast<T>(value);
+    vtkClampHelper3<T>(&typedValue, &table[value - minimum], lower, upper,
+                       lower_val, upper_val, shift, scale);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Same as vtkImageMapToWindowLevelColors3Execute, but each component is
+// mapped with a single load from the window / level table. The output format
+// is resolved once per row, so the inner loops have no branches.
+template <class T>
+void vtkImageMapToWindowLevelColors3TableExecute(
+  vtkImageMapToWindowLevelColors3 *self,
+  vtkImageData *inData, T *inPtr,
+  vtkImageData *outData,
+  unsigned char *outPtr,
+  int outExt[6], int id,
+  const unsigned char *table)
+{
+  int idxX, idxY, idxZ;
+  int extX, extY, extZ;
+  vtkIdType inIncX, inIncY, inIncZ;
+  vtkIdType outIncX, outIncY, outIncZ;
+  unsigned long count = 0;
+  unsigned long target;
+  int numberOfComponents,numberOfOutputComponents,outputFormat;
+  int rowLength;
+  vtkScalarsToColors *lookupTable = self->GetLookupTable();
+  unsigned char *outPtr1;
+  T *inPtr1;
+  unsigned char *optr;
+  T    *iptr;
+
+  // Index of a value in the table
+  const int offset = -static_cast<int>(std::numeric_limits<T>::min());
+
+  // find the region to loop over
+  extX = outExt[1] - outExt[0] + 1;
+  extY = outExt[3] - outExt[2] + 1;
+  extZ = outExt[5] - outExt[4] + 1;
+
+  target = (unsigned long)(extZ*extY/50.0);
+  target++;
+
+  // Get increments to march through data
+  inData->GetContinuousIncrements(outExt, inIncX, inIncY, inIncZ);
+
+  outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+  numberOfComponents = inData->GetNumberOfScalarComponents();
+  numberOfOutputComponents = outData->GetNumberOfScalarComponents();
+  outputFormat = self->GetOutputFormat();
+
+  rowLength = extX*numberOfComponents;
+
+  // Components of the input used for the green and blue output components,
+  // the first one if the input is grayscale
+  const int greenComponent = 1 % numberOfComponents;
+  const int blueComponent = 2 % numberOfComponents;
+
+  if (lookupTable)
+    {
+    lookupTable->SetRange(0, 255);
+    }
+
+  // Loop through output pixels
+  outPtr1 = outPtr;
+  inPtr1 = inPtr;
+  for (idxZ = 0; idxZ < extZ; idxZ++)
+    {
+    for (idxY = 0; !self->AbortExecute && idxY < extY; idxY++)
+      {
+      if (!id)
+        {
+        if (!(count%target))
+          {
+          self->UpdateProgress(count/(50.0*target));
+          }
+        count++;
+        }
+
+      iptr = inPtr1;
+      optr = outPtr1;
+
+      switch (outputFormat)
+        {
+        case VTK_RGBA:
+          for (idxX = 0; idxX < extX; idxX++)
+            {
+            optr[0] = table[iptr[0] + offset];
+            optr[1] = table[iptr[greenComponent] + offset];
+            optr[2] = table[iptr[blueComponent] + offset];
+            optr[3] = 255;
+            iptr += numberOfComponents;
+            optr += numberOfOutputComponents;
+            }
+          break;
+        case VTK_RGB:
+          for (idxX = 0; idxX < extX; idxX++)
+            {
+            optr[0] = table[iptr[0] + offset];
+            optr[1] = table[iptr[greenComponent] + offset];
+            optr[2] = table[iptr[blueComponent] + offset];
+            iptr += numberOfComponents;
+            optr += numberOfOutputComponents;
+            }
+          break;
+        case VTK_LUMINANCE_ALPHA:
+          for (idxX = 0; idxX < extX; idxX++)
+            {
+            optr[0] = table[iptr[0] + offset];
+            optr[1] = 255;
+            iptr += numberOfComponents;
+            optr += numberOfOutputComponents;
+            }
+          break;
+        default:
+          if (numberOfComponents == 1 && numberOfOutputComponents == 1)
+            {
+            // The most common case, a contiguous gather the compiler can unroll
+            for (idxX = 0; idxX < extX; idxX++)
+              {
+              optr[idxX] = table[iptr[idxX] + offset];
+              }
+            }
+          else
+            {
+            for (idxX = 0; idxX < extX; idxX++)
+              {
+              optr[0] = table[iptr[0] + offset];
+              iptr += numberOfComponents;
+              optr += numberOfOutputComponents;
+              }
+            }
+          break;
+        }
+
+      if (lookupTable)
+        {
+        lookupTable->MapScalarsThroughTable2(outPtr1,(unsigned char *)outPtr1,
+                                           outData->GetScalarType(),extX,numberOfOutputComponents,
+                                           outputFormat);
+        }
+      outPtr1 += outIncY + extX*numberOfOutputComponents;
+      inPtr1 += inIncY + rowLength;
+      }
+    outPtr1 += outIncZ;
+    inPtr1 += inIncZ;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelColors3::UpdateWindowLevelTable(vtkImageData *inData)
+{
+  int scalarType = inData->GetScalarType();
+
+  if (!this->UseWindowLevelTable ||
+      !vtkWindowLevelTableSupportsScalarType3(scalarType))
+    {
+    return;
+    }
+
+  if (this->CanUseWindowLevelTable(inData))
+    {
+    return;
+    }
+
+  switch (scalarType)
+    {
+    case VTK_CHAR:
+      vtkBuildWindowLevelTable3<char>(inData, this->Window, this->Level, this->WindowLevelTable);
+      break;
+    case VTK_SIGNED_CHAR:
+      vtkBuildWindowLevelTable3<signed char>(inData, this->Window, this->Level, this->WindowLevelTable);
+      break;
+    case VTK_UNSIGNED_CHAR:
+      vtkBuildWindowLevelTable3<unsigned char>(inData, this->Window, this->Level, this->WindowLevelTable);
+      break;
+    case VTK_SHORT:
+      vtkBuildWindowLevelTable3<short>(inData, this->Window, this->Level, this->WindowLevelTable);
+      break;
+    case VTK_UNSIGNED_SHORT:
+      vtkBuildWindowLevelTable3<unsigned short>(inData, this->Window, this->Level, this->WindowLevelTable);
+      break;
+    }
+
+  this->WindowLevelTableWindow = this->Window;
+  this->WindowLevelTableLevel = this->Level;
+  this->WindowLevelTableScalarType = scalarType;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageMapToWindowLevelColors3::CanUseWindowLevelTable(vtkImageData *inData)
+{
+  return this->UseWindowLevelTable &&
+         this->WindowLevelTableScalarType == inData->GetScalarType() &&
+         this->WindowLevelTableWindow == this->Window &&
+         this->WindowLevelTableLevel == this->Level;
+}
+
 //----------------------------------------------------------------------------
 // This method is passed a input and output data, and executes the filter
 // algorithm to fill the output from the input.
@@ -418,6 +665,36 @@ void vtkImageMapToWindowLevelColors3::ThreadedRequestData(
   void *inPtr = inData[0][0]->GetScalarPointerForExtent(outExt);
   void *outPtr = outData[0]->GetScalarPointerForExtent(outExt);
 
+  // The table has been built by RequestData before starting the threads
+  if (this->CanUseWindowLevelTable(inData[0][0]))
+    {
+    const unsigned char *table = &this->WindowLevelTable[0];
+
+    switch (inData[0][0]->GetScalarType())
+      {
+      case VTK_CHAR:
+        vtkImageMapToWindowLevelColors3TableExecute(this, inData[0][0], (char *)(inPtr),
+                                                   outData[0], (unsigned char *)(outPtr), outExt, id, table);
+        return;
+      case VTK_SIGNED_CHAR:
+        vtkImageMapToWindowLevelColors3TableExecute(this, inData[0][0], (signed char *)(inPtr),
+                                                   outData[0], (unsigned char *)(outPtr), outExt, id, table);
+        return;
+      case VTK_UNSIGNED_CHAR:
+        vtkImageMapToWindowLevelColors3TableExecute(this, inData[0][0], (unsigned char *)(inPtr),
+                                                   outData[0], (unsigned char *)(outPtr), outExt, id, table);
+        return;
+      case VTK_SHORT:
+        vtkImageMapToWindowLevelColors3TableExecute(this, inData[0][0], (short *)(inPtr),
+                                                   outData[0], (unsigned char *)(outPtr), outExt, id, table);
+        return;
+      case VTK_UNSIGNED_SHORT:
+        vtkImageMapToWindowLevelColors3TableExecute(this, inData[0][0], (unsigned short *)(inPtr),
+                                                   outData[0], (unsigned char *)(outPtr), outExt, id, table);
+        return;
+      }
+    }
+
   switch (inData[0][0]->GetScalarType())
     {
     vtkTemplateMacro(
@@ -441,4 +718,5 @@ void vtkImageMapToWindowLevelColors3::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Window: " << this->Window << endl;
   os << indent << "Level: " << this->Level << endl;
+  os << indent << "UseWindowLevelTable: " << this->UseWindowLevelTable << endl;
 }
@@ -49,6 +49,8 @@
 
 #include "vtkImageMapToColors.h"
 
+#include <vector>
+
 class VTK_EXPORT vtkImageMapToWindowLevelColors3 : public vtkImageMapToColors
 {
 public:
@@ -70,6 +72,16 @@ public:
   vtkSetMacro( Level, double );
   vtkGetMacro( Level, double );
 
+  // Description:
+  // Set / Get whether integer inputs of up to 16 bits are mapped through a
+  // table that holds the window / level result of every possible value,
+  // instead of evaluating the window / level for each pixel. The table is
+  // only rebuilt when the window, the level or the scalar type change, and
+  // the output is the same in both modes. On by default.
+  vtkSetMacro( UseWindowLevelTable, int );
+  vtkGetMacro( UseWindowLevelTable, int );
+  vtkBooleanMacro( UseWindowLevelTable, int );
+
 protected:
   vtkImageMapToWindowLevelColors3();
   ~vtkImageMapToWindowLevelColors3();
@@ -84,8 +96,26 @@ protected:
                           vtkInformationVector **inputVector,
                           vtkInformationVector *outputVector);
 
+  // Builds the window / level table for the given input if the table mode
+  // can be used and the current table doesn't match the window, the level
+  // or the scalar type. Called before the threads start.
+  void UpdateWindowLevelTable(vtkImageData *inData);
+
+  // Returns true if the current window / level table can be used for the
+  // given input.
+  bool CanUseWindowLevelTable(vtkImageData *inData);
+
   double Window;
   double Level;
+  int UseWindowLevelTable;
+
+  // Window / level result for every value of the scalar type, indexed by
+  // value minus the minimum of the type, and the parameters it was built
+  // with. The scalar type is -1 when there is no valid table.
+  std::vector<unsigned char> WindowLevelTable;
+  double WindowLevelTableWindow;
+  double WindowLevelTableLevel;
+  int WindowLevelTableScalarType;
 
 private:
   vtkImageMapToWindowLevelColors3(const vtkImageMapToWindowLevelColors3&);  // Not implemented.
@@ -32,6 +32,311 @@
 
 #include "logging.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VTK_PROJECTION_IMAGE_FILTER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#define VTK_PROJECTION_IMAGE_FILTER_USE_AVX2
+#include <immintrin.h>
+#endif
+
+
+/// Running state of vtkProjectionImageFilter kept between executions to update the projection incrementally when the slab is moved
+/// along the projection dimension.
+///
+/// Positions are measured in samples, i.e. slices of the same phase: sample u is the input slice Phase + u * Step, and the slab at
+/// position u covers samples [u, u + Thickness - 1].
+///
+/// The average keeps the running sum of the slab: the samples leaving the slab are subtracted and the entering ones are added.
+/// Maximum and minimum use the van Herk/Gil-Werman decomposition: the slab is split at an anchor sample m into a part covered by
+/// Thickness partial planes, cumulative from the anchor outwards, and a running plane accumulating the other part as the slab
+/// advances. Once the slab has completely crossed the anchor the partial planes are rebuilt for the next block, so each step costs
+/// O(1) amortized per pixel regardless of the thickness. When moving forward, partial plane k holds samples [m - Thickness + k, m - 1]
+/// and the running plane samples [m, u + Thickness - 1]; when moving backward, partial plane k holds samples [m, m + k] and the
+/// running plane samples [u, m - 1]. A change of direction builds the decomposition again.
+///
+/// The running plane is only needed once the slab has left the first partial plane of the block (plane 0 forward, plane
+/// Thickness - 1 backward), so it is stored in that plane and the planes form a ring of Thickness planes.
+///
+/// Memory cost: the average keeps one plane of doubles, i.e. 8 x PlaneSize bytes. Maximum and minimum keep Thickness planes of the
+/// input scalar type, i.e. Thickness x PlaneSize x scalar size bytes, where PlaneSize is the number of values of the output plane
+/// (e.g. 64 MB for a 512x512 unsigned short output and a slab of 128 slices). No state is kept when IncrementalUpdate is off or
+/// when it would take more than IncrementalUpdateMemoryLimit, and the storage is freed as soon as the state is invalidated.
+class vtkProjectionImageFilterSlidingWindow {
+public:
+    enum Mode { FullProjection, Initialize, Advance };
+
+    vtkProjectionImageFilterSlidingWindow()
+        : Valid(false), CurrentMode(FullProjection)
+    {
+    }
+
+    /// Returns the range of input slices that the next execution needs along the projection dimension: the new slab and, when the
+    /// state can be reused, the previous one.
+    void getRequiredSlices(vtkProjectionImageFilter *self, int &firstSlice, int &lastSlice) const
+    {
+        firstSlice = self->GetFirstSlice();
+        lastSlice = self->GetFirstSlice() + self->GetStep() * (self->GetNumberOfSlicesToProject() - 1);
+
+        if (isCompatibleWith(self))
+        {
+            int previousFirstSlice = Phase + Position * Step;
+            firstSlice = std::min(firstSlice, previousFirstSlice);
+            lastSlice = std::max(lastSlice, previousFirstSlice + Step * (Thickness - 1));
+        }
+    }
+
+    /// Decides how the next execution will compute the projection. Must be called before the threads are started.
+    void prepare(vtkProjectionImageFilter *self, vtkImageData *input, const int outputUpdateExtent[6], const int outputWholeExtent[6])
+    {
+        CurrentMode = FullProjection;
+
+        if (!self->GetIncrementalUpdate() || self->GetUseLegacyAccumulators() || self->GetNumberOfSlicesToProject() <= 1)
+        {
+            release();
+            return;
+        }
+
+        // The running state covers the whole output plane, so partial updates can't use it
+        for (int i = 0; i < 6; i++)
+        {
+            if (outputUpdateExtent[i] != outputWholeExtent[i])
+            {
+                release();
+                return;
+            }
+        }
+
+        // Floating point sums would accumulate rounding errors over long scrolls
+        bool isFloatingPoint = input->GetScalarType() == VTK_FLOAT || input->GetScalarType() == VTK_DOUBLE;
+        if (self->GetAccumulatorType() == udg::AccumulatorFactory::Average && isFloatingPoint)
+        {
+            release();
+            return;
+        }
+
+        // Thick slabs of large planes would take too much memory, and then the whole slab is projected in each execution
+        vtkIdType bufferSize = getBufferSize(self->GetAccumulatorType(), self->GetNumberOfSlicesToProject(), input, outputWholeExtent);
+        if (bufferSize * static_cast<vtkIdType>(sizeof(double)) > self->GetIncrementalUpdateMemoryLimit())
+        {
+            release();
+            return;
+        }
+
+        int newPosition = self->GetFirstSlice() / self->GetStep();
+
+        if (isCompatibleWith(self) && Input == input && InputMTime == input->GetMTime() && ScalarType == input->GetScalarType()
+            && NumberOfComponents == input->GetNumberOfScalarComponents() && hasSameOutputPlane(outputWholeExtent)
+            && inputContainsRequiredSlices(self, input))
+        {
+            int delta = newPosition - Position;
+
+            if (AccumulatorType == udg::AccumulatorFactory::Average)
+            {
+                // Each moved sample costs a subtraction and an addition
+                CurrentMode = 2 * std::abs(delta) < Thickness ? Advance : Initialize;
+            }
+            else
+            {
+                int direction = delta >= 0 ? 1 : -1;
+                CurrentMode = (delta == 0 || direction == Direction) && std::abs(delta) < Thickness ? Advance : Initialize;
+            }
+        }
+        else
+        {
+            CurrentMode = Initialize;
+        }
+
+        if (CurrentMode == Initialize)
+        {
+            ProjectionDimension = self->GetProjectionDimension();
+            AccumulatorType = self->GetAccumulatorType();
+            Thickness = self->GetNumberOfSlicesToProject();
+            Step = self->GetStep();
+            Phase = self->GetFirstSlice() % Step;
+            Input = input;
+            InputMTime = input->GetMTime();
+            ScalarType = input->GetScalarType();
+            NumberOfComponents = input->GetNumberOfScalarComponents();
+            std::copy(outputWholeExtent, outputWholeExtent + 6, OutputExtent);
+
+            Direction = !Valid || newPosition >= Position ? 1 : -1;
+            Position = newPosition;
+            Anchor = Direction > 0 ? Position + Thickness : Position;
+
+            PlaneSize = getPlaneSize(input, OutputExtent);
+
+            // The previous storage is freed first, so that the state of the previous parameters and the new one are never kept together
+            if (static_cast<vtkIdType>(Buffer.size()) != bufferSize)
+            {
+                std::vector<double>().swap(Buffer);
+                Buffer.resize(bufferSize);
+            }
+        }
+
+        NewPosition = newPosition;
+        Valid = true;
+    }
+
+    /// Updates the state after the execution
+    void commit(vtkProjectionImageFilter *self)
+    {
+        if (CurrentMode == FullProjection)
+        {
+            return;
+        }
+
+        if (self->AbortExecute)
+        {
+            release();
+            return;
+        }
+
+        if (CurrentMode == Advance && AccumulatorType != udg::AccumulatorFactory::Average)
+        {
+            for (int position = Position; position != NewPosition; position += Direction)
+            {
+                Anchor = getNextAnchor(position, Anchor, Direction, Thickness);
+            }
+        }
+
+        Position = NewPosition;
+        CurrentMode = FullProjection;
+    }
+
+    /// Returns the anchor after moving one sample from position in the given direction
+    static int getNextAnchor(int position, int anchor, int direction, int thickness)
+    {
+        if (direction > 0 && position == anchor)
+        {
+            return anchor + thickness;
+        }
+        else if (direction < 0 && position == anchor - thickness)
+        {
+            return anchor - thickness;
+        }
+        else
+        {
+            return anchor;
+        }
+    }
+
+    /// Invalidates the state and frees its storage
+    void release()
+    {
+        Valid = false;
+        std::vector<double>().swap(Buffer);
+    }
+
+    /// Returns the number of bytes taken by the state
+    vtkIdType getMemorySize() const
+    {
+        return static_cast<vtkIdType>(Buffer.capacity() * sizeof(double));
+    }
+
+    Mode getMode() const
+    {
+        return CurrentMode;
+    }
+
+    template <class AccumulationType> AccumulationType* getPlane(int plane)
+    {
+        return reinterpret_cast<AccumulationType*>(Buffer.data()) + plane * PlaneSize;
+    }
+
+    /// Returns the running plane of maximum and minimum, which shares the storage of the first partial plane of the block
+    template <class AccumulationType> AccumulationType* getRunningPlane()
+    {
+        return getPlane<AccumulationType>(Direction > 0 ? 0 : Thickness - 1);
+    }
+
+public:
+    int Thickness;
+    int Step;
+    int Phase;
+    /// Position of the slab before this execution
+    int Position;
+    /// Position of the slab after this execution
+    int NewPosition;
+    int Anchor;
+    int Direction;
+    vtkIdType PlaneSize;
+
+private:
+    /// Returns the number of values of the output plane
+    static vtkIdType getPlaneSize(vtkImageData *input, const int outputExtent[6])
+    {
+        vtkIdType planeSize = static_cast<vtkIdType>(input->GetNumberOfScalarComponents());
+        for (int i = 0; i < 3; i++)
+        {
+            planeSize *= outputExtent[2 * i + 1] - outputExtent[2 * i] + 1;
+        }
+
+        return planeSize;
+    }
+
+    /// Returns the number of doubles of the storage needed by the state for the given parameters
+    static vtkIdType getBufferSize(int accumulatorType, int thickness, vtkImageData *input, const int outputExtent[6])
+    {
+        vtkIdType planeSize = getPlaneSize(input, outputExtent);
+
+        // Average only needs the running sum; maximum and minimum need the partial planes, one of which also holds the running plane
+        vtkIdType numberOfValues = accumulatorType == udg::AccumulatorFactory::Average ? planeSize : planeSize * thickness;
+        vtkIdType bytesPerValue = accumulatorType == udg::AccumulatorFactory::Average ? sizeof(double) : input->GetScalarSize();
+        // The storage is allocated in doubles to be correctly aligned for any scalar type
+        return (numberOfValues * bytesPerValue + sizeof(double) - 1) / sizeof(double);
+    }
+
+    bool isCompatibleWith(vtkProjectionImageFilter *self) const
+    {
+        return Valid && ProjectionDimension == self->GetProjectionDimension() && AccumulatorType == self->GetAccumulatorType()
+                && Thickness == self->GetNumberOfSlicesToProject() && Step == self->GetStep() && Phase == self->GetFirstSlice() % Step;
+    }
+
+    /// The output extent along the projection dimension is the first slice, so it is not compared
+    bool hasSameOutputPlane(const int outputWholeExtent[6]) const
+    {
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            if (i != ProjectionDimension
+                && (OutputExtent[2 * i] != outputWholeExtent[2 * i] || OutputExtent[2 * i + 1] != outputWholeExtent[2 * i + 1]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool inputContainsRequiredSlices(vtkProjectionImageFilter *self, vtkImageData *input) const
+    {
+        int firstSlice, lastSlice;
+        getRequiredSlices(self, firstSlice, lastSlice);
+        int *extent = input->GetExtent();
+
+        return extent[2 * ProjectionDimension] <= firstSlice && lastSlice <= extent[2 * ProjectionDimension + 1];
+    }
+
+private:
+    bool Valid;
+    Mode CurrentMode;
+    unsigned int ProjectionDimension;
+    int AccumulatorType;
+    vtkImageData *Input;
+    unsigned long InputMTime;
+    int ScalarType;
+    int NumberOfComponents;
+    int OutputExtent[6];
+    std::vector<double> Buffer;
+};
+
 
 vtkStandardNewMacro(vtkProjectionImageFilter);
 
@@ -47,6 +352,10 @@ vtkProjectionImageFilter/*<TAccumulator>*/::vtkProjectionImageFilter()
     FirstSlice = 0;
     NumberOfSlicesToProject = 1;
     Step = 1;
+    UseLegacyAccumulators = false;
+    IncrementalUpdate = false;
+    IncrementalUpdateMemoryLimit = static_cast<vtkIdType>(256) * 1024 * 1024;
+    SlidingWindow = new vtkProjectionImageFilterSlidingWindow();
 }
 
 
@@ -56,6 +365,7 @@ vtkProjectionImageFilter/*<TAccumulator>*/::vtkProjectionImageFilter()
 // template <class TAccumulator>
 vtkProjectionImageFilter/*<TAccumulator>*/::~vtkProjectionImageFilter()
 {
+    delete SlidingWindow;
 }
 
 
@@ -69,11 +379,86 @@ void vtkProjectionImageFilter::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << "FirstSlice: " << FirstSlice << "\n";
     os << indent << "NumberOfSlicesToProject: " << NumberOfSlicesToProject << "\n";
     os << indent << "Step: " << Step << "\n";
+    os << indent << "UseLegacyAccumulators: " << UseLegacyAccumulators << "\n";
+    os << indent << "IncrementalUpdate: " << IncrementalUpdate << "\n";
+    os << indent << "IncrementalUpdateMemoryLimit: " << IncrementalUpdateMemoryLimit << "\n";
 
     os << std::flush;
 }
 
 
+void vtkProjectionImageFilter::SetProjectionDimension(unsigned int projectionDimension)
+{
+    if (ProjectionDimension != projectionDimension)
+    {
+        ProjectionDimension = projectionDimension;
+        SlidingWindow->release();
+        Modified();
+    }
+}
+
+
+void vtkProjectionImageFilter::SetAccumulatorType(udg::AccumulatorFactory::AccumulatorType accumulatorType)
+{
+    if (AccumulatorType != accumulatorType)
+    {
+        AccumulatorType = accumulatorType;
+        SlidingWindow->release();
+        Modified();
+    }
+}
+
+
+void vtkProjectionImageFilter::SetNumberOfSlicesToProject(int numberOfSlicesToProject)
+{
+    if (NumberOfSlicesToProject != numberOfSlicesToProject)
+    {
+        NumberOfSlicesToProject = numberOfSlicesToProject;
+        SlidingWindow->release();
+        Modified();
+    }
+}
+
+
+void vtkProjectionImageFilter::SetStep(int step)
+{
+    if (Step != step)
+    {
+        Step = step;
+        SlidingWindow->release();
+        Modified();
+    }
+}
+
+
+void vtkProjectionImageFilter::SetIncrementalUpdate(bool incrementalUpdate)
+{
+    if (IncrementalUpdate != incrementalUpdate)
+    {
+        IncrementalUpdate = incrementalUpdate;
+
+        if (!IncrementalUpdate)
+        {
+            SlidingWindow->release();
+        }
+
+        Modified();
+    }
+}
+
+
+vtkIdType vtkProjectionImageFilter::GetIncrementalUpdateMemorySize() const
+{
+    return SlidingWindow->getMemorySize();
+}
+
+
+void vtkProjectionImageFilter::ReleaseIncrementalUpdateState()
+{
+    SlidingWindow->release();
+}
+
+
 // Change the WholeExtent
 int vtkProjectionImageFilter::RequestInformation (
                                        vtkInformation * vtkNotUsed(request),
@@ -123,8 +508,11 @@ int vtkProjectionImageFilter::RequestUpdateExtent(
 //     DEBUG_LOG( QString( "outUpdateExtent: %1 %2 %3 %4 %5 %6" ).arg(updateExtent[0]).arg(updateExtent[1]).arg(updateExtent[2]).arg(updateExtent[3]).arg(updateExtent[4]).arg(updateExtent[5]) );
 
     // TODO veure això de l'extent
-    updateExtent[2*ProjectionDimension] = FirstSlice;
-    updateExtent[2*ProjectionDimension+1] = FirstSlice + Step * ( NumberOfSlicesToProject - 1 );
+    // The incremental update may also need the slices of the previous slab
+    int firstSlice, lastSlice;
+    SlidingWindow->getRequiredSlices(this, firstSlice, lastSlice);
+    updateExtent[2*ProjectionDimension] = firstSlice;
+    updateExtent[2*ProjectionDimension+1] = lastSlice;
 //     updateExtent[2*ProjectionDimension] = 0;
 //     updateExtent[2*ProjectionDimension+1] = 0;
 
@@ -137,26 +525,15 @@ int vtkProjectionImageFilter::RequestUpdateExtent(
 
 
 template <class T>
-void vtkProjectionImageFilterExecute(vtkProjectionImageFilter *self,
+void vtkProjectionImageFilterLegacyExecute(vtkProjectionImageFilter *self,
                                      vtkImageData *inData, T *inPtr,
                                      vtkImageData *outData, T *outPtr,
-                                     int inExt[6], int outExt[6],
+                                     int inExt[6], int vtkNotUsed(outExt)[6],
                                      int vtkNotUsed(id) )
 {
     unsigned int projectionDimension = self->GetProjectionDimension();
     unsigned int iA = projectionDimension, i0 = (iA + 1) % 3, i1 = (iA + 2) % 3;
 
-    // per 1 thread això no cal, però per 2 o més potser sí
-    // compute the input region for this thread
-    for ( unsigned int i = 0; i < 6; i++ )
-    {
-//         DEBUG_LOG( QString( "inExt[%1] = %2 | outExt[%1] = %3" ).arg( i ).arg( inExt[i] ).arg( outExt[i] ) );
-        if( i / 2 != projectionDimension )
-        {
-            inExt[i] = outExt[i];
-        }
-    }
-
     int inMin0, inMax0, inMin1, inMax1, inMinA, inMaxA;
     inMin0 = inExt[2*i0]; inMax0 = inExt[2*i0+1];
     inMin1 = inExt[2*i1]; inMax1 = inExt[2*i1+1];
@@ -258,55 +635,696 @@ void vtkProjectionImageFilterExecute(vtkProjectionImageFilter *self,
 }
 
 
+namespace {
+
+/// Maximum intensity projection. Values are accumulated in the input type.
+template <class T> struct MaximumProjection {
+    typedef T AccumulationType;
+
+    static inline void initialize(AccumulationType &accumulated, T input)
+    {
+        accumulated = input;
+    }
+    static inline void accumulate(AccumulationType &accumulated, T input)
+    {
+        accumulated = input > accumulated ? input : accumulated;
+    }
+    static inline T getValue(AccumulationType accumulated, int vtkNotUsed(numberOfSlices))
+    {
+        return accumulated;
+    }
+};
+
+/// Minimum intensity projection. Values are accumulated in the input type.
+template <class T> struct MinimumProjection {
+    typedef T AccumulationType;
+
+    static inline void initialize(AccumulationType &accumulated, T input)
+    {
+        accumulated = input;
+    }
+    static inline void accumulate(AccumulationType &accumulated, T input)
+    {
+        accumulated = input < accumulated ? input : accumulated;
+    }
+    static inline T getValue(AccumulationType accumulated, int vtkNotUsed(numberOfSlices))
+    {
+        return accumulated;
+    }
+};
+
+/// Average intensity projection. Values are summed in double precision, which is exact for all integer scalar types with the
+/// number of slices we can find in a volume, and the result is rounded only for integer types.
+template <class T> struct AverageProjection {
+    typedef double AccumulationType;
+
+    static inline void initialize(AccumulationType &accumulated, T input)
+    {
+        accumulated = input;
+    }
+    static inline void accumulate(AccumulationType &accumulated, T input)
+    {
+        accumulated += input;
+    }
+    static inline T getValue(AccumulationType accumulated, int numberOfSlices)
+    {
+        double average = accumulated / numberOfSlices;
+
+        if (std::numeric_limits<T>::is_integer)
+        {
+            return static_cast<T>(std::floor(average + 0.5));
+        }
+        else
+        {
+            return static_cast<T>(average);
+        }
+    }
+};
+
+/// Accumulates a contiguous row of input values into a row of accumulated values. The generic version is written as a plain
+/// loop so that the compiler can vectorize it; specializations below use explicit SIMD instructions for the most common types.
+template <class Projection> struct RowAccumulator {
+    template <class T>
+    static inline void accumulate(typename Projection::AccumulationType *accumulated, const T *input, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            Projection::accumulate(accumulated[i], input[i]);
+        }
+    }
+};
+
+#ifdef VTK_PROJECTION_IMAGE_FILTER_USE_SSE2
+
+// Signed short is the scalar type of almost every CT, and unsigned char the one of most secondary captures and RGB images,
+// so they are the ones worth writing by hand. SSE2 only offers 8-bit unsigned and 16-bit signed min/max.
+#define VTK_PROJECTION_IMAGE_FILTER_SIMD_ROW_ACCUMULATOR(Projection, Type, Operation128, Operation256)                            \
+template <> struct RowAccumulator< Projection<Type> > {                                                                      \
+    static inline void accumulate(Type *accumulated, const Type *input, int count)                                           \
+    {                                                                                                                        \
+        int i = 0;                                                                                                           \
+        VTK_PROJECTION_IMAGE_FILTER_AVX2_LOOP(Type, Operation256)                                                            \
+        const int valuesPerRegister = static_cast<int>(sizeof(__m128i) / sizeof(Type));                                     \
+        for (; i + valuesPerRegister <= count; i += valuesPerRegister)                                                       \
+        {                                                                                                                    \
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accumulated + i));                                  \
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));                                        \
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulated + i), Operation128(a, b));                               \
+        }                                                                                                                    \
+        for (; i < count; i++)                                                                                               \
+        {                                                                                                                    \
+            Projection<Type>::accumulate(accumulated[i], input[i]);                                                          \
+        }                                                                                                                    \
+    }                                                                                                                        \
+};
+
+#ifdef VTK_PROJECTION_IMAGE_FILTER_USE_AVX2
+#define VTK_PROJECTION_IMAGE_FILTER_AVX2_LOOP(Type, Operation256)                                                                 \
+        const int valuesPerAvxRegister = static_cast<int>(sizeof(__m256i) / sizeof(Type));                                  \
+        for (; i + valuesPerAvxRegister <= count; i += valuesPerAvxRegister)                                                 \
+        {                                                                                                                    \
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(accumulated + i));                               \
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));                                     \
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(accumulated + i), Operation256(a, b));                            \
+        }
+#else
+#define VTK_PROJECTION_IMAGE_FILTER_AVX2_LOOP(Type, Operation256)
+#endif
+
+VTK_PROJECTION_IMAGE_FILTER_SIMD_ROW_ACCUMULATOR(MaximumProjection, short, _mm_max_epi16, _mm256_max_epi16)
+VTK_PROJECTION_IMAGE_FILTER_SIMD_ROW_ACCUMULATOR(MinimumProjection, short, _mm_min_epi16, _mm256_min_epi16)
+VTK_PROJECTION_IMAGE_FILTER_SIMD_ROW_ACCUMULATOR(MaximumProjection, unsigned char, _mm_max_epu8, _mm256_max_epu8)
+VTK_PROJECTION_IMAGE_FILTER_SIMD_ROW_ACCUMULATOR(MinimumProjection, unsigned char, _mm_min_epu8, _mm256_min_epu8)
+
+#undef VTK_PROJECTION_IMAGE_FILTER_SIMD_ROW_ACCUMULATOR
+#undef VTK_PROJECTION_IMAGE_FILTER_AVX2_LOOP
+
+#endif
+
+/// Projection when the projection dimension is not the X axis: for each output row, the corresponding input rows of all the slices
+/// of the slab are accumulated one after the other (slice-outer, row-inner), so that memory is always read sequentially.
+/// Components are interleaved in memory and projected independently, so a row is rowLength = width * numberOfComponents values.
+template <class Projection, class T>
+void projectRows(vtkProjectionImageFilter *self, const T *inPtr, T *outPtr, int rowLength, int numberOfRows,
+                 vtkIdType inRowIncrement, vtkIdType outRowIncrement, int numberOfSlices, vtkIdType inSliceIncrement)
+{
+    typedef typename Projection::AccumulationType AccumulationType;
+    std::vector<AccumulationType> accumulatedRow(rowLength);
+    AccumulationType *accumulated = accumulatedRow.data();
+
+    for (int row = 0; row < numberOfRows && !self->AbortExecute; row++)
+    {
+        const T *inRow = inPtr + row * inRowIncrement;
+
+        for (int i = 0; i < rowLength; i++)
+        {
+            Projection::initialize(accumulated[i], inRow[i]);
+        }
+
+        for (int slice = 1; slice < numberOfSlices; slice++)
+        {
+            inRow += inSliceIncrement;
+            RowAccumulator<Projection>::accumulate(accumulated, inRow, rowLength);
+        }
+
+        T *outRow = outPtr + row * outRowIncrement;
+
+        for (int i = 0; i < rowLength; i++)
+        {
+            outRow[i] = Projection::getValue(accumulated[i], numberOfSlices);
+        }
+    }
+}
+
+/// Projection along the X axis: each output value is the accumulation of a run of values that are already close in memory,
+/// so they are reduced directly pixel by pixel.
+template <class Projection, class T>
+void projectColumns(vtkProjectionImageFilter *self, const T *inPtr, T *outPtr, int numberOfComponents,
+                    int size0, vtkIdType inIncrement0, vtkIdType outIncrement0,
+                    int size1, vtkIdType inIncrement1, vtkIdType outIncrement1,
+                    int numberOfSlices, vtkIdType inSliceIncrement)
+{
+    typedef typename Projection::AccumulationType AccumulationType;
+
+    for (int index1 = 0; index1 < size1 && !self->AbortExecute; index1++)
+    {
+        for (int index0 = 0; index0 < size0; index0++)
+        {
+            const T *inPixel = inPtr + index1 * inIncrement1 + index0 * inIncrement0;
+            T *outPixel = outPtr + index1 * outIncrement1 + index0 * outIncrement0;
+
+            for (int component = 0; component < numberOfComponents; component++)
+            {
+                const T *in = inPixel + component;
+                AccumulationType accumulated;
+                Projection::initialize(accumulated, *in);
+
+                for (int slice = 1; slice < numberOfSlices; slice++)
+                {
+                    in += inSliceIncrement;
+                    Projection::accumulate(accumulated, *in);
+                }
+
+                outPixel[component] = Projection::getValue(accumulated, numberOfSlices);
+            }
+        }
+    }
+}
+
+template <class Projection, class T>
+void project(vtkProjectionImageFilter *self, vtkImageData *inData, const T *inPtr, vtkImageData *outData, T *outPtr, int inExt[6])
+{
+    unsigned int iA = self->GetProjectionDimension();
+
+    vtkIdType inIncs[3], outIncs[3];
+    inData->GetIncrements(inIncs);
+    outData->GetIncrements(outIncs);
+
+    int numberOfComponents = inData->GetNumberOfScalarComponents();
+    int numberOfSlices = (inExt[2 * iA + 1] - inExt[2 * iA]) / self->GetStep() + 1;
+    vtkIdType inSliceIncrement = self->GetStep() * inIncs[iA];
+
+    if (iA != 0)
+    {
+        // Rows along X are contiguous both in the input and the output
+        unsigned int rowsAxis = iA == 1 ? 2 : 1;
+        int rowLength = (inExt[1] - inExt[0] + 1) * numberOfComponents;
+        int numberOfRows = inExt[2 * rowsAxis + 1] - inExt[2 * rowsAxis] + 1;
+
+        projectRows<Projection>(self, inPtr, outPtr, rowLength, numberOfRows, inIncs[rowsAxis], outIncs[rowsAxis], numberOfSlices,
+                                inSliceIncrement);
+    }
+    else
+    {
+        projectColumns<Projection>(self, inPtr, outPtr, numberOfComponents,
+                                   inExt[3] - inExt[2] + 1, inIncs[1], outIncs[1],
+                                   inExt[5] - inExt[4] + 1, inIncs[2], outIncs[2],
+                                   numberOfSlices, inSliceIncrement);
+    }
+}
+
+
+/// One row of the output plane and the corresponding rows of the input samples for the incremental kernels. The planes of the running
+/// state have the same layout as the output.
+template <class T> struct SlidingWindowRow {
+    /// Row of the first sample of the new slab
+    const T *input;
+    /// Distance between consecutive values of an input row
+    vtkIdType inputIncrement;
+    /// Distance between the rows of consecutive samples
+    vtkIdType sampleIncrement;
+    int firstSample;
+    T *output;
+    /// Distance between consecutive values of an output row and of the state rows
+    vtkIdType outputIncrement;
+    /// Offset of the row in the planes of the running state
+    vtkIdType stateOffset;
+    int count;
+
+    inline const T* getSample(int sample) const
+    {
+        return input + (sample - firstSample) * sampleIncrement;
+    }
+    inline bool isContiguous() const
+    {
+        return inputIncrement == 1 && outputIncrement == 1;
+    }
+};
+
+template <class T>
+void copySampleRow(T *state, const T *sample, const SlidingWindowRow<T> &row)
+{
+    for (int i = 0; i < row.count; i++)
+    {
+        state[i * row.outputIncrement] = sample[i * row.inputIncrement];
+    }
+}
+
+template <class Projection, class T>
+void accumulateSampleRow(typename Projection::AccumulationType *state, const T *sample, const SlidingWindowRow<T> &row)
+{
+    if (row.isContiguous())
+    {
+        RowAccumulator<Projection>::accumulate(state, sample, row.count);
+    }
+    else
+    {
+        for (int i = 0; i < row.count; i++)
+        {
+            Projection::accumulate(state[i * row.outputIncrement], sample[i * row.inputIncrement]);
+        }
+    }
+}
+
+/// Builds the partial planes of the van Herk/Gil-Werman decomposition around the given anchor for one row
+template <class Projection, class T>
+void buildPartialPlanes(vtkProjectionImageFilterSlidingWindow *window, const SlidingWindowRow<T> &row, int anchor)
+{
+    int thickness = window->Thickness;
+    vtkIdType increment = row.outputIncrement;
+
+    for (int k = 0; k < thickness; k++)
+    {
+        // Forward: plane k = samples [anchor - thickness + k, anchor - 1], built from the anchor backwards
+        // Backward: plane k = samples [anchor, anchor + k], built from the anchor forwards
+        int plane = window->Direction > 0 ? thickness - 1 - k : k;
+        int previousPlane = window->Direction > 0 ? plane + 1 : plane - 1;
+        int sample = window->Direction > 0 ? anchor - thickness + plane : anchor + plane;
+        T *partial = window->getPlane<T>(plane) + row.stateOffset;
+
+        if (k == 0)
+        {
+            copySampleRow(partial, row.getSample(sample), row);
+        }
+        else
+        {
+            const T *previousPartial = window->getPlane<T>(previousPlane) + row.stateOffset;
+            for (int i = 0; i < row.count; i++)
+            {
+                partial[i * increment] = previousPartial[i * increment];
+            }
+            accumulateSampleRow<Projection>(partial, row.getSample(sample), row);
+        }
+    }
+}
+
+/// Incremental maximum or minimum projection of one row
+template <class Projection, class T>
+void slidingWindowExtremumRow(vtkProjectionImageFilterSlidingWindow *window, const SlidingWindowRow<T> &row, bool initialize)
+{
+    int thickness = window->Thickness;
+    int direction = window->Direction;
+    T *running = window->getRunningPlane<T>() + row.stateOffset;
+    int position = initialize ? window->NewPosition : window->Position;
+    int anchor = window->Anchor;
+
+    if (initialize)
+    {
+        buildPartialPlanes<Projection>(window, row, anchor);
+    }
+
+    while (position != window->NewPosition)
+    {
+        int nextPosition = position + direction;
+        int nextAnchor = vtkProjectionImageFilterSlidingWindow::getNextAnchor(position, anchor, direction, thickness);
+        const T *enteringSample = row.getSample(direction > 0 ? nextPosition + thickness - 1 : nextPosition);
+        bool runningIsEmpty = direction > 0 ? position + thickness - 1 < anchor : position >= anchor;
+
+        if (nextAnchor != anchor)
+        {
+            buildPartialPlanes<Projection>(window, row, nextAnchor);
+            runningIsEmpty = true;
+        }
+
+        if (runningIsEmpty)
+        {
+            copySampleRow(running, enteringSample, row);
+        }
+        else
+        {
+            accumulateSampleRow<Projection>(running, enteringSample, row);
+        }
+
+        position = nextPosition;
+        anchor = nextAnchor;
+    }
+
+    // The slab is the union of one partial plane and the running plane, one of which may be empty
+    int partialPlane = -1;
+    bool hasRunning;
+
+    if (direction > 0)
+    {
+        partialPlane = position < anchor ? position - (anchor - thickness) : -1;
+        hasRunning = position + thickness - 1 >= anchor;
+    }
+    else
+    {
+        partialPlane = position + thickness - 1 >= anchor ? position + thickness - 1 - anchor : -1;
+        hasRunning = position < anchor;
+    }
+
+    const T *partial = partialPlane >= 0 ? window->getPlane<T>(partialPlane) + row.stateOffset : 0;
+    vtkIdType increment = row.outputIncrement;
+
+    for (int i = 0; i < row.count; i++)
+    {
+        T value = partial ? partial[i * increment] : running[i * increment];
+
+        if (partial && hasRunning)
+        {
+            Projection::accumulate(value, running[i * increment]);
+        }
+
+        row.output[i * increment] = value;
+    }
+}
+
+/// Incremental average projection of one row
+template <class T>
+void slidingWindowAverageRow(vtkProjectionImageFilterSlidingWindow *window, const SlidingWindowRow<T> &row, bool initialize)
+{
+    typedef AverageProjection<T> Projection;
+    int thickness = window->Thickness;
+    vtkIdType increment = row.outputIncrement;
+    double *sum = window->getPlane<double>(0) + row.stateOffset;
+
+    // Samples in [firstAdded, lastAdded] are added and samples in [firstRemoved, lastRemoved] are subtracted
+    int firstAdded, lastAdded, firstRemoved, lastRemoved;
+
+    if (initialize)
+    {
+        const T *sample = row.getSample(window->NewPosition);
+        for (int i = 0; i < row.count; i++)
+        {
+            Projection::initialize(sum[i * increment], sample[i * row.inputIncrement]);
+        }
+        firstAdded = window->NewPosition + 1;
+        lastAdded = window->NewPosition + thickness - 1;
+        firstRemoved = 0;
+        lastRemoved = -1;
+    }
+    else if (window->NewPosition > window->Position)
+    {
+        firstAdded = window->Position + thickness;
+        lastAdded = window->NewPosition + thickness - 1;
+        firstRemoved = window->Position;
+        lastRemoved = window->NewPosition - 1;
+    }
+    else
+    {
+        firstAdded = window->NewPosition;
+        lastAdded = window->Position - 1;
+        firstRemoved = window->NewPosition + thickness;
+        lastRemoved = window->Position + thickness - 1;
+    }
+
+    for (int sampleIndex = firstAdded; sampleIndex <= lastAdded; sampleIndex++)
+    {
+        accumulateSampleRow<Projection>(sum, row.getSample(sampleIndex), row);
+    }
+
+    for (int sampleIndex = firstRemoved; sampleIndex <= lastRemoved; sampleIndex++)
+    {
+        const T *sample = row.getSample(sampleIndex);
+        for (int i = 0; i < row.count; i++)
+        {
+            sum[i * increment] -= sample[i * row.inputIncrement];
+        }
+    }
+
+    for (int i = 0; i < row.count; i++)
+    {
+        row.output[i * increment] = Projection::getValue(sum[i * increment], thickness);
+    }
+}
+
+template <class T>
+void slidingWindowRow(vtkProjectionImageFilter *self, vtkProjectionImageFilterSlidingWindow *window, const SlidingWindowRow<T> &row)
+{
+    bool initialize = window->getMode() == vtkProjectionImageFilterSlidingWindow::Initialize;
+
+    switch (self->GetAccumulatorType())
+    {
+        case udg::AccumulatorFactory::Maximum:
+            slidingWindowExtremumRow< MaximumProjection<T> >(window, row, initialize);
+            break;
+        case udg::AccumulatorFactory::Minimum:
+            slidingWindowExtremumRow< MinimumProjection<T> >(window, row, initialize);
+            break;
+        case udg::AccumulatorFactory::Average:
+            slidingWindowAverageRow(window, row, initialize);
+            break;
+    }
+}
+
+}
+
+/// Selects at compile time the kernel for the accumulator type of the filter, so no virtual call is done in the inner loops.
+template <class T>
+void vtkProjectionImageFilterExecute(vtkProjectionImageFilter *self,
+                                     vtkImageData *inData, T *inPtr,
+                                     vtkImageData *outData, T *outPtr,
+                                     int inExt[6])
+{
+    switch (self->GetAccumulatorType())
+    {
+        case udg::AccumulatorFactory::Maximum:
+            project< MaximumProjection<T> >(self, inData, inPtr, outData, outPtr, inExt);
+            break;
+        case udg::AccumulatorFactory::Minimum:
+            project< MinimumProjection<T> >(self, inData, inPtr, outData, outPtr, inExt);
+            break;
+        case udg::AccumulatorFactory::Average:
+            project< AverageProjection<T> >(self, inData, inPtr, outData, outPtr, inExt);
+            break;
+    }
+}
+
+
+/// Updates the projection of the output extent of this thread from the running state kept between executions
+template <class T>
+void vtkProjectionImageFilterSlidingWindowExecute(vtkProjectionImageFilter *self, vtkProjectionImageFilterSlidingWindow *window,
+                                                  vtkImageData *inData, T *inPtr,
+                                                  vtkImageData *outData, T *outPtr,
+                                                  int inExt[6])
+{
+    unsigned int iA = self->GetProjectionDimension();
+
+    vtkIdType inIncs[3], outIncs[3];
+    inData->GetIncrements(inIncs);
+    outData->GetIncrements(outIncs);
+
+    int numberOfComponents = inData->GetNumberOfScalarComponents();
+    const T *outBase = static_cast<T*>(outData->GetScalarPointer());
+
+    SlidingWindowRow<T> row;
+    row.sampleIncrement = window->Step * inIncs[iA];
+    row.firstSample = window->NewPosition;
+
+    if (iA != 0)
+    {
+        // Rows along X, with all the components, are contiguous both in the input and the output
+        unsigned int rowsAxis = iA == 1 ? 2 : 1;
+        int numberOfRows = inExt[2 * rowsAxis + 1] - inExt[2 * rowsAxis] + 1;
+        row.inputIncrement = 1;
+        row.outputIncrement = 1;
+        row.count = (inExt[1] - inExt[0] + 1) * numberOfComponents;
+
+        for (int rowIndex = 0; rowIndex < numberOfRows && !self->AbortExecute; rowIndex++)
+        {
+            row.input = inPtr + rowIndex * inIncs[rowsAxis];
+            row.output = outPtr + rowIndex * outIncs[rowsAxis];
+            row.stateOffset = row.output - outBase;
+            slidingWindowRow(self, window, row);
+        }
+    }
+    else
+    {
+        // Rows along Y, one component at a time
+        int numberOfRows = inExt[5] - inExt[4] + 1;
+        row.inputIncrement = inIncs[1];
+        row.outputIncrement = outIncs[1];
+        row.count = inExt[3] - inExt[2] + 1;
+
+        for (int rowIndex = 0; rowIndex < numberOfRows && !self->AbortExecute; rowIndex++)
+        {
+            for (int component = 0; component < numberOfComponents; component++)
+            {
+                row.input = inPtr + rowIndex * inIncs[2] + component;
+                row.output = outPtr + rowIndex * outIncs[2] + component;
+                row.stateOffset = row.output - outBase;
+                slidingWindowRow(self, window, row);
+            }
+        }
+    }
+}
+
+
+int vtkProjectionImageFilter::RequestData(vtkInformation *request,
+                                          vtkInformationVector **inputVector,
+                                          vtkInformationVector *outputVector)
+{
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    int updateExtent[6], wholeExtent[6];
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), updateExtent);
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+
+    // Decide how the projection will be computed before the threads start
+    SlidingWindow->prepare(this, vtkImageData::GetData(inputVector[0]), updateExtent, wholeExtent);
+
+    int result = this->Superclass::RequestData(request, inputVector, outputVector);
+
+    SlidingWindow->commit(this);
+
+    return result;
+}
+
 void vtkProjectionImageFilter::ThreadedRequestData(vtkInformation *vtkNotUsed(request),
-                                                   vtkInformationVector **inputVector,
+                                                   vtkInformationVector **vtkNotUsed(inputVector),
                                                    vtkInformationVector *vtkNotUsed(outputVector),
                                                    vtkImageData ***inData, vtkImageData **outData,
                                                    int outExt[6], int id)
 {
-//     DEBUG_LOG( QString( "outExt: %1 %2 %3 %4 %5 %6" ).arg(outExt[0]).arg(outExt[1]).arg(outExt[2]).arg(outExt[3]).arg(outExt[4]).arg(outExt[5]) );
-    void *outPtr = outData[0]->GetScalarPointerForExtent(outExt);
-//     void *outPtr0 = outData[0]->GetScalarPointer();
-//     int out1_0 = (int)outPtr - (int)outPtr0;
-//     DEBUG_LOG( QString( "outPtr - outPtr0 = %1" ).arg( out1_0 ) );
+    // this filter expects the output type to be same as input
+    if (outData[0]->GetScalarType() != inData[0][0]->GetScalarType())
+    {
+        vtkErrorMacro(<< "Execute: output ScalarType, "
+                      << vtkImageScalarTypeNameMacro(outData[0]->GetScalarType())
+                      << " must match input scalar type");
+        return;
+    }
 
+    // The input region of this thread is the whole slab along the projection dimension and the output extent of the thread in the
+    // other two dimensions. It isn't taken from the input update extent because it may also contain the previous slab for the
+    // incremental update.
     int inExt[6];
-    inputVector[0]->GetInformationObject(0)->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt);
-//     DEBUG_LOG( QString( "inExt: %1 %2 %3 %4 %5 %6" ).arg(inExt[0]).arg(inExt[1]).arg(inExt[2]).arg(inExt[3]).arg(inExt[4]).arg(inExt[5]) );
-
-    /// \warning Això funciona amb 2 nuclis, però amb més no ho sé!!!!!!!!!!!!!!!!
     unsigned int iA = ProjectionDimension, i0 = (iA + 1) % 3, i1 = (iA + 2) % 3;
+    inExt[2*iA] = FirstSlice; inExt[2*iA+1] = FirstSlice + Step * (NumberOfSlicesToProject - 1);
     inExt[2*i0] = outExt[2*i0]; inExt[2*i0+1] = outExt[2*i0+1];
     inExt[2*i1] = outExt[2*i1]; inExt[2*i1+1] = outExt[2*i1+1];
 
     void *inPtr = inData[0][0]->GetScalarPointerForExtent(inExt);
-//     void *inPtr0 = inData[0][0]->GetScalarPointer();
-//     int in1_0 = (int)inPtr - (int)inPtr0;
-//     DEBUG_LOG( QString( "inPtr - inPtr0 = %1" ).arg( in1_0 ) );
+    void *outPtr = outData[0]->GetScalarPointerForExtent(outExt);
+
+    if (SlidingWindow->getMode() != vtkProjectionImageFilterSlidingWindow::FullProjection)
+    {
+        switch (inData[0][0]->GetScalarType())
+        {
+            vtkTemplateMacro(
+                            vtkProjectionImageFilterSlidingWindowExecute(this, SlidingWindow,
+                                inData[0][0], reinterpret_cast<VTK_TT *>(inPtr),
+                                outData[0], reinterpret_cast<VTK_TT *>(outPtr),
+                                inExt));
+
+        default:
+            vtkErrorMacro(<< "Execute: Unknown ScalarType");
+            return;
+        }
+    }
+    else if (UseLegacyAccumulators)
+    {
+        switch (inData[0][0]->GetScalarType())
+        {
+            vtkTemplateMacro(
+                            vtkProjectionImageFilterLegacyExecute(this,
+                                inData[0][0], reinterpret_cast<VTK_TT *>(inPtr),
+                                outData[0], reinterpret_cast<VTK_TT *>(outPtr),
+                                inExt, outExt,
+                                id));
+
+        default:
+            vtkErrorMacro(<< "Execute: Unknown ScalarType");
+            return;
+        }
+    }
+    else
+    {
+        switch (inData[0][0]->GetScalarType())
+        {
+            vtkTemplateMacro(
+                            vtkProjectionImageFilterExecute(this,
+                                inData[0][0], reinterpret_cast<VTK_TT *>(inPtr),
+                                outData[0], reinterpret_cast<VTK_TT *>(outPtr),
+                                inExt));
+
+        default:
+            vtkErrorMacro(<< "Execute: Unknown ScalarType");
+            return;
+        }
+    }
+}
 
-    /// \warning Restaurem el valor original
-    inputVector[0]->GetInformationObject(0)->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt);
+int vtkProjectionImageFilter::SplitExtent(int splitExt[6], int startExt[6], int num, int total)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        splitExt[i] = startExt[i];
+    }
 
-    // this filter expects the output type to be same as input
-    if (outData[0]->GetScalarType() != inData[0][0]->GetScalarType())
+    // Split along the slowest varying non projected axis if it has enough rows for all the threads (so that each piece is a block of
+    // whole contiguous rows), otherwise along the largest non projected axis
+    int splitAxis = -1;
+    int largestSize = 1;
+
+    for (int axis = 2; axis >= 0; axis--)
     {
-        vtkErrorMacro(<< "Execute: output ScalarType, "
-                      << vtkImageScalarTypeNameMacro(outData[0]->GetScalarType())
-                      << " must match input scalar type");
-        return;
+        int size = startExt[2 * axis + 1] - startExt[2 * axis] + 1;
+
+        if (axis == static_cast<int>(ProjectionDimension) || size <= 1)
+        {
+            continue;
+        }
+
+        if (size >= total)
+        {
+            splitAxis = axis;
+            break;
+        }
+
+        if (size > largestSize)
+        {
+            splitAxis = axis;
+            largestSize = size;
+        }
     }
 
-    switch (inData[0][0]->GetScalarType())
+    if (splitAxis < 0)
     {
-        vtkTemplateMacro(
-                        vtkProjectionImageFilterExecute(this,
-                            inData[0][0], reinterpret_cast<VTK_TT *>(inPtr),
-                            outData[0], reinterpret_cast<VTK_TT *>(outPtr),
-                            inExt, outExt,
-                            id));
+        return 1;
+    }
 
-    default:
-        vtkErrorMacro(<< "Execute: Unknown ScalarType");
-        return;
+    int size = startExt[2 * splitAxis + 1] - startExt[2 * splitAxis] + 1;
+    int numberOfPieces = std::min(total, size);
+
+    if (num >= numberOfPieces)
+    {
+        return numberOfPieces;
     }
+
+    // Distribute the remainder so that piece sizes differ at most by one row
+    splitExt[2 * splitAxis] = startExt[2 * splitAxis] + (size * num) / numberOfPieces;
+    splitExt[2 * splitAxis + 1] = startExt[2 * splitAxis] + (size * (num + 1)) / numberOfPieces - 1;
+
+    return numberOfPieces;
 }
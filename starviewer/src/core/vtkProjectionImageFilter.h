@@ -28,6 +28,7 @@
 #include <vtkThreadedImageAlgorithm.h>
 #include "accumulator.h"
 
+class vtkProjectionImageFilterSlidingWindow;
 
 /** \class vtkProjectionImageFilter
  * \brief Implements an accumulation of an image along a selected direction.
@@ -72,21 +73,49 @@ public:
 
     /// Set/Get the direction in which to accumulate the data.  It must be set
     /// before the update of the filter. Defaults to the last dimension.
-    vtkSetMacro(ProjectionDimension, unsigned int);
+    /// Changing it releases the state of the incremental update, as changing the accumulator type, the number of slices or the step.
+    virtual void SetProjectionDimension(unsigned int projectionDimension);
     vtkGetMacro(ProjectionDimension, unsigned int);
 
-    vtkSetMacro(AccumulatorType, udg::AccumulatorFactory::AccumulatorType);
+    virtual void SetAccumulatorType(udg::AccumulatorFactory::AccumulatorType accumulatorType);
     vtkGetMacro(AccumulatorType, udg::AccumulatorFactory::AccumulatorType);
 
     vtkSetMacro(FirstSlice, int);
     vtkGetMacro(FirstSlice, int);
 
-    vtkSetMacro(NumberOfSlicesToProject, int);
+    virtual void SetNumberOfSlicesToProject(int numberOfSlicesToProject);
     vtkGetMacro(NumberOfSlicesToProject, int);
 
-    vtkSetMacro(Step, int);
+    virtual void SetStep(int step);
     vtkGetMacro(Step, int);
 
+    /// Set/Get whether the projection must be computed with the generic udg::Accumulator objects (one virtual call per voxel)
+    /// instead of the specialized row kernels. It is kept to compare both implementations. Defaults to off.
+    vtkSetMacro(UseLegacyAccumulators, bool);
+    vtkGetMacro(UseLegacyAccumulators, bool);
+    vtkBooleanMacro(UseLegacyAccumulators, bool);
+
+    /// Set/Get whether the filter keeps per-pixel running state between executions, so that when only FirstSlice changes by a multiple
+    /// of Step (e.g. scrolling the slab) the projection is updated incrementally instead of recomputed over the whole slab.
+    /// Any other change falls back to a full projection. The state takes one output plane of doubles for the average and
+    /// NumberOfSlicesToProject output planes of the input scalar type for maximum and minimum. Turning it off releases the state.
+    /// Defaults to off.
+    virtual void SetIncrementalUpdate(bool incrementalUpdate);
+    vtkGetMacro(IncrementalUpdate, bool);
+    vtkBooleanMacro(IncrementalUpdate, bool);
+
+    /// Set/Get the maximum number of bytes that the state of the incremental update may take. When the state for the current
+    /// parameters would take more, the projection is computed over the whole slab and no state is kept. Defaults to 256 MiB.
+    vtkSetMacro(IncrementalUpdateMemoryLimit, vtkIdType);
+    vtkGetMacro(IncrementalUpdateMemoryLimit, vtkIdType);
+
+    /// Returns the number of bytes currently taken by the state of the incremental update.
+    vtkIdType GetIncrementalUpdateMemorySize() const;
+
+    /// Releases the state of the incremental update, so that the next execution computes the projection over the whole slab.
+    /// It must be called when the input is replaced, because the state keeps values of the previous input until the next execution.
+    void ReleaseIncrementalUpdateState();
+
 
 protected:
     vtkProjectionImageFilter();
@@ -96,6 +125,7 @@ protected:
                                     vtkInformationVector **,
                                     vtkInformationVector *);
     virtual int RequestUpdateExtent (vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+    virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
     void ThreadedRequestData(vtkInformation *request,
                              vtkInformationVector **inputVector,
@@ -103,6 +133,9 @@ protected:
                              vtkImageData ***inData, vtkImageData **outData,
                              int outExt[6], int id);
 
+    /// Splits the output extent in balanced blocks of whole rows, never along the projection dimension.
+    virtual int SplitExtent(int splitExt[6], int startExt[6], int num, int total);
+
   /// Apply changes to the output image information.
 //   virtual void GenerateOutputInformation();
 
@@ -124,6 +157,12 @@ private:
     int FirstSlice;
     int NumberOfSlicesToProject;
     int Step;
+    bool UseLegacyAccumulators;
+    bool IncrementalUpdate;
+    vtkIdType IncrementalUpdateMemoryLimit;
+
+    /// Running state used by the incremental update
+    vtkProjectionImageFilterSlidingWindow *SlidingWindow;
 
 };
 
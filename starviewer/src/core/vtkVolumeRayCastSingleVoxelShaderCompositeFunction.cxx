@@ -203,7 +203,7 @@ void vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS>::CastRay( vtkVolumeR
 
             for ( int j = 0; j < 8; j++ )
             {
-                HdrColor tempColor = m_voxelShader->nvShade( positions[j], offsets[j], direction, remainingOpacity, tempColor );
+                HdrColor tempColor = m_voxelShader->nvShade( positions[j], offsets[j], direction, remainingOpacity );
                 tempColor.alpha *= weights[j];
                 color += tempColor.multiplyColorBy( tempColor.alpha );
             }
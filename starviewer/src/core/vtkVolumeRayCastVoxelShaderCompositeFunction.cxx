@@ -283,4 +283,10 @@ void vtkVolumeRayCastVoxelShaderCompositeFunction::RemoveAllVoxelShaders()
 }
 
 
+const QList<VoxelShader*>& vtkVolumeRayCastVoxelShaderCompositeFunction::GetVoxelShaders() const
+{
+    return m_voxelShaderList;
+}
+
+
 }
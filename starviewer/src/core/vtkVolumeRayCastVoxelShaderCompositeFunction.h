@@ -65,6 +65,7 @@ public:
     void RemoveVoxelShader(int i);
     void RemoveVoxelShader(VoxelShader *voxelShader);
     void RemoveAllVoxelShaders();
+    const QList<VoxelShader*>& GetVoxelShaders() const;
 
 protected:
     vtkVolumeRayCastVoxelShaderCompositeFunction();
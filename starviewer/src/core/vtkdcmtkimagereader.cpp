@@ -23,8 +23,17 @@
 #include "photometricinterpretation.h"
 #include "imageorientation.h"
 
+#include <QMutexLocker>
 #include <QSharedPointer>
 #include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
 
 #include <vtkDataArray.h>
 #include <vtkImageCast.h>
@@ -43,6 +52,10 @@ namespace udg {
 
 namespace {
 
+// Thread pool shared by all the readers to decode slices. Its maximum thread count is one per core, so that several volumes read at the same time
+// (e.g. by several VolumeReaderJobs) share the cores instead of starting one thread per core each.
+Q_GLOBAL_STATIC(QThreadPool, decodingThreadPool)
+
 // This exception is thrown when a file can't be loaded.
 class CantLoadFileException {
 };
@@ -242,6 +255,40 @@ QSharedPointer<DcmDataset> getDataset(const char *filename)
     return QSharedPointer<DcmDataset>(dicomFile.getAndRemoveDataset());
 }
 
+// Returns the slices between first and last in the order they have to be loaded: the given first slice to load and then the rest alternately after and
+// before it, getting away from it. If the first slice to load is out of range the slices are returned in natural order.
+QVector<int> getSliceLoadingOrder(int first, int last, int firstSliceToLoad)
+{
+    QVector<int> slices;
+    slices.reserve(last - first + 1);
+
+    if (firstSliceToLoad < first || firstSliceToLoad > last)
+    {
+        for (int slice = first; slice <= last; slice++)
+        {
+            slices.append(slice);
+        }
+    }
+    else
+    {
+        slices.append(firstSliceToLoad);
+
+        for (int distance = 1; slices.size() < last - first + 1; distance++)
+        {
+            if (firstSliceToLoad + distance <= last)
+            {
+                slices.append(firstSliceToLoad + distance);
+            }
+            if (firstSliceToLoad - distance >= first)
+            {
+                slices.append(firstSliceToLoad - distance);
+            }
+        }
+    }
+
+    return slices;
+}
+
 const char* booleanToString(bool b)
 {
     return b ? "yes" : "no";
@@ -261,6 +308,8 @@ void VtkDcmtkImageReader::PrintSelf(std::ostream &os, vtkIndent indent)
     os << indent << "Frame size: " << m_frameSize << " bytes\n";
     os << indent << "Maximum voxel value: " << m_maximumVoxelValue << "\n";
     os << indent << "Needs float scalar type: " << booleanToString(m_needsFloatScalarType) << "\n";
+    os << indent << "Number of decoding threads: " << m_numberOfDecodingThreads << "\n";
+    os << indent << "First slice to load: " << m_firstSliceToLoad << "\n";
 }
 
 void VtkDcmtkImageReader::setFrameNumbers(const QList<int> &frameNumbers)
@@ -268,7 +317,36 @@ void VtkDcmtkImageReader::setFrameNumbers(const QList<int> &frameNumbers)
     m_frameNumbers = frameNumbers;
 }
 
+void VtkDcmtkImageReader::setNumberOfDecodingThreads(int numberOfThreads)
+{
+    if (m_numberOfDecodingThreads != numberOfThreads)
+    {
+        m_numberOfDecodingThreads = numberOfThreads;
+        this->Modified();
+    }
+}
+
+int VtkDcmtkImageReader::getNumberOfDecodingThreads() const
+{
+    return m_numberOfDecodingThreads;
+}
+
+void VtkDcmtkImageReader::setFirstSliceToLoad(int slice)
+{
+    if (m_firstSliceToLoad != slice)
+    {
+        m_firstSliceToLoad = slice;
+        this->Modified();
+    }
+}
+
+int VtkDcmtkImageReader::getFirstSliceToLoad() const
+{
+    return m_firstSliceToLoad;
+}
+
 VtkDcmtkImageReader::VtkDcmtkImageReader()
+    : m_numberOfDecodingThreads(0), m_firstSliceToLoad(-1)
 {
     this->SetNumberOfInputPorts(0);
     this->SetNumberOfOutputPorts(1);
@@ -665,11 +743,19 @@ bool VtkDcmtkImageReader::loadData(int updateExtent[6])
 
     void *scalarPointer = output->GetScalarPointerForExtent(updateExtent);
 
+    if (m_firstSliceToLoad >= 0)
+    {
+        // The output may be shown before all slices are loaded, so pending slices must be blank instead of garbage
+        memset(scalarPointer, 0, m_frameSize * (updateExtent[5] - updateExtent[4] + 1));
+    }
+
     if (this->FileName)
     {
         if (!m_isMultiframe)
         {
             this->loadSingleFrameFile(this->FileName, scalarPointer);
+
+            this->notifySliceLoaded(updateExtent[4]);
         }
         else
         {
@@ -678,14 +764,26 @@ bool VtkDcmtkImageReader::loadData(int updateExtent[6])
     }
     else if (this->FileNames && this->FileNames->GetNumberOfValues() > 0)
     {
-        double total = updateExtent[5] - updateExtent[4] + 1;
-        this->UpdateProgress(0.0);
+        QVector<int> slices = getSliceLoadingOrder(updateExtent[4], updateExtent[5], m_firstSliceToLoad);
+        int numberOfThreads = getEffectiveNumberOfDecodingThreads(slices.size());
 
-        for (int i = updateExtent[4]; i <= updateExtent[5] && !this->AbortExecute; i++)
+        if (numberOfThreads > 1)
         {
-            this->loadSingleFrameFile(this->FileNames->GetValue(i), scalarPointer);
-            scalarPointer = static_cast<char*>(scalarPointer) + m_frameSize;
-            this->UpdateProgress((i - updateExtent[4] + 1) / total);
+            this->loadSlicesInParallel(scalarPointer, updateExtent, slices, numberOfThreads);
+        }
+        else
+        {
+            double total = slices.size();
+            this->UpdateProgress(0.0);
+
+            for (int i = 0; i < slices.size() && !this->AbortExecute; i++)
+            {
+                int slice = slices.at(i);
+                void *sliceBuffer = static_cast<char*>(scalarPointer) + static_cast<size_t>(slice - updateExtent[4]) * m_frameSize;
+                this->loadSingleFrameFile(this->FileNames->GetValue(slice), sliceBuffer);
+                this->notifySliceLoaded(slice);
+                this->UpdateProgress((i + 1) / total);
+            }
         }
     }
     else
@@ -707,38 +805,181 @@ void VtkDcmtkImageReader::loadSingleFrameFile(const char *filename, void *buffer
 
 void VtkDcmtkImageReader::loadMultiframeFile(const char *filename, void *buffer, int updateExtent[6])
 {
-    QSharedPointer<DcmDataset> dataset = getDataset(filename);
-    unsigned long flags = CIF_UsePartialAccessToPixelData | (m_needsFloatScalarType ? CIF_UseFloatingInternalRepresentation : 0);
-    double total = updateExtent[5] - updateExtent[4] + 1;
-    this->UpdateProgress(0.0);
-
     if (m_frameNumbers.isEmpty())
     {
         DEBUG_LOG("Reading multiframe file without frame numbers specified. Frames will be read sequentially.");
         WARN_LOG("Reading multiframe file without frame numbers specified. Frames will be read sequentially.");
     }
 
-    for (int frameIndex = updateExtent[4]; frameIndex <= updateExtent[5] && !this->AbortExecute; frameIndex++)
+    QVector<int> slices = getSliceLoadingOrder(updateExtent[4], updateExtent[5], m_firstSliceToLoad);
+    int numberOfThreads = getEffectiveNumberOfDecodingThreads(slices.size());
+
+    if (numberOfThreads > 1)
+    {
+        // Each thread opens its own dataset in loadSlicesInParallel because partial access to pixel data is not thread-safe
+        this->loadSlicesInParallel(buffer, updateExtent, slices, numberOfThreads);
+        return;
+    }
+
+    QSharedPointer<DcmDataset> dataset = getDataset(filename);
+    double total = slices.size();
+    this->UpdateProgress(0.0);
+
+    for (int i = 0; i < slices.size() && !this->AbortExecute; i++)
     {
-        int frameNumberInFile = m_frameNumbers.isEmpty() ? frameIndex : m_frameNumbers[frameIndex];
+        int frameIndex = slices.at(i);
+        int frameNumberInFile = m_frameNumbers.isEmpty() ? frameIndex : m_frameNumbers.at(frameIndex);
+        void *frameBuffer = static_cast<char*>(buffer) + static_cast<size_t>(frameIndex - updateExtent[4]) * m_frameSize;
+        loadFrame(dataset.data(), frameNumberInFile, frameBuffer);
+        this->notifySliceLoaded(frameIndex);
+        this->UpdateProgress((i + 1) / total);
+    }
+}
 
-        if (m_hasPerFrameRescale)
+void VtkDcmtkImageReader::loadFrame(DcmDataset *dataset, int frameNumberInFile, void *buffer)
+{
+    unsigned long flags = CIF_UsePartialAccessToPixelData | (m_needsFloatScalarType ? CIF_UseFloatingInternalRepresentation : 0);
+
+    if (m_hasPerFrameRescale)
+    {
+        const Rescale &rescale = m_perFrameRescale.at(frameNumberInFile);
+        DicomImage image(dataset, dataset->getOriginalXfer(), rescale.slope, rescale.intercept, flags, frameNumberInFile, 1);
+        copyDcmtkImageToBuffer(buffer, image);
+    }
+    else
+    {
+        DicomImage image(dataset, dataset->getOriginalXfer(), flags, frameNumberInFile, 1);
+        copyDcmtkImageToBuffer(buffer, image);
+    }
+}
+
+void VtkDcmtkImageReader::loadSlicesInParallel(void *buffer, int updateExtent[6], const QVector<int> &slices, int numberOfThreads)
+{
+    const int firstSlice = updateExtent[4];
+    const double total = slices.size();
+
+    // Slices are handed out one at a time because decoding times of compressed slices can vary a lot
+    std::atomic<int> nextSliceIndex(0);
+    std::atomic<bool> abort(false);
+    std::exception_ptr firstException;
+    // Slices loaded by the threads and not yet notified by the calling thread
+    QVector<int> loadedSlices;
+    QMutex mutex;
+    QWaitCondition sliceLoaded;
+
+    auto loadSlices = [&]()
+    {
+        try
+        {
+            QSharedPointer<DcmDataset> multiframeDataset;
+
+            if (m_isMultiframe)
+            {
+                multiframeDataset = getDataset(this->FileName);
+            }
+
+            for (int i = nextSliceIndex++; i < slices.size() && !abort; i = nextSliceIndex++)
+            {
+                int slice = slices.at(i);
+                void *sliceBuffer = static_cast<char*>(buffer) + static_cast<size_t>(slice - firstSlice) * m_frameSize;
+
+                if (m_isMultiframe)
+                {
+                    int frameNumberInFile = m_frameNumbers.isEmpty() ? slice : m_frameNumbers.at(slice);
+                    loadFrame(multiframeDataset.data(), frameNumberInFile, sliceBuffer);
+                }
+                else
+                {
+                    loadSingleFrameFile(this->FileNames->GetValue(slice), sliceBuffer);
+                }
+
+                QMutexLocker locker(&mutex);
+                loadedSlices.append(slice);
+                sliceLoaded.wakeAll();
+            }
+        }
+        catch (...)
         {
-            const Rescale &rescale = m_perFrameRescale.at(frameNumberInFile);
-            DicomImage image(dataset.data(), dataset->getOriginalXfer(), rescale.slope, rescale.intercept, flags, frameNumberInFile, 1);
-            copyDcmtkImageToBuffer(buffer, image);
+            QMutexLocker locker(&mutex);
+
+            if (!firstException)
+            {
+                firstException = std::current_exception();
+            }
+
+            abort = true;
         }
-        else
+    };
+
+    // The workers are queued in the shared pool, so they may start later if other readers are decoding at the same time.
+    // Completion is tracked per worker because the pool is shared.
+    QList<QFuture<void>> workers;
+
+    for (int i = 0; i < numberOfThreads; i++)
+    {
+        workers.append(QtConcurrent::run(decodingThreadPool(), loadSlices));
+    }
+
+    // Progress observers, slice notifications and abort requests belong to the calling thread, so it polls the workers until they have finished
+    int numberOfNotifiedSlices = 0;
+    bool finished = false;
+    this->UpdateProgress(0.0);
+
+    while (!finished)
+    {
+        // Checked before taking the loaded slices so that the last iteration notifies every slice loaded before the workers finished
+        finished = std::all_of(workers.begin(), workers.end(), [](const QFuture<void> &worker) { return worker.isFinished(); });
+
+        if (this->AbortExecute)
+        {
+            abort = true;
+        }
+
+        QVector<int> slicesToNotify;
+
+        {
+            QMutexLocker locker(&mutex);
+
+            if (!finished && loadedSlices.isEmpty())
+            {
+                sliceLoaded.wait(&mutex, 50);
+            }
+
+            slicesToNotify.swap(loadedSlices);
+        }
+
+        for (int slice : slicesToNotify)
         {
-            DicomImage image(dataset.data(), dataset->getOriginalXfer(), flags, frameNumberInFile, 1);
-            copyDcmtkImageToBuffer(buffer, image);
+            this->notifySliceLoaded(slice);
         }
 
-        buffer = static_cast<char*>(buffer) + m_frameSize;
-        this->UpdateProgress((frameIndex - updateExtent[4] + 1) / total);
+        numberOfNotifiedSlices += slicesToNotify.size();
+        this->UpdateProgress(numberOfNotifiedSlices / total);
+    }
+
+    if (firstException)
+    {
+        std::rethrow_exception(firstException);
+    }
+}
+
+void VtkDcmtkImageReader::notifySliceLoaded(int slice)
+{
+    // Slices are only notified when loading progressively, because otherwise nobody shows the output before the read has finished
+    if (m_firstSliceToLoad >= 0)
+    {
+        this->InvokeEvent(SliceLoadedEvent, &slice);
     }
 }
 
+int VtkDcmtkImageReader::getEffectiveNumberOfDecodingThreads(int numberOfSlices) const
+{
+    // More workers than threads in the shared pool would only wait in its queue
+    int maximumNumberOfThreads = decodingThreadPool()->maxThreadCount();
+    int numberOfThreads = m_numberOfDecodingThreads > 0 ? qMin(m_numberOfDecodingThreads, maximumNumberOfThreads) : maximumNumberOfThreads;
+    return qMax(1, qMin(numberOfThreads, numberOfSlices));
+}
+
 void VtkDcmtkImageReader::copyDcmtkImageToBuffer(void *buffer, DicomImage &dicomImage)
 {
     if (dicomImage.getStatus() != EIS_Normal)
@@ -754,9 +995,18 @@ void VtkDcmtkImageReader::copyDcmtkImageToBuffer(void *buffer, DicomImage &dicom
         double minimum, maximum;
         dicomImage.getMinMaxValues(minimum, maximum);
 
-        if (maximum > m_maximumVoxelValue)
+        double maximumVoxelValue;
+
         {
-            m_maximumVoxelValue = maximum;
+            // Slices may be decoded in parallel
+            QMutexLocker locker(&m_maximumVoxelValueMutex);
+
+            if (maximum > m_maximumVoxelValue)
+            {
+                m_maximumVoxelValue = maximum;
+            }
+
+            maximumVoxelValue = m_maximumVoxelValue;
         }
 
         int dcmtkInternalDataScalarType = dcmtkRepresentationToVtkScalarType(dcmtkInternalData->getRepresentation());
@@ -794,7 +1044,7 @@ void VtkDcmtkImageReader::copyDcmtkImageToBuffer(void *buffer, DicomImage &dicom
         {
             // Internal data scalar type is different from the image data scalar type and can't be converted to it
             // Need to find a new scalar type suitable for both and restart read
-            int newScalarType = decideNewScalarType(this->DataScalarType, dcmtkInternalDataScalarType, m_maximumVoxelValue);
+            int newScalarType = decideNewScalarType(this->DataScalarType, dcmtkInternalDataScalarType, maximumVoxelValue);
             throw ChangeScalarTypeException(newScalarType);
         }
     }
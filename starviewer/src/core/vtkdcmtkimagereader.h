@@ -17,10 +17,14 @@
 
 #include <stdexcept>
 
+#include <vtkCommand.h>
 #include <vtkImageReader2.h>
 
 #include <QList>
+#include <QMutex>
+#include <QVector>
 
+class DcmDataset;
 class DicomImage;
 
 namespace udg {
@@ -36,6 +40,10 @@ public:
 
     class CantReadImageException;
 
+    /// Event invoked each time a slice has been loaded into the output. The call data is a pointer to the int index of the slice in the data extent.
+    /// It's always invoked from the thread that executes the reader, and only when a first slice to load has been set (see setFirstSliceToLoad()).
+    enum { SliceLoadedEvent = vtkCommand::UserEvent + 1 };
+
 public:
 
     vtkTypeMacro(VtkDcmtkImageReader, vtkImageReader2);
@@ -50,6 +58,20 @@ public:
     /// Sets the list of frame numbers in the order they must be read from a multiframe file. No need to specify for single-frame files.
     void setFrameNumbers(const QList<int> &frameNumbers);
 
+    /// Sets the number of threads used to decode slices (or frames of a multiframe file) in parallel. A value of 0 or less means one thread per core
+    /// (the default), and 1 disables parallel decoding. The threads come from a pool shared by all the readers, which has one thread per core, so
+    /// readers executed at the same time don't use more decoding threads than cores in total.
+    void setNumberOfDecodingThreads(int numberOfThreads);
+    /// Returns the number of threads used to decode slices as set by the user (0 or less means one thread per core).
+    int getNumberOfDecodingThreads() const;
+
+    /// Sets the slice that has to be loaded first. The remaining slices are then loaded getting away from it, alternately after and before, so that a viewer
+    /// showing the output while it's being read gets the slices around this one first. In this mode the output buffer is zeroed before loading so that pending
+    /// slices are blank. A negative value (the default) loads slices in their natural order.
+    void setFirstSliceToLoad(int slice);
+    /// Returns the slice that has to be loaded first, or a negative value if slices are loaded in their natural order.
+    int getFirstSliceToLoad() const;
+
 protected:
 
     VtkDcmtkImageReader();
@@ -92,6 +114,16 @@ private:
     void loadSingleFrameFile(const char *filename, void *buffer);
     /// Loads image data from a multiframe file, for the given update extent, into the given buffer.
     void loadMultiframeFile(const char *filename, void *buffer, int updateExtent[6]);
+    /// Loads the frame with the given number from the given multiframe dataset into the given buffer.
+    void loadFrame(DcmDataset *dataset, int frameNumberInFile, void *buffer);
+    /// Loads the given slices of the given update extent into the given buffer, in the given order, distributing them over the given number of workers
+    /// executed in the shared decoding thread pool. Each slice is read from its own file, or from its frame in the multiframe file. Progress and loaded
+    /// slices are reported and AbortExecute checked from the calling thread. The first exception thrown by any thread is rethrown in the calling thread once all of them have finished.
+    void loadSlicesInParallel(void *buffer, int updateExtent[6], const QVector<int> &slices, int numberOfThreads);
+    /// Invokes SliceLoadedEvent for the given slice if slices are being loaded progressively.
+    void notifySliceLoaded(int slice);
+    /// Returns the effective number of threads to decode the given number of slices.
+    int getEffectiveNumberOfDecodingThreads(int numberOfSlices) const;
     /// Copies the image data stored in the given dicom image into the given buffer.
     void copyDcmtkImageToBuffer(void *buffer, DicomImage &dicomImage);
 
@@ -119,6 +151,12 @@ private:
     size_t m_frameSize;
     /// Maximum voxel value found in the image data.
     double m_maximumVoxelValue;
+    /// Protects m_maximumVoxelValue when decoding in parallel.
+    QMutex m_maximumVoxelValueMutex;
+    /// Number of threads used to decode slices. 0 or less means one thread per core.
+    int m_numberOfDecodingThreads;
+    /// Slice that has to be loaded first. Negative to load slices in their natural order.
+    int m_firstSliceToLoad;
     /// If it's true, a float scalar type will be used.
     bool m_needsFloatScalarType;
 
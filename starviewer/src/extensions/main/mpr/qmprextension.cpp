@@ -27,6 +27,7 @@
 #include "toolmanager.h"
 #include "toolproxy.h"
 #include "volume.h"
+#include "volumerepository.h"
 #include "voilutpresetstooldata.h"
 // Qt
 #include <QMessageBox>
@@ -86,6 +87,12 @@ QMPRExtension::QMPRExtension(QWidget *parent)
 QMPRExtension::~QMPRExtension()
 {
     writeSettings();
+
+    if (m_pinnedInput)
+    {
+        VolumeRepository::getRepository()->unpinPixelData(m_pinnedInput);
+    }
+
     // Fent això o no sembla que s'allibera la mateixa memòria gràcies als smart pointers
     if (m_sagitalReslice)
     {
@@ -988,7 +995,15 @@ void QMPRExtension::setInput(Volume *input)
         return;
     }
     // HACK End
-    
+
+    // m_volume and the reslices keep the VTK data of the input, so its pixel data must not be released by the repository while it's used here
+    VolumeRepository::getRepository()->pinPixelData(input);
+    if (m_pinnedInput)
+    {
+        VolumeRepository::getRepository()->unpinPixelData(m_pinnedInput);
+    }
+    m_pinnedInput = input;
+
     if (input->getNumberOfPhases() > 1)
     {
         m_phasesAlertLabel->setVisible(true);
@@ -17,6 +17,8 @@
 
 #include "ui_qmprextensionbase.h"
 
+#include <QPointer>
+
 // FWD declarations
 class QAction;
 class QStringList;
@@ -202,6 +204,9 @@ private:
     /// El volum al que se li practica l'MPR
     Volume *m_volume;
 
+    /// Input volume whose pixel data is pinned in the VolumeRepository because m_volume and the reslices use its VTK data.
+    QPointer<Volume> m_pinnedInput;
+
     /// Els actors que representen els eixos que podrem modificar. Línia vermella, blava (axial), blava (sagital) respectivament i el thickSlab
     /// (línies puntejades blaves en vista axial i sagital).
     vtkAxisActor2D *m_sagitalOverAxialAxisActor, *m_axialOverSagitalIntersectionAxis, *m_coronalOverAxialIntersectionAxis,
@@ -66,6 +66,14 @@ Experimental3DVolume::~Experimental3DVolume()
     m_image->Delete();
     m_simpleVolumeRayCastFunction->Delete();
     m_shaderVolumeRayCastFunction->Delete();
+    m_ambientObscuranceVolumeRayCastFunction->Delete();
+    m_directIlluminationObscuranceVolumeRayCastFunction->Delete();
+    m_ambientContourObscuranceVolumeRayCastFunction->Delete();
+    m_directIlluminationContourObscuranceVolumeRayCastFunction->Delete();
+    delete m_ambientObscuranceVoxelShader;
+    delete m_directIlluminationObscuranceVoxelShader;
+    delete m_ambientContourObscuranceVoxelShader;
+    delete m_directIlluminationContourObscuranceVoxelShader;
     delete m_ambientVoxelShader;
     delete m_directIlluminationVoxelShader;
     delete m_contourVoxelShader;
@@ -153,11 +161,19 @@ void Experimental3DVolume::setInterpolation(Interpolation interpolation)
             m_property->SetInterpolationTypeToLinear();
             m_simpleVolumeRayCastFunction->SetCompositeMethodToInterpolateFirst();
             m_shaderVolumeRayCastFunction->SetCompositeMethodToInterpolateFirst();
+            m_ambientObscuranceVolumeRayCastFunction->SetCompositeMethodToInterpolateFirst();
+            m_directIlluminationObscuranceVolumeRayCastFunction->SetCompositeMethodToInterpolateFirst();
+            m_ambientContourObscuranceVolumeRayCastFunction->SetCompositeMethodToInterpolateFirst();
+            m_directIlluminationContourObscuranceVolumeRayCastFunction->SetCompositeMethodToInterpolateFirst();
             break;
         case LinearClassifyInterpolate:
             m_property->SetInterpolationTypeToLinear();
             m_simpleVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
             m_shaderVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
+            m_ambientObscuranceVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
+            m_directIlluminationObscuranceVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
+            m_ambientContourObscuranceVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
+            m_directIlluminationContourObscuranceVolumeRayCastFunction->SetCompositeMethodToClassifyFirst();
             break;
     }
 
@@ -350,6 +366,34 @@ void Experimental3DVolume::forceCpuShaderRendering()
     }
 }
 
+void Experimental3DVolume::useFusedVoxelShaders()
+{
+    if (m_volume->GetMapper() != m_cpuRayCastMapper || m_cpuRayCastMapper->GetVolumeRayCastFunction() != m_shaderVolumeRayCastFunction)
+    {
+        return;
+    }
+
+    // L'ordre dels voxel shaders ha de coincidir amb el de la cadena fusionada
+    const QList<VoxelShader*> &voxelShaders = m_shaderVolumeRayCastFunction->GetVoxelShaders();
+
+    if (voxelShaders == (QList<VoxelShader*>() << m_ambientVoxelShader << m_obscuranceVoxelShader))
+    {
+        m_cpuRayCastMapper->SetVolumeRayCastFunction(m_ambientObscuranceVolumeRayCastFunction);
+    }
+    else if (voxelShaders == (QList<VoxelShader*>() << m_directIlluminationVoxelShader << m_obscuranceVoxelShader))
+    {
+        m_cpuRayCastMapper->SetVolumeRayCastFunction(m_directIlluminationObscuranceVolumeRayCastFunction);
+    }
+    else if (voxelShaders == (QList<VoxelShader*>() << m_ambientVoxelShader << m_contourVoxelShader << m_obscuranceVoxelShader))
+    {
+        m_cpuRayCastMapper->SetVolumeRayCastFunction(m_ambientContourObscuranceVolumeRayCastFunction);
+    }
+    else if (voxelShaders == (QList<VoxelShader*>() << m_directIlluminationVoxelShader << m_contourVoxelShader << m_obscuranceVoxelShader))
+    {
+        m_cpuRayCastMapper->SetVolumeRayCastFunction(m_directIlluminationContourObscuranceVolumeRayCastFunction);
+    }
+}
+
 void Experimental3DVolume::startVmiMode()
 {
     m_cpuRayCastMapper->SetVolumeRayCastFunction(m_shaderVolumeRayCastFunction);
@@ -545,6 +589,11 @@ void Experimental3DVolume::createVolumeRayCastFunctions()
 {
     m_simpleVolumeRayCastFunction = vtkVolumeRayCastCompositeFunction::New();
     m_shaderVolumeRayCastFunction = vtkVolumeRayCastVoxelShaderCompositeFunction::New();
+    m_ambientObscuranceVolumeRayCastFunction = vtkVolumeRayCastSingleVoxelShaderCompositeFunction<AmbientObscuranceVoxelShader>::New();
+    m_directIlluminationObscuranceVolumeRayCastFunction = vtkVolumeRayCastSingleVoxelShaderCompositeFunction<DirectIlluminationObscuranceVoxelShader>::New();
+    m_ambientContourObscuranceVolumeRayCastFunction = vtkVolumeRayCastSingleVoxelShaderCompositeFunction<AmbientContourObscuranceVoxelShader>::New();
+    m_directIlluminationContourObscuranceVolumeRayCastFunction =
+        vtkVolumeRayCastSingleVoxelShaderCompositeFunction<DirectIlluminationContourObscuranceVoxelShader>::New();
 }
 
 void Experimental3DVolume::createVoxelShaders()
@@ -580,6 +629,19 @@ void Experimental3DVolume::createVoxelShaders()
     m_filteringAmbientOcclusionMapVoxelShader->setData(m_data, m_rangeMax);
     m_filteringAmbientOcclusionStipplingVoxelShader = new FilteringAmbientOcclusionStipplingVoxelShader();
     m_filteringAmbientOcclusionStipplingVoxelShader->setData(m_data, m_rangeMax);
+
+    m_ambientObscuranceVoxelShader = new AmbientObscuranceVoxelShader();
+    m_ambientObscuranceVoxelShader->setVoxelShaders(m_ambientVoxelShader, m_obscuranceVoxelShader);
+    m_ambientObscuranceVolumeRayCastFunction->SetVoxelShader(m_ambientObscuranceVoxelShader);
+    m_directIlluminationObscuranceVoxelShader = new DirectIlluminationObscuranceVoxelShader();
+    m_directIlluminationObscuranceVoxelShader->setVoxelShaders(m_directIlluminationVoxelShader, m_obscuranceVoxelShader);
+    m_directIlluminationObscuranceVolumeRayCastFunction->SetVoxelShader(m_directIlluminationObscuranceVoxelShader);
+    m_ambientContourObscuranceVoxelShader = new AmbientContourObscuranceVoxelShader();
+    m_ambientContourObscuranceVoxelShader->setVoxelShaders(m_ambientVoxelShader, m_contourVoxelShader, m_obscuranceVoxelShader);
+    m_ambientContourObscuranceVolumeRayCastFunction->SetVoxelShader(m_ambientContourObscuranceVoxelShader);
+    m_directIlluminationContourObscuranceVoxelShader = new DirectIlluminationContourObscuranceVoxelShader();
+    m_directIlluminationContourObscuranceVoxelShader->setVoxelShaders(m_directIlluminationVoxelShader, m_contourVoxelShader, m_obscuranceVoxelShader);
+    m_directIlluminationContourObscuranceVolumeRayCastFunction->SetVoxelShader(m_directIlluminationContourObscuranceVoxelShader);
 }
 
 void Experimental3DVolume::createMappers()
@@ -2,6 +2,8 @@
 #define UDGEXPERIMENTAL3DVOLUME_H
 
 #include "vector3.h"
+#include "voxelshaderchain.h"
+#include "vtkVolumeRayCastSingleVoxelShaderCompositeFunction.h"
 
 #include <QVector>
 
@@ -53,6 +55,11 @@ public:
     enum Interpolation { NearestNeighbour, LinearInterpolateClassify, LinearClassifyInterpolate };
     /// Estimadors de gradient.
     enum GradientEstimator { FiniteDifference, FourDLInearRegression1, FourDLInearRegression2 };
+    /// Cadenes de voxel shaders fusionades en temps de compilació per les combinacions d'obscurances més habituals.
+    typedef VoxelShaderChain<AmbientVoxelShader2, ObscuranceVoxelShader> AmbientObscuranceVoxelShader;
+    typedef VoxelShaderChain<DirectIlluminationVoxelShader2, ObscuranceVoxelShader> DirectIlluminationObscuranceVoxelShader;
+    typedef VoxelShaderChain<AmbientVoxelShader2, ContourVoxelShader, ObscuranceVoxelShader> AmbientContourObscuranceVoxelShader;
+    typedef VoxelShaderChain<DirectIlluminationVoxelShader2, ContourVoxelShader, ObscuranceVoxelShader> DirectIlluminationContourObscuranceVoxelShader;
 
     Experimental3DVolume(Volume *volume);
     Experimental3DVolume(vtkImageData *image);
@@ -104,6 +111,9 @@ public:
     void forceCpuRendering();
     /// Força el renderitzat amb voxel shaders de CPU encara que es pogués fer amb GPU o amb CPU amb el pipeline normal de VTK.
     void forceCpuShaderRendering();
+    /// Si la cadena de voxel shaders actual té una versió fusionada en temps de compilació, la fa servir en lloc de la llista de voxel shaders.
+    /// El resultat és el mateix però sense crides virtuals per shader i per mostra. S'ha de cridar després d'afegir tots els voxel shaders.
+    void useFusedVoxelShaders();
 
     /// Prepara el rendering amb el voxel shader per fer càlculs de VMI.
     void startVmiMode();
@@ -170,6 +180,17 @@ private:
     /// Volume ray cast function amb shaders.
     vtkVolumeRayCastVoxelShaderCompositeFunction *m_shaderVolumeRayCastFunction;
 
+    /// Cadenes fusionades dels voxel shaders.
+    AmbientObscuranceVoxelShader *m_ambientObscuranceVoxelShader;
+    DirectIlluminationObscuranceVoxelShader *m_directIlluminationObscuranceVoxelShader;
+    AmbientContourObscuranceVoxelShader *m_ambientContourObscuranceVoxelShader;
+    DirectIlluminationContourObscuranceVoxelShader *m_directIlluminationContourObscuranceVoxelShader;
+    /// Volume ray cast functions amb les cadenes fusionades.
+    vtkVolumeRayCastSingleVoxelShaderCompositeFunction<AmbientObscuranceVoxelShader> *m_ambientObscuranceVolumeRayCastFunction;
+    vtkVolumeRayCastSingleVoxelShaderCompositeFunction<DirectIlluminationObscuranceVoxelShader> *m_directIlluminationObscuranceVolumeRayCastFunction;
+    vtkVolumeRayCastSingleVoxelShaderCompositeFunction<AmbientContourObscuranceVoxelShader> *m_ambientContourObscuranceVolumeRayCastFunction;
+    vtkVolumeRayCastSingleVoxelShaderCompositeFunction<DirectIlluminationContourObscuranceVoxelShader> *m_directIlluminationContourObscuranceVolumeRayCastFunction;
+
     /// Voxel shader d'il·luminació ambient.
     AmbientVoxelShader2 *m_ambientVoxelShader;
     /// Voxel shader d'il·luminació directa (ambient + difusa [+ especular]).
@@ -1806,6 +1806,8 @@ void QExperimental3DExtension::render()
         m_volume->forceCpuShaderRendering();
     }
 
+    m_volume->useFusedVoxelShaders();
+
     m_viewer->render();
 }
 
@@ -5,6 +5,8 @@
  *   Universitat de Girona                                                 *
  ***************************************************************************/
 #include "rectumSegmentationMethod.h"
+#include "regiongrower.h"
+#include "itkImageToVTKImageFilter.h"
 
 #include <itkImage.h>
 #include <itkImageRegionIterator.h>
@@ -468,25 +470,50 @@ void rectumSegmentationMethod::applyMethodNextSlice(unsigned int slice, int step
         ++itRegion;
     }
 
+    // Fem créixer la regió dins la ROI sobre la dilatació, des dels punts que ja eren a la regió de la llesca anterior
+    typedef itk::ImageToVTKImageFilter<InternalImageType> ItkToVtkFilterType;
+    ItkToVtkFilterType::Pointer dilateToVtk = ItkToVtkFilterType::New();
+    dilateToVtk->SetInput(binaryDilate->GetOutput());
+    dilateToVtk->Update();
+    vtkImageData *dilateImage = dilateToVtk->GetOutput();
+
+    int roiExtent[6] = { m_minROI[0], m_maxROI[0], m_minROI[1], m_maxROI[1], 0, 0 };
+    RegionGrower regionGrower;
+    regionGrower.setExtent(roiExtent);
+    QVector<bool> regionMask;
+
     itDilate.GoToBegin();
     itPrevious.GoToBegin();
-    itRegion.GoToBegin();
-    //std::cout<<"Init Recorregut..."<<std::endl;
     while(!itDilate.IsAtEnd())
     {
-        if((itDilate.Get()==m_insideMaskValue)&&(itPrevious.Get()==m_insideMaskValue)&&(itRegion.Get()!=m_insideMaskValue))
+        if((itDilate.Get()==m_insideMaskValue)&&(itPrevious.Get()==m_insideMaskValue))
         {
-            //std::cout<<"Crida a regionGrowingRecursive a "<<itDilate.GetIndex()[0]<<", "<<itDilate.GetIndex()[1]<<" [ "<<regionThreshold->GetLargestPossibleRegion().GetSize()<<std::endl;
-            //Primer ho desem en atributs de la classe així ja no s'ha de passar per paràmetre
-            m_maskrecursive = regionThreshold;
-            m_imrecursive = binaryDilate->GetOutput();
-            this->regionGrowingRecursive(itDilate.GetIndex()[0], itDilate.GetIndex()[1],0);
+            // La màscara acumula les regions ja crescudes, així no es tornen a recórrer
+            int seed[3] = { static_cast<int>(itDilate.GetIndex()[0]), static_cast<int>(itDilate.GetIndex()[1]), 0 };
+            regionGrower.computeMask(dilateImage, seed, m_insideMaskValue, m_insideMaskValue, regionMask);
         }
         ++itDilate;
         ++itPrevious;
-        ++itRegion;
     }
 
+    int growingExtent[6];
+    if (!regionMask.isEmpty() && regionGrower.getGrowingExtent(dilateImage, growingExtent))
+    {
+        int maskIndex = 0;
+        InternalImageType::IndexType regionIndex;
+        for (int y = growingExtent[2]; y <= growingExtent[3]; y++)
+        {
+            for (int x = growingExtent[0]; x <= growingExtent[1]; x++)
+            {
+                if (regionMask[maskIndex++])
+                {
+                    regionIndex[0] = x;
+                    regionIndex[1] = y;
+                    regionThreshold->SetPixel(regionIndex, m_insideMaskValue);
+                }
+            }
+        }
+    }
 
     itk::ImageRegionIterator< Volume::ItkImageType > itMask(m_Mask->getItkData(), m_Mask->getItkData()->GetLargestPossibleRegion());
     itMask.GoToBegin();
@@ -529,37 +556,6 @@ void rectumSegmentationMethod::applyMethodNextSlice(unsigned int slice, int step
     return;
 }
 
-void rectumSegmentationMethod::regionGrowingRecursive(int indexX, int indexY , int prof)
-{
-    itk::ImageRegionIteratorWithIndex< InternalImageType > itIm(m_imrecursive, m_imrecursive->GetLargestPossibleRegion());
-    itk::ImageRegionIteratorWithIndex< InternalImageType > itMask(m_maskrecursive, m_maskrecursive->GetLargestPossibleRegion());
-    InternalImageType::IndexType index;
-    index[0]=indexX;
-    index[1]=indexY;
-
-    itIm.SetIndex(index);
-    itMask.SetIndex(index);
-    //if((itIm.Get()>=m_lowerThreshold)&&(itIm.Get()<=m_upperThreshold)&&(itMask.Get()!=m_insideMaskValue))
-    //if((itIm.Get()==m_insideMaskValue)&&(itMask.Get()!=m_insideMaskValue))
-    if((itIm.Get()==m_insideMaskValue)&&(itMask.Get()!=m_insideMaskValue)&& (indexX>=m_minROI[0])&&(indexX<=m_maxROI[0])&&(indexY>=m_minROI[1])&&(indexY<=m_maxROI[1])&&prof<=2000)
-    {
-        //std::cout<<"->Set "<<std::endl;
-        itMask.Set(m_insideMaskValue);
-        if(indexX+1 < (int)m_maskrecursive->GetLargestPossibleRegion().GetSize()[0])
-            regionGrowingRecursive(indexX + 1, indexY, prof +1);
-        if(indexX > 0)
-            regionGrowingRecursive(indexX - 1, indexY, prof +1);
-        if(indexY+1 < (int)m_maskrecursive->GetLargestPossibleRegion().GetSize()[1])
-            regionGrowingRecursive(indexX, indexY + 1, prof +1);
-        if(indexY > 0)
-            regionGrowingRecursive(indexX, indexY - 1, prof +1);
-    }
-    else
-    {
-      //  std::cout<<"*"<<std::endl;
-    }
-}
-
 void rectumSegmentationMethod::applyFilter(Volume* output)
 {
     typedef   float           InternalPixelType;
@@ -14,15 +14,337 @@
 
 #include "databaseconnection.h"
 
+#include "inputoutputsettings.h"
 #include "localdatabasemanager.h"
 #include "logging.h"
+#include "settings.h"
 
+#include <QAtomicInt>
+#include <QHash>
 #include <QSqlDatabase>
+#include <QSqlDriver>
 #include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QThread>
+#include <QThreadStorage>
 
 namespace udg {
 
+/**
+ * Connection to a SQLite database with the cache of the statements prepared on it.
+ */
+class SqliteConnection {
+
+public:
+    SqliteConnection(const QString &databasePath, const QString &connectionName);
+    ~SqliteConnection();
+
+    /// Opens the connection if it's not already open. Returns true if it's open.
+    bool open();
+
+    /// Returns the database of this connection.
+    QSqlDatabase getDatabase() const;
+
+    /// Returns a query with the given SQL prepared on this connection, reusing the cached one if it's not in use.
+    QSqlQuery getPreparedQuery(const QString &sql);
+
+    /// Returns the SQL of the cached prepared queries.
+    QStringList getPreparedQueriesSql() const;
+
+    /// Begins a transaction. Returns true if it has begun.
+    bool beginTransaction();
+    /// Commits the current transaction. Returns true if it has been committed.
+    bool commitTransaction();
+    /// Rolls back the current transaction, if any.
+    void rollbackTransaction();
+
+    /// Registers a new user of the connection.
+    void acquire();
+    /// Unregisters a user of the connection. When there are no users left the cached queries are reset and a transaction left open is rolled back, so
+    /// that they don't keep the database locked nor leave partial changes to be committed by the next transaction.
+    void release();
+
+    /// Returns true if some DatabaseConnection is using this connection.
+    bool isInUse() const;
+
+    /// Returns true if the pooled connections have been closed after this one was created, and then it must not be used by new DatabaseConnection objects.
+    bool isStale() const;
+
+private:
+    /// Path to the database file.
+    QString m_databasePath;
+
+    /// Name of the connection in QSqlDatabase.
+    QString m_connectionName;
+
+    /// Prepared queries indexed by their SQL.
+    QHash<QString, QSqlQuery> m_preparedQueries;
+
+    /// Number of DatabaseConnection objects using this connection.
+    int m_numberOfUsers;
+
+    /// Pool generation when this connection was created.
+    int m_generation;
+
+    /// True while a transaction begun with beginTransaction() hasn't been committed nor rolled back.
+    bool m_inTransaction;
+
+};
+
+namespace {
+
+// Incremented each time the pooled connections are closed. Pooled connections of an older generation are closed by their thread as soon as they are idle.
+QAtomicInt poolGeneration;
+
+// Returns true if the given path refers to an in-memory database. Each connection to such a path creates a different database, so they can't be shared.
+bool isInMemoryDatabase(const QString &databasePath)
+{
+    return databasePath == ":memory:";
+}
+
+// Configures the journal mode and the pragmas of the given database according to the settings.
+void applyPragmas(QSqlDatabase &database)
+{
+    QStringList pragmas;
+
+    if (Settings().getValue(InputOutputSettings::UseDatabaseWriteAheadLogging).toBool())
+    {
+        // With a write-ahead log readers don't block the writer and commits don't need to sync the whole database
+        pragmas << "PRAGMA journal_mode = WAL" << "PRAGMA synchronous = NORMAL" << "PRAGMA temp_store = MEMORY" << "PRAGMA cache_size = -16000";
+    }
+    else
+    {
+        // The journal mode is persistent, so it must be restored if the setting has been disabled
+        pragmas << "PRAGMA journal_mode = DELETE";
+    }
+
+    QSqlQuery query(database);
+
+    foreach (const QString &pragma, pragmas)
+    {
+        if (!query.exec(pragma))
+        {
+            WARN_LOG(QString("Could not execute \"%1\": %2").arg(pragma).arg(query.lastError().text()));
+        }
+    }
+}
+
+// Connections to database files of one thread, indexed by database path.
+class ConnectionPool : public QHash<QString, SqliteConnection*> {
+public:
+    ~ConnectionPool()
+    {
+        qDeleteAll(*this);
+    }
+};
+
+// The pool of each thread is deleted, closing its connections, when the thread finishes (or when the application is destroyed for the main thread).
+QThreadStorage<ConnectionPool*> threadConnectionPools;
+
+// Returns the pool of the current thread.
+ConnectionPool* getConnectionPoolOfCurrentThread()
+{
+    if (!threadConnectionPools.hasLocalData())
+    {
+        threadConnectionPools.setLocalData(new ConnectionPool());
+    }
+
+    return threadConnectionPools.localData();
+}
+
+// Closes the given pooled connection of the current thread, removing it from the pool if it's still there.
+void closePooledConnection(const QString &databasePath, SqliteConnection *connection)
+{
+    ConnectionPool *pool = getConnectionPoolOfCurrentThread();
+
+    if (pool->value(databasePath) == connection)
+    {
+        pool->remove(databasePath);
+    }
+
+    delete connection;
+}
+
+}
+
+SqliteConnection::SqliteConnection(const QString &databasePath, const QString &connectionName)
+    : m_databasePath(databasePath), m_connectionName(connectionName), m_numberOfUsers(0), m_generation(poolGeneration.load()),
+      m_inTransaction(false)
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    database.setDatabaseName(m_databasePath);
+    database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=15000");
+}
+
+SqliteConnection::~SqliteConnection()
+{
+    // Queries must be destroyed before the database is removed
+    m_preparedQueries.clear();
+
+    {
+        QSqlDatabase database = getDatabase();
+        database.close();
+    }
+
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+bool SqliteConnection::open()
+{
+    QSqlDatabase database = getDatabase();
+
+    if (database.isOpen())
+    {
+        return true;
+    }
+
+    if (!database.open())
+    {
+        ERROR_LOG(database.lastError().text());
+        return false;
+    }
+
+    if (!isInMemoryDatabase(m_databasePath))
+    {
+        applyPragmas(database);
+    }
+
+    return true;
+}
+
+QSqlDatabase SqliteConnection::getDatabase() const
+{
+    return QSqlDatabase::database(m_connectionName, false);
+}
+
+QSqlQuery SqliteConnection::getPreparedQuery(const QString &sql)
+{
+    QHash<QString, QSqlQuery>::iterator cachedQuery = m_preparedQueries.find(sql);
+
+    if (cachedQuery != m_preparedQueries.end())
+    {
+        // A query positioned on a row may still be in use, e.g. by an outer loop, so it can't be reset
+        if (!cachedQuery->isActive() || !cachedQuery->isValid())
+        {
+            cachedQuery->finish();
+            return *cachedQuery;
+        }
+
+        QSqlQuery query(getDatabase());
+        query.prepare(sql);
+        return query;
+    }
+
+    QSqlQuery query(getDatabase());
+
+    if (query.prepare(sql))
+    {
+        m_preparedQueries.insert(sql, query);
+    }
+
+    return query;
+}
+
+QStringList SqliteConnection::getPreparedQueriesSql() const
+{
+    return m_preparedQueries.keys();
+}
+
+bool SqliteConnection::beginTransaction()
+{
+    if (m_inTransaction)
+    {
+        ERROR_LOG("Could not begin a transaction in the database because another one is in progress in the same connection.");
+        return false;
+    }
+
+    m_inTransaction = getDatabase().transaction();
+
+    if (!m_inTransaction)
+    {
+        ERROR_LOG("Could not begin a transaction in the database: " + getDatabase().lastError().text());
+    }
+
+    return m_inTransaction;
+}
+
+bool SqliteConnection::commitTransaction()
+{
+    if (!m_inTransaction)
+    {
+        return false;
+    }
+
+    if (!getDatabase().commit())
+    {
+        ERROR_LOG("Could not commit the transaction in the database, it will be rolled back: " + getDatabase().lastError().text());
+        rollbackTransaction();
+        return false;
+    }
+
+    m_inTransaction = false;
+    return true;
+}
+
+void SqliteConnection::rollbackTransaction()
+{
+    if (!m_inTransaction)
+    {
+        return;
+    }
+
+    // Queries still positioned on a row would make the rollback fail
+    for (QHash<QString, QSqlQuery>::iterator query = m_preparedQueries.begin(); query != m_preparedQueries.end(); ++query)
+    {
+        query->finish();
+    }
+
+    if (!getDatabase().rollback())
+    {
+        ERROR_LOG("Could not roll back the transaction in the database: " + getDatabase().lastError().text());
+    }
+
+    m_inTransaction = false;
+}
+
+void SqliteConnection::acquire()
+{
+    m_numberOfUsers++;
+}
+
+void SqliteConnection::release()
+{
+    m_numberOfUsers--;
+
+    if (m_numberOfUsers == 0)
+    {
+        for (QHash<QString, QSqlQuery>::iterator query = m_preparedQueries.begin(); query != m_preparedQueries.end(); ++query)
+        {
+            query->finish();
+        }
+
+        // Otherwise the next transaction of the thread couldn't begin and the partial changes would be committed with the next commit
+        if (m_inTransaction && getDatabase().driver()->hasFeature(QSqlDriver::Transactions))
+        {
+            WARN_LOG("The last user of the connection to " + m_databasePath + " left a transaction open. It will be rolled back.");
+            rollbackTransaction();
+        }
+    }
+}
+
+bool SqliteConnection::isInUse() const
+{
+    return m_numberOfUsers > 0;
+}
+
+bool SqliteConnection::isStale() const
+{
+    return m_generation != poolGeneration.load();
+}
+
 DatabaseConnection::DatabaseConnection()
+    : m_privateConnection(0), m_pooledConnection(0), m_transactionOpen(false)
 {
     m_databasePath = LocalDatabaseManager::getDatabaseFilePath();
 }
@@ -34,17 +356,49 @@ DatabaseConnection::~DatabaseConnection()
 
 void DatabaseConnection::setDatabasePath(const QString &path)
 {
-    m_databasePath = path;
+    if (path != m_databasePath)
+    {
+        close();
+        m_databasePath = path;
+    }
 }
 
 QSqlDatabase DatabaseConnection::getConnection()
 {
-    if (!isConnected())
+    return getOpenConnection()->getDatabase();
+}
+
+QSqlQuery DatabaseConnection::getPreparedQuery(const QString &sql)
+{
+    return getOpenConnection()->getPreparedQuery(sql);
+}
+
+QStringList DatabaseConnection::getPreparedQueriesSql()
+{
+    return getOpenConnection()->getPreparedQueriesSql();
+}
+
+void DatabaseConnection::closePooledConnections()
+{
+    // Connections of other threads can only be closed by their thread, so they are marked as stale and closed when they are next used or released
+    poolGeneration.ref();
+
+    ConnectionPool *pool = getConnectionPoolOfCurrentThread();
+    ConnectionPool::iterator connection = pool->begin();
+
+    while (connection != pool->end())
     {
-        open();
+        if (connection.value()->isInUse())
+        {
+            WARN_LOG("Can't close the connection to " + connection.key() + " yet because it's in use. It will be closed when it's released.");
+            ++connection;
+        }
+        else
+        {
+            delete connection.value();
+            connection = pool->erase(connection);
+        }
     }
-
-    return QSqlDatabase::database();
 }
 
 QSqlError DatabaseConnection::getLastError()
@@ -60,22 +414,45 @@ QString DatabaseConnection::getLastErrorMessage()
 void DatabaseConnection::beginTransaction()
 {
     m_mutex.lock();
-    getConnection().transaction();
+    m_transactionOpen = true;
+    getOpenConnection()->beginTransaction();
 }
 
 void DatabaseConnection::commitTransaction()
 {
-    getConnection().commit();
+    if (!m_transactionOpen)
+    {
+        return;
+    }
+
+    getOpenConnection()->commitTransaction();
+    m_transactionOpen = false;
     m_mutex.unlock();
 }
 
 void DatabaseConnection::rollbackTransaction()
 {
-    getConnection().rollback();
+    if (!m_transactionOpen)
+    {
+        return;
+    }
+
+    getOpenConnection()->rollbackTransaction();
+    m_transactionOpen = false;
     m_mutex.unlock();
     INFO_LOG("Transaction in the database rolled back.");
 }
 
+SqliteConnection* DatabaseConnection::getOpenConnection()
+{
+    if (!isConnected())
+    {
+        open();
+    }
+
+    return m_privateConnection ? m_privateConnection : m_pooledConnection;
+}
+
 void DatabaseConnection::open()
 {
     if (isConnected())
@@ -83,35 +460,85 @@ void DatabaseConnection::open()
         return;
     }
 
-    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE");
-    database.setDatabaseName(m_databasePath);
-    database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=15000");
+    if (isInMemoryDatabase(m_databasePath))
+    {
+        if (!m_privateConnection)
+        {
+            m_privateConnection = new SqliteConnection(m_databasePath, QString("private-%1").arg(reinterpret_cast<quintptr>(this)));
+        }
 
-    if (!database.open())
+        m_privateConnection->open();
+    }
+    else
     {
-        ERROR_LOG(database.lastError().text());
+        if (!m_pooledConnection)
+        {
+            ConnectionPool *pool = getConnectionPoolOfCurrentThread();
+            SqliteConnection *connection = pool->value(m_databasePath);
+
+            if (connection && connection->isStale())
+            {
+                // If it's in use, its current users keep it until they release it, and then it's closed
+                pool->remove(m_databasePath);
+
+                if (!connection->isInUse())
+                {
+                    delete connection;
+                }
+
+                connection = 0;
+            }
+
+            if (!connection)
+            {
+                // The generation is part of the name because a stale connection to the same database may still be in use
+                QString connectionName = QString("pooled-%1-%2-%3").arg(reinterpret_cast<quintptr>(QThread::currentThreadId())).arg(poolGeneration.load())
+                                                                   .arg(m_databasePath);
+                connection = new SqliteConnection(m_databasePath, connectionName);
+                pool->insert(m_databasePath, connection);
+            }
+
+            m_pooledConnection = connection;
+            m_pooledConnection->acquire();
+        }
+
+        m_pooledConnection->open();
     }
 }
 
 void DatabaseConnection::close()
 {
-    if (isConnected())
+    // E.g. when an exception is thrown in the middle of a transaction
+    if (m_transactionOpen)
+    {
+        WARN_LOG("Closing a database connection with a transaction in progress. It will be rolled back.");
+        rollbackTransaction();
+    }
+
+    if (m_privateConnection)
+    {
+        delete m_privateConnection;
+        m_privateConnection = 0;
+    }
+
+    // Pooled connections stay open to be reused by the next DatabaseConnection of the thread, unless they have been closed meanwhile
+    if (m_pooledConnection)
     {
-        QString name;
+        m_pooledConnection->release();
 
+        if (!m_pooledConnection->isInUse() && m_pooledConnection->isStale())
         {
-            QSqlDatabase database = QSqlDatabase::database();
-            name = database.connectionName();
-            database.close();
+            closePooledConnection(m_databasePath, m_pooledConnection);
         }
 
-        QSqlDatabase::removeDatabase(name);
+        m_pooledConnection = 0;
     }
 }
 
 bool DatabaseConnection::isConnected()
 {
-    return QSqlDatabase::database().isOpen();
+    SqliteConnection *connection = m_privateConnection ? m_privateConnection : m_pooledConnection;
+    return connection && connection->getDatabase().isOpen();
 }
 
 }
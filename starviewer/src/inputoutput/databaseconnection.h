@@ -17,16 +17,22 @@
 
 #include <QMutex>
 #include <QString>
+#include <QStringList>
 
 class QSqlDatabase;
 class QSqlError;
+class QSqlQuery;
 
 namespace udg {
 
+class SqliteConnection;
+
 /**
  * @brief The DatabaseConnection class provides the connection to the database.
  *
- * This class automatically opens the database connection when getConnection() is called and closes it in its destructor.
+ * This class automatically opens the database connection when getConnection() is called. Connections to database files are pooled per thread: they are
+ * reused by all the DatabaseConnection objects of the thread and closed when the thread finishes. Connections to in-memory databases are private to each
+ * object and closed in its destructor.
  */
 class DatabaseConnection {
 
@@ -44,6 +50,20 @@ public:
     /// Returns the connection to the database. It opens the connection if it's not already open.
     QSqlDatabase getConnection();
 
+    /// Returns a query with the given SQL prepared on this connection. Prepared statements are cached by SQL text, so repeated calls with the same SQL
+    /// reuse the compiled statement instead of preparing it again, unless the cached one is still positioned on a row (e.g. it's being iterated by an
+    /// outer loop). All the values of the returned query must be bound again before executing it.
+    QSqlQuery getPreparedQuery(const QString &sql);
+
+    /// Returns the SQL of the statements prepared with getPreparedQuery() and cached on this connection, e.g. to check their query plans. Pooled connections
+    /// are shared by the thread, so they also include the statements prepared by other DatabaseConnection objects.
+    QStringList getPreparedQueriesSql();
+
+    /// Closes the pooled connections of all the threads, e.g. before removing the database file. The idle connections of the current thread are closed
+    /// immediately. The rest are closed by their thread as soon as they are idle: when they are released, when the thread uses the database again or
+    /// when the thread finishes. DatabaseConnection objects created afterwards never use a connection opened before.
+    static void closePooledConnections();
+
     /// Returns the last error in the database.
     QSqlError getLastError();
     /// Returns the text of the last error in the database.
@@ -51,12 +71,16 @@ public:
 
     /// Begins a trasaction in the database.
     void beginTransaction();
-    /// Commits the current transaction in the database.
+    /// Commits the current transaction in the database. If the commit fails, the transaction is rolled back.
     void commitTransaction();
-    /// Rolls back the current transaction in the database. If the connexion is closed, the current transaction is rolled back automatically.
+    /// Rolls back the current transaction in the database. If this object is destroyed or closed with a transaction in progress, e.g. because an
+    /// exception has been thrown in the middle of it, the transaction is rolled back automatically, even if its pooled connection stays open.
     void rollbackTransaction();
 
 private:
+    /// Returns the connection to the database specified in the database path, opening it if it's not already open.
+    SqliteConnection* getOpenConnection();
+
     /// Opens the connection to the database specified in the database path.
     void open();
 
@@ -70,9 +94,18 @@ private:
     /// Path to the database file.
     QString m_databasePath;
 
+    /// Connection to an in-memory database, owned by this object. Connections to database files are kept in the pool of the thread instead.
+    SqliteConnection *m_privateConnection;
+
+    /// Pooled connection used by this object, if any. It's released in the destructor.
+    SqliteConnection *m_pooledConnection;
+
     /// SQLite doesn't support simultaneous transactions with the same connection, thus a mutex is needed for transactions.
     QMutex m_mutex;
 
+    /// True between beginTransaction() and commitTransaction() or rollbackTransaction(), while m_mutex is locked.
+    bool m_transactionOpen;
+
 };
 
 } // End namespace
@@ -139,6 +139,9 @@ bool DatabaseInstallation::reinstallDatabase()
 {
     QFileInfo databaseFileInfo(LocalDatabaseManager::getDatabaseFilePath());
 
+    // The pooled connections keep the file open, and those of other threads would keep using the removed database
+    DatabaseConnection::closePooledConnections();
+
     if (databaseFileInfo.exists())
     {
         if (!QFile().remove(LocalDatabaseManager::getDatabaseFilePath()))
@@ -149,6 +152,10 @@ bool DatabaseInstallation::reinstallDatabase()
         }
     }
 
+    // Remove the write-ahead log files that may have been left if the database was used in WAL mode
+    QFile::remove(LocalDatabaseManager::getDatabaseFilePath() + "-wal");
+    QFile::remove(LocalDatabaseManager::getDatabaseFilePath() + "-shm");
+
     return createDatabaseFile();
 }
 
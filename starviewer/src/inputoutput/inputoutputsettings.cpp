@@ -29,6 +29,7 @@ namespace udg {
 // Definició de les claus
 const QString CacheBase("PACS/cache/");
 const QString InputOutputSettings::DatabaseAbsoluteFilePath(CacheBase + "sdatabasePath");
+const QString InputOutputSettings::UseDatabaseWriteAheadLogging(CacheBase + "useDatabaseWriteAheadLogging");
 const QString InputOutputSettings::CachePath(CacheBase + "imagePath");
 const QString InputOutputSettings::DeleteLeastRecentlyUsedStudiesInDaysCriteria(CacheBase + "deleteOldStudiesHasNotViewedInDays");
 const QString InputOutputSettings::DeleteLeastRecentlyUsedStudiesNoFreeSpaceCriteria(CacheBase + "deleteOldStudiesIfNotEnoughSpaceAvailable");
@@ -109,6 +110,7 @@ void InputOutputSettings::init()
     SettingsRegistry *settingsRegistry = SettingsRegistry::instance();
 
     settingsRegistry->addSetting(DatabaseAbsoluteFilePath, UserDataRootPath + "pacs/database/dicom.sdb", Settings::Parseable);
+    settingsRegistry->addSetting(UseDatabaseWriteAheadLogging, false);
     settingsRegistry->addSetting(CachePath, UserDataRootPath + "pacs/dicom/", Settings::Parseable);
 
     settingsRegistry->addSetting(DeleteLeastRecentlyUsedStudiesInDaysCriteria, true);
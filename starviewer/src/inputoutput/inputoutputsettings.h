@@ -29,6 +29,9 @@ public:
     /// Declaració de claus
     /// Path absolut de l'arxiu de base dades
     static const QString DatabaseAbsoluteFilePath;
+    /// If true, the database uses write-ahead logging and relaxed synchronization, which make saving faster.
+    /// Not suitable for databases stored in network shares.
+    static const QString UseDatabaseWriteAheadLogging;
     /// Path del directori de la cache
     static const QString CachePath;
     /// Polítiques d'autogestió de cache
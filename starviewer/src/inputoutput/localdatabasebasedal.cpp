@@ -64,10 +64,14 @@ QSqlQuery LocalDatabaseBaseDAL::getNewQuery()
     return QSqlQuery(m_databaseConnection.getConnection());
 }
 
+QSqlQuery LocalDatabaseBaseDAL::getPreparedQuery(const QString &sql)
+{
+    return m_databaseConnection.getPreparedQuery(sql);
+}
+
 bool LocalDatabaseBaseDAL::executeSql(const QString &sql)
 {
-    QSqlQuery query(m_databaseConnection.getConnection());
-    query.prepare(sql);
+    QSqlQuery query = getPreparedQuery(sql);
     return executeQueryAndLogError(query);
 }
 
@@ -48,6 +48,9 @@ protected:
     /// Returns a new query that uses the current database connection.
     QSqlQuery getNewQuery();
 
+    /// Returns a query with the given SQL prepared on the current database connection, reusing the cached prepared statement if there is one.
+    QSqlQuery getPreparedQuery(const QString &sql);
+
     /// Executes the given SQL command, keeps the last error and logs it, if any. Returns true if there's no error and false otherwise.
     bool executeSql(const QString &sql);
 
@@ -14,6 +14,7 @@
 
 #include "localdatabasedisplayshutterdal.h"
 
+#include "databaseconnection.h"
 #include "dicommask.h"
 #include "displayshutter.h"
 #include "image.h"
@@ -25,30 +26,30 @@ namespace udg {
 
 namespace {
 
-// Prepares the given query with the given SQL base command followed by the appropriate where clause according to the given mask.
-void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString &sqlCommand)
+// Returns a query prepared with the given SQL base command followed by the appropriate where clause according to the given mask.
+QSqlQuery prepareQueryWithMask(DatabaseConnection &databaseConnection, const DicomMask &mask, const QString &sqlCommand)
 {
+    QString where;
+
     if (!mask.getSOPInstanceUID().isEmpty() && !mask.getImageNumber().isEmpty())
     {
-        query.prepare(sqlCommand + " WHERE ImageInstanceUID = :imageInstanceUID AND ImageFrameNumber = :imageFrameNumber");
+        where = " WHERE ImageInstanceUID = :imageInstanceUID AND ImageFrameNumber = :imageFrameNumber";
     }
     else if (!mask.getSOPInstanceUID().isEmpty())
     {
-        query.prepare(sqlCommand + " WHERE ImageInstanceUID = :imageInstanceUID");
+        where = " WHERE ImageInstanceUID = :imageInstanceUID";
     }
     else if (!mask.getSeriesInstanceUID().isEmpty())
     {
-        query.prepare(sqlCommand + " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image WHERE SeriesInstanceUID = :seriesInstanceUID)");
+        where = " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image WHERE SeriesInstanceUID = :seriesInstanceUID)";
     }
     else if (!mask.getStudyInstanceUID().isEmpty())
     {
-        query.prepare(sqlCommand + " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image WHERE StudyInstanceUID = :studyInstanceUID)");
-    }
-    else
-    {
-        query.prepare(sqlCommand);
+        where = " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image WHERE StudyInstanceUID = :studyInstanceUID)";
     }
 
+    QSqlQuery query = databaseConnection.getPreparedQuery(sqlCommand + where);
+
     if (!mask.getSOPInstanceUID().isEmpty())
     {
         query.bindValue(":imageInstanceUID", mask.getSOPInstanceUID());
@@ -65,6 +66,8 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
     {
         query.bindValue(":studyInstanceUID", mask.getStudyInstanceUID());
     }
+
+    return query;
 }
 
 // Creates and returns a display shutter with the information of the current row of the given query.
@@ -105,8 +108,7 @@ LocalDatabaseDisplayShutterDAL::LocalDatabaseDisplayShutterDAL(DatabaseConnectio
 
 bool LocalDatabaseDisplayShutterDAL::insert(const DisplayShutter &shutter, const Image *shuttersImage)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO DisplayShutter (Shape, ShutterValue, PointsList, ImageInstanceUID, ImageFrameNumber) "
+    QSqlQuery query = getPreparedQuery("INSERT INTO DisplayShutter (Shape, ShutterValue, PointsList, ImageInstanceUID, ImageFrameNumber) "
                   "VALUES (:shape, :shutterValue, :pointsList, :imageInstanceUID, :imageFrameNumber)");
     query.bindValue(":shape", shutter.getShapeAsDICOMString());
     query.bindValue(":shutterValue", shutter.getShutterValue());
@@ -143,15 +145,13 @@ bool LocalDatabaseDisplayShutterDAL::update(const QList<DisplayShutter> &shutter
 
 bool LocalDatabaseDisplayShutterDAL::del(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "DELETE FROM DisplayShutter");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "DELETE FROM DisplayShutter");
     return executeQueryAndLogError(query);
 }
 
 QList<DisplayShutter> LocalDatabaseDisplayShutterDAL::query(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT Shape, ShutterValue, PointsList FROM DisplayShutter");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT Shape, ShutterValue, PointsList FROM DisplayShutter");
     QList<DisplayShutter> shutterList;
 
     if (executeQueryAndLogError(query))
@@ -165,4 +165,22 @@ QList<DisplayShutter> LocalDatabaseDisplayShutterDAL::query(const DicomMask &mas
     return shutterList;
 }
 
+QHash<QPair<QString, int>, QList<DisplayShutter> > LocalDatabaseDisplayShutterDAL::queryGroupedByImage(const DicomMask &mask)
+{
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask,
+                                           "SELECT Shape, ShutterValue, PointsList, ImageInstanceUID, ImageFrameNumber FROM DisplayShutter");
+    QHash<QPair<QString, int>, QList<DisplayShutter> > shuttersByImage;
+
+    if (executeQueryAndLogError(query))
+    {
+        while (query.next())
+        {
+            QPair<QString, int> image(query.value("ImageInstanceUID").toString(), query.value("ImageFrameNumber").toInt());
+            shuttersByImage[image] << getDisplayShutter(query);
+        }
+    }
+
+    return shuttersByImage;
+}
+
 }
@@ -17,6 +17,9 @@
 
 #include "localdatabasebasedal.h"
 
+#include <QHash>
+#include <QPair>
+
 namespace udg {
 
 class DicomMask;
@@ -44,6 +47,10 @@ public:
     /// Retrieves from the database the display shutters that match the given mask and returns them in a list.
     QList<DisplayShutter> query(const DicomMask &mask);
 
+    /// Retrieves from the database the display shutters that match the given mask with a single query and returns them grouped by image,
+    /// using as key the SOP Instance UID and the frame number of the image.
+    QHash<QPair<QString, int>, QList<DisplayShutter> > queryGroupedByImage(const DicomMask &mask);
+
 };
 
 } // End namespace udg
@@ -14,6 +14,7 @@
 
 #include "localdatabaseencapsulateddocumentdal.h"
 
+#include "databaseconnection.h"
 #include "dicommask.h"
 #include "encapsulateddocument.h"
 #include "localdatabasemanager.h"
@@ -28,8 +29,8 @@ namespace udg {
 
 namespace {
 
-// Prepares the given query with the given SQL base command followed by the appropriate where clause according to the given mask.
-void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString &sqlCommand)
+// Returns a query prepared with the given SQL base command followed by the appropriate where clause according to the given mask.
+QSqlQuery prepareQueryWithMask(DatabaseConnection &databaseConnection, const DicomMask &mask, const QString &sqlCommand)
 {
     QString where;
 
@@ -58,7 +59,7 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
         where = " WHERE " + where;
     }
 
-    query.prepare(sqlCommand + where);
+    QSqlQuery query = databaseConnection.getPreparedQuery(sqlCommand + where);
 
     if (!mask.getStudyInstanceUID().isEmpty())
     {
@@ -72,6 +73,8 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
     {
         query.bindValue(":sopInstanceUID", mask.getSOPInstanceUID());
     }
+
+    return query;
 }
 
 }
@@ -83,8 +86,7 @@ LocalDatabaseEncapsulatedDocumentDAL::LocalDatabaseEncapsulatedDocumentDAL(Datab
 
 bool LocalDatabaseEncapsulatedDocumentDAL::insert(const EncapsulatedDocument *document)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO EncapsulatedDocument (SOPInstanceUID, TransferSyntaxUID, InstanceNumber, DocumentTitle, MimeTypeOfEncapsulatedDocument, "
+    QSqlQuery query = getPreparedQuery("INSERT INTO EncapsulatedDocument (SOPInstanceUID, TransferSyntaxUID, InstanceNumber, DocumentTitle, MimeTypeOfEncapsulatedDocument, "
                                                     "RetrievedPacsID, StudyInstanceUID, SeriesInstanceUID) "
                   "VALUES (:sopInstanceUID, :transferSyntaxUID, :instanceNumber, :documentTitle, :mimeTypeOfEncapsulatedDocument, "
                           ":retrievedPacsId, :studyInstanceUID, :seriesInstanceUID)");
@@ -94,8 +96,7 @@ bool LocalDatabaseEncapsulatedDocumentDAL::insert(const EncapsulatedDocument *do
 
 bool LocalDatabaseEncapsulatedDocumentDAL::update(const EncapsulatedDocument *document)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("UPDATE EncapsulatedDocument SET TransferSyntaxUID = :transferSyntaxUID, InstanceNumber = :instanceNumber, DocumentTitle = :documentTitle, "
+    QSqlQuery query = getPreparedQuery("UPDATE EncapsulatedDocument SET TransferSyntaxUID = :transferSyntaxUID, InstanceNumber = :instanceNumber, DocumentTitle = :documentTitle, "
                                                   "MimeTypeOfEncapsulatedDocument = :mimeTypeOfEncapsulatedDocument, RetrievedPacsID = :retrievedPacsId, "
                                                   "StudyInstanceUID = :studyInstanceUID, SeriesInstanceUID = :seriesInstanceUID "
                   "WHERE SOPInstanceUID = :sopInstanceUID");
@@ -105,18 +106,16 @@ bool LocalDatabaseEncapsulatedDocumentDAL::update(const EncapsulatedDocument *do
 
 bool LocalDatabaseEncapsulatedDocumentDAL::del(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "DELETE FROM EncapsulatedDocument");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "DELETE FROM EncapsulatedDocument");
     return executeQueryAndLogError(query);
 }
 
 QList<EncapsulatedDocument*> LocalDatabaseEncapsulatedDocumentDAL::query(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
     QString select("SELECT SOPInstanceUID, TransferSyntaxUID, InstanceNumber, DocumentTitle, MimeTypeOfEncapsulatedDocument, RetrievedPacsID, "
                           "StudyInstanceUID, SeriesInstanceUID "
                    "FROM EncapsulatedDocument");
-    prepareQueryWithMask(query, mask, select);
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, select);
     QList<EncapsulatedDocument*> documentList;
 
     if (executeQueryAndLogError(query))
@@ -132,8 +131,7 @@ QList<EncapsulatedDocument*> LocalDatabaseEncapsulatedDocumentDAL::query(const D
 
 int LocalDatabaseEncapsulatedDocumentDAL::count(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT count(*) FROM EncapsulatedDocument");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT count(*) FROM EncapsulatedDocument");
 
     if (executeQueryAndLogError(query) && query.next())
     {
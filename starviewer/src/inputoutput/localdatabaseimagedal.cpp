@@ -14,6 +14,7 @@
 
 #include "localdatabaseimagedal.h"
 
+#include "databaseconnection.h"
 #include "dicomformattedvaluesconverter.h"
 #include "dicommask.h"
 #include "image.h"
@@ -27,6 +28,7 @@
 #include <array>
 
 #include <QDate>
+#include <QRegExp>
 #include <QSqlQuery>
 #include <QVariant>
 #include <QVector2D>
@@ -35,6 +37,40 @@ namespace udg {
 
 namespace {
 
+// Maximum number of parameters in a SQLite statement with the default compilation options.
+const int MaximumNumberOfSqliteParameters = 999;
+
+// Beginning of the statement to insert images, up to the values.
+const QString InsertImageColumns("INSERT INTO Image (SOPInstanceUID, FrameNumber, StudyInstanceUID, SeriesInstanceUID, InstanceNumber, "
+                                        "ImageOrientationPatient, PatientOrientation, PixelSpacing, SliceThickness, PatientPosition, SamplesPerPixel, Rows, "
+                                        "Columns, BitsAllocated, BitsStored, PixelRepresentation, RescaleSlope, WindowLevelWidth, WindowLevelCenter, "
+                                        "WindowLevelExplanations, SliceLocation, RescaleIntercept, PhotometricInterpretation, ImageType, ViewPosition, "
+                                        "ImageLaterality, ViewCodeMeaning, PhaseNumber, ImageTime, VolumeNumberInSeries, OrderNumberInVolume, RetrievedDate, "
+                                        "RetrievedTime, State, NumberOfOverlays, RetrievedPACSID, ImagerPixelSpacing, EstimatedRadiographicMagnificationFactor, "
+                                        "TransferSyntaxUID) ");
+
+// Values of one image in the statement to insert images.
+const QString InsertImageValues("(:sopInstanceUID, :frameNumber, :studyInstanceUID, :seriesInstanceUID, :instanceNumber, :imageOrientationPatient, "
+                                 ":patientOrientation, :pixelSpacing, :sliceThickness, :patientPosition, :samplesPerPixel, :rows, :columns, :bitsAllocated, "
+                                 ":bitsStored, :pixelRepresentation, :rescaleSlope, :windowLevelWidth, :windowLevelCenter, :windowLevelExplanations, "
+                                 ":sliceLocation, :rescaleIntercept, :photometricInterpretation, :imageType, :viewPosition, :imageLaterality, "
+                                 ":viewCodeMeaning, :phaseNumber, :imageTime, :volumeNumberInSeries, :orderNumberInVolume, :retrievedDate, :retrievedTime, "
+                                 ":state, :numberOfOverlays, :retrievedPacsId, :imagerPixelSpacing, :estimatedRadiographicMagnificationFactor, "
+                                 ":transferSyntaxUID)");
+
+// Returns the statement to insert the given number of images at once. The placeholders of the i-th image have the suffix "_i".
+QString getMultiRowInsertImageSql(int numberOfImages)
+{
+    QStringList rows;
+
+    for (int i = 0; i < numberOfImages; i++)
+    {
+        rows << QString(InsertImageValues).replace(QRegExp(":(\\w+)"), QString(":\\1_%1").arg(i));
+    }
+
+    return InsertImageColumns + "VALUES " + rows.join(", ");
+}
+
 // Returns pixel spacing formatted as a DICOM string, with values separated by "\\".
 QString pixelSpacingToDicomString(const PixelSpacing2D &pixelSpacing)
 {
@@ -107,9 +143,10 @@ void windowLevelInformationToDicomStrings(const Image *image, QString &windowWid
     }
 }
 
-// Prepares the given query with the given SQL base command followed by the appropriate where clause according to the given mask
+// Returns a query prepared with the given SQL base command followed by the appropriate where clause according to the given mask
 // followed by the given SQL continuation (order by, group by, etc.).
-void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString &sqlCommand, const QString &sqlContinuation = QString())
+QSqlQuery prepareQueryWithMask(DatabaseConnection &databaseConnection, const DicomMask &mask, const QString &sqlCommand,
+                               const QString &sqlContinuation = QString())
 {
     QString where;
 
@@ -138,7 +175,7 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
         where = " WHERE " + where;
     }
 
-    query.prepare(sqlCommand + where + sqlContinuation);
+    QSqlQuery query = databaseConnection.getPreparedQuery(sqlCommand + where + sqlContinuation);
 
     if (!mask.getStudyInstanceUID().isEmpty())
     {
@@ -152,6 +189,8 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
     {
         query.bindValue(":sopInstanceUID", mask.getSOPInstanceUID());
     }
+
+    return query;
 }
 
 }
@@ -163,27 +202,43 @@ LocalDatabaseImageDAL::LocalDatabaseImageDAL(DatabaseConnection &databaseConnect
 
 bool LocalDatabaseImageDAL::insert(const Image *image)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO Image (SOPInstanceUID, FrameNumber, StudyInstanceUID, SeriesInstanceUID, InstanceNumber, ImageOrientationPatient, "
-                                     "PatientOrientation, PixelSpacing, SliceThickness, PatientPosition, SamplesPerPixel, Rows, Columns, BitsAllocated, "
-                                     "BitsStored, PixelRepresentation, RescaleSlope, WindowLevelWidth, WindowLevelCenter, WindowLevelExplanations, "
-                                     "SliceLocation, RescaleIntercept, PhotometricInterpretation, ImageType, ViewPosition, ImageLaterality, ViewCodeMeaning, "
-                                     "PhaseNumber, ImageTime, VolumeNumberInSeries, OrderNumberInVolume, RetrievedDate, RetrievedTime, State, "
-                                     "NumberOfOverlays, RetrievedPACSID, ImagerPixelSpacing, EstimatedRadiographicMagnificationFactor, TransferSyntaxUID) "
-                  "VALUES (:sopInstanceUID, :frameNumber, :studyInstanceUID, :seriesInstanceUID, :instanceNumber, :imageOrientationPatient, "
-                          ":patientOrientation, :pixelSpacing, :sliceThickness, :patientPosition, :samplesPerPixel, :rows, :columns, :bitsAllocated, "
-                          ":bitsStored, :pixelRepresentation, :rescaleSlope, :windowLevelWidth, :windowLevelCenter, :windowLevelExplanations, "
-                          ":sliceLocation, :rescaleIntercept, :photometricInterpretation, :imageType, :viewPosition, :imageLaterality, :viewCodeMeaning, "
-                          ":phaseNumber, :imageTime, :volumeNumberInSeries, :orderNumberInVolume, :retrievedDate, :retrievedTime, :state, "
-                          ":numberOfOverlays, :retrievedPacsId, :imagerPixelSpacing, :estimatedRadiographicMagnificationFactor, :transferSyntaxUID)");
+    QSqlQuery query = getPreparedQuery(InsertImageColumns + "VALUES " + InsertImageValues);
     bindValues(query, image);
     return executeQueryAndLogError(query);
 }
 
+int LocalDatabaseImageDAL::insert(const QList<Image*> &imageList)
+{
+    // Each row uses one parameter per column, and a statement can't have more than MaximumNumberOfSqliteParameters
+    const int numberOfImagesPerBatch = MaximumNumberOfSqliteParameters / InsertImageValues.count(':');
+    const QString fullBatchSql = getMultiRowInsertImageSql(numberOfImagesPerBatch);
+
+    int numberOfInsertedImages = 0;
+
+    while (numberOfInsertedImages < imageList.size())
+    {
+        int batchSize = qMin(numberOfImagesPerBatch, imageList.size() - numberOfInsertedImages);
+        QSqlQuery query = getPreparedQuery(batchSize == numberOfImagesPerBatch ? fullBatchSql : getMultiRowInsertImageSql(batchSize));
+
+        for (int i = 0; i < batchSize; i++)
+        {
+            bindValues(query, imageList.at(numberOfInsertedImages + i), QString("_%1").arg(i));
+        }
+
+        if (!executeQueryAndLogError(query))
+        {
+            break;
+        }
+
+        numberOfInsertedImages += batchSize;
+    }
+
+    return numberOfInsertedImages;
+}
+
 bool LocalDatabaseImageDAL::update(const Image *image)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("UPDATE Image SET StudyInstanceUID = :studyInstanceUID, SeriesInstanceUID = :seriesInstanceUID, InstanceNumber = :instanceNumber, "
+    QSqlQuery query = getPreparedQuery("UPDATE Image SET StudyInstanceUID = :studyInstanceUID, SeriesInstanceUID = :seriesInstanceUID, InstanceNumber = :instanceNumber, "
                                    "ImageOrientationPatient = :imageOrientationPatient, PatientOrientation = :patientOrientation, "
                                    "PixelSpacing = :pixelSpacing, SliceThickness = :sliceThickness, PatientPosition = :patientPosition, "
                                    "SamplesPerPixel = :samplesPerPixel, Rows = :rows, Columns = :columns, BitsAllocated = :bitsAllocated, "
@@ -204,14 +259,12 @@ bool LocalDatabaseImageDAL::update(const Image *image)
 
 bool LocalDatabaseImageDAL::del(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "DELETE FROM Image");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "DELETE FROM Image");
     return executeQueryAndLogError(query);
 }
 
 QList<Image*> LocalDatabaseImageDAL::query(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
     QString select("SELECT SOPInstanceUID, FrameNumber, StudyInstanceUID, SeriesInstanceUID, InstanceNumber, ImageOrientationPatient, PatientOrientation, "
                           "PixelSpacing, SliceThickness, PatientPosition, SamplesPerPixel, Rows, Columns, BitsAllocated, BitsStored, PixelRepresentation, "
                           "RescaleSlope, WindowLevelWidth, WindowLevelCenter, WindowLevelExplanations, SliceLocation, RescaleIntercept, "
@@ -220,32 +273,38 @@ QList<Image*> LocalDatabaseImageDAL::query(const DicomMask &mask)
                           "EstimatedRadiographicMagnificationFactor, TransferSyntaxUID "
                    "FROM Image");
     QString orderBy(" ORDER BY VolumeNumberInSeries, OrderNumberInVolume");
-    prepareQueryWithMask(query, mask, select, orderBy);
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, select, orderBy);
     QList<Image*> imageList;
 
     if (executeQueryAndLogError(query))
     {
-        LocalDatabaseDisplayShutterDAL shutterDAL(m_databaseConnection);
-        LocalDatabaseVoiLutDAL voiLutDAL(m_databaseConnection);
-
         while (query.next())
         {
-            Image *image = getImage(query);
+            imageList << getImage(query);
+        }
+    }
+
+    if (!imageList.isEmpty())
+    {
+        // Get the display shutters and VOI LUTs of all the images at once instead of querying them image by image.
+        // Only the fields used to select the images are kept, so that the mask doesn't filter by frame.
+        DicomMask imagesMask;
+        imagesMask.setStudyInstanceUID(mask.getStudyInstanceUID());
+        imagesMask.setSeriesInstanceUID(mask.getSeriesInstanceUID());
+        imagesMask.setSOPInstanceUID(mask.getSOPInstanceUID());
 
-            // Get display shutters
-            DicomMask mask;
-            mask.setSOPInstanceUID(image->getSOPInstanceUID());
-            mask.setImageNumber(QString::number(image->getFrameNumber()));
-            image->setDisplayShutters(shutterDAL.query(mask));
+        QHash<QPair<QString, int>, QList<DisplayShutter> > shuttersByImage = LocalDatabaseDisplayShutterDAL(m_databaseConnection).queryGroupedByImage(imagesMask);
+        QHash<QPair<QString, int>, QList<VoiLut> > voiLutsByImage = LocalDatabaseVoiLutDAL(m_databaseConnection).queryGroupedByImage(imagesMask);
 
-            // Get VOI LUTs
-            QList<VoiLut> voiLuts = voiLutDAL.query(mask);
-            foreach (const VoiLut &voiLut, voiLuts)
+        foreach (Image *image, imageList)
+        {
+            QPair<QString, int> imageKey(image->getSOPInstanceUID(), image->getFrameNumber());
+            image->setDisplayShutters(shuttersByImage.value(imageKey));
+
+            foreach (const VoiLut &voiLut, voiLutsByImage.value(imageKey))
             {
                 image->addVoiLut(voiLut);
             }
-
-            imageList << image;
         }
     }
 
@@ -254,8 +313,7 @@ QList<Image*> LocalDatabaseImageDAL::query(const DicomMask &mask)
 
 int LocalDatabaseImageDAL::count(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT count(*) FROM Image");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT count(*) FROM Image");
 
     if (executeQueryAndLogError(query) && query.next())
     {
@@ -267,49 +325,49 @@ int LocalDatabaseImageDAL::count(const DicomMask &mask)
     }
 }
 
-void LocalDatabaseImageDAL::bindValues(QSqlQuery &query, const Image *image)
+void LocalDatabaseImageDAL::bindValues(QSqlQuery &query, const Image *image, const QString &placeholderSuffix)
 {
-    query.bindValue(":sopInstanceUID", image->getSOPInstanceUID());
-    query.bindValue(":frameNumber", image->getFrameNumber());
-    query.bindValue(":studyInstanceUID", image->getParentSeries()->getParentStudy()->getInstanceUID());
-    query.bindValue(":seriesInstanceUID", image->getParentSeries()->getInstanceUID());
-    query.bindValue(":instanceNumber", image->getInstanceNumber());
-    query.bindValue(":imageOrientationPatient", image->getImageOrientationPatient().getDICOMFormattedImageOrientation());
-    query.bindValue(":patientOrientation", image->getPatientOrientation().getDICOMFormattedPatientOrientation());
-    query.bindValue(":pixelSpacing", pixelSpacingToDicomString(image->getPixelSpacing()));
-    query.bindValue(":sliceThickness", image->getSliceThickness());
-    query.bindValue(":patientPosition", imagePositionPatientToDicomString(image->getImagePositionPatient()));
-    query.bindValue(":samplesPerPixel", image->getSamplesPerPixel());
-    query.bindValue(":rows", image->getRows());
-    query.bindValue(":columns", image->getColumns());
-    query.bindValue(":bitsAllocated", image->getBitsAllocated());
-    query.bindValue(":bitsStored", image->getBitsStored());
-    query.bindValue(":pixelRepresentation", image->getPixelRepresentation());
-    query.bindValue(":rescaleSlope", image->getRescaleSlope());
+    query.bindValue(":sopInstanceUID" + placeholderSuffix, image->getSOPInstanceUID());
+    query.bindValue(":frameNumber" + placeholderSuffix, image->getFrameNumber());
+    query.bindValue(":studyInstanceUID" + placeholderSuffix, image->getParentSeries()->getParentStudy()->getInstanceUID());
+    query.bindValue(":seriesInstanceUID" + placeholderSuffix, image->getParentSeries()->getInstanceUID());
+    query.bindValue(":instanceNumber" + placeholderSuffix, image->getInstanceNumber());
+    query.bindValue(":imageOrientationPatient" + placeholderSuffix, image->getImageOrientationPatient().getDICOMFormattedImageOrientation());
+    query.bindValue(":patientOrientation" + placeholderSuffix, image->getPatientOrientation().getDICOMFormattedPatientOrientation());
+    query.bindValue(":pixelSpacing" + placeholderSuffix, pixelSpacingToDicomString(image->getPixelSpacing()));
+    query.bindValue(":sliceThickness" + placeholderSuffix, image->getSliceThickness());
+    query.bindValue(":patientPosition" + placeholderSuffix, imagePositionPatientToDicomString(image->getImagePositionPatient()));
+    query.bindValue(":samplesPerPixel" + placeholderSuffix, image->getSamplesPerPixel());
+    query.bindValue(":rows" + placeholderSuffix, image->getRows());
+    query.bindValue(":columns" + placeholderSuffix, image->getColumns());
+    query.bindValue(":bitsAllocated" + placeholderSuffix, image->getBitsAllocated());
+    query.bindValue(":bitsStored" + placeholderSuffix, image->getBitsStored());
+    query.bindValue(":pixelRepresentation" + placeholderSuffix, image->getPixelRepresentation());
+    query.bindValue(":rescaleSlope" + placeholderSuffix, image->getRescaleSlope());
     QString windowWidth, windowCenter, windowExplanation;
     windowLevelInformationToDicomStrings(image, windowWidth, windowCenter, windowExplanation);
-    query.bindValue(":windowLevelWidth", windowWidth);
-    query.bindValue(":windowLevelCenter", windowCenter);
-    query.bindValue(":windowLevelExplanations", windowExplanation);
-    query.bindValue(":sliceLocation", image->getSliceLocation());
-    query.bindValue(":rescaleIntercept", image->getRescaleIntercept());
-    query.bindValue(":photometricInterpretation", image->getPhotometricInterpretation().getAsQString());
-    query.bindValue(":imageType", image->getImageType());
-    query.bindValue(":viewPosition", image->getViewPosition());
-    query.bindValue(":imageLaterality", convertToQString(image->getImageLaterality()));
-    query.bindValue(":viewCodeMeaning", image->getViewCodeMeaning());
-    query.bindValue(":phaseNumber", image->getPhaseNumber());
-    query.bindValue(":imageTime", image->getImageTime());
-    query.bindValue(":volumeNumberInSeries", image->getVolumeNumberInSeries());
-    query.bindValue(":orderNumberInVolume", image->getOrderNumberInVolume());
-    query.bindValue(":retrievedDate", image->getRetrievedDate().toString("yyyyMMdd"));
-    query.bindValue(":retrievedTime", image->getRetrievedTime().toString("hhmmss"));
-    query.bindValue(":state", 0);
-    query.bindValue(":numberOfOverlays", image->getNumberOfOverlays());
-    query.bindValue(":retrievedPacsId", getDatabasePacsId(image->getDICOMSource()));
-    query.bindValue(":imagerPixelSpacing", pixelSpacingToDicomString(image->getImagerPixelSpacing()));
-    query.bindValue(":estimatedRadiographicMagnificationFactor", QString::number(image->getEstimatedRadiographicMagnificationFactor()));
-    query.bindValue(":transferSyntaxUID", image->getTransferSyntaxUID());
+    query.bindValue(":windowLevelWidth" + placeholderSuffix, windowWidth);
+    query.bindValue(":windowLevelCenter" + placeholderSuffix, windowCenter);
+    query.bindValue(":windowLevelExplanations" + placeholderSuffix, windowExplanation);
+    query.bindValue(":sliceLocation" + placeholderSuffix, image->getSliceLocation());
+    query.bindValue(":rescaleIntercept" + placeholderSuffix, image->getRescaleIntercept());
+    query.bindValue(":photometricInterpretation" + placeholderSuffix, image->getPhotometricInterpretation().getAsQString());
+    query.bindValue(":imageType" + placeholderSuffix, image->getImageType());
+    query.bindValue(":viewPosition" + placeholderSuffix, image->getViewPosition());
+    query.bindValue(":imageLaterality" + placeholderSuffix, convertToQString(image->getImageLaterality()));
+    query.bindValue(":viewCodeMeaning" + placeholderSuffix, image->getViewCodeMeaning());
+    query.bindValue(":phaseNumber" + placeholderSuffix, image->getPhaseNumber());
+    query.bindValue(":imageTime" + placeholderSuffix, image->getImageTime());
+    query.bindValue(":volumeNumberInSeries" + placeholderSuffix, image->getVolumeNumberInSeries());
+    query.bindValue(":orderNumberInVolume" + placeholderSuffix, image->getOrderNumberInVolume());
+    query.bindValue(":retrievedDate" + placeholderSuffix, image->getRetrievedDate().toString("yyyyMMdd"));
+    query.bindValue(":retrievedTime" + placeholderSuffix, image->getRetrievedTime().toString("hhmmss"));
+    query.bindValue(":state" + placeholderSuffix, 0);
+    query.bindValue(":numberOfOverlays" + placeholderSuffix, image->getNumberOfOverlays());
+    query.bindValue(":retrievedPacsId" + placeholderSuffix, getDatabasePacsId(image->getDICOMSource()));
+    query.bindValue(":imagerPixelSpacing" + placeholderSuffix, pixelSpacingToDicomString(image->getImagerPixelSpacing()));
+    query.bindValue(":estimatedRadiographicMagnificationFactor" + placeholderSuffix, QString::number(image->getEstimatedRadiographicMagnificationFactor()));
+    query.bindValue(":transferSyntaxUID" + placeholderSuffix, image->getTransferSyntaxUID());
 }
 
 Image* LocalDatabaseImageDAL::getImage(const QSqlQuery &query)
@@ -39,6 +39,10 @@ public:
     /// Inserts to the database the given image. Returns true if successful and false otherwise.
     bool insert(const Image *image);
 
+    /// Inserts to the database the images in the given list, several images per statement, which is much faster than inserting them one by one.
+    /// Stops at the first statement that fails. Returns the number of images from the beginning of the list that have been inserted.
+    int insert(const QList<Image*> &imageList);
+
     /// Updates in the database the given image. Returns true if successful and false otherwise.
     bool update(const Image *image);
 
@@ -56,7 +60,8 @@ public:
 
 private:
     /// Binds the necessary values of the given query with the information of the given image.
-    void bindValues(QSqlQuery &query, const Image *image);
+    /// The given suffix is appended to the placeholder names, for statements with the values of several images.
+    void bindValues(QSqlQuery &query, const Image *image, const QString &placeholderSuffix = QString());
 
     /// Creates and returns an image with the information of the current row of the given query.
     Image* getImage(const QSqlQuery &query);
@@ -15,8 +15,10 @@
 #include "localdatabasemanager.h"
 
 #include "databaseconnection.h"
+#include "decodedvolumecache.h"
 #include "dicommask.h"
 #include "directoryutilities.h"
+#include "encapsulateddocument.h"
 #include "harddiskinformation.h"
 #include "image.h"
 #include "inputoutputsettings.h"
@@ -29,7 +31,7 @@
 #include "localdatabaseutildal.h"
 #include "localdatabasevoilutdal.h"
 #include "patient.h"
-#include "thumbnailcreator.h"
+#include "thumbnailservice.h"
 
 #include <QDir>
 
@@ -127,13 +129,33 @@ void saveImage(DatabaseConnection &databaseConnection, const Image *image)
 }
 
 // Saves the images in the given list to the database, inserting or updating them as necessary.
+// The images are inserted in batches until one of them fails because an image already exists. From then on they are saved one by one.
 void saveImages(DatabaseConnection &databaseConnection, const QList<Image*> &imageList, const QDate &currentDate, const QTime &currentTime)
 {
     foreach (Image *image, imageList)
     {
         image->setRetrievedDate(currentDate);
         image->setRetrievedTime(currentTime);
-        saveImage(databaseConnection, image);
+    }
+
+    LocalDatabaseImageDAL imageDAL(databaseConnection);
+    int numberOfInsertedImages = imageDAL.insert(imageList);
+
+    if (numberOfInsertedImages < imageList.size() && imageDAL.getLastError().nativeErrorCode().toInt() != DatabaseConnection::SqliteConstraint)
+    {
+        throw imageDAL.getLastError();
+    }
+
+    for (int i = 0; i < numberOfInsertedImages; i++)
+    {
+        const Image *image = imageList.at(i);
+        insertDisplayShutters(databaseConnection, image->getDisplayShutters(), image);
+        insertVoiLuts(databaseConnection, image);
+    }
+
+    for (int i = numberOfInsertedImages; i < imageList.size(); i++)
+    {
+        saveImage(databaseConnection, imageList.at(i));
     }
 }
 
@@ -393,6 +415,30 @@ int countSeries(const DicomMask &mask)
     return count;
 }
 
+// Removes the decoded volumes cached for the series with the given UIDs, because its files may have changed or are going to be deleted.
+void invalidateDecodedVolumeCache(const QString &studyInstanceUID, const QString &seriesInstanceUID)
+{
+    DecodedVolumeCache::invalidate(LocalDatabaseManager::getStudyPath(studyInstanceUID) + "/" + seriesInstanceUID);
+}
+
+// Removes the decoded volumes cached for the given series, because its files may have changed or are going to be deleted.
+void invalidateDecodedVolumeCache(const Series *series)
+{
+    invalidateDecodedVolumeCache(series->getParentStudy()->getInstanceUID(), series->getInstanceUID());
+}
+
+// Removes the decoded volumes cached for every series directory of the study with the given UID, before deleting it. The directories are listed instead
+// of queried because the study may not be in the database anymore, or may have been partially retrieved.
+void invalidateDecodedVolumeCacheOfStudy(const QString &studyInstanceUID)
+{
+    QDir studyDirectory(LocalDatabaseManager::getStudyPath(studyInstanceUID));
+
+    foreach (const QString &seriesInstanceUID, studyDirectory.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        invalidateDecodedVolumeCache(studyInstanceUID, seriesInstanceUID);
+    }
+}
+
 // Deletes all the studies from the given patient from the disk.
 void deleteRetrievedObjects(const Patient *patient)
 {
@@ -400,6 +446,7 @@ void deleteRetrievedObjects(const Patient *patient)
 
     foreach (Study *study, patient->getStudies())
     {
+        invalidateDecodedVolumeCacheOfStudy(study->getInstanceUID());
         directoryUtilities.deleteDirectory(LocalDatabaseManager::getCachePath() + study->getInstanceUID(), true);
     }
 }
@@ -410,6 +457,8 @@ void deleteRetrievedObjects(const Series *series)
     QString studyPath = LocalDatabaseManager::getCachePath() + series->getParentStudy()->getInstanceUID();
     QString seriesDirectory = studyPath + QDir::separator() + series->getInstanceUID();
 
+    invalidateDecodedVolumeCache(series);
+
     DirectoryUtilities directoryUtilities;
     directoryUtilities.deleteDirectory(seriesDirectory, true);
 
@@ -425,24 +474,17 @@ QString getSeriesThumbnailPath(const QString &studyInstanceUID, const Series *se
     return LocalDatabaseManager::getStudyPath(studyInstanceUID) + "/" + series->getInstanceUID() + "/thumbnail.png";
 }
 
-// Creates and saves a thumbnail for the given series in the directory of the series' images.
-void createSeriesThumbnail(const Series *series)
+// Requests the thumbnails of the given series that don't exist yet to the ThumbnailService, which creates them in the background and saves them in the
+// directory of the series, under the local database cache. Icon thumbnails aren't saved, Series::getThumbnail() creates them when needed.
+void createSeriesThumbnails(const QList<Series*> &seriesList)
 {
-    QString thumbnailFilePath = getSeriesThumbnailPath(series->getParentStudy()->getInstanceUID(), series);
-
-    // Create thumbnail only if it doesn't already exist
-    if (!QFileInfo(thumbnailFilePath).exists())
+    foreach (const Series *series, seriesList)
     {
-        ThumbnailCreator().getThumbnail(series).save(thumbnailFilePath, "PNG");
-    }
-}
-
-// Creates and saves a thumbnail for each series in the given study.
-void createStudyThumbnails(const Study *study)
-{
-    foreach (Series *series, study->getSeries())
-    {
-        createSeriesThumbnail(series);
+        if (!QFileInfo(getSeriesThumbnailPath(series->getParentStudy()->getInstanceUID(), series)).exists())
+        {
+            // They aren't shown yet, so they go after the ones that are
+            ThumbnailService::instance()->requestThumbnail(series, ThumbnailService::LowPriority);
+        }
     }
 }
 
@@ -524,7 +566,8 @@ void LocalDatabaseManager::save(Series *series)
 
         databaseConnection.commitTransaction();
 
-        createSeriesThumbnail(series);
+        createSeriesThumbnails(QList<Series*>() << series);
+        invalidateDecodedVolumeCache(series);
 
         m_lastError = Ok;
     }
@@ -553,6 +596,15 @@ QList<Patient*> LocalDatabaseManager::queryPatientsAndStudies(const DicomMask &m
     return patientList;
 }
 
+QList<Patient*> LocalDatabaseManager::queryPatientsAndStudies(const DicomMask &mask, LocalDatabaseStudyDAL::PatientStudyCursor &cursor, int pageSize)
+{
+    DatabaseConnection databaseConnection;
+    LocalDatabaseStudyDAL studyDAL(databaseConnection);
+    QList<Patient*> patientList = studyDAL.queryPatientStudyPage(mask, cursor, pageSize, QDate(), LastAccessDateSelectedStudies);
+    setLastError(studyDAL.getLastError());
+    return patientList;
+}
+
 QList<Study*> LocalDatabaseManager::queryStudies(const DicomMask &mask)
 {
     DatabaseConnection databaseConnection;
@@ -955,7 +1007,12 @@ void LocalDatabaseManager::save(Patient *patient)
 
         foreach (Study *study, patient->getStudies())
         {
-            createStudyThumbnails(study);
+            createSeriesThumbnails(study->getSeries());
+
+            foreach (Series *series, study->getSeries())
+            {
+                invalidateDecodedVolumeCache(series);
+            }
         }
 
         m_lastError = Ok;
@@ -1010,6 +1067,9 @@ QList<Study*> LocalDatabaseManager::getAllStudiesOrderedByLastAccessDate()
 
 void LocalDatabaseManager::deleteStudyFromHardDisk(const QString &studyInstanceUID)
 {
+    // Loaded volumes may keep their cached blobs mapped, and the generation must change so that the volumes being read now are not stored afterwards
+    invalidateDecodedVolumeCacheOfStudy(studyInstanceUID);
+
     if (DirectoryUtilities().deleteDirectory(getStudyPath(studyInstanceUID), true))
     {
         m_lastError = Ok;
@@ -1022,6 +1082,8 @@ void LocalDatabaseManager::deleteStudyFromHardDisk(const QString &studyInstanceU
 
 void LocalDatabaseManager::deleteSeriesFromHardDisk(const QString &studyInstanceUID, const QString &seriesInstanceUID)
 {
+    invalidateDecodedVolumeCache(studyInstanceUID, seriesInstanceUID);
+
     if (DirectoryUtilities().deleteDirectory(getStudyPath(studyInstanceUID) + QDir::separator() + seriesInstanceUID, true))
     {
         m_lastError = Ok;
@@ -15,6 +15,8 @@
 #ifndef UDGLOCALDATABASEMANAGER_H
 #define UDGLOCALDATABASEMANAGER_H
 
+#include "localdatabasestudydal.h"
+
 #include <QObject>
 
 class QSqlError;
@@ -56,6 +58,9 @@ public:
     /// Returns patients that contain studies that match the given mask (PatientID, PatientName, StudyDate and StudyInstanceUID are considered).
     /// Returns the patients with the studies but not series and images.
     QList<Patient*> queryPatientsAndStudies(const DicomMask &mask);
+    /// Returns the next page of at most \a pageSize patients with studies that match the given mask, as queryPatientsAndStudies(), and moves the given cursor
+    /// past them. Pass a default-constructed cursor to get the first page; when the cursor is at the end there are no more pages.
+    QList<Patient*> queryPatientsAndStudies(const DicomMask &mask, LocalDatabaseStudyDAL::PatientStudyCursor &cursor, int pageSize);
     /// Returns studies that match the given mask (only StudyInstanceUID is considered). Returns only studies, without patients, series and images.
     QList<Study*> queryStudies(const DicomMask &mask);
     /// Returns series that match the given mask (only StudyInstanceUID and SeriesInstanceUID are considered).
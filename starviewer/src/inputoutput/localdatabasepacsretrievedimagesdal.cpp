@@ -28,8 +28,7 @@ LocalDatabasePACSRetrievedImagesDAL::LocalDatabasePACSRetrievedImagesDAL(Databas
 
 qlonglong LocalDatabasePACSRetrievedImagesDAL::insert(const PacsDevice &pacsDevice)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO PACSRetrievedImages (AETitle, Address, QueryPort) VALUES (:aeTitle, :address, :queryPort)");
+    QSqlQuery query = getPreparedQuery("INSERT INTO PACSRetrievedImages (AETitle, Address, QueryPort) VALUES (:aeTitle, :address, :queryPort)");
     query.bindValue(":aeTitle", pacsDevice.getAETitle());
     query.bindValue(":address", pacsDevice.getAddress());
     query.bindValue(":queryPort", pacsDevice.getQueryRetrieveServicePort());
@@ -46,16 +45,15 @@ qlonglong LocalDatabasePACSRetrievedImagesDAL::insert(const PacsDevice &pacsDevi
 
 PacsDevice LocalDatabasePACSRetrievedImagesDAL::query(qlonglong pacsId)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("SELECT ID, AETitle, Address, QueryPort FROM PACSRetrievedImages WHERE ID = :id");
+    QSqlQuery query = getPreparedQuery("SELECT ID, AETitle, Address, QueryPort FROM PACSRetrievedImages WHERE ID = :id");
     query.bindValue(":id", pacsId);
     return this->query(query);
 }
 
 PacsDevice LocalDatabasePACSRetrievedImagesDAL::query(const QString &aeTitle, const QString &address, int queryPort)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("SELECT ID, AETitle, Address, QueryPort FROM PACSRetrievedImages WHERE AETitle = :aeTitle AND Address = :address AND QueryPort = :queryPort");
+    QSqlQuery query = getPreparedQuery("SELECT ID, AETitle, Address, QueryPort FROM PACSRetrievedImages "
+                                       "WHERE AETitle = :aeTitle AND Address = :address AND QueryPort = :queryPort");
     query.bindValue(":aeTitle", aeTitle);
     query.bindValue(":address", address);
     query.bindValue(":queryPort", queryPort);
@@ -14,6 +14,7 @@
 
 #include "localdatabasepatientdal.h"
 
+#include "databaseconnection.h"
 #include "dicommask.h"
 #include "patient.h"
 
@@ -33,18 +34,17 @@ void bindValues(QSqlQuery &query, const Patient *patient)
     query.bindValue(":sex", patient->getSex());
 }
 
-// Prepares the given query with the given SQL base command followed by the appropriate where clause according to the given mask.
-void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString &sqlCommand)
+// Returns a query prepared with the given SQL base command followed by the appropriate where clause according to the given mask.
+QSqlQuery prepareQueryWithMask(DatabaseConnection &databaseConnection, const DicomMask &mask, const QString &sqlCommand)
 {
     if (mask.getPatientID().isEmpty())
     {
-        query.prepare(sqlCommand);
-    }
-    else
-    {
-        query.prepare(sqlCommand + " WHERE DICOMPatientId = :dicomPatientId");
-        query.bindValue(":dicomPatientId", mask.getPatientID());
+        return databaseConnection.getPreparedQuery(sqlCommand);
     }
+
+    QSqlQuery query = databaseConnection.getPreparedQuery(sqlCommand + " WHERE DICOMPatientId = :dicomPatientId");
+    query.bindValue(":dicomPatientId", mask.getPatientID());
+    return query;
 }
 
 
@@ -57,8 +57,7 @@ LocalDatabasePatientDAL::LocalDatabasePatientDAL(DatabaseConnection &databaseCon
 
 bool LocalDatabasePatientDAL::insert(Patient *patient)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO Patient (DICOMPatientId, Name, BirthDate, Sex) VALUES (:dicomPatientId, :name, :birthDate, :sex)");
+    QSqlQuery query = getPreparedQuery("INSERT INTO Patient (DICOMPatientId, Name, BirthDate, Sex) VALUES (:dicomPatientId, :name, :birthDate, :sex)");
     bindValues(query, patient);
 
     if (executeQueryAndLogError(query))
@@ -74,8 +73,7 @@ bool LocalDatabasePatientDAL::insert(Patient *patient)
 
 bool LocalDatabasePatientDAL::update(const Patient *patient)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("UPDATE Patient SET DICOMPatientId = :dicomPatientId, Name = :name, BirthDate = :birthDate, Sex = :sex WHERE ID = :id");
+    QSqlQuery query = getPreparedQuery("UPDATE Patient SET DICOMPatientId = :dicomPatientId, Name = :name, BirthDate = :birthDate, Sex = :sex WHERE ID = :id");
     bindValues(query, patient);
     query.bindValue(":id", patient->getDatabaseID());
     return executeQueryAndLogError(query);
@@ -83,16 +81,14 @@ bool LocalDatabasePatientDAL::update(const Patient *patient)
 
 bool LocalDatabasePatientDAL::del(qlonglong patientID)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("DELETE FROM Patient WHERE ID = :id");
+    QSqlQuery query = getPreparedQuery("DELETE FROM Patient WHERE ID = :id");
     query.bindValue(":id", patientID);
     return executeQueryAndLogError(query);
 }
 
 QList<Patient*> LocalDatabasePatientDAL::query(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT ID, DICOMPatientId, Name, Birthdate, Sex FROM Patient");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT ID, DICOMPatientId, Name, Birthdate, Sex FROM Patient");
     QList<Patient*> patientList;
 
     if (executeQueryAndLogError(query))
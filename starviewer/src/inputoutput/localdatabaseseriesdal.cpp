@@ -14,6 +14,7 @@
 
 #include "localdatabaseseriesdal.h"
 
+#include "databaseconnection.h"
 #include "dicommask.h"
 #include "localdatabasemanager.h"
 #include "series.h"
@@ -50,8 +51,8 @@ void bindValues(QSqlQuery &query, const Series *series)
     query.bindValue(":state", 0);
 }
 
-// Prepares the given query with the given SQL base command followed by the appropriate where clause according to the given mask.
-void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString &sqlCommand)
+// Returns a query prepared with the given SQL base command followed by the appropriate where clause according to the given mask.
+QSqlQuery prepareQueryWithMask(DatabaseConnection &databaseConnection, const DicomMask &mask, const QString &sqlCommand)
 {
     QString where;
 
@@ -72,7 +73,7 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
         where = " WHERE " + where;
     }
 
-    query.prepare(sqlCommand + where);
+    QSqlQuery query = databaseConnection.getPreparedQuery(sqlCommand + where);
 
     if (!mask.getStudyInstanceUID().isEmpty())
     {
@@ -82,6 +83,8 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
     {
         query.bindValue(":seriesInstanceUID", mask.getSeriesInstanceUID());
     }
+
+    return query;
 }
 
 }
@@ -93,8 +96,7 @@ LocalDatabaseSeriesDAL::LocalDatabaseSeriesDAL(DatabaseConnection &databaseConne
 
 bool LocalDatabaseSeriesDAL::insert(const Series *series)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO Series (InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, InstitutionName, PatientPosition, ProtocolName, "
+    QSqlQuery query = getPreparedQuery("INSERT INTO Series (InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, InstitutionName, PatientPosition, ProtocolName, "
                                       "Description, FrameOfReferenceUID, PositionReferenceIndicator, BodyPartExaminated, ViewPosition, Manufacturer, "
                                       "Laterality, RetrievedDate, RetrievedTime, State) "
                   "VALUES (:instanceUID, :studyInstanceUID, :number, :modality, :date, :time, :institutionName, :patientPosition, :protocolName, "
@@ -106,8 +108,7 @@ bool LocalDatabaseSeriesDAL::insert(const Series *series)
 
 bool LocalDatabaseSeriesDAL::update(const Series *series)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("UPDATE Series SET StudyInstanceUID = :studyInstanceUID, Number = :number, Modality = :modality, Date = :date, Time = :time, "
+    QSqlQuery query = getPreparedQuery("UPDATE Series SET StudyInstanceUID = :studyInstanceUID, Number = :number, Modality = :modality, Date = :date, Time = :time, "
                                     "InstitutionName = :institutionName, PatientPosition = :patientPosition, ProtocolName = :protocolName, "
                                     "Description = :description, FrameOfReferenceUID = :frameOfReferenceUID, "
                                     "PositionReferenceIndicator = :positionReferenceIndicator, BodyPartExaminated = :bodyPartExamined, "
@@ -120,18 +121,17 @@ bool LocalDatabaseSeriesDAL::update(const Series *series)
 
 bool LocalDatabaseSeriesDAL::del(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "DELETE FROM Series");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "DELETE FROM Series");
     return executeQueryAndLogError(query);
 }
 
 QList<Series*> LocalDatabaseSeriesDAL::query(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, InstitutionName, PatientPosition, ProtocolName, "
-                                             "Description, FrameOfReferenceUID, PositionReferenceIndicator, BodyPartExaminated, ViewPosition,  Manufacturer, "
-                                             "Laterality, RetrievedDate, RetrievedTime, State "
-                                      "FROM Series");
+    QString select("SELECT InstanceUID, StudyInstanceUID, Number, Modality, Date, Time, InstitutionName, PatientPosition, ProtocolName, "
+                          "Description, FrameOfReferenceUID, PositionReferenceIndicator, BodyPartExaminated, ViewPosition,  Manufacturer, "
+                          "Laterality, RetrievedDate, RetrievedTime, State "
+                   "FROM Series");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, select);
     QList<Series*> seriesList;
 
     if (executeQueryAndLogError(query))
@@ -147,8 +147,7 @@ QList<Series*> LocalDatabaseSeriesDAL::query(const DicomMask &mask)
 
 int LocalDatabaseSeriesDAL::count(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT count(*) FROM Series");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT count(*) FROM Series");
 
     if (executeQueryAndLogError(query) && query.next())
     {
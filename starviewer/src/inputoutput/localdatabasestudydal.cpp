@@ -14,6 +14,7 @@
 
 #include "localdatabasestudydal.h"
 
+#include "databaseconnection.h"
 #include "dicommask.h"
 #include "patient.h"
 #include "study.h"
@@ -46,9 +47,9 @@ void bindValues(QSqlQuery &query, const Study *study, const QDate &lastAccessDat
     query.bindValue(":state", 0);
 }
 
-// Prepares the given query to query studies according to the given mask and access dates and ordered according to orderBy.
-void prepareSelectFromStudy(QSqlQuery &query, const DicomMask &mask, const QDate &accessedBefore, const QDate &accessedAfter,
-                            const QString &orderBy = QString())
+// Returns a query prepared to query studies according to the given mask and access dates and ordered according to orderBy.
+QSqlQuery prepareSelectFromStudy(DatabaseConnection &databaseConnection, const DicomMask &mask, const QDate &accessedBefore, const QDate &accessedAfter,
+                                 const QString &orderBy = QString())
 {
     QString select("SELECT InstanceUID, PatientID, ID, PatientAge, PatientWeigth, PatientHeigth, Modalities, Date, Time, AccessionNumber, Description, "
                           "ReferringPhysicianName, LastAccessDate, RetrievedDate, RetrievedTime, State "
@@ -79,7 +80,7 @@ void prepareSelectFromStudy(QSqlQuery &query, const DicomMask &mask, const QDate
         where = " WHERE " + where;
     }
 
-    query.prepare(select + where + orderBy);
+    QSqlQuery query = databaseConnection.getPreparedQuery(select + where + orderBy);
 
     if (!mask.getStudyInstanceUID().isEmpty())
     {
@@ -93,10 +94,14 @@ void prepareSelectFromStudy(QSqlQuery &query, const DicomMask &mask, const QDate
     {
         query.bindValue(":accessedAfter", accessedAfter.toString("yyyyMMdd"));
     }
+
+    return query;
 }
 
-// Prepares the given query to query studies and patients according to the given mask and access dates.
-void prepareSelectFromStudyPatient(QSqlQuery &query, const DicomMask &mask, const QDate &accessedBefore, const QDate &accessedAfter)
+// Returns a query prepared to query studies and patients according to the given mask and access dates. If a cursor is given, only the first pageSize
+// results after the cursor are queried, sorted by study instance UID.
+QSqlQuery prepareSelectFromStudyPatient(DatabaseConnection &databaseConnection, const DicomMask &mask, const QDate &accessedBefore,
+                                        const QDate &accessedAfter, const LocalDatabaseStudyDAL::PatientStudyCursor *cursor = 0, int pageSize = 0)
 {
     QString select("SELECT InstanceUID, PatientID, Study.ID, PatientAge, PatientWeigth, PatientHeigth, Modalities, Date, Time, AccessionNumber, Description, "
                           "ReferringPhysicianName, LastAccessDate, RetrievedDate, RetrievedTime, Study.State, "
@@ -136,9 +141,21 @@ void prepareSelectFromStudyPatient(QSqlQuery &query, const DicomMask &mask, cons
     {
         where += " AND Modalities LIKE :modalities";
     }
-    QString orderBy(" ORDER BY Patient_Name");
+    if (cursor)
+    {
+        // Also for the first page, with an empty UID, so that every page is a range search on the primary key index of Study instead of a scan
+        where += " AND InstanceUID > :lastStudyInstanceUID";
+    }
+    // Paging on the study instance UID, which is unique, never changes and is indexed, keeps the order stable while studies are inserted or deleted
+    // and lets SQLite read the studies in order from the index, without sorting the whole join. Unpaged queries aren't sorted, so that they can use
+    // the date indexes
+    QString orderBy;
+    if (cursor)
+    {
+        orderBy = " ORDER BY InstanceUID LIMIT :pageSize";
+    }
 
-    query.prepare(select + where + orderBy);
+    QSqlQuery query = databaseConnection.getPreparedQuery(select + where + orderBy);
 
     if (!mask.getStudyInstanceUID().isEmpty())
     {
@@ -172,6 +189,13 @@ void prepareSelectFromStudyPatient(QSqlQuery &query, const DicomMask &mask, cons
     {
         query.bindValue(":modalities", QString("%%1%").arg(mask.getSeriesModality()));
     }
+    if (cursor)
+    {
+        query.bindValue(":lastStudyInstanceUID", cursor->lastStudyInstanceUID);
+        query.bindValue(":pageSize", pageSize);
+    }
+
+    return query;
 }
 
 }
@@ -183,8 +207,7 @@ LocalDatabaseStudyDAL::LocalDatabaseStudyDAL(DatabaseConnection &databaseConnect
 
 bool LocalDatabaseStudyDAL::insert(const Study *study, const QDate &lastAccessDate)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO Study (InstanceUID, PatientID, ID, PatientAge, PatientWeigth, PatientHeigth, Modalities, Date, Time, AccessionNumber, "
+    QSqlQuery query = getPreparedQuery("INSERT INTO Study (InstanceUID, PatientID, ID, PatientAge, PatientWeigth, PatientHeigth, Modalities, Date, Time, AccessionNumber, "
                                      "Description, ReferringPhysicianName, LastAccessDate, RetrievedDate, RetrievedTime , State) "
                   "VALUES (:instanceUID, :patientId, :id, :patientAge, :patientWeight, :patientHeight, :modalities, :date, :time, :accessionNumber, "
                           ":description, :referringPhysicianName, :lastAccessDate, :retrievedDate, :retrievedTime, :state)");
@@ -194,8 +217,7 @@ bool LocalDatabaseStudyDAL::insert(const Study *study, const QDate &lastAccessDa
 
 bool LocalDatabaseStudyDAL::update(const Study *study, const QDate &lastAccessDate)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("UPDATE Study SET ID = :id, PatientAge = :patientAge, PatientWeigth = :patientWeight, PatientHeigth = :patientHeight, "
+    QSqlQuery query = getPreparedQuery("UPDATE Study SET ID = :id, PatientAge = :patientAge, PatientWeigth = :patientWeight, PatientHeigth = :patientHeight, "
                                    "Modalities = :modalities, Date = :date, Time = :time, AccessionNumber = :accessionNumber, Description = :description, "
                                    "ReferringPhysicianName = :referringPhysicianName, LastAccessDate = :lastAccessDate, RetrievedDate = :retrievedDate, "
                                    "RetrievedTime = :retrievedTime, State = :state "
@@ -207,18 +229,15 @@ bool LocalDatabaseStudyDAL::update(const Study *study, const QDate &lastAccessDa
 // TODO We could pass just the StudyInstanceUID instead of a mask
 bool LocalDatabaseStudyDAL::del(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-
     if (mask.getStudyInstanceUID().isEmpty())
     {
-        query.prepare("DELETE FROM Study");
-    }
-    else
-    {
-        query.prepare("DELETE FROM Study WHERE InstanceUID = :instanceUID");
-        query.bindValue(":instanceUID", mask.getStudyInstanceUID());
+        QSqlQuery query = getPreparedQuery("DELETE FROM Study");
+        return executeQueryAndLogError(query);
     }
 
+    QSqlQuery query = getPreparedQuery("DELETE FROM Study WHERE InstanceUID = :instanceUID");
+    query.bindValue(":instanceUID", mask.getStudyInstanceUID());
+
     return executeQueryAndLogError(query);
 }
 
@@ -236,10 +255,34 @@ QList<Study*> LocalDatabaseStudyDAL::queryOrderByLastAccessDate(const DicomMask
 
 QList<Patient*> LocalDatabaseStudyDAL::queryPatientStudy(const DicomMask &mask, const QDate &accessedBefore, const QDate &accessedAfter)
 {
-    QSqlQuery query = getNewQuery();
-    prepareSelectFromStudyPatient(query, mask, accessedBefore, accessedAfter);
+    QSqlQuery query = prepareSelectFromStudyPatient(m_databaseConnection, mask, accessedBefore, accessedAfter);
+    QList<Patient*> patientList;
+
+    if (executeQueryAndLogError(query))
+    {
+        while (query.next())
+        {
+            Patient *patient = getPatient(query);
+            patient->addStudy(getStudy(query));
+            patientList.append(patient);
+        }
+    }
+
+    return patientList;
+}
+
+QList<Patient*> LocalDatabaseStudyDAL::queryPatientStudyPage(const DicomMask &mask, PatientStudyCursor &cursor, int pageSize, const QDate &accessedBefore,
+                                                            const QDate &accessedAfter)
+{
     QList<Patient*> patientList;
 
+    if (cursor.atEnd || pageSize <= 0)
+    {
+        return patientList;
+    }
+
+    QSqlQuery query = prepareSelectFromStudyPatient(m_databaseConnection, mask, accessedBefore, accessedAfter, &cursor, pageSize);
+
     if (executeQueryAndLogError(query))
     {
         while (query.next())
@@ -247,7 +290,11 @@ QList<Patient*> LocalDatabaseStudyDAL::queryPatientStudy(const DicomMask &mask,
             Patient *patient = getPatient(query);
             patient->addStudy(getStudy(query));
             patientList.append(patient);
+
+            cursor.lastStudyInstanceUID = query.value("InstanceUID").toString();
         }
+
+        cursor.atEnd = patientList.size() < pageSize;
     }
 
     return patientList;
@@ -255,16 +302,14 @@ QList<Patient*> LocalDatabaseStudyDAL::queryPatientStudy(const DicomMask &mask,
 
 bool LocalDatabaseStudyDAL::exists(const QString &studyInstanceUID)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("SELECT InstanceUID FROM Study WHERE InstanceUID = :instanceUID");
+    QSqlQuery query = getPreparedQuery("SELECT InstanceUID FROM Study WHERE InstanceUID = :instanceUID");
     query.bindValue(":instanceUID", studyInstanceUID);
     return executeQueryAndLogError(query) && query.next();
 }
 
 qlonglong LocalDatabaseStudyDAL::getPatientIDFromStudyInstanceUID(const QString &studyInstanceUID)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("SELECT PatientID FROM Study WHERE InstanceUID = :instanceUID");
+    QSqlQuery query = getPreparedQuery("SELECT PatientID FROM Study WHERE InstanceUID = :instanceUID");
     query.bindValue(":instanceUID", studyInstanceUID);
 
     if (executeQueryAndLogError(query) && query.next())
@@ -318,8 +363,7 @@ Patient* LocalDatabaseStudyDAL::getPatient(const QSqlQuery &query)
 
 QList<Study*> LocalDatabaseStudyDAL::query(const DicomMask &mask, const QDate &accessedBefore, const QDate &accessedAfter, const QString &orderBy)
 {
-    QSqlQuery query = getNewQuery();
-    prepareSelectFromStudy(query, mask, accessedBefore, accessedAfter, orderBy);
+    QSqlQuery query = prepareSelectFromStudy(m_databaseConnection, mask, accessedBefore, accessedAfter, orderBy);
     QList<Study*> studyList;
 
     if (executeQueryAndLogError(query))
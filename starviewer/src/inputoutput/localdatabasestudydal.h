@@ -31,6 +31,16 @@ class Study;
 class LocalDatabaseStudyDAL : public LocalDatabaseBaseDAL {
 
 public:
+    /// Position in the results of a paged query of patients and studies. A default-constructed cursor points to the first page.
+    struct PatientStudyCursor {
+        PatientStudyCursor() : atEnd(false) {}
+
+        /// Instance UID of the last returned study. Empty if no page has been returned yet.
+        QString lastStudyInstanceUID;
+        /// True when all the results have been returned.
+        bool atEnd;
+    };
+
     LocalDatabaseStudyDAL(DatabaseConnection &databaseConnection);
 
     /// Inserts to the database the given study and sets the given date as the last access date. Returns true if successful and false otherwise.
@@ -55,6 +65,12 @@ public:
     /// For each matching study a Patient object with one Study object will be returned, so there may be multiple Patient objects representing the same patient.
     QList<Patient*> queryPatientStudy(const DicomMask &mask, const QDate &accessedBefore = QDate(), const QDate &accessedAfter = QDate());
 
+    /// Like queryPatientStudy(), but returns at most \a pageSize results that follow the position of the given cursor, and moves the cursor past them.
+    /// Results are sorted by study instance UID, so consecutive pages never repeat a study nor skip one that exists during the whole paging, even if other
+    /// studies are inserted or deleted meanwhile, and each page is a range search on the study primary key regardless of how many pages have been returned.
+    QList<Patient*> queryPatientStudyPage(const DicomMask &mask, PatientStudyCursor &cursor, int pageSize, const QDate &accessedBefore = QDate(),
+                                          const QDate &accessedAfter = QDate());
+
     /// Returns true if there's a study with the given UID in the database, and false otherwise.
     bool exists(const QString &studyInstanceUID);
 
@@ -14,6 +14,7 @@
 
 #include "localdatabasevoilutdal.h"
 
+#include "databaseconnection.h"
 #include "dicommask.h"
 #include "image.h"
 
@@ -45,9 +46,11 @@ VoiLut getVoiLut(const QByteArray &byteArray)
     return voiLut;
 }
 
-// Prepares the given query with the given SQL base command followed by the appropriate where clause according to the given mask.
-void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString &sqlCommand)
+// Returns a query prepared with the given SQL base command followed by the appropriate where clause according to the given mask.
+QSqlQuery prepareQueryWithMask(DatabaseConnection &databaseConnection, const DicomMask &mask, const QString &sqlCommand)
 {
+    QSqlQuery query;
+
     if (!mask.getSOPInstanceUID().isEmpty())
     {
         QString where(" WHERE ImageInstanceUID = :imageInstanceUID");
@@ -56,7 +59,7 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
             where += " AND ImageFrameNumber = :imageFrameNumber";
         }
 
-        query.prepare(sqlCommand + where);
+        query = databaseConnection.getPreparedQuery(sqlCommand + where);
 
         query.bindValue(":imageInstanceUID", mask.getSOPInstanceUID());
         if (!mask.getImageNumber().isEmpty())
@@ -66,18 +69,22 @@ void prepareQueryWithMask(QSqlQuery &query, const DicomMask &mask, const QString
     }
     else if (!mask.getSeriesInstanceUID().isEmpty())
     {
-        query.prepare(sqlCommand + " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image WHERE SeriesInstanceUID = :seriesInstanceUID)");
+        query = databaseConnection.getPreparedQuery(sqlCommand + " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image "
+                                                                  "WHERE SeriesInstanceUID = :seriesInstanceUID)");
         query.bindValue(":seriesInstanceUID", mask.getSeriesInstanceUID());
     }
     else if (!mask.getStudyInstanceUID().isEmpty())
     {
-        query.prepare(sqlCommand + " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image WHERE StudyInstanceUID = :studyInstanceUID)");
+        query = databaseConnection.getPreparedQuery(sqlCommand + " WHERE ImageInstanceUID IN (SELECT SOPInstanceUID FROM Image "
+                                                                  "WHERE StudyInstanceUID = :studyInstanceUID)");
         query.bindValue(":studyInstanceUID", mask.getStudyInstanceUID());
     }
     else
     {
-        query.prepare(sqlCommand);
+        query = databaseConnection.getPreparedQuery(sqlCommand);
     }
+
+    return query;
 }
 
 }
@@ -89,8 +96,7 @@ LocalDatabaseVoiLutDAL::LocalDatabaseVoiLutDAL(DatabaseConnection &databaseConne
 
 bool LocalDatabaseVoiLutDAL::insert(const VoiLut &voiLut, const Image *image)
 {
-    QSqlQuery query = getNewQuery();
-    query.prepare("INSERT INTO VoiLut (Lut, ImageInstanceUID, ImageFrameNumber) VALUES (:lut, :imageInstanceUID, :imageFrameNumber)");
+    QSqlQuery query = getPreparedQuery("INSERT INTO VoiLut (Lut, ImageInstanceUID, ImageFrameNumber) VALUES (:lut, :imageInstanceUID, :imageFrameNumber)");
     QByteArray blob = getByteArray(voiLut);
     query.bindValue(":lut", blob);
     query.bindValue(":imageInstanceUID", image->getSOPInstanceUID());
@@ -100,15 +106,13 @@ bool LocalDatabaseVoiLutDAL::insert(const VoiLut &voiLut, const Image *image)
 
 bool LocalDatabaseVoiLutDAL::del(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "DELETE FROM VoiLut");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "DELETE FROM VoiLut");
     return executeQueryAndLogError(query);
 }
 
 QList<VoiLut> LocalDatabaseVoiLutDAL::query(const DicomMask &mask)
 {
-    QSqlQuery query = getNewQuery();
-    prepareQueryWithMask(query, mask, "SELECT Lut, ImageInstanceUID, ImageFrameNumber FROM VoiLut");
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT Lut, ImageInstanceUID, ImageFrameNumber FROM VoiLut");
     QList<VoiLut> voiLutList;
 
     if (executeQueryAndLogError(query))
@@ -122,4 +126,21 @@ QList<VoiLut> LocalDatabaseVoiLutDAL::query(const DicomMask &mask)
     return voiLutList;
 }
 
+QHash<QPair<QString, int>, QList<VoiLut> > LocalDatabaseVoiLutDAL::queryGroupedByImage(const DicomMask &mask)
+{
+    QSqlQuery query = prepareQueryWithMask(m_databaseConnection, mask, "SELECT Lut, ImageInstanceUID, ImageFrameNumber FROM VoiLut");
+    QHash<QPair<QString, int>, QList<VoiLut> > voiLutsByImage;
+
+    if (executeQueryAndLogError(query))
+    {
+        while (query.next())
+        {
+            QPair<QString, int> image(query.value("ImageInstanceUID").toString(), query.value("ImageFrameNumber").toInt());
+            voiLutsByImage[image].append(getVoiLut(query.value("Lut").toByteArray()));
+        }
+    }
+
+    return voiLutsByImage;
+}
+
 } // namespace udg
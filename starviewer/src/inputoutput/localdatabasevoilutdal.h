@@ -17,6 +17,9 @@
 
 #include "localdatabasebasedal.h"
 
+#include <QHash>
+#include <QPair>
+
 namespace udg {
 
 class DicomMask;
@@ -40,6 +43,10 @@ public:
     /// Retrieves from the database the VOI LUTs that match the given mask and returns them in a list.
     QList<VoiLut> query(const DicomMask &mask);
 
+    /// Retrieves from the database the VOI LUTs that match the given mask with a single query and returns them grouped by image,
+    /// using as key the SOP Instance UID and the frame number of the image.
+    QHash<QPair<QString, int>, QList<VoiLut> > queryGroupedByImage(const DicomMask &mask);
+
 };
 
 } // namespace udg
@@ -33,6 +33,14 @@
 
 namespace udg {
 
+namespace {
+
+// Nombre d'estudis que es consulten i s'afegeixen a la llista de cop. La primera pàgina es mostra de seguida i la resta s'hi afegeixen mentre l'aplicació
+// està inactiva, de manera que la interfície no es bloqueja encara que la base de dades tingui molts estudis
+const int StudiesQueryPageSize = 200;
+
+}
+
 QInputOutputLocalDatabaseWidget::QInputOutputLocalDatabaseWidget(QWidget *parent)
  : QWidget(parent)
 {
@@ -58,6 +66,9 @@ QInputOutputLocalDatabaseWidget::QInputOutputLocalDatabaseWidget(QWidget *parent
 
     m_qwidgetSelectPacsToStoreDicomImage = new QWidgetSelectPacsToStoreDicomImage();
 
+    m_nextStudiesPageTimer.setSingleShot(true);
+    m_nextStudiesPageTimer.setInterval(0);
+
     createConnections();
 
     // Esborrem els estudis vells de la cache.
@@ -87,6 +98,8 @@ void QInputOutputLocalDatabaseWidget::createConnections()
 
     connect(m_viewButton, SIGNAL(clicked()), SLOT(viewFromQStudyTreeWidget()));
 
+    connect(&m_nextStudiesPageTimer, SIGNAL(timeout()), SLOT(queryNextStudiesPage()));
+
     connect(m_seriesThumbnailPreviewWidget, SIGNAL(seriesThumbnailClicked(QString,QString)), this, SLOT(currentSeriesChangedOfQSeriesListWidget(QString, QString)));
     connect(m_seriesThumbnailPreviewWidget, SIGNAL(seriesThumbnailDoubleClicked(QString,QString)), SLOT(viewFromQSeriesListWidget(QString, QString)));
     connect(m_studyTreeWidget, SIGNAL(currentStudyChanged(Study*)), SLOT(setSeriesToSeriesListWidget(Study*)));
@@ -135,6 +148,7 @@ void QInputOutputLocalDatabaseWidget::setQCreateDicomdir(QCreateDicomdir *qcreat
 
 void QInputOutputLocalDatabaseWidget::clear()
 {
+    m_nextStudiesPageTimer.stop();
     m_studyTreeWidget->clear();
     m_seriesThumbnailPreviewWidget->clear();
 }
@@ -155,7 +169,9 @@ void QInputOutputLocalDatabaseWidget::queryStudy(DicomMask queryMask)
 
     clear();
 
-    patientStudyList = localDatabaseManager.queryPatientsAndStudies(queryMask);
+    m_studiesQueryMask = queryMask;
+    m_studiesQueryCursor = LocalDatabaseStudyDAL::PatientStudyCursor();
+    patientStudyList = localDatabaseManager.queryPatientsAndStudies(m_studiesQueryMask, m_studiesQueryCursor, StudiesQueryPageSize);
 
     if (showDatabaseManagerError(localDatabaseManager.getLastError()))
     {
@@ -176,9 +192,32 @@ void QInputOutputLocalDatabaseWidget::queryStudy(DicomMask queryMask)
     }
     else
     {
-        // Es mostra la llista d'estudis
+        // Es mostra la primera pàgina d'estudis, la resta s'afegiran a mesura que es consultin
         m_studyTreeWidget->insertPatientList(patientStudyList);
         QApplication::restoreOverrideCursor();
+
+        if (!m_studiesQueryCursor.atEnd)
+        {
+            m_nextStudiesPageTimer.start();
+        }
+    }
+}
+
+void QInputOutputLocalDatabaseWidget::queryNextStudiesPage()
+{
+    LocalDatabaseManager localDatabaseManager;
+    QList<Patient*> patientStudyList = localDatabaseManager.queryPatientsAndStudies(m_studiesQueryMask, m_studiesQueryCursor, StudiesQueryPageSize);
+
+    if (showDatabaseManagerError(localDatabaseManager.getLastError()))
+    {
+        return;
+    }
+
+    m_studyTreeWidget->appendPatientList(patientStudyList);
+
+    if (!m_studiesQueryCursor.atEnd)
+    {
+        m_nextStudiesPageTimer.start();
     }
 }
 
@@ -200,11 +239,23 @@ void QInputOutputLocalDatabaseWidget::addStudyToQStudyTreeWidget(QString studyUI
         m_studyTreeWidget->insertPatient(patientList.at(0));
         m_studyTreeWidget->sort();
     }
+
+    restartStudiesPaging();
 }
 
 void QInputOutputLocalDatabaseWidget::removeStudyFromQStudyTreeWidget(QString studyInstanceUID)
 {
     m_studyTreeWidget->removeStudy(studyInstanceUID);
+    restartStudiesPaging();
+}
+
+void QInputOutputLocalDatabaseWidget::restartStudiesPaging()
+{
+    // Entre pàgina i pàgina el timer està actiu. Els estudis que ja es mostren no es tornaran a afegir
+    if (m_nextStudiesPageTimer.isActive())
+    {
+        m_studiesQueryCursor = LocalDatabaseStudyDAL::PatientStudyCursor();
+    }
 }
 
 void QInputOutputLocalDatabaseWidget::requestedSeriesOfStudy(Study *study)
@@ -510,6 +561,7 @@ QList<Image*> QInputOutputLocalDatabaseWidget::getAllImagesFromPatient(Patient *
 void QInputOutputLocalDatabaseWidget::deleteOldStudiesThreadFinished()
 {
     showDatabaseManagerError(m_qdeleteOldStudiesThread.getLastError(), tr("deleting old studies"));
+    restartStudiesPaging();
 }
 
 void QInputOutputLocalDatabaseWidget::qSplitterPositionChanged()
@@ -25,6 +25,7 @@
 #include "pacsjob.h"
 
 #include <QMenu>
+#include <QTimer>
 
 // Fordward declarations
 class QString;
@@ -109,7 +110,14 @@ private:
     /// Retorna totes les imatges d'un pacient
     QList<Image*> getAllImagesFromPatient(Patient *patient);
 
+    /// S'ha de cridar quan s'insereixen o s'esborren estudis de la base de dades. Si encara s'estan afegint pàgines de la darrera cerca, es tornen a
+    /// consultar des del principi perquè la llista acabi reflectint la base de dades actual
+    void restartStudiesPaging();
+
 private slots:
+    /// Consulta la següent pàgina d'estudis de la darrera cerca i l'afegeix al QStudyTreeWidget
+    void queryNextStudiesPage();
+
     /// Mostra les sèries d'un estudi, les consulta al dicomdir i les mostra al tree widget
     void requestedSeriesOfStudy(Study *studyRequestedSeries);
 
@@ -159,6 +167,11 @@ private:
     StatsWatcher *m_statsWatcher;
     QWidgetSelectPacsToStoreDicomImage *m_qwidgetSelectPacsToStoreDicomImage;
     PacsManager *m_pacsManager;
+
+    /// Màscara i posició de la darrera cerca d'estudis, dels quals es van mostrant pàgines mentre l'aplicació està inactiva
+    DicomMask m_studiesQueryMask;
+    LocalDatabaseStudyDAL::PatientStudyCursor m_studiesQueryCursor;
+    QTimer m_nextStudiesPageTimer;
 };
 
 };// end namespace udg
@@ -17,6 +17,8 @@
 #include <QString>
 
 #include "series.h"
+#include "thumbnailcreator.h"
+#include "thumbnailservice.h"
 
 namespace udg {
 
@@ -38,18 +40,25 @@ void QSeriesThumbnailPreviewWidget::insertSeries(QString studyInstanceUID, Serie
     // Comprovem la posició que hem d'inserir la sèrie, si és un DICOM Non-Image (no és una imatge) val final, sinó va després de la última imatge inserida
     if (m_DICOMModalitiesNonImage.contains(series->getModality()))
     {
-        m_seriesThumbnailsPreviewWidget->append(series->getInstanceUID(), series->getThumbnail(), seriesThumbnailDescription);
+        m_seriesThumbnailsPreviewWidget->append(series->getInstanceUID(), getSeriesThumbnail(series), seriesThumbnailDescription);
     }
     else
     {
         // És una imatge
         m_positionOfLastInsertedThumbnail++;
-        m_seriesThumbnailsPreviewWidget->insert(m_positionOfLastInsertedThumbnail, series->getInstanceUID(), series->getThumbnail(), seriesThumbnailDescription);
+        m_seriesThumbnailsPreviewWidget->insert(m_positionOfLastInsertedThumbnail, series->getInstanceUID(), getSeriesThumbnail(series), seriesThumbnailDescription);
     }
 }
 
 void QSeriesThumbnailPreviewWidget::removeSeries(const QString &seriesInstanceUID)
 {
+    QString thumbnailKey = m_seriesInstanceUIDByPendingThumbnailKey.key(seriesInstanceUID);
+    if (!thumbnailKey.isEmpty())
+    {
+        ThumbnailService::instance()->cancelRequest(thumbnailKey);
+        m_seriesInstanceUIDByPendingThumbnailKey.remove(thumbnailKey);
+    }
+
     m_seriesThumbnailsPreviewWidget->remove(seriesInstanceUID);
 }
 
@@ -62,6 +71,14 @@ void QSeriesThumbnailPreviewWidget::clear()
 {
     m_seriesThumbnailsPreviewWidget->clear();
     m_studyInstanceUIDBySeriesInstanceUID.clear();
+
+    // Els thumbnails que no s'han començat a generar ja no cal generar-los
+    foreach (const QString &thumbnailKey, m_seriesInstanceUIDByPendingThumbnailKey.keys())
+    {
+        ThumbnailService::instance()->cancelRequest(thumbnailKey);
+    }
+    m_seriesInstanceUIDByPendingThumbnailKey.clear();
+
     // Indiquem que la última imatge insertada està a la posició 0 perquè hem un clear
     m_positionOfLastInsertedThumbnail = -1;
 }
@@ -70,6 +87,29 @@ void QSeriesThumbnailPreviewWidget::createConnections()
 {
     connect(m_seriesThumbnailsPreviewWidget, SIGNAL(thumbnailClicked(QString)), this, SLOT(seriesClicked(QString)));
     connect(m_seriesThumbnailsPreviewWidget, SIGNAL(thumbnailDoubleClicked(QString)), this, SLOT(seriesDoubleClicked(QString)));
+    connect(ThumbnailService::instance(), SIGNAL(thumbnailReady(QString, QImage)), this, SLOT(updateSeriesThumbnail(QString, QImage)));
+}
+
+QPixmap QSeriesThumbnailPreviewWidget::getSeriesThumbnail(Series *series)
+{
+    // Les sèries que es mostren tenen prioritat sobre els thumbnails que es generen per avançat
+    ThumbnailService *thumbnailService = ThumbnailService::instance();
+    QString thumbnailKey = thumbnailService->requestThumbnail(series, ThumbnailService::HighPriority);
+
+    if (thumbnailKey.isEmpty())
+    {
+        // El thumbnail de la sèrie és una icona, que es crea ràpidament
+        return series->getThumbnail();
+    }
+
+    QImage thumbnail;
+    if (!thumbnailService->getThumbnail(thumbnailKey, thumbnail))
+    {
+        m_seriesInstanceUIDByPendingThumbnailKey.insert(thumbnailKey, series->getInstanceUID());
+        thumbnail = ThumbnailCreator::makeEmptyThumbnailWithCustomText(tr("Loading..."));
+    }
+
+    return QPixmap::fromImage(thumbnail);
 }
 
 QString QSeriesThumbnailPreviewWidget::getSeriesThumbnailDescription(Series *series)
@@ -123,4 +163,12 @@ void QSeriesThumbnailPreviewWidget::seriesDoubleClicked(QString IDThumbnail)
     emit(seriesThumbnailDoubleClicked(m_studyInstanceUIDBySeriesInstanceUID[IDThumbnail], IDThumbnail));
 }
 
+void QSeriesThumbnailPreviewWidget::updateSeriesThumbnail(const QString &thumbnailKey, const QImage &thumbnail)
+{
+    if (m_seriesInstanceUIDByPendingThumbnailKey.contains(thumbnailKey))
+    {
+        m_seriesThumbnailsPreviewWidget->setThumbnail(m_seriesInstanceUIDByPendingThumbnailKey.take(thumbnailKey), QPixmap::fromImage(thumbnail));
+    }
+}
+
 }
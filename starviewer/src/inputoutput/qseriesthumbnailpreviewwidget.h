@@ -57,6 +57,10 @@ private:
     /// Retorna la descripció pel thumbnail de la sèrie
     QString getSeriesThumbnailDescription(Series *series);
 
+    /// Retorna el thumbnail de la sèrie. Si s'ha de generar a partir d'una imatge i encara no està disponible, en demana la generació en segon pla
+    /// i retorna un thumbnail provisional que se substituirà quan estigui llest
+    QPixmap getSeriesThumbnail(Series *series);
+
 private slots:
     /// Slot que s'activa quan s'ha fet click sobre un thumbnail
     void seriesClicked(QString IDThumbnail);
@@ -64,10 +68,16 @@ private slots:
     /// Slot que s'activa quan s'ha fet doble click sobre un thumbnail
     void seriesDoubleClicked(QString IDThumbnail);
 
+    /// Substitueix el thumbnail provisional de la sèrie a la que correspon el thumbnail generat
+    void updateSeriesThumbnail(const QString &thumbnailKey, const QImage &thumbnail);
+
 private:
     //Guardem per cada sèrie a quin estudi pertany
     QHash<QString, QString> m_studyInstanceUIDBySeriesInstanceUID;
 
+    //Sèries que esperen el seu thumbnail, per la clau del thumbnail al ThumbnailService
+    QHash<QString, QString> m_seriesInstanceUIDByPendingThumbnailKey;
+
     //Modalitats de sèries que no són images, com (KO, PR, SR)
     QStringList m_DICOMModalitiesNonImage;
     //Indica a quina ha estat la última fila que hem inseritat una sèrie que era una imatge
@@ -110,6 +110,31 @@ void QStudyTreeWidget::insertPatient(Patient *patient)
     }
 }
 
+void QStudyTreeWidget::appendPatientList(const QList<Patient*> &patientList)
+{
+    QList<QTreeWidgetItem*> items;
+
+    foreach (Patient *patient, patientList)
+    {
+        if (patient->getNumberOfStudies() == 0)
+        {
+            continue;
+        }
+
+        if (areAllStudiesInserted(patient))
+        {
+            delete patient;
+        }
+        else
+        {
+            items.append(fillPatient(patient));
+            m_addedPatients.append(patient);
+        }
+    }
+
+    m_studyTreeView->addTopLevelItems(items);
+}
+
 void QStudyTreeWidget::insertSeriesList(const QString &studyInstanceUID, QList<Series*> seriesList)
 {
     QTreeWidgetItem *studyItem = getStudyQTreeWidgetItem(studyInstanceUID, seriesList.at(0)->getDICOMSource());
@@ -167,9 +192,9 @@ void QStudyTreeWidget::removeStudy(const QString &studyInstanceUIDToRemove, cons
     if (studyItem)
     {
         delete studyItem;
+        m_studyTreeView->clearSelection();
     }
 
-    m_studyTreeView->clearSelection();
     //No esborrem l'estudi del HashTable ja s'esborrarà quan netegem la HashTable
 }
 
@@ -379,6 +404,19 @@ QTreeWidgetItem* QStudyTreeWidget::getStudyQTreeWidgetItem(const QString &studyU
     return NULL;
 }
 
+bool QStudyTreeWidget::areAllStudiesInserted(Patient *patient)
+{
+    foreach (Study *study, patient->getStudies())
+    {
+        if (!getStudyQTreeWidgetItem(study->getInstanceUID(), study->getDICOMSource()))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 QTreeWidgetItem* QStudyTreeWidget::getSeriesQTreeWidgetItem(const QString &studyInstanceUID, const QString &seriesInstanceUID, const DICOMSource &seriesDICOMSource)
 {
     QTreeWidgetItem *studyItem = getStudyQTreeWidgetItem(studyInstanceUID, seriesDICOMSource);
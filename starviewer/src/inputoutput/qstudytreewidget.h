@@ -69,6 +69,11 @@ public:
     /// Insereix el pacient al QStudyTreeWiget. Si el pacient amb aquell estudi ja existeix en sobreescriu la informació
     void insertPatient(Patient *patient);
 
+    /// Afegeix els pacients passats per paràmetre als que ja es mostren, com insertPatientList, però sense canviar la selecció ni el cursor.
+    /// Pensat per anar afegint els resultats d'una cerca per pàgines mentre l'usuari ja treballa amb els primers
+    /// Els pacients amb tots els estudis ja mostrats, per exemple perquè s'han afegit mentre es consultaven les pàgines, no s'afegeixen i s'esborren
+    void appendPatientList(const QList<Patient*> &patientList);
+
     /// Insereix un llista de sèries a l'estudi seleccionat actualment.
     void insertSeriesList(const QString &studyIstanceUID, QList<Series*> seriesList);
 
@@ -163,6 +168,9 @@ private:
     /// Retorna l'objecte QTreeWidgetItem que mostra a l'estudi que compleix els paràmetres passats
     QTreeWidgetItem* getStudyQTreeWidgetItem(const QString &studyUID, const DICOMSource &studyDICOMSource);
 
+    /// Retorna cert si tots els estudis del pacient ja es mostren
+    bool areAllStudiesInserted(Patient *patient);
+
     /// Retorna l'Objecte QTtreeWidgeItem que és de l'estudi i series
     QTreeWidgetItem* getSeriesQTreeWidgetItem(const QString &studyUID, const QString &seriesUID, const DICOMSource &seriesDICOMSource);
 
@@ -45,6 +45,9 @@ public:
     /// Treu el thumbnail de la previsualització.
     void remove(QString IDThumbnail);
 
+    /// Canvia la imatge del thumbnail amb l'ID passat, si hi és
+    void setThumbnail(QString IDThumbnail, const QPixmap &thumbnail);
+
     /// Selecciona el Thumbnail amb l'ID passat
     void setCurrentThumbnail(QString IDThumbnail);
 
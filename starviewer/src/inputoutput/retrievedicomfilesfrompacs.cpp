@@ -23,6 +23,7 @@
 #include <dcdeftag.h>
 
 #include <QDir>
+#include <QRunnable>
 #include <QString>
 
 #include "localdatabasemanager.h"
@@ -37,11 +38,39 @@ namespace udg {
 // Constant que contindrà quin Abanstract Syntax de Move utilitzem entre els diversos que hi ha utilitzem
 static const char *MoveAbstractSyntax = UID_MOVEStudyRootQueryRetrieveInformationModel;
 
+// Maximum number of received files waiting to be saved before the association stops reading from the network.
+static const int MaximumNumberOfPendingStores = 32;
+
+/**
+    Saves a received file in the store thread.
+  */
+class StoreRetrievedFileRunnable : public QRunnable {
+public:
+    StoreRetrievedFileRunnable(RetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS, DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath)
+        : m_retrieveDICOMFilesFromPACS(retrieveDICOMFilesFromPACS), m_fileRetrieved(fileRetrieved), m_dicomFileAbsolutePath(dicomFileAbsolutePath)
+    {
+    }
+
+    virtual void run()
+    {
+        m_retrieveDICOMFilesFromPACS->saveAndNotify(m_fileRetrieved, m_dicomFileAbsolutePath);
+    }
+
+private:
+    RetrieveDICOMFilesFromPACS *m_retrieveDICOMFilesFromPACS;
+    DcmFileFormat *m_fileRetrieved;
+    QString m_dicomFileAbsolutePath;
+};
+
 RetrieveDICOMFilesFromPACS::RetrieveDICOMFilesFromPACS(PacsDevice pacs)
- : DIMSECService()
+ : DIMSECService(), m_pendingStoresSemaphore(MaximumNumberOfPendingStores)
 {
     m_pacs = pacs;
     m_abortIsRequested = false;
+    m_numberOfImagesRetrieved = 0;
+    m_storeThreadPool.setMaxThreadCount(1);
+    // Keep the store thread alive between files
+    m_storeThreadPool.setExpiryTimeout(-1);
 
     this->setUpAsCMove();
 }
@@ -166,49 +195,40 @@ void RetrieveDICOMFilesFromPACS::storeSCPCallback(void *callbackData, T_DIMSE_St
             RetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS = storeSCPCallbackData->retrieveDICOMFilesFromPACS;
             QString dicomFileAbsolutePath = retrieveDICOMFilesFromPACS->getAbsoluteFilePathCompositeInstance(*imageDataSet, storeSCPCallbackData->fileName);
 
-            // Guardem la imatge
-            OFCondition stateSaveImage = retrieveDICOMFilesFromPACS->save(storeSCPCallbackData->dcmFileFormat, dicomFileAbsolutePath);
-
-            if (stateSaveImage.bad())
+            // If a previous file couldn't be saved, most likely the following ones won't either (e.g. the disk is full)
+            if (retrieveDICOMFilesFromPACS->m_numberOfFailedStores.load() > 0)
             {
                 storeResponse->DimseStatus = STATUS_STORE_Refused_OutOfResources;
-                DEBUG_LOG("No s'ha pogut guardar la imatge descarregada [" + dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
-                ERROR_LOG("No s'ha pogut guardar la imatge descarregada [" + dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
-                if (!QFile::remove(dicomFileAbsolutePath))
-                {
-                    DEBUG_LOG("Ha fallat el voler esborrar el fitxer " + dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
-                    ERROR_LOG("Ha fallat el voler esborrar el fitxer " + dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
-                }
+                ERROR_LOG("Es refusa la imatge [" + dicomFileAbsolutePath + "] perque no s'han pogut guardar imatges anteriors");
+                return;
             }
-            else
+
+            // Should really check the image to make sure it is consistent, that its
+            // sopClass and sopInstance correspond with those in the request.
+            if (storeResponse->DimseStatus == STATUS_Success)
             {
-                // Should really check the image to make sure it is consistent, that its
-                // sopClass and sopInstance correspond with those in the request.
-                if (storeResponse->DimseStatus == STATUS_Success)
+                // Which SOP class and SOP instance?
+                if (!DU_findSOPClassAndInstanceInDataSet(*imageDataSet, sopClass, sopInstance, correctUIDPadding))
                 {
-                    // Which SOP class and SOP instance?
-                    if (!DU_findSOPClassAndInstanceInDataSet(*imageDataSet, sopClass, sopInstance, correctUIDPadding))
-                    {
-                        storeResponse->DimseStatus = STATUS_STORE_Error_CannotUnderstand;
-                        ERROR_LOG(QString("No s'ha trobat la sop class i la sop instance per la imatge %1").arg(storeSCPCallbackData->fileName));
-                    }
-                    else if (strcmp(sopClass, storeRequest->AffectedSOPClassUID) != 0)
-                    {
-                        storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
-                        ERROR_LOG(QString("No concorda la sop class rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
-                    }
-                    else if (strcmp(sopInstance, storeRequest->AffectedSOPInstanceUID) != 0)
-                    {
-                        storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
-                        ERROR_LOG(QString("No concorda sop instance rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
-                    }
+                    storeResponse->DimseStatus = STATUS_STORE_Error_CannotUnderstand;
+                    ERROR_LOG(QString("No s'ha trobat la sop class i la sop instance per la imatge %1").arg(storeSCPCallbackData->fileName));
+                }
+                else if (strcmp(sopClass, storeRequest->AffectedSOPClassUID) != 0)
+                {
+                    storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
+                    ERROR_LOG(QString("No concorda la sop class rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
+                }
+                else if (strcmp(sopInstance, storeRequest->AffectedSOPInstanceUID) != 0)
+                {
+                    storeResponse->DimseStatus = STATUS_STORE_Error_DataSetDoesNotMatchSOPClass;
+                    ERROR_LOG(QString("No concorda sop instance rebuda amb la sol.licitada per la imatge %1").arg(storeSCPCallbackData->fileName));
                 }
-
-                // TODO:Té processar el fitxer si ha fallat alguna de les anteriors comprovacions ?
-                retrieveDICOMFilesFromPACS->m_numberOfImagesRetrieved++;
-                DICOMTagReader *dicomTagReader = new DICOMTagReader(dicomFileAbsolutePath, storeSCPCallbackData->dcmFileFormat->getAndRemoveDataset());
-                emit retrieveDICOMFilesFromPACS->DICOMFileRetrieved(dicomTagReader, retrieveDICOMFilesFromPACS->m_numberOfImagesRetrieved);
             }
+
+            // TODO:Té processar el fitxer si ha fallat alguna de les anteriors comprovacions ?
+            // The file is saved and processed in the store thread, so we can acknowledge it and receive the next one meanwhile
+            retrieveDICOMFilesFromPACS->enqueueStore(storeSCPCallbackData->dcmFileFormat, dicomFileAbsolutePath);
+            storeSCPCallbackData->dcmFileFormat = NULL;
         }
     }
 }
@@ -227,15 +247,62 @@ OFCondition RetrieveDICOMFilesFromPACS::save(DcmFileFormat *fileRetrieved, QStri
                                    filePadding, itemPadding, writeMode);
 }
 
+void RetrieveDICOMFilesFromPACS::enqueueStore(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath)
+{
+    m_pendingStoresSemaphore.acquire();
+    m_storeThreadPool.start(new StoreRetrievedFileRunnable(this, fileRetrieved, dicomFileAbsolutePath));
+}
+
+void RetrieveDICOMFilesFromPACS::saveAndNotify(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath)
+{
+    // Guardem la imatge
+    OFCondition stateSaveImage = save(fileRetrieved, dicomFileAbsolutePath);
+
+    if (stateSaveImage.bad())
+    {
+        m_numberOfFailedStores.ref();
+        DEBUG_LOG("No s'ha pogut guardar la imatge descarregada [" + dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
+        ERROR_LOG("No s'ha pogut guardar la imatge descarregada [" + dicomFileAbsolutePath + "], error: " + stateSaveImage.text());
+        if (!QFile::remove(dicomFileAbsolutePath))
+        {
+            DEBUG_LOG("Ha fallat el voler esborrar el fitxer " + dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
+            ERROR_LOG("Ha fallat el voler esborrar el fitxer " + dicomFileAbsolutePath + " que havia fallat prèviament al voler guardar-se.");
+        }
+    }
+    else
+    {
+        m_numberOfImagesRetrieved++;
+        DICOMTagReader *dicomTagReader = new DICOMTagReader(dicomFileAbsolutePath, fileRetrieved->getAndRemoveDataset());
+        emit DICOMFileRetrieved(dicomTagReader, m_numberOfImagesRetrieved);
+    }
+
+    delete fileRetrieved;
+    m_pendingStoresSemaphore.release();
+}
+
+PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACS::waitForPendingStores(PACSRequestStatus::RetrieveRequestStatus retrieveRequestStatus)
+{
+    m_storeThreadPool.waitForDone();
+
+    if (retrieveRequestStatus == PACSRequestStatus::RetrieveOk && m_numberOfFailedStores.load() > 0)
+    {
+        // The files were acknowledged before being saved, so the PACS can't know that some of them failed
+        return PACSRequestStatus::RetrieveSomeDICOMFilesFailed;
+    }
+
+    return retrieveRequestStatus;
+}
+
 OFCondition RetrieveDICOMFilesFromPACS::storeSCP(T_ASC_Association *association, T_DIMSE_Message *msg, T_ASC_PresentationContextID presentationContextID)
 {
     T_DIMSE_C_StoreRQ *storeRequest = &msg->msg.CStoreRQ;
     OFBool useMetaheader = OFTrue;
     StoreSCPCallbackData storeSCPCallbackData;
-    DcmFileFormat retrievedFile;
-    DcmDataset *retrievedDataset = retrievedFile.getDataset();
+    // Allocated in the heap because its ownership is transferred to the store thread once it has been completely received
+    DcmFileFormat *retrievedFile = new DcmFileFormat();
+    DcmDataset *retrievedDataset = retrievedFile->getDataset();
 
-    storeSCPCallbackData.dcmFileFormat = &retrievedFile;
+    storeSCPCallbackData.dcmFileFormat = retrievedFile;
     storeSCPCallbackData.retrieveDICOMFilesFromPACS = this;
     storeSCPCallbackData.fileName = storeRequest->AffectedSOPInstanceUID;
 
@@ -249,6 +316,9 @@ OFCondition RetrieveDICOMFilesFromPACS::storeSCP(T_ASC_Association *association,
         unlink(qPrintable(storeSCPCallbackData.fileName));
     }
 
+    // If it hasn't been handed to the store thread, it's still ours
+    delete storeSCPCallbackData.dcmFileFormat;
+
     return condition;
 }
 
@@ -370,6 +440,7 @@ PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACS::retrieve(co
     MoveSCPCallbackData moveSCPCallbackData;
     DcmDataset *dcmDatasetToRetrieve = getDcmDatasetOfImagesToRetrieve(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
     m_numberOfImagesRetrieved = 0;
+    m_numberOfFailedStores.store(0);
 
     // TODO S'hauria de comprovar que es tracti d'un PACS amb el servei de retrieve configurat
     if (!m_pacsConnection->connectToPACS(PACSConnection::RetrieveDICOMFiles))
@@ -407,9 +478,10 @@ PACSRequestStatus::RetrieveRequestStatus RetrieveDICOMFilesFromPACS::retrieve(co
 
     m_pacsConnection->disconnect();
 
-    retrieveRequestStatus = getDIMSEStatusCodeAsRetrieveRequestStatus(moveResponse.DimseStatus);
+    // Wait until all the received files have been saved and notified
+    retrieveRequestStatus = waitForPendingStores(getDIMSEStatusCodeAsRetrieveRequestStatus(moveResponse.DimseStatus));
     processServiceClassProviderResponseStatus(moveResponse.DimseStatus, statusDetail);
-    
+
     // Dump status detail information if there is some
     if (statusDetail != NULL)
     {
@@ -15,7 +15,10 @@
 #ifndef RETRIEVEDICOMFILESFROMPACS_H
 #define RETRIEVEDICOMFILESFROMPACS_H
 
+#include <QAtomicInt>
 #include <QObject>
+#include <QSemaphore>
+#include <QThreadPool>
 #include <ofcond.h>
 #include <assoc.h>
 
@@ -60,8 +63,25 @@ public:
 
 signals:
     /// Signal que indica que s'ha descarregat un fitxer
+    /// It's emitted from the store thread, not from the thread that called retrieve(), once the file has been saved. The files are notified in the order
+    /// they are received and all of them have been notified when retrieve() returns. Receivers connected with Qt::DirectConnection run in the store
+    /// thread and delay the saving of the following files; receivers with queued connections get the DICOMTagReader when the store thread may have
+    /// already moved on, which is fine because the receiver takes its ownership.
     void DICOMFileRetrieved(DICOMTagReader *dicomTagReader, int numberOfImagesRetrieved);
 
+protected:
+    /// Guarda una composite instance descarregada
+    /// It's executed in the store thread.
+    virtual OFCondition save(DcmFileFormat *fileRetrieved, QString dicomFileAbsolutePath);
+
+    /// Hands the received file to the store thread, which saves it and notifies it with DICOMFileRetrieved. Takes ownership of the file.
+    /// Blocks while there are MaximumNumberOfPendingStores files waiting to be saved.
+    void enqueueStore(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath);
+
+    /// Waits until all the files handed to the store thread have been saved and notified, and returns the given retrieve status taking into account the
+    /// files that couldn't be saved: as they were acknowledged before being saved, a RetrieveOk from the PACS becomes RetrieveSomeDICOMFilesFailed.
+    PACSRequestStatus::RetrieveRequestStatus waitForPendingStores(PACSRequestStatus::RetrieveRequestStatus retrieveRequestStatus);
+
 private:
     /// En aquesta funció acceptem la connexió que se'ns sol·licita per transmetre'ns imatges, i indiquem quins transfer syntax suportem
     OFCondition acceptSubAssociation(T_ASC_Network *associationNetwork, T_ASC_Association **association);
@@ -75,8 +95,8 @@ private:
     /// Accepta la connexió que ens fa el PACS, per convertir-nos en un scp
     OFCondition subOperationSCP(T_ASC_Association **subAssociation);
 
-    /// Guarda una composite instance descarregada
-    OFCondition save(DcmFileFormat *fileRetrieved, QString dicomFileAbsolutePath);
+    /// Saves the received file and notifies it. It's executed in the store thread. Takes ownership of the file.
+    void saveAndNotify(DcmFileFormat *fileRetrieved, const QString &dicomFileAbsolutePath);
 
     /// Retorna el nom del fitxer amb que s'ha de guardar l'objecte descarregat, composa el path on s'ha de guardar més el nom del fitxer.
     /// Si el path on s'ha de guardar la imatge no existeix, el crea
@@ -102,6 +122,8 @@ private:
     static void subOperationCallback(void *subOperationCallbackData, T_ASC_Network *associationNetwork, T_ASC_Association **subAssociation);
 
 private:
+    friend class StoreRetrievedFileRunnable;
+
     struct StoreSCPCallbackData
     {
         DcmFileFormat *dcmFileFormat;
@@ -124,6 +146,16 @@ private:
 
     bool m_abortIsRequested;
 
+    /// Thread where the received files are saved and notified, so that the association keeps receiving while they are written to disk.
+    /// It has only one thread to keep the order of the notifications.
+    QThreadPool m_storeThreadPool;
+
+    /// Limits the number of received files waiting to be saved, to bound the memory used when the disk is slower than the network.
+    QSemaphore m_pendingStoresSemaphore;
+
+    /// Number of received files that couldn't be saved. Once one fails, the following ones are refused.
+    QAtomicInt m_numberOfFailedStores;
+
 };
 
 };
@@ -105,6 +105,8 @@ void RetrieveDICOMFilesFromPACSJob::run(ThreadWeaver::JobPointer self, ThreadWea
 
         // S'ha d'especificar com a DirectConnection, perquè sinó aquest signal l'aten qui ha creat el Job, que és la interfície, per tant
         // no s'atendria fins que la interfície estigui lliure, provocant comportaments incorrectes
+        // The slot runs in the store thread of m_retrieveDICOMFilesFromPACS, which is the only one that touches m_retrievedSeriesInstanceUIDSet until
+        // retrieve() returns
         connect(m_retrieveDICOMFilesFromPACS, SIGNAL(DICOMFileRetrieved(DICOMTagReader*, int)), this, SLOT(DICOMFileRetrieved(DICOMTagReader*, int)),
                 Qt::DirectConnection);
         // Connectem amb els signals del patientFiller per processar els fitxers descarregats
@@ -85,6 +85,7 @@ signals:
 
 private slots:
     /// Slot que s'activa quan s'ha descarregat una imatge, respn al signal DICOMFileRetrieved de RetrieveDICOMFilesFromPACS
+    /// It runs in the store thread of RetrieveDICOMFilesFromPACS, so the signals it emits are queued to the interface and to the fillers thread.
     void DICOMFileRetrieved(DICOMTagReader *dicomTagReader, int numberOfImagesRetrieved);
 
 private:
@@ -34,6 +34,7 @@
 #include "patientcomparer.h"
 #include "patient.h"
 #include "image.h"
+#include "thumbnailservice.h"
 
 // PACS --------------------------------------------
 #include "queryscreen.h"
@@ -432,7 +433,8 @@ void ExtensionHandler::generatePatientVolumes(Patient *patient, const QString &d
                 volume->setImages(imageList);
                 volume->setNumberOfPhases(numberOfPhases);
                 volume->setNumberOfSlicesPerPhase(numberOfSlicesPerPhase);
-                volume->setThumbnail(imageList.at(imageList.count() / 2)->getThumbnail(true));
+                // El thumbnail es genera en segon pla perquè el tingui el menú de pacient quan es desplegui
+                ThumbnailService::instance()->requestThumbnail(imageList.at(imageList.count() / 2), ThumbnailService::LowPriority);
                 series->addVolume(volume);
             }
         }
@@ -12,7 +12,7 @@ CREATE TABLE DatabaseRevision
 -- IMPORTANT!!! Cal canviar el número de revisió per un de superior cada vegada que es faci un canvi a aquest fitxer i calgui
 -- que la BD s'actualitzi
 
-INSERT INTO DatabaseRevision (Revision) VALUES ('9593');
+INSERT INTO DatabaseRevision (Revision) VALUES ('9594');
 
 CREATE TABLE PACSRetrievedImages
 (
@@ -33,6 +33,8 @@ CREATE TABLE Patient
   Sex                           TEXT
 );
 
+CREATE INDEX IndexPatient_DICOMPatientId ON Patient (DICOMPatientId);
+
 
 CREATE TABLE Study
 (
@@ -54,6 +56,9 @@ CREATE TABLE Study
   State                         INTEGER
 );
 
+CREATE INDEX IndexStudy_Date ON Study (Date);
+CREATE INDEX IndexStudy_LastAccessDate ON Study (LastAccessDate);
+
 CREATE TABLE Series
 (
   InstanceUID                   TEXT PRIMARY KEY,
@@ -136,6 +141,8 @@ CREATE TABLE DisplayShutter
 --TODO:Comprovar si s'utilitzarà l'index IndexImage_StudyInstanceUIDSeriesInstanceUID després dels canvis fets a la BD
 CREATE INDEX  IndexImage_StudyInstanceUIDSeriesInstanceUID ON Image (StudyInstanceUID,SeriesInstanceUID); 
 CREATE INDEX  IndexImage_SOPInstanceUIDOrderNumberInVolume ON Image (SOPInstanceUID, OrderNumberInVolume); 
+CREATE INDEX IndexImage_SeriesInstanceUIDVolumeNumberInSeriesOrderNumberInVolume ON Image (SeriesInstanceUID, VolumeNumberInSeries, OrderNumberInVolume);
+CREATE INDEX IndexDisplayShutter_ImageInstanceUIDImageFrameNumber ON DisplayShutter (ImageInstanceUID, ImageFrameNumber);
 
 CREATE TABLE VoiLut
 (
@@ -146,6 +153,8 @@ CREATE TABLE VoiLut
     FOREIGN KEY (ImageInstanceUID, ImageFrameNumber) REFERENCES Image (SOPInstanceUID, FrameNumber)
 );
 
+CREATE INDEX IndexVoiLut_ImageInstanceUIDImageFrameNumber ON VoiLut (ImageInstanceUID, ImageFrameNumber);
+
 CREATE TABLE EncapsulatedDocument
 (
     SOPInstanceUID                  TEXT PRIMARY KEY,
@@ -157,3 +166,5 @@ CREATE TABLE EncapsulatedDocument
     StudyInstanceUID                TEXT,
     SeriesInstanceUID               TEXT
 );
+
+CREATE INDEX IndexEncapsulatedDocument_StudyInstanceUIDSeriesInstanceUID ON EncapsulatedDocument (StudyInstanceUID, SeriesInstanceUID);
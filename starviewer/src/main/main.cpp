@@ -30,9 +30,12 @@ INITIALIZE_EASYLOGGINGPP
 #include "applicationtranslationsloader.h"
 
 #include "coresettings.h"
+#include "decodedvolumecache.h"
 #include "inputoutputsettings.h"
 #include "interfacesettings.h"
+#include "localdatabasemanager.h"
 #include "shortcuts.h"
+#include "thumbnailservice.h"
 #include "starviewerapplicationcommandline.h"
 #include "applicationcommandlineoptions.h"
 #include "loggingoutputwindow.h"
@@ -192,6 +195,11 @@ int main(int argc, char *argv[])
     interfaceSettings.init();
     shortcuts.init();
 
+    // Only the series of the local database can keep a decoded copy of their volumes
+    udg::DecodedVolumeCache::setCacheableDirectory(udg::LocalDatabaseManager::getCachePath());
+    // and save the thumbnails created for them
+    udg::ThumbnailService::instance()->setPersistentCacheDirectory(udg::LocalDatabaseManager::getCachePath());
+
     initQtPluginsDirectory();
     initializeTranslations(app);
 
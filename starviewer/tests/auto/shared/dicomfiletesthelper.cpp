@@ -0,0 +1,119 @@
+#include "dicomfiletesthelper.h"
+
+#include <QDir>
+#include <QVector>
+
+#include <dcdatset.h>
+#include <dcdeftag.h>
+#include <dcfilefo.h>
+
+namespace testing {
+
+bool DICOMFileTestHelper::createCTImage(const QString &filename, const QString &seriesInstanceUID, int instanceNumber, double slicePosition,
+                                        int size)
+{
+    DcmFileFormat fileFormat;
+    DcmDataset *dataset = fileFormat.getDataset();
+
+    dataset->putAndInsertString(DCM_SOPClassUID, "1.2.840.10008.5.1.4.1.1.2");
+    dataset->putAndInsertString(DCM_SOPInstanceUID, qPrintable(QString("%1.%2").arg(seriesInstanceUID).arg(instanceNumber)));
+    dataset->putAndInsertString(DCM_StudyInstanceUID, "1.2.3.4.5");
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, qPrintable(seriesInstanceUID));
+    dataset->putAndInsertString(DCM_PatientName, "JOHN^DOE");
+    dataset->putAndInsertString(DCM_PatientID, "12345");
+    dataset->putAndInsertString(DCM_Modality, "CT");
+    dataset->putAndInsertString(DCM_InstanceNumber, qPrintable(QString::number(instanceNumber)));
+    dataset->putAndInsertString(DCM_ImageComments, qPrintable(getLongComment()));
+    dataset->putAndInsertString(DCM_ImagePositionPatient, qPrintable(QString("0\\0\\%1").arg(slicePosition)));
+    dataset->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+    dataset->putAndInsertString(DCM_PixelSpacing, "0.5\\0.5");
+    dataset->putAndInsertString(DCM_SliceThickness, "1");
+    dataset->putAndInsertString(DCM_RescaleIntercept, "-1024");
+    dataset->putAndInsertString(DCM_RescaleSlope, "1");
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+    dataset->putAndInsertUint16(DCM_Rows, size);
+    dataset->putAndInsertUint16(DCM_Columns, size);
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset->putAndInsertUint16(DCM_BitsStored, 12);
+    dataset->putAndInsertUint16(DCM_HighBit, 11);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+
+    dataset->putAndInsertUint16(DCM_OverlayRows, size);
+    dataset->putAndInsertUint16(DCM_OverlayColumns, size);
+    dataset->putAndInsertString(DCM_OverlayType, "G");
+    dataset->putAndInsertUint16(DCM_OverlayBitsAllocated, 1);
+    dataset->putAndInsertUint16(DCM_OverlayBitPosition, 0);
+    QVector<Uint8> overlay(size * size / 8, 0x0F);
+    dataset->putAndInsertUint8Array(DCM_OverlayData, overlay.constData(), overlay.size());
+
+    QVector<Uint16> pixels(size * size);
+    for (int i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = (i + instanceNumber) % 4096;
+    }
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.constData(), pixels.size());
+
+    return fileFormat.saveFile(qPrintable(filename), EXS_LittleEndianExplicit).good();
+}
+
+QStringList DICOMFileTestHelper::createCTSeries(const QString &directory, const QString &seriesInstanceUID, int numberOfImages, int size)
+{
+    QStringList files;
+
+    for (int i = 1; i <= numberOfImages; i++)
+    {
+        QString filename = QDir(directory).filePath(QString("%1_%2.dcm").arg(seriesInstanceUID).arg(i));
+
+        if (!createCTImage(filename, seriesInstanceUID, i, i, size))
+        {
+            return QStringList();
+        }
+
+        files << filename;
+    }
+
+    return files;
+}
+
+bool DICOMFileTestHelper::createMultiframeImage(const QString &filename, int numberOfFrames, int size)
+{
+    DcmFileFormat fileFormat;
+    DcmDataset *dataset = fileFormat.getDataset();
+
+    dataset->putAndInsertString(DCM_SOPClassUID, "1.2.840.10008.5.1.4.1.1.7");
+    dataset->putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5.8.1");
+    dataset->putAndInsertString(DCM_StudyInstanceUID, "1.2.3.4.5");
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, "1.2.3.4.5.8");
+    dataset->putAndInsertString(DCM_PatientName, "JOHN^DOE");
+    dataset->putAndInsertString(DCM_PatientID, "12345");
+    dataset->putAndInsertString(DCM_Modality, "OT");
+    dataset->putAndInsertString(DCM_NumberOfFrames, qPrintable(QString::number(numberOfFrames)));
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+    dataset->putAndInsertUint16(DCM_Rows, size);
+    dataset->putAndInsertUint16(DCM_Columns, size);
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset->putAndInsertUint16(DCM_BitsStored, 12);
+    dataset->putAndInsertUint16(DCM_HighBit, 11);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+
+    QVector<Uint16> pixels(numberOfFrames * size * size);
+    for (int frame = 0; frame < numberOfFrames; frame++)
+    {
+        for (int i = 0; i < size * size; i++)
+        {
+            pixels[frame * size * size + i] = (i + frame) % 4096;
+        }
+    }
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.constData(), pixels.size());
+
+    return fileFormat.saveFile(qPrintable(filename), EXS_LittleEndianExplicit).good();
+}
+
+QString DICOMFileTestHelper::getLongComment()
+{
+    return QString("Long comment ").repeated(50).trimmed();
+}
+
+}
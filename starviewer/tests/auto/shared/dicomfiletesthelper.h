@@ -0,0 +1,36 @@
+#ifndef DICOMFILETESTHELPER_H
+#define DICOMFILETESTHELPER_H
+
+#include <QStringList>
+
+namespace testing {
+
+/**
+ * @brief The DICOMFileTestHelper class writes synthetic DICOM files to disk for testing.
+ *
+ * The images are axial CT slices of a single patient and study with 16-bit pixel data, an overlay and a long comment, so that they have
+ * small and big values as the files imported from a PACS.
+ */
+class DICOMFileTestHelper
+{
+public:
+    /// Writes a CT image of size x size pixels of the given series, with the given instance number and slice position along the z axis.
+    /// Returns true if the file could be written.
+    static bool createCTImage(const QString &filename, const QString &seriesInstanceUID, int instanceNumber, double slicePosition, int size);
+
+    /// Writes a series of numberOfImages CT images of size x size pixels in the given directory and returns the paths of the written files
+    /// in the order of their instance numbers, which start at 1. Slice i is placed at z = i. Returns an empty list if a file could not be
+    /// written.
+    static QStringList createCTSeries(const QString &directory, const QString &seriesInstanceUID, int numberOfImages, int size);
+
+    /// Writes a multiframe secondary capture image with the given number of frames of size x size pixels. Pixel i of frame f has the value
+    /// (i + f) % 4096. Returns true if the file could be written.
+    static bool createMultiframeImage(const QString &filename, int numberOfFrames, int size);
+
+    /// Returns the value of the Image Comments of the written images.
+    static QString getLongComment();
+};
+
+}
+
+#endif // DICOMFILETESTHELPER_H
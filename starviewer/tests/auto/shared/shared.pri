@@ -24,7 +24,9 @@ SOURCES += $$PWD/pacsdevicetesthelper.cpp \
            $$PWD/testingsettings.cpp \
            $$PWD/testingmammographyimagehelper.cpp \
            $$PWD/testingdecaycorrectionfactorformulacalculator.cpp \
-           $$PWD/databasetesthelper.cpp
+           $$PWD/databasetesthelper.cpp \
+           $$PWD/dicomfiletesthelper.cpp \
+           $$PWD/voxelshadertesthelper.cpp
            
 HEADERS += $$PWD/autotest.h \
            $$PWD/pacsdevicetesthelper.h \
@@ -52,4 +54,6 @@ HEADERS += $$PWD/autotest.h \
            $$PWD/testingsettings.h \
            $$PWD/testingmammographyimagehelper.h \
            $$PWD/testingdecaycorrectionfactorformulacalculator.h \
-           $$PWD/databasetesthelper.h
+           $$PWD/databasetesthelper.h \
+           $$PWD/dicomfiletesthelper.h \
+           $$PWD/voxelshadertesthelper.h
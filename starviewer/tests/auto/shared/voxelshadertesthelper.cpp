@@ -0,0 +1,45 @@
+#include "voxelshadertesthelper.h"
+
+#include <vtkVolumeRayCastFunction.h>
+
+namespace testing {
+
+QVector<float> VoxelShaderTestHelper::castFrame(vtkVolumeRayCastFunction *function, int size, bool interpolation)
+{
+    vtkVolumeRayCastStaticInfo staticInfo = vtkVolumeRayCastStaticInfo();
+    staticInfo.InterpolationType = interpolation ? VTK_LINEAR_INTERPOLATION : VTK_NEAREST_INTERPOLATION;
+    staticInfo.DataIncrement[0] = 1;
+    staticInfo.DataIncrement[1] = size;
+    staticInfo.DataIncrement[2] = size * size;
+
+    vtkVolumeRayCastDynamicInfo dynamicInfo = vtkVolumeRayCastDynamicInfo();
+    dynamicInfo.TransformedIncrement[0] = 0.0f;
+    dynamicInfo.TransformedIncrement[1] = 0.0f;
+    dynamicInfo.TransformedIncrement[2] = 0.5f;
+    dynamicInfo.TransformedDirection[0] = 0.0f;
+    dynamicInfo.TransformedDirection[1] = 0.0f;
+    dynamicInfo.TransformedDirection[2] = 1.0f;
+    // Every sample and its 8 neighbours are inside the volume
+    dynamicInfo.NumberOfStepsToTake = 2 * (size - 2);
+
+    QVector<float> colors;
+    colors.reserve(4 * (size - 1) * (size - 1));
+
+    for (int y = 0; y < size - 1; y++)
+    {
+        for (int x = 0; x < size - 1; x++)
+        {
+            dynamicInfo.TransformedStart[0] = x + 0.3f;
+            dynamicInfo.TransformedStart[1] = y + 0.6f;
+            dynamicInfo.TransformedStart[2] = 0.0f;
+
+            function->CastRay(&dynamicInfo, &staticInfo);
+
+            colors << dynamicInfo.Color[0] << dynamicInfo.Color[1] << dynamicInfo.Color[2] << dynamicInfo.Color[3];
+        }
+    }
+
+    return colors;
+}
+
+}
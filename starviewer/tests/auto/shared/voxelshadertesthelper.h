@@ -0,0 +1,20 @@
+#ifndef VOXELSHADERTESTHELPER_H
+#define VOXELSHADERTESTHELPER_H
+
+#include <QVector>
+
+class vtkVolumeRayCastFunction;
+
+namespace testing {
+
+/// Functions to test voxel shaders through volume ray cast functions.
+class VoxelShaderTestHelper {
+public:
+    /// Casts one ray per voxel column of a volume of size³ voxels along the z axis, as in an orthographic frame, and returns the RGBA colors of the
+    /// rays. Rays go between voxel centers so that linear interpolation weights are not trivial.
+    static QVector<float> castFrame(vtkVolumeRayCastFunction *function, int size, bool interpolation);
+};
+
+}
+
+#endif // VOXELSHADERTESTHELPER_H
@@ -45,8 +45,10 @@ SOURCES += $$PWD/test_image.cpp \
            $$PWD/test_studylayoutconfigsettingsconverter.cpp \
            $$PWD/test_optimalviewersgridestimator.cpp \
            $$PWD/test_vtkimagedatacreator.cpp \
+           $$PWD/test_vtkimagemaptowindowlevelcolors3.cpp \
            $$PWD/test_pixelspacing2d.cpp \
            $$PWD/test_imagefillerstep.cpp \
+           $$PWD/test_orderimagesfillerstep.cpp \
            $$PWD/test_temporaldimensionfillerstep.cpp \
            $$PWD/test_computezspacingpostprocessor.cpp \
            $$PWD/test_pixelspacingamenderpostprocessor.cpp \
@@ -67,6 +69,12 @@ SOURCES += $$PWD/test_image.cpp \
            $$PWD/test_filteroutput.cpp \
            $$PWD/test_orthogonalplane.cpp \
            $$PWD/test_slicehandler.cpp \
+           $$PWD/test_slicepositionindex.cpp \
+           $$PWD/test_regiongrower.cpp \
+           $$PWD/test_obscurancemainthread.cpp \
+           $$PWD/test_voxelshaderchain.cpp \
+           $$PWD/test_thumbnailcreator.cpp \
+           $$PWD/test_thumbnailservice.cpp \
            $$PWD/test_voxel.cpp \
            $$PWD/test_roidata.cpp \
            $$PWD/test_mammographyimagehelper.cpp \
@@ -87,7 +95,13 @@ SOURCES += $$PWD/test_image.cpp \
            $$PWD/test_hangingprotocolimagesetrestrictionexpression.cpp \
            $$PWD/test_volumefillerstep.cpp \
            $$PWD/test_patientfillerinput.cpp \
-           $$PWD/test_externalapplication.cpp
+           $$PWD/test_patientfiller.cpp \
+           $$PWD/test_externalapplication.cpp \
+           $$PWD/test_vtkprojectionimagefilter.cpp \
+           $$PWD/test_vtkdcmtkimagereader.cpp \
+           $$PWD/test_volumerepository.cpp \
+           $$PWD/test_decodedvolumecache.cpp \
+           $$PWD/test_recentlyusedslices.cpp
 
 win32 {
     SOURCES += $$PWD/test_windowsfirewallaccess.cpp \
@@ -0,0 +1,301 @@
+#include "autotest.h"
+#include "decodedvolumecache.h"
+
+#include "coresettings.h"
+#include "settings.h"
+#include "volumepixeldata.h"
+
+#include <QDir>
+#include <QFile>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <cstring>
+
+using namespace udg;
+
+class test_DecodedVolumeCache : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void cleanupTestCase();
+
+    void store_ShouldStoreVolumeThatIsLoadedBack();
+
+    void constructor_ShouldGiveDifferentFileWhenFilesChange();
+
+    void invalidate_ShouldRemoveCachedVolumes();
+
+    void invalidate_ShouldRemoveCachedVolumesThatAreLoaded();
+
+    void store_ShouldReplaceCachedVolumeThatIsLoaded();
+
+    void store_ShouldNotStoreAfterInvalidate();
+
+    void isCacheable_ShouldReturnFalseForNotCacheableFiles();
+
+private:
+    /// Writes the given number of files in the series directory and returns their paths.
+    QStringList createFiles(const QString &directory, int numberOfFiles);
+    /// Returns an image data with a recognizable content.
+    static vtkSmartPointer<vtkImageData> createImageData();
+
+private:
+    QScopedPointer<QTemporaryDir> m_cacheableDirectory;
+    QString m_seriesDirectory;
+};
+
+void test_DecodedVolumeCache::initTestCase()
+{
+    Settings().setValue(CoreSettings::EnableDecodedVolumeCache, true);
+}
+
+void test_DecodedVolumeCache::init()
+{
+    m_cacheableDirectory.reset(new QTemporaryDir());
+    QVERIFY(m_cacheableDirectory->isValid());
+    DecodedVolumeCache::setCacheableDirectory(m_cacheableDirectory->path());
+
+    m_seriesDirectory = m_cacheableDirectory->path() + "/1.2.3/1.2.3.4";
+    QVERIFY(QDir().mkpath(m_seriesDirectory));
+}
+
+void test_DecodedVolumeCache::cleanup()
+{
+    DecodedVolumeCache::setCacheableDirectory(QString());
+    m_cacheableDirectory.reset();
+}
+
+void test_DecodedVolumeCache::cleanupTestCase()
+{
+    Settings().remove(CoreSettings::EnableDecodedVolumeCache);
+}
+
+void test_DecodedVolumeCache::store_ShouldStoreVolumeThatIsLoadedBack()
+{
+    QStringList files = createFiles(m_seriesDirectory, 3);
+    vtkSmartPointer<vtkImageData> imageData = createImageData();
+
+    DecodedVolumeCache cache("1.2.3.4", files, QList<int>());
+    QVERIFY(cache.isCacheable());
+    QVERIFY(cache.getCacheFilePath().startsWith(m_seriesDirectory + "/"));
+    QVERIFY(!cache.load());
+
+    QVERIFY(cache.store(imageData));
+    QVERIFY(QFile::exists(cache.getCacheFilePath()));
+
+    // A new cache object for the same files finds the stored volume
+    QScopedPointer<VolumePixelData> pixelData(DecodedVolumeCache("1.2.3.4", files, QList<int>()).load());
+    QVERIFY(pixelData);
+
+    int expectedExtent[6], extent[6];
+    imageData->GetExtent(expectedExtent);
+    pixelData->getExtent(extent);
+    double spacing[3], origin[3];
+    pixelData->getSpacing(spacing);
+    pixelData->getOrigin(origin);
+
+    for (int i = 0; i < 6; i++)
+    {
+        QCOMPARE(extent[i], expectedExtent[i]);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        QCOMPARE(spacing[i], imageData->GetSpacing()[i]);
+        QCOMPARE(origin[i], imageData->GetOrigin()[i]);
+    }
+
+    QCOMPARE(pixelData->getScalarType(), imageData->GetScalarType());
+    QCOMPARE(pixelData->getNumberOfScalarComponents(), imageData->GetNumberOfScalarComponents());
+    QVERIFY(std::memcmp(pixelData->getScalarPointer(), imageData->GetScalarPointer(), imageData->GetNumberOfPoints() * imageData->GetScalarSize()) == 0);
+}
+
+void test_DecodedVolumeCache::constructor_ShouldGiveDifferentFileWhenFilesChange()
+{
+    QStringList files = createFiles(m_seriesDirectory, 3);
+
+    QString cacheFilePath = DecodedVolumeCache("1.2.3.4", files, QList<int>()).getCacheFilePath();
+
+    QCOMPARE(DecodedVolumeCache("1.2.3.4", files, QList<int>()).getCacheFilePath(), cacheFilePath);
+    QVERIFY(DecodedVolumeCache("1.2.3.5", files, QList<int>()).getCacheFilePath() != cacheFilePath);
+    QVERIFY(DecodedVolumeCache("1.2.3.4", files.mid(1), QList<int>()).getCacheFilePath() != cacheFilePath);
+    QVERIFY(DecodedVolumeCache("1.2.3.4", QStringList() << files.at(1) << files.at(0) << files.at(2), QList<int>()).getCacheFilePath() != cacheFilePath);
+    QVERIFY(DecodedVolumeCache("1.2.3.4", files, QList<int>() << 0 << 1 << 2).getCacheFilePath() != cacheFilePath);
+
+    // A file replaced with a different size
+    QFile file(files.first());
+    QVERIFY(file.open(QIODevice::Append));
+    file.write("more data");
+    file.close();
+
+    QVERIFY(DecodedVolumeCache("1.2.3.4", files, QList<int>()).getCacheFilePath() != cacheFilePath);
+}
+
+void test_DecodedVolumeCache::invalidate_ShouldRemoveCachedVolumes()
+{
+    QStringList files = createFiles(m_seriesDirectory, 3);
+
+    DecodedVolumeCache cache("1.2.3.4", files, QList<int>());
+    QVERIFY(cache.store(createImageData()));
+    QVERIFY(QFile::exists(cache.getCacheFilePath()));
+
+    DecodedVolumeCache::invalidate(m_seriesDirectory);
+
+    QVERIFY(!QFile::exists(cache.getCacheFilePath()));
+    QVERIFY(!DecodedVolumeCache("1.2.3.4", files, QList<int>()).load());
+    // The DICOM files are not touched
+    foreach (const QString &file, files)
+    {
+        QVERIFY(QFile::exists(file));
+    }
+}
+
+void test_DecodedVolumeCache::invalidate_ShouldRemoveCachedVolumesThatAreLoaded()
+{
+    QStringList files = createFiles(m_seriesDirectory, 3);
+    vtkSmartPointer<vtkImageData> imageData = createImageData();
+
+    DecodedVolumeCache cache("1.2.3.4", files, QList<int>());
+    QVERIFY(cache.store(imageData));
+    QScopedPointer<VolumePixelData> pixelData(cache.load());
+    QVERIFY(pixelData);
+    QVERIFY(pixelData->isMemoryMapped());
+
+    DecodedVolumeCache::invalidate(m_seriesDirectory);
+
+    // The blob is removed even though it was mapped, and the loaded volume keeps its data
+    QVERIFY(!QFile::exists(cache.getCacheFilePath()));
+    QVERIFY(!pixelData->isMemoryMapped());
+    QVERIFY(std::memcmp(pixelData->getScalarPointer(), imageData->GetScalarPointer(), imageData->GetNumberOfPoints() * imageData->GetScalarSize()) == 0);
+}
+
+void test_DecodedVolumeCache::store_ShouldReplaceCachedVolumeThatIsLoaded()
+{
+    QStringList files = createFiles(m_seriesDirectory, 3);
+    vtkSmartPointer<vtkImageData> imageData = createImageData();
+
+    DecodedVolumeCache cache("1.2.3.4", files, QList<int>());
+    QVERIFY(cache.store(imageData));
+    QScopedPointer<VolumePixelData> pixelData(cache.load());
+    QVERIFY(pixelData);
+    QVERIFY(pixelData->isMemoryMapped());
+
+    vtkSmartPointer<vtkImageData> newImageData = createImageData();
+    static_cast<short*>(newImageData->GetScalarPointer())[0] = 1234;
+
+    // Storing the same volume again renames a new blob over the mapped one
+    QVERIFY(cache.store(newImageData));
+    QVERIFY(!pixelData->isMemoryMapped());
+    QVERIFY(std::memcmp(pixelData->getScalarPointer(), imageData->GetScalarPointer(), imageData->GetNumberOfPoints() * imageData->GetScalarSize()) == 0);
+
+    QScopedPointer<VolumePixelData> newPixelData(cache.load());
+    QVERIFY(newPixelData);
+    QCOMPARE(static_cast<short*>(newPixelData->getScalarPointer())[0], static_cast<short>(1234));
+}
+
+void test_DecodedVolumeCache::store_ShouldNotStoreAfterInvalidate()
+{
+    QStringList files = createFiles(m_seriesDirectory, 3);
+
+    // As a volume read while its series is deleted or replaced: the cache object is created before the invalidation and stores after it
+    DecodedVolumeCache cache("1.2.3.4", files, QList<int>());
+    DecodedVolumeCache::invalidate(m_seriesDirectory + "/");
+
+    QVERIFY(!cache.store(createImageData()));
+    QVERIFY(!QFile::exists(cache.getCacheFilePath()));
+    QCOMPARE(QDir(m_seriesDirectory).entryList(QDir::Files).size(), files.size());
+
+    // Volumes read after the invalidation are stored
+    DecodedVolumeCache newCache("1.2.3.4", files, QList<int>());
+    QVERIFY(newCache.store(createImageData()));
+}
+
+void test_DecodedVolumeCache::isCacheable_ShouldReturnFalseForNotCacheableFiles()
+{
+    QStringList files = createFiles(m_seriesDirectory, 2);
+
+    QTemporaryDir otherDirectory;
+    QStringList otherFiles = createFiles(otherDirectory.path(), 2);
+
+    QString otherSeriesDirectory = m_cacheableDirectory->path() + "/1.2.3/1.2.3.5";
+    QVERIFY(QDir().mkpath(otherSeriesDirectory));
+    QStringList filesInTwoDirectories = QStringList() << files.first() << createFiles(otherSeriesDirectory, 1);
+
+    // A directory that only starts like the cacheable one
+    QString siblingDirectory = m_cacheableDirectory->path() + "sibling";
+    QVERIFY(QDir().mkpath(siblingDirectory));
+    QStringList siblingFiles = createFiles(siblingDirectory, 1);
+
+    QList<DecodedVolumeCache> notCacheable;
+    notCacheable << DecodedVolumeCache("1.2.3.4", otherFiles, QList<int>())
+                 << DecodedVolumeCache("1.2.3.4", filesInTwoDirectories, QList<int>())
+                 << DecodedVolumeCache("1.2.3.4", siblingFiles, QList<int>())
+                 << DecodedVolumeCache("", files, QList<int>())
+                 << DecodedVolumeCache("1.2.3.4", QStringList(), QList<int>());
+
+    foreach (const DecodedVolumeCache &cache, notCacheable)
+    {
+        QVERIFY(!cache.isCacheable());
+        QVERIFY(cache.getCacheFilePath().isEmpty());
+        QVERIFY(!cache.store(createImageData()));
+        QVERIFY(!cache.load());
+    }
+
+    QDir(siblingDirectory).removeRecursively();
+
+    // Disabled cache
+    DecodedVolumeCache::setCacheableDirectory(QString());
+    QVERIFY(!DecodedVolumeCache("1.2.3.4", files, QList<int>()).isCacheable());
+
+    DecodedVolumeCache::setCacheableDirectory(m_cacheableDirectory->path());
+    Settings().setValue(CoreSettings::EnableDecodedVolumeCache, false);
+    bool cacheable = DecodedVolumeCache("1.2.3.4", files, QList<int>()).isCacheable();
+    Settings().setValue(CoreSettings::EnableDecodedVolumeCache, true);
+    QVERIFY(!cacheable);
+}
+
+QStringList test_DecodedVolumeCache::createFiles(const QString &directory, int numberOfFiles)
+{
+    QStringList files;
+
+    for (int i = 0; i < numberOfFiles; i++)
+    {
+        QFile file(QDir(directory).filePath(QString("%1.dcm").arg(i)));
+
+        if (file.open(QIODevice::WriteOnly))
+        {
+            file.write(QByteArray(100 + i, 'x'));
+            files << file.fileName();
+        }
+    }
+
+    return files;
+}
+
+vtkSmartPointer<vtkImageData> test_DecodedVolumeCache::createImageData()
+{
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetExtent(0, 15, 0, 7, 2, 5);
+    imageData->SetSpacing(0.5, 0.75, 2.0);
+    imageData->SetOrigin(-10.0, 20.0, 3.5);
+    imageData->AllocateScalars(VTK_SHORT, 1);
+
+    short *scalars = static_cast<short*>(imageData->GetScalarPointer());
+    for (vtkIdType i = 0; i < imageData->GetNumberOfPoints(); i++)
+    {
+        scalars[i] = static_cast<short>(i * 7 - 300);
+    }
+
+    return imageData;
+}
+
+DECLARE_TEST(test_DecodedVolumeCache)
+
+#include "test_decodedvolumecache.moc"
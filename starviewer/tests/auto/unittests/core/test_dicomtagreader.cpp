@@ -1,13 +1,18 @@
 #include "autotest.h"
 
+#include "dicomfiletesthelper.h"
 #include "dicomtagreader.h"
 #include "dicomvalueattribute.h"
 
+#include <QProcessEnvironment>
+#include <QTemporaryDir>
+
 #include <dcdatset.h>
 #include <dcdeftag.h>
 #include <dcsequen.h>
 
 using namespace udg;
+using namespace testing;
 
 class test_DICOMTagReader : public QObject {
 Q_OBJECT
@@ -17,8 +22,15 @@ private slots:
     
     void getValueAttribute_ReturnsExpectedValues_data();
     void getValueAttribute_ReturnsExpectedValues();
+
+    void setFile_WithMetadataOnlyLoadingModeDefersBigValues();
+
+    void setFile_Benchmark_data();
+    void setFile_Benchmark();
 };
 
+Q_DECLARE_METATYPE(DICOMTagReader::LoadingMode)
+
 Q_DECLARE_METATYPE(DcmDataset*)
 Q_DECLARE_METATYPE(DICOMValueAttribute*)
 Q_DECLARE_METATYPE(DICOMTag)
@@ -110,6 +122,69 @@ void test_DICOMTagReader::getValueAttribute_ReturnsExpectedValues()
     QCOMPARE(expectedValue->getValueAsByteArray(), returnValue->getValueAsByteArray());
 }
 
+void test_DICOMTagReader::setFile_WithMetadataOnlyLoadingModeDefersBigValues()
+{
+    QTemporaryDir directory;
+    QString filename = directory.path() + "/image.dcm";
+    QVERIFY(DICOMFileTestHelper::createCTImage(filename, "1.2.3.4.5.6", 1, 1, 64));
+
+    DICOMTagReader tagReader;
+    QVERIFY(tagReader.setFile(filename, DICOMTagReader::LoadMetadataOnly));
+
+    DcmElement *element = 0;
+    QVERIFY(tagReader.getDcmDataset()->findAndGetElement(DCM_PatientName, element).good());
+    QVERIFY(element->valueLoaded());
+    QVERIFY(tagReader.getDcmDataset()->findAndGetElement(DCM_ImageComments, element).good());
+    QVERIFY(!element->valueLoaded());
+    QVERIFY(tagReader.getDcmDataset()->findAndGetElement(DCM_OverlayData, element).good());
+    QVERIFY(!element->valueLoaded());
+    QVERIFY(tagReader.getDcmDataset()->findAndGetElement(DCM_PixelData, element).good());
+    QVERIFY(!element->valueLoaded());
+
+    // Big values are still present and are loaded when requested
+    QVERIFY(tagReader.tagExists(DICOMPixelData));
+    QCOMPARE(tagReader.getValueAttributeAsQString(DICOMPatientName), QString("JOHN^DOE"));
+    QCOMPARE(tagReader.getValueAttributeAsQString(DICOMImageComments), DICOMFileTestHelper::getLongComment());
+    const Uint16 *pixels = 0;
+    unsigned long numberOfPixels = 0;
+    QVERIFY(tagReader.getDcmDataset()->findAndGetUint16Array(DCM_PixelData, pixels, &numberOfPixels).good());
+    QCOMPARE(numberOfPixels, 64ul * 64ul);
+    QCOMPARE(pixels[10], static_cast<Uint16>(11));
+}
+
+void test_DICOMTagReader::setFile_Benchmark_data()
+{
+    // Creating and reading a series of 1000 images takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("setFile benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QTest::addColumn<DICOMTagReader::LoadingMode>("loadingMode");
+
+    QTest::newRow("default") << DICOMTagReader::LoadDefault;
+    QTest::newRow("metadata only") << DICOMTagReader::LoadMetadataOnly;
+}
+
+void test_DICOMTagReader::setFile_Benchmark()
+{
+    QFETCH(DICOMTagReader::LoadingMode, loadingMode);
+
+    // A synthetic series of 1000 images as the ones read by PatientFiller when importing
+    QTemporaryDir directory;
+    QStringList files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", 1000, 256);
+    QVERIFY(!files.isEmpty());
+
+    QBENCHMARK
+    {
+        foreach (const QString &filename, files)
+        {
+            DICOMTagReader tagReader(filename, loadingMode);
+            QVERIFY(tagReader.canReadFile());
+        }
+    }
+}
+
 DECLARE_TEST(test_DICOMTagReader)
 
 #include "test_dicomtagreader.moc"
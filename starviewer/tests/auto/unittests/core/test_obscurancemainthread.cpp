@@ -0,0 +1,180 @@
+#include "autotest.h"
+#include "obscurancemainthread.h"
+
+#include "fuzzycomparetesthelper.h"
+#include "obscurance.h"
+#include "transferfunction.h"
+
+#include <QThread>
+
+#include <vtkEncodedGradientEstimator.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtkVolume.h>
+#include <vtkVolumeRayCastMapper.h>
+
+using namespace udg;
+
+class test_ObscuranceMainThread : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void run_ShouldComputeTheSameObscurancesWithAnyNumberOfThreads_data();
+    void run_ShouldComputeTheSameObscurancesWithAnyNumberOfThreads();
+
+    void getMaximumNumberOfThreads_ShouldLimitMemoryOfThreadBuffers_data();
+    void getMaximumNumberOfThreads_ShouldLimitMemoryOfThreadBuffers();
+
+    void run_Benchmark_data();
+    void run_Benchmark();
+
+private:
+    /// Creates a volume of size³ voxels with a sphere of value 1000 on a background of value 0.
+    vtkSmartPointer<vtkVolume> createVolume(int size);
+
+    /// Computes the obscurances of the given volume with the given number of threads and returns them. The caller takes ownership.
+    Obscurance* computeObscurance(vtkVolume *volume, ObscuranceMainThread::Variant variant, int numberOfThreads);
+};
+
+vtkSmartPointer<vtkVolume> test_ObscuranceMainThread::createVolume(int size)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+    image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+
+    unsigned short *data = static_cast<unsigned short*>(image->GetScalarPointer());
+    double center = (size - 1) / 2.0;
+    double radius = size / 3.0;
+
+    for (int z = 0; z < size; z++)
+    {
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                double distance2 = (x - center) * (x - center) + (y - center) * (y - center) + (z - center) * (z - center);
+                *data++ = distance2 <= radius * radius ? 1000 : 0;
+            }
+        }
+    }
+
+    vtkSmartPointer<vtkVolumeRayCastMapper> mapper = vtkSmartPointer<vtkVolumeRayCastMapper>::New();
+    mapper->SetInputData(image);
+    // The mapper only connects its gradient estimator when it renders
+    mapper->GetGradientEstimator()->SetInputData(image);
+
+    vtkSmartPointer<vtkVolume> volume = vtkSmartPointer<vtkVolume>::New();
+    volume->SetMapper(mapper);
+
+    return volume;
+}
+
+Obscurance* test_ObscuranceMainThread::computeObscurance(vtkVolume *volume, ObscuranceMainThread::Variant variant, int numberOfThreads)
+{
+    TransferFunction transferFunction;
+    transferFunction.set(0.0, Qt::black, 0.0);
+    transferFunction.set(1000.0, Qt::white, 1.0);
+
+    ObscuranceMainThread mainThread(0, volume->GetLength() / 2.0, ObscuranceMainThread::Distance, variant);
+    mainThread.setVolume(volume);
+    mainThread.setTransferFunction(transferFunction);
+    mainThread.setNumberOfThreads(numberOfThreads);
+    mainThread.start();
+    mainThread.wait();
+
+    return mainThread.getObscurance();
+}
+
+void test_ObscuranceMainThread::run_ShouldComputeTheSameObscurancesWithAnyNumberOfThreads_data()
+{
+    QTest::addColumn<int>("variant");
+    QTest::addColumn<int>("numberOfThreads");
+
+    QTest::newRow("density, 2 threads") << static_cast<int>(ObscuranceMainThread::Density) << 2;
+    QTest::newRow("density, 4 threads") << static_cast<int>(ObscuranceMainThread::Density) << 4;
+    QTest::newRow("opacity, 3 threads") << static_cast<int>(ObscuranceMainThread::Opacity) << 3;
+    QTest::newRow("color bleeding, 4 threads") << static_cast<int>(ObscuranceMainThread::OpacityColorBleeding) << 4;
+}
+
+void test_ObscuranceMainThread::run_ShouldComputeTheSameObscurancesWithAnyNumberOfThreads()
+{
+    QFETCH(int, variant);
+    QFETCH(int, numberOfThreads);
+
+    vtkSmartPointer<vtkVolume> volume = createVolume(32);
+    QScopedPointer<Obscurance> expectedObscurance(computeObscurance(volume, static_cast<ObscuranceMainThread::Variant>(variant), 1));
+    QScopedPointer<Obscurance> obscurance(computeObscurance(volume, static_cast<ObscuranceMainThread::Variant>(variant), numberOfThreads));
+
+    QVERIFY(expectedObscurance);
+    QVERIFY(obscurance);
+    QCOMPARE(obscurance->size(), expectedObscurance->size());
+
+    // The sums of the directions are done in a different order, so the results are only equal up to rounding
+    for (unsigned int i = 0; i < obscurance->size(); i++)
+    {
+        if (obscurance->hasColor())
+        {
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(obscurance->colorBleeding(i), expectedObscurance->colorBleeding(i), 1e-9));
+        }
+        else
+        {
+            QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(obscurance->obscurance(i), expectedObscurance->obscurance(i), 1e-9));
+        }
+    }
+}
+
+void test_ObscuranceMainThread::getMaximumNumberOfThreads_ShouldLimitMemoryOfThreadBuffers_data()
+{
+    QTest::addColumn<unsigned int>("dataSize");
+    QTest::addColumn<bool>("color");
+    QTest::addColumn<bool>("doublePrecision");
+    QTest::addColumn<int>("expectedMaximumNumberOfThreads");
+
+    int idealThreadCount = qMax(1, QThread::idealThreadCount());
+
+    // The memory of the buffers of the threads besides the first one is limited to 1 GiB
+    QTest::newRow("empty volume") << 0u << false << true << idealThreadCount;
+    QTest::newRow("small volume") << 64u * 64u * 64u << true << true << idealThreadCount;
+    QTest::newRow("512³ double obscurance") << 512u * 512u * 512u << false << true << qMin(idealThreadCount, 2);
+    QTest::newRow("512³ float obscurance") << 512u * 512u * 512u << false << false << qMin(idealThreadCount, 3);
+    QTest::newRow("512³ double color bleeding") << 512u * 512u * 512u << true << true << 1;
+    QTest::newRow("256³ double color bleeding") << 256u * 256u * 256u << true << true << qMin(idealThreadCount, 3);
+}
+
+void test_ObscuranceMainThread::getMaximumNumberOfThreads_ShouldLimitMemoryOfThreadBuffers()
+{
+    QFETCH(unsigned int, dataSize);
+    QFETCH(bool, color);
+    QFETCH(bool, doublePrecision);
+    QFETCH(int, expectedMaximumNumberOfThreads);
+
+    QCOMPARE(ObscuranceMainThread::getMaximumNumberOfThreads(dataSize, color, doublePrecision), expectedMaximumNumberOfThreads);
+}
+
+void test_ObscuranceMainThread::run_Benchmark_data()
+{
+    QTest::addColumn<int>("numberOfThreads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("4 threads") << 4;
+    QTest::newRow("ideal number of threads") << 0;
+}
+
+void test_ObscuranceMainThread::run_Benchmark()
+{
+    QFETCH(int, numberOfThreads);
+
+    vtkSmartPointer<vtkVolume> volume = createVolume(64);
+
+    QBENCHMARK
+    {
+        QScopedPointer<Obscurance> obscurance(computeObscurance(volume, ObscuranceMainThread::Opacity, numberOfThreads));
+        QVERIFY(obscurance);
+    }
+}
+
+DECLARE_TEST(test_ObscuranceMainThread)
+
+#include "test_obscurancemainthread.moc"
@@ -0,0 +1,221 @@
+#include "autotest.h"
+#include "orderimagesfillerstep.h"
+
+#include "image.h"
+#include "imageorientation.h"
+#include "patientfillerinput.h"
+#include "series.h"
+
+#include <QtCore/qmath.h>
+
+using namespace udg;
+
+class test_OrderImagesFillerStep : public QObject {
+Q_OBJECT
+
+private slots:
+    void postProcessing_ShouldOrderAStackByDistance();
+    void postProcessing_ShouldOrderPhasesOfTheSamePositionByInstanceNumber();
+    void postProcessing_ShouldOrderByInstanceNumberWhenNotAllPositionsHaveTheSameNumberOfPhases();
+    void postProcessing_ShouldOrderByInstanceNumberWhenThereAreMultipleAcquisitionNumbers();
+    void postProcessing_ShouldOrderStacksByDistanceOfTheirFirstImage();
+    void postProcessing_ShouldOrderRotationalPlanesByAngle();
+    void postProcessing_ShouldOrderEachVolumeSeparately();
+
+    void postProcessing_Benchmark_data();
+    void postProcessing_Benchmark();
+
+private:
+    /// Creates an image in the given series with the given orientation, position, instance number and acquisition number.
+    /// The SOP Instance UID is the instance number.
+    Image* createImage(Series *series, const QVector3D &rowVector, const QVector3D &columnVector, const QVector3D &position, int instanceNumber,
+                       const QString &acquisitionNumber = "1", int volumeNumber = 0);
+
+    /// Creates an axial image at the given z position.
+    Image* createAxialImage(Series *series, double z, int instanceNumber, const QString &acquisitionNumber = "1", int volumeNumber = 0);
+
+    /// Fills the step with every image of the series individually, in the order in which they were added, and returns the SOP Instance UIDs
+    /// of the ordered images.
+    QStringList orderImages(Series *series);
+};
+
+Image* test_OrderImagesFillerStep::createImage(Series *series, const QVector3D &rowVector, const QVector3D &columnVector, const QVector3D &position,
+                                               int instanceNumber, const QString &acquisitionNumber, int volumeNumber)
+{
+    Image *image = new Image(series);
+    image->setSOPInstanceUID(QString::number(instanceNumber));
+    image->setInstanceNumber(QString::number(instanceNumber));
+    image->setFrameNumber(0);
+    image->setAcquisitionNumber(acquisitionNumber);
+    image->setImageOrientationPatient(ImageOrientation(rowVector, columnVector));
+    double imagePositionPatient[3] = { position.x(), position.y(), position.z() };
+    image->setImagePositionPatient(imagePositionPatient);
+    image->setVolumeNumberInSeries(volumeNumber);
+    series->addImage(image);
+
+    return image;
+}
+
+Image* test_OrderImagesFillerStep::createAxialImage(Series *series, double z, int instanceNumber, const QString &acquisitionNumber, int volumeNumber)
+{
+    return createImage(series, QVector3D(1, 0, 0), QVector3D(0, 1, 0), QVector3D(0, 0, z), instanceNumber, acquisitionNumber, volumeNumber);
+}
+
+QStringList test_OrderImagesFillerStep::orderImages(Series *series)
+{
+    PatientFillerInput input;
+    input.setCurrentSeries(series);
+
+    OrderImagesFillerStep step;
+    step.setInput(&input);
+
+    foreach (Image *image, series->getImages())
+    {
+        input.setCurrentVolumeNumber(image->getVolumeNumberInSeries());
+        input.setCurrentImages(QList<Image*>() << image, false);
+        step.fillIndividually();
+    }
+
+    step.postProcessing();
+
+    QStringList order;
+    foreach (Image *image, series->getImages())
+    {
+        order << image->getSOPInstanceUID();
+    }
+
+    return order;
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderAStackByDistance()
+{
+    QScopedPointer<Series> series(new Series());
+    createAxialImage(series.data(), 30.0, 1);
+    createAxialImage(series.data(), 10.0, 2);
+    createAxialImage(series.data(), 20.0, 3);
+    createAxialImage(series.data(), -5.0, 4);
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "4" << "2" << "3" << "1");
+
+    for (int i = 0; i < series->getImages().size(); i++)
+    {
+        QCOMPARE(series->getImages().at(i)->getOrderNumberInVolume(), i);
+    }
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderPhasesOfTheSamePositionByInstanceNumber()
+{
+    QScopedPointer<Series> series(new Series());
+    for (int phase = 0; phase < 2; phase++)
+    {
+        for (int slice = 2; slice >= 0; slice--)
+        {
+            createAxialImage(series.data(), 1.0 + slice * 5.0, phase * 3 + slice + 1);
+        }
+    }
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "1" << "4" << "2" << "5" << "3" << "6");
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderByInstanceNumberWhenNotAllPositionsHaveTheSameNumberOfPhases()
+{
+    QScopedPointer<Series> series(new Series());
+    createAxialImage(series.data(), 10.0, 3);
+    createAxialImage(series.data(), 10.0, 1);
+    createAxialImage(series.data(), 5.0, 4);
+    createAxialImage(series.data(), 20.0, 2);
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "1" << "2" << "3" << "4");
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderByInstanceNumberWhenThereAreMultipleAcquisitionNumbers()
+{
+    QScopedPointer<Series> series(new Series());
+    createAxialImage(series.data(), 10.0, 3, "1");
+    createAxialImage(series.data(), 20.0, 1, "2");
+    createAxialImage(series.data(), 30.0, 2, "2");
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "1" << "2" << "3");
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderStacksByDistanceOfTheirFirstImage()
+{
+    QScopedPointer<Series> series(new Series());
+    // Axial stack from 10 to 30
+    createAxialImage(series.data(), 30.0, 1);
+    createAxialImage(series.data(), 10.0, 2);
+    createAxialImage(series.data(), 20.0, 3);
+    // Sagittal stack from -5 to 5
+    createImage(series.data(), QVector3D(0, 1, 0), QVector3D(0, 0, 1), QVector3D(5, 0, 0), 4);
+    createImage(series.data(), QVector3D(0, 1, 0), QVector3D(0, 0, 1), QVector3D(-5, 0, 0), 5);
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "5" << "4" << "2" << "3" << "1");
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderRotationalPlanesByAngle()
+{
+    QScopedPointer<Series> series(new Series());
+    // Planes rotated around the y axis, all of them through the origin
+    QList<int> angles;
+    angles << 0 << 60 << 120 << 30 << 90;
+
+    for (int i = 0; i < angles.size(); i++)
+    {
+        double angle = qDegreesToRadians(static_cast<double>(angles.at(i)));
+        createImage(series.data(), QVector3D(qCos(angle), 0, qSin(angle)), QVector3D(0, 1, 0), QVector3D(0, 0, 0), i + 1);
+    }
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "1" << "4" << "2" << "5" << "3");
+}
+
+void test_OrderImagesFillerStep::postProcessing_ShouldOrderEachVolumeSeparately()
+{
+    QScopedPointer<Series> series(new Series());
+    createAxialImage(series.data(), 20.0, 1, "1", 1);
+    createAxialImage(series.data(), 20.0, 2, "1", 0);
+    createAxialImage(series.data(), 10.0, 3, "1", 1);
+    createAxialImage(series.data(), 10.0, 4, "1", 0);
+
+    QCOMPARE(orderImages(series.data()), QStringList() << "4" << "2" << "3" << "1");
+
+    QList<Image*> images = series->getImages();
+    QCOMPARE(images.at(0)->getVolumeNumberInSeries(), 0);
+    QCOMPARE(images.at(1)->getOrderNumberInVolume(), 1);
+    QCOMPARE(images.at(2)->getVolumeNumberInSeries(), 1);
+    QCOMPARE(images.at(2)->getOrderNumberInVolume(), 0);
+}
+
+void test_OrderImagesFillerStep::postProcessing_Benchmark_data()
+{
+    QTest::addColumn<int>("numberOfSlices");
+    QTest::addColumn<int>("numberOfPhases");
+
+    QTest::newRow("1k slices") << 1000 << 1;
+    QTest::newRow("200 slices x 50 phases") << 200 << 50;
+    QTest::newRow("500 slices x 40 phases") << 500 << 40;
+}
+
+void test_OrderImagesFillerStep::postProcessing_Benchmark()
+{
+    QFETCH(int, numberOfSlices);
+    QFETCH(int, numberOfPhases);
+
+    QScopedPointer<Series> series(new Series());
+    for (int phase = 0; phase < numberOfPhases; phase++)
+    {
+        for (int slice = 0; slice < numberOfSlices; slice++)
+        {
+            // Slices in descending order so that they have to be reordered
+            createAxialImage(series.data(), numberOfSlices - slice, phase * numberOfSlices + slice + 1);
+        }
+    }
+
+    QBENCHMARK
+    {
+        QCOMPARE(orderImages(series.data()).size(), numberOfSlices * numberOfPhases);
+    }
+}
+
+DECLARE_TEST(test_OrderImagesFillerStep)
+
+#include "test_orderimagesfillerstep.moc"
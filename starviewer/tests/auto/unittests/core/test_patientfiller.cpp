@@ -0,0 +1,289 @@
+#include "autotest.h"
+#include "patientfiller.h"
+
+#include "dicomfiletesthelper.h"
+#include "dicomtagreader.h"
+#include "image.h"
+#include "patient.h"
+#include "series.h"
+#include "study.h"
+
+#include <QFile>
+#include <QProcessEnvironment>
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+#include <dcdatset.h>
+#include <dcsequen.h>
+
+using namespace udg;
+using namespace testing;
+
+class test_PatientFiller : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void processFiles_ShouldFillSameResultAsProcessingFilesOneByOne();
+
+    void processFiles_Benchmark();
+
+    void processDICOMFile_Benchmark_data();
+    void processDICOMFile_Benchmark();
+
+    void processDICOMFile_LoadedValueBytesBenchmark_data();
+    void processDICOMFile_LoadedValueBytesBenchmark();
+
+private:
+    /// Fills the given files calling processDICOMFile() for each one in order and returns the generated patient.
+    static Patient* processDICOMFilesOneByOne(const QStringList &files);
+    /// Returns a description of the given patients with their studies, series and volumes and the order and filled values of the images.
+    static QStringList describe(const QList<Patient*> &patients);
+    /// Returns the number of bytes of the element values of the given item that are loaded in memory, including those of its sequences.
+    static qint64 getLoadedValueBytes(DcmItem *item);
+    /// Adds the loading mode column and a row for each loading mode to the benchmark data.
+    static void addLoadingModeRows();
+};
+
+Q_DECLARE_METATYPE(DICOMTagReader::LoadingMode)
+
+namespace {
+
+/// Size of the synthetic series imported by the benchmarks
+const int NumberOfImages = 200;
+const int ImageSize = 256;
+
+}
+
+void test_PatientFiller::processFiles_ShouldFillSameResultAsProcessingFilesOneByOne()
+{
+    QTemporaryDir directory;
+    QStringList firstSeries = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", 30, 16);
+    QStringList secondSeries = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.7", 30, 16);
+    QVERIFY(!firstSeries.isEmpty() && !secondSeries.isEmpty());
+
+    // Files that are not DICOM make the first stage stop after the first step, as thumbnails found when reading a directory
+    QStringList notDICOMFiles;
+    for (int i = 0; i < 3; i++)
+    {
+        QFile file(directory.path() + QString("/thumbnail%1.png").arg(i));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("not a DICOM file");
+        notDICOMFiles << file.fileName();
+    }
+
+    // Interleave the series in reverse order of the slices, with the non-DICOM files at the start, in the middle and at the end
+    QStringList files;
+    files << notDICOMFiles.at(0);
+    for (int i = firstSeries.size() - 1; i >= 0; i--)
+    {
+        files << firstSeries.at(i) << secondSeries.at(i);
+        if (i == firstSeries.size() / 2)
+        {
+            files << notDICOMFiles.at(1);
+        }
+    }
+    files << notDICOMFiles.at(2);
+
+    // Limit the threads so that the files read ahead are fewer than the files and the queue has to be refilled
+    int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+    QThreadPool::globalInstance()->setMaxThreadCount(2);
+
+    PatientFiller patientFiller;
+    QList<Patient*> patients = patientFiller.processFiles(files);
+
+    QThreadPool::globalInstance()->setMaxThreadCount(maxThreadCount);
+
+    Patient *expectedPatient = processDICOMFilesOneByOne(files);
+
+    QCOMPARE(patients.size(), 1);
+    QCOMPARE(patients.first()->getStudies().first()->getSeries().size(), 2);
+    QCOMPARE(describe(patients), describe(QList<Patient*>() << expectedPatient));
+
+    qDeleteAll(patients);
+    delete expectedPatient;
+}
+
+void test_PatientFiller::processFiles_Benchmark()
+{
+    // Creating and filling the series takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("processFiles benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QTemporaryDir directory;
+    QStringList files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", NumberOfImages, ImageSize);
+    QVERIFY(!files.isEmpty());
+
+    QBENCHMARK
+    {
+        PatientFiller patientFiller;
+        QList<Patient*> patients = patientFiller.processFiles(files);
+
+        QCOMPARE(patients.size(), 1);
+        QCOMPARE(patients.first()->getStudies().first()->getSeries().first()->getImages().size(), NumberOfImages);
+        qDeleteAll(patients);
+    }
+}
+
+void test_PatientFiller::processDICOMFile_Benchmark_data()
+{
+    // Creating and filling the series takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("processDICOMFile benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    addLoadingModeRows();
+}
+
+void test_PatientFiller::processDICOMFile_Benchmark()
+{
+    QFETCH(DICOMTagReader::LoadingMode, loadingMode);
+
+    QTemporaryDir directory;
+    QStringList files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", NumberOfImages, ImageSize);
+    QVERIFY(!files.isEmpty());
+
+    QBENCHMARK
+    {
+        PatientFiller patientFiller;
+        QList<Patient*> patients;
+        QObject::connect(&patientFiller, &PatientFiller::patientProcessed, [&patients](Patient *patient) { patients << patient; });
+
+        foreach (const QString &file, files)
+        {
+            patientFiller.processDICOMFile(new DICOMTagReader(file, loadingMode));
+        }
+        patientFiller.finishDICOMFilesProcess();
+
+        QCOMPARE(patients.size(), 1);
+        QCOMPARE(patients.first()->getStudies().first()->getSeries().first()->getImages().size(), NumberOfImages);
+        qDeleteAll(patients);
+    }
+}
+
+void test_PatientFiller::processDICOMFile_LoadedValueBytesBenchmark_data()
+{
+    // Creating and filling the series takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("processDICOMFile loaded value bytes benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    addLoadingModeRows();
+}
+
+void test_PatientFiller::processDICOMFile_LoadedValueBytesBenchmark()
+{
+    QFETCH(DICOMTagReader::LoadingMode, loadingMode);
+
+    QTemporaryDir directory;
+    QStringList files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", NumberOfImages, ImageSize);
+    QVERIFY(!files.isEmpty());
+
+    // Reports the bytes of the values held in memory by the read files once the steps have used them, added over the whole series.
+    // The reader is deleted by the PatientFillerInput when the next file is processed, so it's measured right after processing it.
+    // processFiles() keeps up to 4 x maxThreadCount() files read ahead, so its peak is about that many times the per file value.
+    PatientFiller patientFiller;
+    qint64 loadedValueBytes = 0;
+
+    foreach (const QString &file, files)
+    {
+        DICOMTagReader *dicomTagReader = new DICOMTagReader(file, loadingMode);
+        patientFiller.processDICOMFile(dicomTagReader);
+        loadedValueBytes += getLoadedValueBytes(dicomTagReader->getDcmDataset());
+    }
+    patientFiller.finishDICOMFilesProcess();
+
+    if (loadingMode == DICOMTagReader::LoadMetadataOnly)
+    {
+        // No step needs the pixel data, so it must not have been loaded
+        QVERIFY(loadedValueBytes < static_cast<qint64>(NumberOfImages) * ImageSize * ImageSize);
+    }
+
+    QTest::setBenchmarkResult(loadedValueBytes, QTest::BytesAllocated);
+}
+
+void test_PatientFiller::addLoadingModeRows()
+{
+    QTest::addColumn<DICOMTagReader::LoadingMode>("loadingMode");
+
+    QTest::newRow("default") << DICOMTagReader::LoadDefault;
+    QTest::newRow("metadata only") << DICOMTagReader::LoadMetadataOnly;
+}
+
+Patient* test_PatientFiller::processDICOMFilesOneByOne(const QStringList &files)
+{
+    PatientFiller patientFiller;
+    Patient *processedPatient = 0;
+    QObject::connect(&patientFiller, &PatientFiller::patientProcessed, [&processedPatient](Patient *patient) { processedPatient = patient; });
+
+    foreach (const QString &file, files)
+    {
+        patientFiller.processDICOMFile(new DICOMTagReader(file, DICOMTagReader::LoadMetadataOnly));
+    }
+    patientFiller.finishDICOMFilesProcess();
+
+    return processedPatient;
+}
+
+QStringList test_PatientFiller::describe(const QList<Patient*> &patients)
+{
+    QStringList description;
+
+    foreach (Patient *patient, patients)
+    {
+        description << "Patient " + patient->getID() + " " + patient->getFullName();
+
+        foreach (Study *study, patient->getStudies())
+        {
+            description << "Study " + study->getInstanceUID();
+
+            foreach (Series *series, study->getSeries())
+            {
+                description << QString("Series %1 with %2 volumes").arg(series->getInstanceUID()).arg(series->getNumberOfVolumes());
+
+                foreach (Image *image, series->getImages())
+                {
+                    description << QString("Image %1 frame %2 phase %3 volume %4 order %5").arg(image->getSOPInstanceUID())
+                                   .arg(image->getFrameNumber()).arg(image->getPhaseNumber()).arg(image->getVolumeNumberInSeries())
+                                   .arg(image->getOrderNumberInVolume());
+                }
+            }
+        }
+    }
+
+    return description;
+}
+
+qint64 test_PatientFiller::getLoadedValueBytes(DcmItem *item)
+{
+    qint64 bytes = 0;
+
+    for (unsigned long i = 0; i < item->card(); i++)
+    {
+        DcmElement *element = item->getElement(i);
+
+        if (element->ident() == EVR_SQ)
+        {
+            DcmSequenceOfItems *sequence = static_cast<DcmSequenceOfItems*>(element);
+
+            for (unsigned long j = 0; j < sequence->card(); j++)
+            {
+                bytes += getLoadedValueBytes(sequence->getItem(j));
+            }
+        }
+        else if (element->valueLoaded())
+        {
+            bytes += element->getLength();
+        }
+    }
+
+    return bytes;
+}
+
+DECLARE_TEST(test_PatientFiller)
+
+#include "test_patientfiller.moc"
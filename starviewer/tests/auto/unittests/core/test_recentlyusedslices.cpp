@@ -0,0 +1,132 @@
+#include "autotest.h"
+#include "recentlyusedslices.h"
+
+using namespace udg;
+
+typedef QList<int> IntList;
+
+class test_RecentlyUsedSlices : public QObject {
+Q_OBJECT
+
+private slots:
+    void useSlicesAround_ShouldReturnSlicesInsideWindowWithGivenSliceLast_data();
+    void useSlicesAround_ShouldReturnSlicesInsideWindowWithGivenSliceLast();
+
+    void useSlicesAround_ShouldMakeUsedSlicesTheMostRecentOnes();
+
+    void takeLeastRecentlyUsedSlices_ShouldReturnSlicesExceedingMaximumFromLeastRecent_data();
+    void takeLeastRecentlyUsedSlices_ShouldReturnSlicesExceedingMaximumFromLeastRecent();
+
+    void takeLeastRecentlyUsedSlices_ShouldKeepSlicesVisitedAgain();
+
+    void clear_ShouldForgetAllSlices();
+};
+
+void test_RecentlyUsedSlices::useSlicesAround_ShouldReturnSlicesInsideWindowWithGivenSliceLast_data()
+{
+    QTest::addColumn<int>("slice");
+    QTest::addColumn<int>("distance");
+    QTest::addColumn<int>("numberOfSlices");
+    QTest::addColumn<IntList>("expectedSlices");
+
+    QTest::newRow("middle slice") << 10 << 2 << 20 << (IntList() << 8 << 9 << 11 << 12 << 10);
+    QTest::newRow("first slice") << 0 << 2 << 20 << (IntList() << 1 << 2 << 0);
+    QTest::newRow("second slice") << 1 << 2 << 20 << (IntList() << 0 << 2 << 3 << 1);
+    QTest::newRow("last slice") << 19 << 2 << 20 << (IntList() << 17 << 18 << 19);
+    QTest::newRow("single slice volume") << 0 << 2 << 1 << (IntList() << 0);
+    QTest::newRow("no neighbours") << 5 << 0 << 20 << (IntList() << 5);
+    QTest::newRow("slice before first") << -1 << 2 << 20 << IntList();
+    QTest::newRow("slice after last") << 20 << 2 << 20 << IntList();
+    QTest::newRow("empty volume") << 0 << 2 << 0 << IntList();
+}
+
+void test_RecentlyUsedSlices::useSlicesAround_ShouldReturnSlicesInsideWindowWithGivenSliceLast()
+{
+    QFETCH(int, slice);
+    QFETCH(int, distance);
+    QFETCH(int, numberOfSlices);
+    QFETCH(IntList, expectedSlices);
+
+    RecentlyUsedSlices recentlyUsedSlices(16);
+
+    QCOMPARE(recentlyUsedSlices.useSlicesAround(slice, distance, numberOfSlices), expectedSlices);
+    QCOMPARE(recentlyUsedSlices.getSlices(), expectedSlices);
+}
+
+void test_RecentlyUsedSlices::useSlicesAround_ShouldMakeUsedSlicesTheMostRecentOnes()
+{
+    RecentlyUsedSlices recentlyUsedSlices(16);
+
+    recentlyUsedSlices.useSlicesAround(10, 2, 20);
+    recentlyUsedSlices.useSlicesAround(11, 2, 20);
+
+    // The slices shared by both windows are moved after the ones only used before
+    QCOMPARE(recentlyUsedSlices.getSlices(), IntList() << 8 << 9 << 10 << 12 << 13 << 11);
+}
+
+void test_RecentlyUsedSlices::takeLeastRecentlyUsedSlices_ShouldReturnSlicesExceedingMaximumFromLeastRecent_data()
+{
+    QTest::addColumn<int>("maximumNumberOfSlices");
+    QTest::addColumn<IntList>("visitedSlices");
+    QTest::addColumn<IntList>("expectedTakenSlices");
+    QTest::addColumn<IntList>("expectedRemainingSlices");
+
+    QTest::newRow("below maximum") << 16 << (IntList() << 10) << IntList() << (IntList() << 8 << 9 << 11 << 12 << 10);
+    QTest::newRow("exactly maximum") << 5 << (IntList() << 10) << IntList() << (IntList() << 8 << 9 << 11 << 12 << 10);
+    QTest::newRow("forward scroll") << 5 << (IntList() << 10 << 11 << 12) << (IntList() << 8 << 9)
+                                    << (IntList() << 10 << 11 << 13 << 14 << 12);
+    QTest::newRow("backward scroll") << 5 << (IntList() << 10 << 9) << (IntList() << 12) << (IntList() << 7 << 8 << 10 << 11 << 9);
+    QTest::newRow("jump") << 6 << (IntList() << 2 << 15) << (IntList() << 0 << 1 << 3 << 4)
+                          << (IntList() << 2 << 13 << 14 << 16 << 17 << 15);
+    QTest::newRow("only current slice") << 1 << (IntList() << 10) << (IntList() << 8 << 9 << 11 << 12) << (IntList() << 10);
+}
+
+void test_RecentlyUsedSlices::takeLeastRecentlyUsedSlices_ShouldReturnSlicesExceedingMaximumFromLeastRecent()
+{
+    QFETCH(int, maximumNumberOfSlices);
+    QFETCH(IntList, visitedSlices);
+    QFETCH(IntList, expectedTakenSlices);
+    QFETCH(IntList, expectedRemainingSlices);
+
+    RecentlyUsedSlices recentlyUsedSlices(maximumNumberOfSlices);
+
+    foreach (int slice, visitedSlices)
+    {
+        recentlyUsedSlices.useSlicesAround(slice, 2, 20);
+    }
+
+    QCOMPARE(recentlyUsedSlices.takeLeastRecentlyUsedSlices(), expectedTakenSlices);
+    QCOMPARE(recentlyUsedSlices.getSlices(), expectedRemainingSlices);
+    QCOMPARE(recentlyUsedSlices.takeLeastRecentlyUsedSlices(), IntList());
+}
+
+void test_RecentlyUsedSlices::takeLeastRecentlyUsedSlices_ShouldKeepSlicesVisitedAgain()
+{
+    RecentlyUsedSlices recentlyUsedSlices(4);
+
+    recentlyUsedSlices.useSlicesAround(0, 1, 20);
+    recentlyUsedSlices.useSlicesAround(3, 1, 20);
+    QCOMPARE(recentlyUsedSlices.takeLeastRecentlyUsedSlices(), IntList() << 1);
+
+    // Visiting slice 0 again makes it the most recent, so slice 2 is the one released instead of it
+    recentlyUsedSlices.useSlicesAround(0, 0, 20);
+    QCOMPARE(recentlyUsedSlices.takeLeastRecentlyUsedSlices(), IntList());
+    recentlyUsedSlices.useSlicesAround(6, 0, 20);
+    QCOMPARE(recentlyUsedSlices.takeLeastRecentlyUsedSlices(), IntList() << 2);
+    QCOMPARE(recentlyUsedSlices.getSlices(), IntList() << 4 << 3 << 0 << 6);
+}
+
+void test_RecentlyUsedSlices::clear_ShouldForgetAllSlices()
+{
+    RecentlyUsedSlices recentlyUsedSlices(16);
+
+    recentlyUsedSlices.useSlicesAround(10, 2, 20);
+    recentlyUsedSlices.clear();
+
+    QVERIFY(recentlyUsedSlices.getSlices().isEmpty());
+    QCOMPARE(recentlyUsedSlices.takeLeastRecentlyUsedSlices(), IntList());
+}
+
+DECLARE_TEST(test_RecentlyUsedSlices)
+
+#include "test_recentlyusedslices.moc"
@@ -0,0 +1,222 @@
+#include "autotest.h"
+#include "regiongrower.h"
+
+#include <QProcessEnvironment>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+
+class test_RegionGrower : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void fill_ShouldFillTheRegionConnectedToTheSeed_data();
+    void fill_ShouldFillTheRegionConnectedToTheSeed();
+
+    void fill_ShouldNotGrowOutsideTheExtent();
+
+    void computeMask_ShouldMarkTheRegionWithoutModifyingTheImage_data();
+    void computeMask_ShouldMarkTheRegionWithoutModifyingTheImage();
+
+    void computeMask_ShouldAccumulateRegionsOfSuccessiveSeeds();
+
+    void fill_Benchmark_data();
+    void fill_Benchmark();
+
+private:
+    /// Synthetic masks where the voxels of the regions have value 1 and the rest 0.
+    enum Shape { Filled, TwoBlocks, Comb, Sphere };
+
+    /// Creates a short image of size³ voxels (size² if it's a comb, which is a single slice) with the given shape.
+    vtkSmartPointer<vtkImageData> createImage(Shape shape, int size);
+};
+
+Q_DECLARE_METATYPE(vtkSmartPointer<vtkImageData>)
+
+vtkSmartPointer<vtkImageData> test_RegionGrower::createImage(Shape shape, int size)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, size - 1, 0, size - 1, 0, shape == Comb ? 0 : size - 1);
+    image->AllocateScalars(VTK_SHORT, 1);
+
+    int extent[6];
+    image->GetExtent(extent);
+    double center = (size - 1) / 2.0;
+
+    for (int z = extent[4]; z <= extent[5]; z++)
+    {
+        for (int y = extent[2]; y <= extent[3]; y++)
+        {
+            for (int x = extent[0]; x <= extent[1]; x++)
+            {
+                bool inside = false;
+                switch (shape)
+                {
+                    case Filled:
+                        inside = true;
+                        break;
+                    case TwoBlocks:
+                        // Two halves separated by a plane of background voxels
+                        inside = x != size / 2;
+                        break;
+                    case Comb:
+                        // A spine along the first row with teeth on the even columns
+                        inside = y == 0 || x % 2 == 0;
+                        break;
+                    case Sphere:
+                        inside = (x - center) * (x - center) + (y - center) * (y - center) + (z - center) * (z - center) <= center * center;
+                        break;
+                }
+
+                image->SetScalarComponentFromDouble(x, y, z, 0, inside ? 1.0 : 0.0);
+            }
+        }
+    }
+
+    return image;
+}
+
+void test_RegionGrower::fill_ShouldFillTheRegionConnectedToTheSeed_data()
+{
+    QTest::addColumn<vtkSmartPointer<vtkImageData> >("image");
+    QTest::addColumn<QList<int> >("seed");
+    QTest::addColumn<int>("numberOfThreads");
+    QTest::addColumn<qint64>("expectedNumberOfVoxels");
+
+    for (int numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3)
+    {
+        QString threads = QString(" (%1 threads)").arg(numberOfThreads);
+        QTest::newRow(qPrintable("filled volume" + threads)) << createImage(Filled, 20) << (QList<int>() << 3 << 4 << 5) << numberOfThreads << 8000LL;
+        QTest::newRow(qPrintable("one of two blocks" + threads)) << createImage(TwoBlocks, 20) << (QList<int>() << 15 << 19 << 0) << numberOfThreads
+                                                                  << 9 * 20 * 20LL;
+        QTest::newRow(qPrintable("comb from the tip of the last tooth" + threads)) << createImage(Comb, 9) << (QList<int>() << 8 << 8 << 0) << numberOfThreads
+                                                                                   << 49LL;
+        QTest::newRow(qPrintable("seed out of range" + threads)) << createImage(TwoBlocks, 20) << (QList<int>() << 10 << 0 << 0) << numberOfThreads << 0LL;
+    }
+}
+
+void test_RegionGrower::fill_ShouldFillTheRegionConnectedToTheSeed()
+{
+    QFETCH(vtkSmartPointer<vtkImageData>, image);
+    QFETCH(QList<int>, seed);
+    QFETCH(int, numberOfThreads);
+    QFETCH(qint64, expectedNumberOfVoxels);
+
+    int seedIndex[3] = { seed[0], seed[1], seed[2] };
+    RegionGrower regionGrower;
+    regionGrower.setNumberOfThreads(numberOfThreads);
+
+    QCOMPARE(regionGrower.fill(image, seedIndex, 1.0, 1.0, 2.0), expectedNumberOfVoxels);
+
+    qint64 numberOfFilledVoxels = 0;
+    short *scalars = static_cast<short*>(image->GetScalarPointer());
+    for (vtkIdType i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+        if (scalars[i] == 2)
+        {
+            numberOfFilledVoxels++;
+        }
+    }
+
+    QCOMPARE(numberOfFilledVoxels, expectedNumberOfVoxels);
+}
+
+void test_RegionGrower::fill_ShouldNotGrowOutsideTheExtent()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(Filled, 10);
+    int extent[6] = { 2, 5, -3, 4, 7, 7 };
+    int seed[3] = { 3, 3, 7 };
+
+    RegionGrower regionGrower;
+    regionGrower.setExtent(extent);
+
+    QCOMPARE(regionGrower.fill(image, seed, 1.0, 1.0, 2.0), 4LL * 5LL);
+    QCOMPARE(image->GetScalarComponentAsDouble(2, 0, 7, 0), 2.0);
+    QCOMPARE(image->GetScalarComponentAsDouble(1, 0, 7, 0), 1.0);
+    QCOMPARE(image->GetScalarComponentAsDouble(3, 3, 6, 0), 1.0);
+}
+
+void test_RegionGrower::computeMask_ShouldMarkTheRegionWithoutModifyingTheImage_data()
+{
+    QTest::addColumn<int>("numberOfThreads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("4 threads") << 4;
+}
+
+void test_RegionGrower::computeMask_ShouldMarkTheRegionWithoutModifyingTheImage()
+{
+    QFETCH(int, numberOfThreads);
+
+    vtkSmartPointer<vtkImageData> image = createImage(TwoBlocks, 20);
+    int seed[3] = { 0, 0, 0 };
+
+    RegionGrower regionGrower;
+    regionGrower.setNumberOfThreads(numberOfThreads);
+    QVector<bool> mask;
+
+    QCOMPARE(regionGrower.computeMask(image, seed, 1.0, 1.0, mask), 10LL * 20LL * 20LL);
+    QCOMPARE(mask.size(), 8000);
+    QCOMPARE(mask.count(true), 4000);
+    QVERIFY(mask.at(9));
+    QVERIFY(!mask.at(10));
+    QVERIFY(!mask.at(11));
+    QCOMPARE(image->GetScalarComponentAsDouble(0, 0, 0, 0), 1.0);
+}
+
+void test_RegionGrower::computeMask_ShouldAccumulateRegionsOfSuccessiveSeeds()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(TwoBlocks, 20);
+    int firstSeed[3] = { 0, 0, 0 };
+    int secondSeed[3] = { 19, 19, 19 };
+
+    RegionGrower regionGrower;
+    QVector<bool> mask;
+
+    QCOMPARE(regionGrower.computeMask(image, firstSeed, 1.0, 1.0, mask), 4000LL);
+    QCOMPARE(regionGrower.computeMask(image, firstSeed, 1.0, 1.0, mask), 0LL);
+    QCOMPARE(regionGrower.computeMask(image, secondSeed, 1.0, 1.0, mask), 3600LL);
+    QCOMPARE(mask.count(true), 7600);
+}
+
+void test_RegionGrower::fill_Benchmark_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("numberOfThreads");
+
+    QTest::newRow("sphere 128^3, 1 thread") << 128 << 1;
+    QTest::newRow("sphere 128^3, ideal threads") << 128 << 0;
+    QTest::newRow("sphere 256^3, 1 thread") << 256 << 1;
+    QTest::newRow("sphere 256^3, ideal threads") << 256 << 0;
+}
+
+void test_RegionGrower::fill_Benchmark()
+{
+    QFETCH(int, size);
+    QFETCH(int, numberOfThreads);
+
+    // Filling the larger spheres takes too long for the default run
+    if (size > 128 && !QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Spheres larger than 128^3 are only filled when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    vtkSmartPointer<vtkImageData> sphere = createImage(Sphere, size);
+    int seed[3] = { size / 2, size / 2, size / 2 };
+    RegionGrower regionGrower;
+    regionGrower.setNumberOfThreads(numberOfThreads);
+
+    QBENCHMARK
+    {
+        // Alternate the values so that every iteration fills the whole sphere
+        QVERIFY(regionGrower.fill(sphere, seed, 1.0, 1.0, 2.0) > 0);
+        QVERIFY(regionGrower.fill(sphere, seed, 2.0, 2.0, 1.0) > 0);
+    }
+}
+
+DECLARE_TEST(test_RegionGrower)
+
+#include "test_regiongrower.moc"
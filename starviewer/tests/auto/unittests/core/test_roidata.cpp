@@ -27,6 +27,19 @@ private slots:
     void getMaximum_ReturnsExpectedData_data();
     void getMaximum_ReturnsExpectedData();
 
+    void getMinimum_ReturnsExpectedData_data();
+    void getMinimum_ReturnsExpectedData();
+
+    void getPercentile_ReturnsExpectedData_data();
+    void getPercentile_ReturnsExpectedData();
+
+    void getMedian_ReturnsExpectedData();
+
+    void addValue_ComputesTheSameStatisticsAsAddVoxel();
+
+    void getVoxels_ReturnsVoxelsOnlyIfTheyAreKept_data();
+    void getVoxels_ReturnsVoxelsOnlyIfTheyAreKept();
+
 private:
     ROIData generateROIData();
 };
@@ -46,7 +59,10 @@ void test_ROIData::clear_ShouldInitializeData()
 
     roiData.clear();
     
+    QCOMPARE(roiData.getNumberOfVoxels(), 0LL);
     QCOMPARE(roiData.getMaximum(), 0.0);
+    QCOMPARE(roiData.getMinimum(), 0.0);
+    QCOMPARE(roiData.getMedian(), 0.0);
     QCOMPARE(roiData.getMean(), 0.0);
     QCOMPARE(roiData.getStandardDeviation(), 0.0);
     QCOMPARE(roiData.getUnits(), QString());
@@ -70,6 +86,7 @@ void test_ROIData::addVoxel_EmptyVoxelIsNotAdded()
     roiData.addVoxel(emptyVoxel);
     
     QCOMPARE(meanBeforeAdd, roiData.getMean());
+    QCOMPARE(roiData.getNumberOfVoxels(), 10LL);
 }
 
 void test_ROIData::getMean_ReturnsExpectedData_data()
@@ -120,6 +137,110 @@ void test_ROIData::getMaximum_ReturnsExpectedData()
     QCOMPARE(roiData.getMaximum(), expectedMaximum);
 }
 
+void test_ROIData::getMinimum_ReturnsExpectedData_data()
+{
+    QTest::addColumn<ROIData>("roiData");
+    QTest::addColumn<double>("expectedMinimum");
+
+    QTest::newRow("Random single valued voxels (min)") << generateROIData() << 1.0;
+}
+
+void test_ROIData::getMinimum_ReturnsExpectedData()
+{
+    QFETCH(ROIData, roiData);
+    QFETCH(double, expectedMinimum);
+
+    QCOMPARE(roiData.getMinimum(), expectedMinimum);
+}
+
+void test_ROIData::getPercentile_ReturnsExpectedData_data()
+{
+    QTest::addColumn<ROIData>("roiData");
+    QTest::addColumn<double>("percentile");
+    QTest::addColumn<double>("expectedValue");
+
+    QTest::newRow("0th percentile") << generateROIData() << 0.0 << 1.0;
+    QTest::newRow("25th percentile") << generateROIData() << 25.0 << 3.0;
+    QTest::newRow("90th percentile") << generateROIData() << 90.0 << 9.0;
+    QTest::newRow("100th percentile") << generateROIData() << 100.0 << 10.0;
+}
+
+void test_ROIData::getPercentile_ReturnsExpectedData()
+{
+    QFETCH(ROIData, roiData);
+    QFETCH(double, percentile);
+    QFETCH(double, expectedValue);
+
+    // Percentiles are estimated with a relative error below 1%
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(roiData.getPercentile(percentile), expectedValue, expectedValue * 0.01));
+}
+
+void test_ROIData::getMedian_ReturnsExpectedData()
+{
+    ROIData roiData;
+    for (int i = -500; i <= 500; ++i)
+    {
+        roiData.addValue(i * 2.0);
+    }
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(roiData.getMedian(), 0.0, 1.0e-6));
+
+    roiData.addValue(5000.0);
+    roiData.addValue(6000.0);
+
+    QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(roiData.getMedian(), 2.0, 0.02));
+}
+
+void test_ROIData::addValue_ComputesTheSameStatisticsAsAddVoxel()
+{
+    ROIData voxelROIData = generateROIData();
+
+    ROIData valueROIData;
+    for (int i = 1; i <= 10; ++i)
+    {
+        valueROIData.addValue(i);
+    }
+
+    QCOMPARE(valueROIData.getNumberOfVoxels(), voxelROIData.getNumberOfVoxels());
+    QCOMPARE(valueROIData.getMean(), voxelROIData.getMean());
+    QCOMPARE(valueROIData.getStandardDeviation(), voxelROIData.getStandardDeviation());
+    QCOMPARE(valueROIData.getMinimum(), voxelROIData.getMinimum());
+    QCOMPARE(valueROIData.getMaximum(), voxelROIData.getMaximum());
+    QCOMPARE(valueROIData.getMedian(), voxelROIData.getMedian());
+}
+
+void test_ROIData::getVoxels_ReturnsVoxelsOnlyIfTheyAreKept_data()
+{
+    QTest::addColumn<bool>("keepVoxels");
+    QTest::addColumn<int>("expectedNumberOfVoxels");
+
+    QTest::newRow("voxels not kept") << false << 0;
+    QTest::newRow("voxels kept") << true << 2;
+}
+
+void test_ROIData::getVoxels_ReturnsVoxelsOnlyIfTheyAreKept()
+{
+    QFETCH(bool, keepVoxels);
+    QFETCH(int, expectedNumberOfVoxels);
+
+    ROIData roiData;
+    roiData.setKeepVoxels(keepVoxels);
+
+    Voxel voxel;
+    voxel.addComponent(3.0);
+    roiData.addVoxel(voxel);
+    roiData.addValue(4.0);
+
+    QCOMPARE(roiData.getVoxels().size(), expectedNumberOfVoxels);
+    QCOMPARE(roiData.getNumberOfVoxels(), 2LL);
+
+    if (keepVoxels)
+    {
+        QCOMPARE(roiData.getVoxels().at(0).getComponent(0), 3.0);
+        QCOMPARE(roiData.getVoxels().at(1).getComponent(0), 4.0);
+    }
+}
+
 ROIData test_ROIData::generateROIData()
 {
     ROIData roiData;
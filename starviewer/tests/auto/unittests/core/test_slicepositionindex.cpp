@@ -0,0 +1,132 @@
+#include "autotest.h"
+#include "slicepositionindex.h"
+
+#include "fuzzycomparetesthelper.h"
+#include "image.h"
+#include "imageplane.h"
+#include "mathtools.h"
+#include "volume.h"
+#include "volumetesthelper.h"
+
+#include <QVector3D>
+
+using namespace udg;
+using namespace testing;
+
+class test_SlicePositionIndex : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void getNearestSlice_ShouldReturnSameSliceAsLinearSearch_data();
+    void getNearestSlice_ShouldReturnSameSliceAsLinearSearch();
+
+    void getSlicePositionIndex_ShouldBeRebuiltWhenImagesChange();
+
+private:
+    /// Creates an axial volume with one image for each given z position. If tiltedSlice is a valid slice index, the orientation of that slice is tilted.
+    Volume* createVolume(const QVector<double> &zPositions, int tiltedSlice = -1);
+
+    /// Returns the nearest slice to the given point computing the distance to the image plane of each slice.
+    int getNearestSliceWithLinearSearch(Volume *volume, double point[3], double &distanceToSlice);
+};
+
+Volume* test_SlicePositionIndex::createVolume(const QVector<double> &zPositions, int tiltedSlice)
+{
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    int extent[6] = { 0, 9, 0, 9, 0, zPositions.size() - 1 };
+    Volume *volume = VolumeTestHelper::createVolumeWithParameters(zPositions.size(), 1, zPositions.size(), origin, spacing, extent);
+
+    for (int i = 0; i < zPositions.size(); i++)
+    {
+        Image *image = volume->getImage(i);
+        QVector3D columnVector = i == tiltedSlice ? QVector3D(0.0, 0.8, 0.6) : QVector3D(0.0, 1.0, 0.0);
+        image->setImageOrientationPatient(ImageOrientation(QVector3D(1.0, 0.0, 0.0), columnVector));
+        double position[3] = { 0.0, 0.0, zPositions.at(i) };
+        image->setImagePositionPatient(position);
+    }
+
+    return volume;
+}
+
+int test_SlicePositionIndex::getNearestSliceWithLinearSearch(Volume *volume, double point[3], double &distanceToSlice)
+{
+    int nearestSlice = -1;
+    distanceToSlice = MathTools::DoubleMaximumValue;
+
+    for (int i = 0; i <= volume->getMaximumSlice(OrthogonalPlane::XYPlane); i++)
+    {
+        ImagePlane *imagePlane = volume->getImagePlane(i, OrthogonalPlane::XYPlane);
+        double distance = imagePlane->getDistanceToPoint(point);
+        if (distance < distanceToSlice)
+        {
+            distanceToSlice = distance;
+            nearestSlice = i;
+        }
+        delete imagePlane;
+    }
+
+    return nearestSlice;
+}
+
+void test_SlicePositionIndex::getNearestSlice_ShouldReturnSameSliceAsLinearSearch_data()
+{
+    QTest::addColumn<QVector<double> >("zPositions");
+    QTest::addColumn<int>("tiltedSlice");
+    QTest::addColumn<bool>("expectedSlicesAreParallel");
+
+    QTest::newRow("one slice") << (QVector<double>() << 3.0) << -1 << true;
+    QTest::newRow("ascending positions") << (QVector<double>() << 0.0 << 2.5 << 5.0 << 7.5 << 10.0) << -1 << true;
+    QTest::newRow("descending positions") << (QVector<double>() << 10.0 << 7.5 << 5.0 << 2.5 << 0.0) << -1 << true;
+    QTest::newRow("unordered positions with duplicates") << (QVector<double>() << 4.0 << -1.0 << 4.0 << 9.5 << 0.3 << -1.0) << -1 << true;
+    QTest::newRow("non-parallel slices") << (QVector<double>() << 0.0 << 2.0 << 4.0 << 6.0) << 2 << false;
+}
+
+void test_SlicePositionIndex::getNearestSlice_ShouldReturnSameSliceAsLinearSearch()
+{
+    QFETCH(QVector<double>, zPositions);
+    QFETCH(int, tiltedSlice);
+    QFETCH(bool, expectedSlicesAreParallel);
+
+    Volume *volume = createVolume(zPositions, tiltedSlice);
+    const SlicePositionIndex &slicePositionIndex = volume->getSlicePositionIndex(OrthogonalPlane::XYPlane);
+
+    QCOMPARE(slicePositionIndex.getNumberOfSlices(), zPositions.size());
+    QCOMPARE(slicePositionIndex.areSlicesParallel(), expectedSlicesAreParallel);
+
+    for (double z = -5.0; z <= 15.0; z += 0.25)
+    {
+        double point[3] = { 3.0, -2.0, z };
+        double expectedDistance;
+        int expectedSlice = getNearestSliceWithLinearSearch(volume, point, expectedDistance);
+        double distance;
+        int slice = slicePositionIndex.getNearestSlice(point, distance);
+
+        QCOMPARE(slice, expectedSlice);
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(distance, expectedDistance));
+    }
+
+    VolumeTestHelper::cleanUp(volume);
+}
+
+void test_SlicePositionIndex::getSlicePositionIndex_ShouldBeRebuiltWhenImagesChange()
+{
+    Volume *volume = createVolume(QVector<double>() << 0.0 << 1.0 << 2.0);
+    double point[3] = { 0.0, 0.0, 1.9 };
+    double distance;
+
+    QCOMPARE(volume->getSlicePositionIndex(OrthogonalPlane::XYPlane).getNearestSlice(point, distance), 2);
+
+    QList<Image*> images = volume->getImages();
+    std::swap(images[0], images[2]);
+    volume->setImages(images);
+
+    QCOMPARE(volume->getSlicePositionIndex(OrthogonalPlane::XYPlane).getNearestSlice(point, distance), 0);
+
+    VolumeTestHelper::cleanUp(volume);
+}
+
+DECLARE_TEST(test_SlicePositionIndex)
+
+#include "test_slicepositionindex.moc"
@@ -0,0 +1,257 @@
+#include "autotest.h"
+#include "thumbnailcreator.h"
+
+#include <QImage>
+#include <QProcessEnvironment>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include <dcdatset.h>
+#include <dcdeftag.h>
+#include <dcfilefo.h>
+
+using namespace udg;
+
+class test_ThumbnailCreator : public QObject {
+Q_OBJECT
+
+private slots:
+    void getThumbnail_ShouldReturnASquareThumbnailOfTheGivenResolution_data();
+    void getThumbnail_ShouldReturnASquareThumbnailOfTheGivenResolution();
+
+    void getThumbnail_ShouldCropTheCenterOfTheImage();
+
+    void getThumbnail_ShouldUseTheIconImageWhenItIsBigEnough_data();
+    void getThumbnail_ShouldUseTheIconImageWhenItIsBigEnough();
+
+    void getThumbnail_Benchmark_data();
+    void getThumbnail_Benchmark();
+
+    void getThumbnail_LargeImagesBenchmark_data();
+    void getThumbnail_LargeImagesBenchmark();
+
+private:
+    /// Pixel value functions of the created images.
+    enum PixelPattern { ColumnGradient, RowGradientWithBrightLeftQuarter, Constant };
+
+    /// Creates a 16 bit monochrome DICOM file with the given size, number of frames and pixel pattern.
+    /// If iconSize is greater than 0, the file has an 8 bit icon of that size that is dark on its left half and bright on its right half.
+    static bool createDICOMFile(const QString &filename, const QString &modality, int columns, int rows, int numberOfFrames, PixelPattern pattern,
+                                int iconSize = 0);
+
+    /// Adds the columns of the benchmark data.
+    static void addBenchmarkColumns();
+
+    /// Creates the DICOM file of the current benchmark row and measures the creation of its thumbnail.
+    static void benchmarkGetThumbnail();
+};
+
+bool test_ThumbnailCreator::createDICOMFile(const QString &filename, const QString &modality, int columns, int rows, int numberOfFrames,
+                                            PixelPattern pattern, int iconSize)
+{
+    DcmFileFormat fileFormat;
+    DcmDataset *dataset = fileFormat.getDataset();
+
+    dataset->putAndInsertString(DCM_SOPClassUID, "1.2.840.10008.5.1.4.1.1.7");
+    dataset->putAndInsertString(DCM_SOPInstanceUID, "1.2.3.4.5.6.1");
+    dataset->putAndInsertString(DCM_StudyInstanceUID, "1.2.3.4.5");
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, "1.2.3.4.5.6");
+    dataset->putAndInsertString(DCM_Modality, qPrintable(modality));
+    dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset->putAndInsertString(DCM_NumberOfFrames, qPrintable(QString::number(numberOfFrames)));
+    dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+    dataset->putAndInsertUint16(DCM_Rows, rows);
+    dataset->putAndInsertUint16(DCM_Columns, columns);
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset->putAndInsertUint16(DCM_BitsStored, 12);
+    dataset->putAndInsertUint16(DCM_HighBit, 11);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+
+    QVector<Uint16> pixels(columns * rows * numberOfFrames);
+    for (int i = 0; i < pixels.size(); i++)
+    {
+        int x = i % columns;
+        int y = (i / columns) % rows;
+
+        switch (pattern)
+        {
+            case ColumnGradient:
+                pixels[i] = x * 4000 / columns;
+                break;
+            case RowGradientWithBrightLeftQuarter:
+                pixels[i] = x < columns / 4 ? 4000 : y * 1000 / rows;
+                break;
+            case Constant:
+                pixels[i] = 1000;
+                break;
+        }
+    }
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.constData(), pixels.size());
+
+    if (iconSize > 0)
+    {
+        DcmItem *iconItem = NULL;
+        dataset->findOrCreateSequenceItem(DCM_IconImageSequence, iconItem, -2);
+        iconItem->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+        iconItem->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+        iconItem->putAndInsertUint16(DCM_Rows, iconSize);
+        iconItem->putAndInsertUint16(DCM_Columns, iconSize);
+        iconItem->putAndInsertUint16(DCM_BitsAllocated, 8);
+        iconItem->putAndInsertUint16(DCM_BitsStored, 8);
+        iconItem->putAndInsertUint16(DCM_HighBit, 7);
+        iconItem->putAndInsertUint16(DCM_PixelRepresentation, 0);
+
+        QVector<Uint8> iconPixels(iconSize * iconSize);
+        for (int i = 0; i < iconPixels.size(); i++)
+        {
+            iconPixels[i] = i % iconSize < iconSize / 2 ? 0 : 255;
+        }
+        iconItem->putAndInsertUint8Array(DCM_PixelData, iconPixels.constData(), iconPixels.size());
+    }
+
+    return fileFormat.saveFile(qPrintable(filename), EXS_LittleEndianExplicit).good();
+}
+
+void test_ThumbnailCreator::getThumbnail_ShouldReturnASquareThumbnailOfTheGivenResolution_data()
+{
+    QTest::addColumn<QSize>("imageSize");
+    QTest::addColumn<int>("numberOfFrames");
+    QTest::addColumn<int>("resolution");
+
+    QTest::newRow("square") << QSize(256, 256) << 1 << 96;
+    QTest::newRow("wide") << QSize(300, 120) << 1 << 96;
+    QTest::newRow("tall") << QSize(120, 300) << 1 << 100;
+    QTest::newRow("smaller than the thumbnail") << QSize(40, 30) << 1 << 96;
+    QTest::newRow("multiframe") << QSize(128, 128) << 10 << 96;
+}
+
+void test_ThumbnailCreator::getThumbnail_ShouldReturnASquareThumbnailOfTheGivenResolution()
+{
+    QFETCH(QSize, imageSize);
+    QFETCH(int, numberOfFrames);
+    QFETCH(int, resolution);
+
+    QTemporaryDir directory;
+    QString filename = directory.path() + "/image.dcm";
+    QVERIFY(createDICOMFile(filename, "OT", imageSize.width(), imageSize.height(), numberOfFrames, ColumnGradient));
+
+    QImage thumbnail = ThumbnailCreator().getThumbnail(filename, resolution);
+
+    QCOMPARE(thumbnail.size(), QSize(resolution, resolution));
+    // The gradient goes from black to white
+    QVERIFY(qGray(thumbnail.pixel(0, resolution / 2)) < 64);
+    QVERIFY(qGray(thumbnail.pixel(resolution - 1, resolution / 2)) > 192);
+}
+
+void test_ThumbnailCreator::getThumbnail_ShouldCropTheCenterOfTheImage()
+{
+    QTemporaryDir directory;
+    QString filename = directory.path() + "/image.dcm";
+    // The bright left quarter is outside the centered square, so the window only depends on the row gradient
+    QVERIFY(createDICOMFile(filename, "OT", 200, 100, 1, RowGradientWithBrightLeftQuarter));
+
+    QImage thumbnail = ThumbnailCreator().getThumbnail(filename, 96);
+
+    QCOMPARE(thumbnail.size(), QSize(96, 96));
+    QVERIFY(qGray(thumbnail.pixel(0, 0)) < 64);
+    QVERIFY(qGray(thumbnail.pixel(0, 95)) > 192);
+}
+
+void test_ThumbnailCreator::getThumbnail_ShouldUseTheIconImageWhenItIsBigEnough_data()
+{
+    QTest::addColumn<int>("iconSize");
+    QTest::addColumn<bool>("shouldUseIcon");
+
+    QTest::newRow("no icon") << 0 << false;
+    QTest::newRow("icon smaller than the thumbnail") << 64 << false;
+    QTest::newRow("icon of the same size") << 96 << true;
+    QTest::newRow("icon bigger than the thumbnail") << 128 << true;
+}
+
+void test_ThumbnailCreator::getThumbnail_ShouldUseTheIconImageWhenItIsBigEnough()
+{
+    QFETCH(int, iconSize);
+    QFETCH(bool, shouldUseIcon);
+
+    QTemporaryDir directory;
+    QString filename = directory.path() + "/image.dcm";
+    // The image is uniform and the icon is dark on the left and bright on the right
+    QVERIFY(createDICOMFile(filename, "MG", 512, 512, 1, Constant, iconSize));
+
+    QImage thumbnail = ThumbnailCreator().getThumbnail(filename, 96);
+
+    QCOMPARE(thumbnail.size(), QSize(96, 96));
+    int leftGray = qGray(thumbnail.pixel(10, 48));
+    int rightGray = qGray(thumbnail.pixel(85, 48));
+    if (shouldUseIcon)
+    {
+        QVERIFY(leftGray < 64);
+        QVERIFY(rightGray > 192);
+    }
+    else
+    {
+        QCOMPARE(leftGray, rightGray);
+    }
+}
+
+void test_ThumbnailCreator::getThumbnail_Benchmark_data()
+{
+    addBenchmarkColumns();
+
+    QTest::newRow("CT 512x512") << "CT" << QSize(512, 512) << 1 << 0;
+    QTest::newRow("XA 512x512, 30 frames") << "XA" << QSize(512, 512) << 30 << 0;
+}
+
+void test_ThumbnailCreator::getThumbnail_Benchmark()
+{
+    benchmarkGetThumbnail();
+}
+
+void test_ThumbnailCreator::getThumbnail_LargeImagesBenchmark_data()
+{
+    // Creating and reading these images takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Large images benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    addBenchmarkColumns();
+
+    QTest::newRow("DX 3000x3000") << "DX" << QSize(3000, 3000) << 1 << 0;
+    QTest::newRow("MG 3328x4096") << "MG" << QSize(3328, 4096) << 1 << 0;
+    QTest::newRow("MG 3328x4096 with icon") << "MG" << QSize(3328, 4096) << 1 << 128;
+}
+
+void test_ThumbnailCreator::getThumbnail_LargeImagesBenchmark()
+{
+    benchmarkGetThumbnail();
+}
+
+void test_ThumbnailCreator::addBenchmarkColumns()
+{
+    QTest::addColumn<QString>("modality");
+    QTest::addColumn<QSize>("imageSize");
+    QTest::addColumn<int>("numberOfFrames");
+    QTest::addColumn<int>("iconSize");
+}
+
+void test_ThumbnailCreator::benchmarkGetThumbnail()
+{
+    QFETCH(QString, modality);
+    QFETCH(QSize, imageSize);
+    QFETCH(int, numberOfFrames);
+    QFETCH(int, iconSize);
+
+    QTemporaryDir directory;
+    QString filename = directory.path() + "/image.dcm";
+    QVERIFY(createDICOMFile(filename, modality, imageSize.width(), imageSize.height(), numberOfFrames, ColumnGradient, iconSize));
+
+    QBENCHMARK
+    {
+        QCOMPARE(ThumbnailCreator().getThumbnail(filename).size(), QSize(96, 96));
+    }
+}
+
+DECLARE_TEST(test_ThumbnailCreator)
+
+#include "test_thumbnailcreator.moc"
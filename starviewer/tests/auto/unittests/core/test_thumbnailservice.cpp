@@ -0,0 +1,354 @@
+#include "autotest.h"
+#include "thumbnailservice.h"
+
+#include "image.h"
+#include "series.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+using namespace udg;
+
+class TestingThumbnailService : public ThumbnailService {
+public:
+    /// If true, each decode waits for a release of m_decodeAllowed
+    bool m_waitForDecodeAllowed;
+    mutable QSemaphore m_decodeAllowed;
+    mutable QAtomicInt m_numberOfDecodesStarted;
+    /// Whether the decodes succeed
+    bool m_decodeSucceeds;
+
+    TestingThumbnailService()
+        : m_waitForDecodeAllowed(false), m_decodeSucceeds(true)
+    {
+    }
+
+    /// Returns the files decoded so far, in the order they have been decoded.
+    QStringList getDecodedFiles() const
+    {
+        QMutexLocker locker(&m_decodedFilesMutex);
+        return m_decodedFiles;
+    }
+
+    /// Returns the thumbnail decoded for any file, depending on whether the decode succeeds.
+    QImage getDecodedThumbnail() const
+    {
+        QImage thumbnail(8, 8, QImage::Format_RGB32);
+        thumbnail.fill(m_decodeSucceeds ? Qt::blue : Qt::black);
+
+        return thumbnail;
+    }
+
+protected:
+    virtual QImage decodeThumbnail(const QString &imageFilePath, int resolution, bool &ok) const
+    {
+        Q_UNUSED(resolution);
+
+        m_numberOfDecodesStarted.ref();
+
+        if (m_waitForDecodeAllowed)
+        {
+            m_decodeAllowed.acquire();
+        }
+
+        {
+            QMutexLocker locker(&m_decodedFilesMutex);
+            m_decodedFiles << QFileInfo(imageFilePath).fileName();
+        }
+
+        ok = m_decodeSucceeds;
+        return getDecodedThumbnail();
+    }
+
+private:
+    mutable QMutex m_decodedFilesMutex;
+    mutable QStringList m_decodedFiles;
+};
+
+class test_ThumbnailService : public QObject {
+Q_OBJECT
+
+private slots:
+    void requestThumbnail_ShouldReadTheExistingThumbnailFileOfTheVolume();
+    void requestThumbnail_ShouldFallBackToTheThumbnailFileOfTheSeries();
+    void requestThumbnail_ShouldDeduplicateRequestsOfTheSameThumbnail();
+    void requestThumbnail_ShouldReturnAnEmptyKeyForIconThumbnails_data();
+    void requestThumbnail_ShouldReturnAnEmptyKeyForIconThumbnails();
+    void requestThumbnail_ShouldReturnAnEmptyKeyForSeriesWithoutLoadedImages();
+
+    void requestThumbnail_ShouldServePendingRequestsByPriority();
+
+    void cancelRequest_ShouldNotCreateNorNotifyPendingThumbnail();
+
+    void requestThumbnail_ShouldSaveDecodedThumbnailOnlyUnderPersistentCacheDirectory_data();
+    void requestThumbnail_ShouldSaveDecodedThumbnailOnlyUnderPersistentCacheDirectory();
+
+private:
+    /// Creates an image of the given volume with the given file name in the given directory. The DICOM file itself doesn't exist.
+    Image* createImage(const QString &directory, int volumeNumber, const QString &fileName = "image.dcm");
+
+    /// Saves a thumbnail filled with the given color with the given file name in the given directory.
+    QImage saveThumbnailFile(const QString &directory, const QString &fileName, const QColor &color);
+
+    /// Waits for the pending requests of the given service and delivers their results.
+    void waitForThumbnails(ThumbnailService &service);
+};
+
+Image* test_ThumbnailService::createImage(const QString &directory, int volumeNumber, const QString &fileName)
+{
+    Image *image = new Image(this);
+    image->setPath(directory + "/" + fileName);
+    image->setVolumeNumberInSeries(volumeNumber);
+
+    return image;
+}
+
+QImage test_ThumbnailService::saveThumbnailFile(const QString &directory, const QString &fileName, const QColor &color)
+{
+    QImage thumbnail(8, 8, QImage::Format_RGB32);
+    thumbnail.fill(color);
+    thumbnail.save(directory + "/" + fileName, "PNG");
+
+    return thumbnail;
+}
+
+void test_ThumbnailService::waitForThumbnails(ThumbnailService &service)
+{
+    service.waitForDone();
+    QCoreApplication::processEvents();
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldReadTheExistingThumbnailFileOfTheVolume()
+{
+    QTemporaryDir directory;
+    saveThumbnailFile(directory.path(), "thumbnail.png", Qt::red);
+    QImage expectedThumbnail = saveThumbnailFile(directory.path(), "thumbnail2.png", Qt::green);
+
+    ThumbnailService service;
+    QSignalSpy thumbnailReadySpy(&service, SIGNAL(thumbnailReady(QString, QImage)));
+
+    QString key = service.requestThumbnail(createImage(directory.path(), 2));
+    waitForThumbnails(service);
+
+    QCOMPARE(thumbnailReadySpy.count(), 1);
+    QCOMPARE(thumbnailReadySpy.at(0).at(0).toString(), key);
+    QCOMPARE(thumbnailReadySpy.at(0).at(1).value<QImage>(), expectedThumbnail);
+
+    QImage thumbnail;
+    QVERIFY(service.getThumbnail(key, thumbnail));
+    QCOMPARE(thumbnail, expectedThumbnail);
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldFallBackToTheThumbnailFileOfTheSeries()
+{
+    QTemporaryDir directory;
+    QImage expectedThumbnail = saveThumbnailFile(directory.path(), "thumbnail.png", Qt::red);
+
+    ThumbnailService service;
+    QString key = service.requestThumbnail(createImage(directory.path(), 3));
+    waitForThumbnails(service);
+
+    QImage thumbnail;
+    QVERIFY(service.getThumbnail(key, thumbnail));
+    QCOMPARE(thumbnail, expectedThumbnail);
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldDeduplicateRequestsOfTheSameThumbnail()
+{
+    QTemporaryDir directory;
+    saveThumbnailFile(directory.path(), "thumbnail1.png", Qt::red);
+    saveThumbnailFile(directory.path(), "thumbnail2.png", Qt::green);
+
+    ThumbnailService service;
+    QSignalSpy thumbnailReadySpy(&service, SIGNAL(thumbnailReady(QString, QImage)));
+
+    QString key = service.requestThumbnail(createImage(directory.path(), 1), ThumbnailService::LowPriority);
+    QCOMPARE(service.requestThumbnail(createImage(directory.path(), 1), ThumbnailService::HighPriority), key);
+    QString otherKey = service.requestThumbnail(createImage(directory.path(), 2));
+    QVERIFY(otherKey != key);
+    waitForThumbnails(service);
+
+    QCOMPARE(thumbnailReadySpy.count(), 2);
+
+    // Once in memory, it is not created again
+    QCOMPARE(service.requestThumbnail(createImage(directory.path(), 1)), key);
+    waitForThumbnails(service);
+
+    QCOMPARE(thumbnailReadySpy.count(), 2);
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldReturnAnEmptyKeyForIconThumbnails_data()
+{
+    QTest::addColumn<QString>("modality");
+    QTest::addColumn<bool>("hasImages");
+
+    QTest::newRow("KO") << "KO" << true;
+    QTest::newRow("PR") << "PR" << true;
+    QTest::newRow("SR") << "SR" << true;
+    QTest::newRow("series without images") << "CT" << false;
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldReturnAnEmptyKeyForIconThumbnails()
+{
+    QFETCH(QString, modality);
+    QFETCH(bool, hasImages);
+
+    QTemporaryDir directory;
+    Series series;
+    series.setModality(modality);
+    if (hasImages)
+    {
+        series.addImage(createImage(directory.path(), 1));
+    }
+
+    ThumbnailService service;
+    QVERIFY(service.requestThumbnail(&series).isEmpty());
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldReturnAnEmptyKeyForSeriesWithoutLoadedImages()
+{
+    // Like the series queried from the local database
+    Series series;
+    series.setModality("CT");
+    series.setNumberOfImages(10);
+
+    ThumbnailService service;
+    QVERIFY(service.requestThumbnail(&series).isEmpty());
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldServePendingRequestsByPriority()
+{
+    QTemporaryDir directory;
+
+    TestingThumbnailService service;
+    service.setMaximumThreadCount(1);
+    service.m_waitForDecodeAllowed = true;
+
+    // The only worker takes the first request and waits while the rest are queued
+    service.requestThumbnail(createImage(directory.path(), 1, "first.dcm"), ThumbnailService::LowPriority);
+    QTRY_COMPARE(service.m_numberOfDecodesStarted.load(), 1);
+
+    service.requestThumbnail(createImage(directory.path(), 1, "low.dcm"), ThumbnailService::LowPriority);
+    service.requestThumbnail(createImage(directory.path(), 1, "normal.dcm"), ThumbnailService::NormalPriority);
+    service.requestThumbnail(createImage(directory.path(), 1, "high.dcm"), ThumbnailService::HighPriority);
+    QString raisedKey = service.requestThumbnail(createImage(directory.path(), 1, "raised.dcm"), ThumbnailService::LowPriority);
+    service.requestThumbnail(createImage(directory.path(), 1, "secondHigh.dcm"), ThumbnailService::HighPriority);
+    // Raising the priority puts it after the requests that already had it
+    service.setPriority(raisedKey, ThumbnailService::HighPriority);
+    // Requesting again a pending thumbnail with a higher priority raises it too
+    service.requestThumbnail(createImage(directory.path(), 1, "low.dcm"), ThumbnailService::NormalPriority);
+
+    service.m_decodeAllowed.release(6);
+    waitForThumbnails(service);
+
+    QCOMPARE(service.getDecodedFiles(), QStringList() << "first.dcm" << "high.dcm" << "secondHigh.dcm" << "raised.dcm" << "normal.dcm" << "low.dcm");
+}
+
+void test_ThumbnailService::cancelRequest_ShouldNotCreateNorNotifyPendingThumbnail()
+{
+    QTemporaryDir directory;
+
+    TestingThumbnailService service;
+    service.setMaximumThreadCount(1);
+    service.m_waitForDecodeAllowed = true;
+    QSignalSpy thumbnailReadySpy(&service, SIGNAL(thumbnailReady(QString, QImage)));
+
+    QString runningKey = service.requestThumbnail(createImage(directory.path(), 1, "running.dcm"));
+    QTRY_COMPARE(service.m_numberOfDecodesStarted.load(), 1);
+
+    QString cancelledKey = service.requestThumbnail(createImage(directory.path(), 1, "cancelled.dcm"));
+    QString keptKey = service.requestThumbnail(createImage(directory.path(), 1, "kept.dcm"));
+    service.cancelRequest(cancelledKey);
+    // The thumbnail that is already being created is finished anyway
+    service.cancelRequest(runningKey);
+
+    service.m_decodeAllowed.release(3);
+    waitForThumbnails(service);
+
+    QCOMPARE(service.getDecodedFiles(), QStringList() << "running.dcm" << "kept.dcm");
+    QCOMPARE(thumbnailReadySpy.count(), 2);
+    QCOMPARE(thumbnailReadySpy.at(0).at(0).toString(), runningKey);
+    QCOMPARE(thumbnailReadySpy.at(1).at(0).toString(), keptKey);
+
+    QImage thumbnail;
+    QVERIFY(!service.getThumbnail(cancelledKey, thumbnail));
+
+    // It can be requested again
+    QCOMPARE(service.requestThumbnail(createImage(directory.path(), 1, "cancelled.dcm")), cancelledKey);
+    service.m_decodeAllowed.release(1);
+    waitForThumbnails(service);
+
+    QVERIFY(service.getThumbnail(cancelledKey, thumbnail));
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldSaveDecodedThumbnailOnlyUnderPersistentCacheDirectory_data()
+{
+    QTest::addColumn<bool>("seriesThumbnail");
+    QTest::addColumn<bool>("underPersistentCacheDirectory");
+    QTest::addColumn<bool>("decodeSucceeds");
+    QTest::addColumn<QString>("expectedThumbnailFileName");
+    QTest::addColumn<bool>("expectedSaved");
+
+    QTest::newRow("volume under cache") << false << true << true << "thumbnail1.png" << true;
+    QTest::newRow("volume under cache, not decoded") << false << true << false << "thumbnail1.png" << false;
+    QTest::newRow("volume outside cache") << false << false << true << "thumbnail1.png" << false;
+    QTest::newRow("series under cache") << true << true << true << "thumbnail.png" << true;
+    QTest::newRow("series under cache, not decoded") << true << true << false << "thumbnail.png" << false;
+    QTest::newRow("series outside cache") << true << false << true << "thumbnail.png" << false;
+}
+
+void test_ThumbnailService::requestThumbnail_ShouldSaveDecodedThumbnailOnlyUnderPersistentCacheDirectory()
+{
+    QFETCH(bool, seriesThumbnail);
+    QFETCH(bool, underPersistentCacheDirectory);
+    QFETCH(bool, decodeSucceeds);
+    QFETCH(QString, expectedThumbnailFileName);
+    QFETCH(bool, expectedSaved);
+
+    QTemporaryDir directory;
+    QString persistentCacheDirectory = directory.path() + "/cache";
+    QString seriesDirectory = underPersistentCacheDirectory ? persistentCacheDirectory + "/study/series" : directory.path() + "/other/series";
+    QVERIFY(QDir().mkpath(seriesDirectory));
+
+    TestingThumbnailService service;
+    service.setPersistentCacheDirectory(persistentCacheDirectory);
+    service.m_decodeSucceeds = decodeSucceeds;
+    QSignalSpy thumbnailReadySpy(&service, SIGNAL(thumbnailReady(QString, QImage)));
+
+    Series series;
+    series.setModality("CT");
+    series.addImage(createImage(seriesDirectory, 1));
+
+    if (seriesThumbnail)
+    {
+        service.requestThumbnail(&series);
+    }
+    else
+    {
+        service.requestThumbnail(series.getImages().first());
+    }
+    waitForThumbnails(service);
+
+    // The thumbnail is delivered in any case
+    QCOMPARE(thumbnailReadySpy.count(), 1);
+    QCOMPARE(thumbnailReadySpy.at(0).at(1).value<QImage>(), service.getDecodedThumbnail());
+
+    QString thumbnailFilePath = seriesDirectory + "/" + expectedThumbnailFileName;
+    QCOMPARE(QFileInfo(thumbnailFilePath).exists(), expectedSaved);
+    if (expectedSaved)
+    {
+        QCOMPARE(QImage(thumbnailFilePath).convertToFormat(QImage::Format_RGB32), service.getDecodedThumbnail());
+    }
+    // No other thumbnail file is saved
+    QCOMPARE(QDir(seriesDirectory).entryList(QStringList() << "*.png").size(), expectedSaved ? 1 : 0);
+}
+
+DECLARE_TEST(test_ThumbnailService)
+
+#include "test_thumbnailservice.moc"
@@ -102,6 +102,8 @@ private slots:
 
     void isMultiframe_ShouldReturnTrueForMultiframeVolumes_data();
     void isMultiframe_ShouldReturnTrueForMultiframeVolumes();
+
+    void releasePixelData_ShouldUnloadPixelData();
 };
 
 Q_DECLARE_METATYPE(AnatomicalPlane)
@@ -1284,6 +1286,26 @@ void test_Volume::isMultiframe_ShouldReturnTrueForMultiframeVolumes()
     QCOMPARE(volume->isMultiframe(), isMultiframe);
 }
 
+void test_Volume::releasePixelData_ShouldUnloadPixelData()
+{
+    int dimensions[3] = { 32, 16, 8 };
+    int extent[6] = { 0, 31, 0, 15, 0, 7 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+    Volume volume;
+    volume.setNumberOfPhases(2);
+    volume.setPixelData(VolumePixelDataTestHelper::createVolumePixelData(dimensions, extent, spacing, origin));
+
+    QVERIFY(volume.isPixelDataLoaded());
+    QVERIFY(volume.getPixelDataMemorySize() >= static_cast<qint64>(32 * 16 * 8 * sizeof(short)));
+
+    volume.releasePixelData();
+
+    QVERIFY(!volume.isPixelDataLoaded());
+    QCOMPARE(volume.getPixelDataMemorySize(), Q_INT64_C(0));
+    QCOMPARE(volume.getNumberOfPhases(), 2);
+}
+
 DECLARE_TEST(test_Volume)
 
 #include "test_volume.moc"
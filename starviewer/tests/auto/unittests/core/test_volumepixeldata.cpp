@@ -9,6 +9,11 @@
 
 #include "vtkImageData.h"
 
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+
 using namespace udg;
 using namespace testing;
 
@@ -29,6 +34,13 @@ private slots:
     void setData_ShouldSetDataFromArray_data();
     void setData_ShouldSetDataFromArray();
 
+    void setData_ShouldMapDataFromFile_data();
+    void setData_ShouldMapDataFromFile();
+
+    void setData_ShouldNotMapTooSmallFile();
+
+    void releaseFileMappings_ShouldCopyDataAndUnmapFile();
+
     void convertToNeutralPixelData_ShouldActAsExpected_data();
     void convertToNeutralPixelData_ShouldActAsExpected();
 
@@ -228,6 +240,111 @@ void test_VolumePixelData::setData_ShouldSetDataFromArray()
     delete pixelData;
 }
 
+void test_VolumePixelData::setData_ShouldMapDataFromFile_data()
+{
+    QTest::addColumn<int>("mappingMode");
+
+    QTest::newRow("read only") << static_cast<int>(VolumePixelData::ReadOnlyMapping);
+    QTest::newRow("copy on write") << static_cast<int>(VolumePixelData::CopyOnWriteMapping);
+}
+
+void test_VolumePixelData::setData_ShouldMapDataFromFile()
+{
+    QFETCH(int, mappingMode);
+
+    const qint64 offset = 16;
+    int extent[6] = { 0, 3, 0, 2, 0, 1 };
+    QVector<short> values(4 * 3 * 2);
+    for (int i = 0; i < values.size(); i++)
+    {
+        values[i] = i * 7 - 50;
+    }
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(QByteArray(offset, 'x'));
+    file.write(reinterpret_cast<const char*>(values.constData()), values.size() * sizeof(short));
+    file.flush();
+
+    VolumePixelData *pixelData = new VolumePixelData();
+    QVERIFY(pixelData->setData(file.fileName(), offset, extent, VTK_SHORT, 1, static_cast<VolumePixelData::FileMappingMode>(mappingMode)));
+    QVERIFY(pixelData->isLoaded());
+    QVERIFY(pixelData->isMemoryMapped());
+    QCOMPARE(pixelData->getScalarType(), VTK_SHORT);
+    QCOMPARE(pixelData->getNumberOfPoints(), values.size());
+
+    // The mapping must outlive the pixel data while the VTK data is referenced
+    vtkSmartPointer<vtkImageData> vtkData = pixelData->getVtkData();
+    delete pixelData;
+
+    short *dataPointer = reinterpret_cast<short*>(vtkData->GetScalarPointer());
+    for (int i = 0; i < values.size(); i++)
+    {
+        QCOMPARE(dataPointer[i], values[i]);
+    }
+}
+
+void test_VolumePixelData::setData_ShouldNotMapTooSmallFile()
+{
+    int extent[6] = { 0, 9, 0, 9, 0, 0 };
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(QByteArray(100, 0));
+    file.flush();
+
+    VolumePixelData pixelData;
+    vtkImageData *vtkOldData = pixelData.getVtkData();
+
+    QVERIFY(!pixelData.setData(file.fileName(), 0, extent, VTK_SHORT, 1));
+    QVERIFY(!pixelData.isMemoryMapped());
+    QCOMPARE(pixelData.getVtkData(), vtkOldData);
+}
+
+void test_VolumePixelData::releaseFileMappings_ShouldCopyDataAndUnmapFile()
+{
+    int extent[6] = { 0, 3, 0, 2, 0, 1 };
+    QVector<short> values(4 * 3 * 2);
+    for (int i = 0; i < values.size(); i++)
+    {
+        values[i] = i * 7 - 50;
+    }
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    QString fileName = directory.path() + "/volume.raw";
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(reinterpret_cast<const char*>(values.constData()), values.size() * sizeof(short));
+    file.close();
+
+    VolumePixelData *pixelData = new VolumePixelData();
+    VolumePixelData otherPixelData;
+    QVERIFY(pixelData->setData(fileName, 0, extent, VTK_SHORT, 1));
+    QVERIFY(otherPixelData.setData(fileName, 0, extent, VTK_SHORT, 1));
+
+    // Relative paths refer to the same file
+    QVERIFY(VolumePixelData::releaseFileMappings(QDir(QDir::currentPath()).relativeFilePath(fileName)));
+    QVERIFY(!pixelData->isMemoryMapped());
+    QVERIFY(!otherPixelData.isMemoryMapped());
+
+    // The file can be removed and the data is kept
+    QVERIFY(QFile::remove(fileName));
+
+    short *dataPointer = reinterpret_cast<short*>(pixelData->getScalarPointer());
+    short *otherDataPointer = reinterpret_cast<short*>(otherPixelData.getScalarPointer());
+    for (int i = 0; i < values.size(); i++)
+    {
+        QCOMPARE(dataPointer[i], values[i]);
+        QCOMPARE(otherDataPointer[i], values[i]);
+    }
+
+    // Nothing is left to release, and the copies are freed with the pixel data
+    QVERIFY(VolumePixelData::releaseFileMappings(fileName));
+    delete pixelData;
+}
+
 void test_VolumePixelData::convertToNeutralPixelData_ShouldActAsExpected_data()
 {
     QTest::addColumn<VolumePixelData*>("volumePixelData");
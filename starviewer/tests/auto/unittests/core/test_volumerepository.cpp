@@ -0,0 +1,205 @@
+#include "autotest.h"
+#include "volumerepository.h"
+
+#include "volume.h"
+#include "volumepixeldatatesthelper.h"
+
+using namespace udg;
+using namespace testing;
+
+class test_VolumeRepository : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void enforceMemoryBudget_ShouldReleaseLeastRecentlyDisplayedVolumesFirst();
+
+    void enforceMemoryBudget_ShouldNotReleaseDisplayedOrPinnedVolumes();
+
+    void unpinPixelData_ShouldReleasePixelDataIfBudgetIsExceeded();
+
+    void getMemoryUsage_ShouldReturnSizeOfLoadedPixelData();
+
+    void getCacheStatistics_ShouldCountHitsMissesAndEvictions();
+
+private:
+    /// Creates a volume with loaded pixel data, adds it to the repository and returns it. It's deleted from the repository in cleanup().
+    Volume* addVolume();
+
+private:
+    VolumeRepository *m_repository;
+    QList<Identifier> m_addedVolumes;
+};
+
+void test_VolumeRepository::initTestCase()
+{
+    m_repository = VolumeRepository::getRepository();
+
+    // The repository is a singleton and other tests may have left volumes in it. The expected memory usage and evictions assume that only the volumes of
+    // these tests have pixel data loaded.
+    QCOMPARE(m_repository->getMemoryUsage(), Q_INT64_C(0));
+}
+
+void test_VolumeRepository::init()
+{
+    m_repository->setMemoryBudget(0);
+    m_repository->resetCacheStatistics();
+}
+
+void test_VolumeRepository::cleanup()
+{
+    foreach (const Identifier &id, m_addedVolumes)
+    {
+        m_repository->deleteVolume(id);
+    }
+
+    m_addedVolumes.clear();
+    m_repository->setMemoryBudget(0);
+}
+
+void test_VolumeRepository::enforceMemoryBudget_ShouldReleaseLeastRecentlyDisplayedVolumesFirst()
+{
+    Volume *volume1 = addVolume();
+    Volume *volume2 = addVolume();
+    Volume *volume3 = addVolume();
+    qint64 size = volume1->getPixelDataMemorySize();
+
+    // Least recently displayed first: volume2, volume1, volume3
+    foreach (Volume *volume, QList<Volume*>() << volume2 << volume1 << volume3)
+    {
+        m_repository->volumeDisplayed(volume);
+        m_repository->volumeNoLongerDisplayed(volume);
+    }
+
+    m_repository->setMemoryBudget(2 * size);
+
+    QVERIFY(!volume2->isPixelDataLoaded());
+    QVERIFY(volume1->isPixelDataLoaded());
+    QVERIFY(volume3->isPixelDataLoaded());
+
+    m_repository->setMemoryBudget(size);
+
+    QVERIFY(!volume1->isPixelDataLoaded());
+    QVERIFY(volume3->isPixelDataLoaded());
+    QCOMPARE(m_repository->getMemoryUsage(), size);
+}
+
+void test_VolumeRepository::enforceMemoryBudget_ShouldNotReleaseDisplayedOrPinnedVolumes()
+{
+    Volume *displayedVolume = addVolume();
+    Volume *pinnedVolume = addVolume();
+    Volume *volume = addVolume();
+
+    m_repository->volumeDisplayed(displayedVolume);
+    m_repository->pinPixelData(pinnedVolume);
+    QVERIFY(m_repository->isPixelDataPinned(pinnedVolume));
+
+    // The budget can't be respected, but only the volume that is neither displayed nor pinned can be released
+    m_repository->setMemoryBudget(1);
+
+    QVERIFY(displayedVolume->isPixelDataLoaded());
+    QVERIFY(pinnedVolume->isPixelDataLoaded());
+    QVERIFY(!volume->isPixelDataLoaded());
+
+    m_repository->volumeNoLongerDisplayed(displayedVolume);
+
+    QVERIFY(!displayedVolume->isPixelDataLoaded());
+    QVERIFY(pinnedVolume->isPixelDataLoaded());
+
+    m_repository->unpinPixelData(pinnedVolume);
+}
+
+void test_VolumeRepository::unpinPixelData_ShouldReleasePixelDataIfBudgetIsExceeded()
+{
+    Volume *volume = addVolume();
+
+    m_repository->pinPixelData(volume);
+    m_repository->pinPixelData(volume);
+    m_repository->setMemoryBudget(1);
+
+    m_repository->unpinPixelData(volume);
+
+    QVERIFY(m_repository->isPixelDataPinned(volume));
+    QVERIFY(volume->isPixelDataLoaded());
+
+    m_repository->unpinPixelData(volume);
+
+    QVERIFY(!m_repository->isPixelDataPinned(volume));
+    QVERIFY(!volume->isPixelDataLoaded());
+}
+
+void test_VolumeRepository::getMemoryUsage_ShouldReturnSizeOfLoadedPixelData()
+{
+    Volume *volume1 = addVolume();
+    Volume *volume2 = addVolume();
+
+    QVERIFY(volume1->getPixelDataMemorySize() > 0);
+    QCOMPARE(m_repository->getMemoryUsage(), volume1->getPixelDataMemorySize() + volume2->getPixelDataMemorySize());
+
+    volume1->releasePixelData();
+
+    QCOMPARE(m_repository->getMemoryUsage(), volume2->getPixelDataMemorySize());
+}
+
+void test_VolumeRepository::getCacheStatistics_ShouldCountHitsMissesAndEvictions()
+{
+    Volume *volume1 = addVolume();
+    Volume *volume2 = addVolume();
+    qint64 size = volume1->getPixelDataMemorySize();
+
+    // Displayed with the pixel data in memory: hit. Displaying it in a second viewer isn't counted again.
+    m_repository->volumeDisplayed(volume1);
+    m_repository->volumeDisplayed(volume1);
+    m_repository->volumeNoLongerDisplayed(volume1);
+    m_repository->volumeNoLongerDisplayed(volume1);
+    m_repository->volumeDisplayed(volume2);
+    m_repository->volumeNoLongerDisplayed(volume2);
+
+    QCOMPARE(m_repository->getCacheStatistics().hits, 2);
+    QCOMPARE(m_repository->getCacheStatistics().misses, 0);
+    QCOMPARE(m_repository->getCacheStatistics().evictions, 0);
+
+    m_repository->setMemoryBudget(size);
+
+    QCOMPARE(m_repository->getCacheStatistics().evictions, 1);
+    QCOMPARE(m_repository->getCacheStatistics().bytesEvicted, size);
+    QVERIFY(!volume1->isPixelDataLoaded());
+
+    // Displayed after its pixel data has been released: miss
+    m_repository->volumeDisplayed(volume1);
+
+    QCOMPARE(m_repository->getCacheStatistics().hits, 2);
+    QCOMPARE(m_repository->getCacheStatistics().misses, 1);
+
+    m_repository->volumeNoLongerDisplayed(volume1);
+    m_repository->resetCacheStatistics();
+
+    QCOMPARE(m_repository->getCacheStatistics().hits, 0);
+    QCOMPARE(m_repository->getCacheStatistics().misses, 0);
+    QCOMPARE(m_repository->getCacheStatistics().evictions, 0);
+    QCOMPARE(m_repository->getCacheStatistics().bytesEvicted, Q_INT64_C(0));
+}
+
+Volume* test_VolumeRepository::addVolume()
+{
+    int dimensions[3] = { 64, 64, 32 };
+    int extent[6] = { 0, 63, 0, 63, 0, 31 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+
+    Volume *volume = new Volume();
+    volume->setPixelData(VolumePixelDataTestHelper::createVolumePixelData(dimensions, extent, spacing, origin));
+    Identifier id = m_repository->addVolume(volume);
+    volume->setIdentifier(id);
+    m_addedVolumes << id;
+
+    return volume;
+}
+
+DECLARE_TEST(test_VolumeRepository)
+
+#include "test_volumerepository.moc"
@@ -0,0 +1,247 @@
+#include "autotest.h"
+#include "voxelshaderchain.h"
+
+#include "ambientvoxelshader.h"
+#include "fuzzycomparetesthelper.h"
+#include "obscurance.h"
+#include "obscurancevoxelshader.h"
+#include "transferfunction.h"
+#include "vtkVolumeRayCastSingleVoxelShaderCompositeFunction.h"
+#include "voxelshadertesthelper.h"
+#include "vtkVolumeRayCastVoxelShaderCompositeFunction.h"
+
+#include <vtkSmartPointer.h>
+
+using namespace udg;
+using namespace testing;
+
+typedef VoxelShaderChain<AmbientVoxelShader, ObscuranceVoxelShader> AmbientObscuranceVoxelShader;
+typedef vtkVolumeRayCastSingleVoxelShaderCompositeFunction<AmbientObscuranceVoxelShader> AmbientObscuranceCompositeFunction;
+
+namespace {
+
+/// Volume of size³ voxels with a textured sphere, obscurances and the ambient and obscurance voxel shaders that paint it.
+class TestVolume {
+
+public:
+    TestVolume(int size)
+        : m_size(size), m_data(size * size * size), m_obscurance(size * size * size)
+    {
+        double center = (size - 1) / 2.0;
+        double radius = size / 3.0;
+        int i = 0;
+
+        for (int z = 0; z < size; z++)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                for (int x = 0; x < size; x++, i++)
+                {
+                    double distance2 = (x - center) * (x - center) + (y - center) * (y - center) + (z - center) * (z - center);
+                    m_data[i] = distance2 <= radius * radius ? 500 + (7 * x + 13 * y + 3 * z) % 500 : 0;
+                    m_obscurance.setObscurance(i, (i % 97) / 96.0);
+                }
+            }
+        }
+
+        TransferFunction transferFunction;
+        transferFunction.set(0.0, Qt::black, 0.0);
+        transferFunction.set(499.0, Qt::black, 0.0);
+        transferFunction.set(500.0, Qt::red, 0.05);
+        transferFunction.set(999.0, Qt::white, 0.2);
+
+        m_ambientVoxelShader.setData(m_data.constData(), 999);
+        m_ambientVoxelShader.setTransferFunction(transferFunction);
+        m_obscuranceVoxelShader.setData(m_data.constData(), 999);
+        m_obscuranceVoxelShader.setTransferFunction(transferFunction);
+        m_obscuranceVoxelShader.setObscurance(&m_obscurance);
+        m_obscuranceVoxelShader.setFactor(0.8);
+        m_voxelShaderChain.setVoxelShaders(&m_ambientVoxelShader, &m_obscuranceVoxelShader);
+    }
+
+    int m_size;
+    QVector<unsigned short> m_data;
+    Obscurance m_obscurance;
+    AmbientVoxelShader m_ambientVoxelShader;
+    ObscuranceVoxelShader m_obscuranceVoxelShader;
+    AmbientObscuranceVoxelShader m_voxelShaderChain;
+
+};
+
+}
+
+class test_VoxelShaderChain : public QObject {
+Q_OBJECT
+
+private slots:
+    void nvShade_ShouldGiveTheSameColorAsApplyingTheVoxelShadersInOrder();
+    void nvShade_ShouldGiveTheSameInterpolatedColorAsApplyingTheVoxelShadersInOrder();
+
+    void toString_ShouldListTheChainedVoxelShaders();
+
+    void castRay_ShouldGiveTheSameImageAsTheVoxelShaderListFunction_data();
+    void castRay_ShouldGiveTheSameImageAsTheVoxelShaderListFunction();
+
+    void castRay_Benchmark_data();
+    void castRay_Benchmark();
+
+private:
+    /// Returns true if both colors are equal up to rounding.
+    bool fuzzyCompare(const HdrColor &color1, const HdrColor &color2);
+
+    /// Creates the composite function that calls the voxel shaders of the volume through a list of virtual voxel shaders.
+    vtkSmartPointer<vtkVolumeRayCastVoxelShaderCompositeFunction> createListFunction(TestVolume &volume, bool classifyFirst);
+    /// Creates the composite function that calls the voxel shaders of the volume through the voxel shader chain.
+    vtkSmartPointer<AmbientObscuranceCompositeFunction> createFusedFunction(TestVolume &volume, bool classifyFirst);
+};
+
+bool test_VoxelShaderChain::fuzzyCompare(const HdrColor &color1, const HdrColor &color2)
+{
+    return FuzzyCompareTestHelper::fuzzyCompare(color1.red, color2.red, 1e-6) && FuzzyCompareTestHelper::fuzzyCompare(color1.green, color2.green, 1e-6)
+        && FuzzyCompareTestHelper::fuzzyCompare(color1.blue, color2.blue, 1e-6) && FuzzyCompareTestHelper::fuzzyCompare(color1.alpha, color2.alpha, 1e-6);
+}
+
+vtkSmartPointer<vtkVolumeRayCastVoxelShaderCompositeFunction> test_VoxelShaderChain::createListFunction(TestVolume &volume, bool classifyFirst)
+{
+    vtkSmartPointer<vtkVolumeRayCastVoxelShaderCompositeFunction> function = vtkSmartPointer<vtkVolumeRayCastVoxelShaderCompositeFunction>::New();
+    function->AddVoxelShader(&volume.m_ambientVoxelShader);
+    function->AddVoxelShader(&volume.m_obscuranceVoxelShader);
+
+    if (classifyFirst)
+    {
+        function->SetCompositeMethodToClassifyFirst();
+    }
+    else
+    {
+        function->SetCompositeMethodToInterpolateFirst();
+    }
+
+    return function;
+}
+
+vtkSmartPointer<AmbientObscuranceCompositeFunction> test_VoxelShaderChain::createFusedFunction(TestVolume &volume, bool classifyFirst)
+{
+    vtkSmartPointer<AmbientObscuranceCompositeFunction> function = vtkSmartPointer<AmbientObscuranceCompositeFunction>::New();
+    function->SetVoxelShader(&volume.m_voxelShaderChain);
+
+    if (classifyFirst)
+    {
+        function->SetCompositeMethodToClassifyFirst();
+    }
+    else
+    {
+        function->SetCompositeMethodToInterpolateFirst();
+    }
+
+    return function;
+}
+
+void test_VoxelShaderChain::nvShade_ShouldGiveTheSameColorAsApplyingTheVoxelShadersInOrder()
+{
+    TestVolume volume(16);
+    Vector3 direction(0.0, 0.0, 1.0);
+
+    for (int offset = 0; offset < volume.m_data.size(); offset += 7)
+    {
+        Vector3 position(offset % 16, (offset / 16) % 16, offset / 256);
+        HdrColor ambientColor = volume.m_ambientVoxelShader.nvShade(position, offset, direction, 1.0f);
+        HdrColor expectedColor = volume.m_obscuranceVoxelShader.nvShade(position, offset, direction, 1.0f, ambientColor);
+
+        QVERIFY(fuzzyCompare(volume.m_voxelShaderChain.nvShade(position, offset, direction, 1.0f), expectedColor));
+        QVERIFY(fuzzyCompare(volume.m_voxelShaderChain.shade(position, offset, direction, 1.0f), expectedColor));
+    }
+}
+
+void test_VoxelShaderChain::nvShade_ShouldGiveTheSameInterpolatedColorAsApplyingTheVoxelShadersInOrder()
+{
+    TestVolume volume(16);
+    Vector3 direction(0.0, 0.0, 1.0);
+    TrilinearInterpolator interpolator;
+    interpolator.setIncrements(1, 16, 256);
+
+    for (double z = 0.0; z < 14.0; z += 0.7)
+    {
+        Vector3 position(7.25, 8.5, z);
+        HdrColor ambientColor = volume.m_ambientVoxelShader.nvShade(position, direction, &interpolator, 1.0f);
+        HdrColor expectedColor = volume.m_obscuranceVoxelShader.nvShade(position, direction, &interpolator, 1.0f, ambientColor);
+
+        QVERIFY(fuzzyCompare(volume.m_voxelShaderChain.nvShade(position, direction, &interpolator, 1.0f), expectedColor));
+    }
+}
+
+void test_VoxelShaderChain::toString_ShouldListTheChainedVoxelShaders()
+{
+    TestVolume volume(4);
+    QCOMPARE(volume.m_voxelShaderChain.toString(), QString("VoxelShaderChain<AmbientVoxelShader, ObscuranceVoxelShader>"));
+
+    AmbientObscuranceVoxelShader emptyChain;
+    QCOMPARE(emptyChain.toString(), QString("VoxelShaderChain<null, null>"));
+}
+
+void test_VoxelShaderChain::castRay_ShouldGiveTheSameImageAsTheVoxelShaderListFunction_data()
+{
+    QTest::addColumn<bool>("interpolation");
+    QTest::addColumn<bool>("classifyFirst");
+
+    QTest::newRow("nearest") << false << false;
+    QTest::newRow("linear, classify first") << true << true;
+    QTest::newRow("linear, interpolate first") << true << false;
+}
+
+void test_VoxelShaderChain::castRay_ShouldGiveTheSameImageAsTheVoxelShaderListFunction()
+{
+    QFETCH(bool, interpolation);
+    QFETCH(bool, classifyFirst);
+
+    TestVolume volume(32);
+    QVector<float> expectedColors = VoxelShaderTestHelper::castFrame(createListFunction(volume, classifyFirst), volume.m_size, interpolation);
+    QVector<float> colors = VoxelShaderTestHelper::castFrame(createFusedFunction(volume, classifyFirst), volume.m_size, interpolation);
+
+    QCOMPARE(colors.size(), expectedColors.size());
+
+    for (int i = 0; i < colors.size(); i++)
+    {
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(colors.at(i), expectedColors.at(i), 1e-5));
+    }
+}
+
+void test_VoxelShaderChain::castRay_Benchmark_data()
+{
+    QTest::addColumn<bool>("interpolation");
+    QTest::addColumn<bool>("classifyFirst");
+    QTest::addColumn<bool>("fused");
+
+    QTest::newRow("nearest, voxel shader list") << false << false << false;
+    QTest::newRow("nearest, voxel shader chain") << false << false << true;
+    QTest::newRow("linear, classify first, voxel shader list") << true << true << false;
+    QTest::newRow("linear, classify first, voxel shader chain") << true << true << true;
+    QTest::newRow("linear, interpolate first, voxel shader list") << true << false << false;
+    QTest::newRow("linear, interpolate first, voxel shader chain") << true << false << true;
+}
+
+void test_VoxelShaderChain::castRay_Benchmark()
+{
+    QFETCH(bool, interpolation);
+    QFETCH(bool, classifyFirst);
+    QFETCH(bool, fused);
+
+    TestVolume volume(128);
+    vtkSmartPointer<vtkVolumeRayCastFunction> function;
+    if (fused)
+    {
+        function = createFusedFunction(volume, classifyFirst).GetPointer();
+    }
+    else
+    {
+        function = createListFunction(volume, classifyFirst).GetPointer();
+    }
+
+    QBENCHMARK
+    {
+        VoxelShaderTestHelper::castFrame(function, volume.m_size, interpolation);
+    }
+}
+
+DECLARE_TEST(test_VoxelShaderChain)
+
+#include "test_voxelshaderchain.moc"
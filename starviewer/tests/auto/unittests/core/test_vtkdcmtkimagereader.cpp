@@ -0,0 +1,254 @@
+#include "autotest.h"
+#include "vtkdcmtkimagereader.h"
+
+#include "dicomfiletesthelper.h"
+
+#include <QTemporaryDir>
+
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkStringArray.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace udg;
+using namespace testing;
+
+class test_VtkDcmtkImageReader : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void update_ShouldNotifySlicesInExpectedOrder_data();
+    void update_ShouldNotifySlicesInExpectedOrder();
+
+    void update_InParallelShouldNotifyEachSliceOnce_data();
+    void update_InParallelShouldNotifyEachSliceOnce();
+
+    void update_InParallelShouldReturnSameOutputAsSerially_data();
+    void update_InParallelShouldReturnSameOutputAsSerially();
+
+private:
+    /// Reads the given files (or multiframe file if there is only one) with the given number of decoding threads and returns the output.
+    /// If the update extent is not empty only that extent is read.
+    static vtkSmartPointer<vtkImageData> read(const QStringList &files, const QList<int> &frameNumbers, const QVector<int> &updateExtent,
+                                              int firstSliceToLoad, int numberOfDecodingThreads, QVector<int> *notifiedSlices = 0);
+    /// Appends the slice notified by SliceLoadedEvent to the QVector<int> given as client data.
+    static void appendNotifiedSlice(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
+};
+
+namespace {
+
+const int NumberOfSlices = 12;
+const int ImageSize = 32;
+
+}
+
+void test_VtkDcmtkImageReader::update_ShouldNotifySlicesInExpectedOrder_data()
+{
+    QTest::addColumn<bool>("multiframe");
+    QTest::addColumn<int>("firstSliceToLoad");
+    QTest::addColumn<QVector<int>>("expectedSlices");
+
+    QVector<int> naturalOrder;
+    for (int i = 0; i < NumberOfSlices; i++)
+    {
+        naturalOrder << i;
+    }
+
+    QVector<int> fromMiddle = QVector<int>() << 6 << 7 << 5 << 8 << 4 << 9 << 3 << 10 << 2 << 11 << 1 << 0;
+    QVector<int> fromEnd = QVector<int>() << 11 << 10 << 9 << 8 << 7 << 6 << 5 << 4 << 3 << 2 << 1 << 0;
+
+    QTest::newRow("files, not progressive") << false << -1 << QVector<int>();
+    QTest::newRow("files, from first") << false << 0 << naturalOrder;
+    QTest::newRow("files, from middle") << false << 6 << fromMiddle;
+    QTest::newRow("files, from last") << false << NumberOfSlices - 1 << fromEnd;
+    QTest::newRow("multiframe, not progressive") << true << -1 << QVector<int>();
+    QTest::newRow("multiframe, from middle") << true << 6 << fromMiddle;
+}
+
+void test_VtkDcmtkImageReader::update_ShouldNotifySlicesInExpectedOrder()
+{
+    QFETCH(bool, multiframe);
+    QFETCH(int, firstSliceToLoad);
+    QFETCH(QVector<int>, expectedSlices);
+
+    QTemporaryDir directory;
+    QStringList files;
+
+    if (multiframe)
+    {
+        files << directory.path() + "/multiframe.dcm";
+        QVERIFY(DICOMFileTestHelper::createMultiframeImage(files.first(), NumberOfSlices, ImageSize));
+    }
+    else
+    {
+        files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", NumberOfSlices, ImageSize);
+        QVERIFY(!files.isEmpty());
+    }
+
+    // Serial decoding loads the slices exactly in the loading order
+    QVector<int> notifiedSlices;
+    read(files, QList<int>(), QVector<int>(), firstSliceToLoad, 1, &notifiedSlices);
+
+    QCOMPARE(notifiedSlices, expectedSlices);
+}
+
+void test_VtkDcmtkImageReader::update_InParallelShouldNotifyEachSliceOnce_data()
+{
+    QTest::addColumn<int>("firstSliceToLoad");
+    QTest::addColumn<int>("expectedNumberOfNotifiedSlices");
+
+    QTest::newRow("not progressive") << -1 << 0;
+    QTest::newRow("progressive") << 6 << NumberOfSlices;
+}
+
+void test_VtkDcmtkImageReader::update_InParallelShouldNotifyEachSliceOnce()
+{
+    QFETCH(int, firstSliceToLoad);
+    QFETCH(int, expectedNumberOfNotifiedSlices);
+
+    QTemporaryDir directory;
+    QStringList files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", NumberOfSlices, ImageSize);
+    QVERIFY(!files.isEmpty());
+
+    QVector<int> notifiedSlices;
+    read(files, QList<int>(), QVector<int>(), firstSliceToLoad, 4, &notifiedSlices);
+
+    QCOMPARE(notifiedSlices.size(), expectedNumberOfNotifiedSlices);
+
+    std::sort(notifiedSlices.begin(), notifiedSlices.end());
+    for (int i = 0; i < notifiedSlices.size(); i++)
+    {
+        QCOMPARE(notifiedSlices.at(i), i);
+    }
+}
+
+void test_VtkDcmtkImageReader::update_InParallelShouldReturnSameOutputAsSerially_data()
+{
+    QTest::addColumn<bool>("multiframe");
+    QTest::addColumn<QList<int>>("frameNumbers");
+    QTest::addColumn<QVector<int>>("updateExtent");
+    QTest::addColumn<int>("firstSliceToLoad");
+
+    QList<int> reversedFrameNumbers;
+    for (int i = NumberOfSlices - 1; i >= 0; i--)
+    {
+        reversedFrameNumbers << i;
+    }
+
+    QVector<int> wholeExtent;
+    QVector<int> partialExtent = QVector<int>() << 0 << ImageSize - 1 << 0 << ImageSize - 1 << 3 << 8;
+
+    QTest::newRow("files") << false << QList<int>() << wholeExtent << -1;
+    QTest::newRow("files, partial extent") << false << QList<int>() << partialExtent << -1;
+    QTest::newRow("files, first slice to load") << false << QList<int>() << wholeExtent << NumberOfSlices / 2;
+    QTest::newRow("files, partial extent, first slice to load") << false << QList<int>() << partialExtent << 7;
+    QTest::newRow("multiframe") << true << QList<int>() << wholeExtent << -1;
+    QTest::newRow("multiframe, frame numbers") << true << reversedFrameNumbers << wholeExtent << -1;
+    QTest::newRow("multiframe, partial extent") << true << QList<int>() << partialExtent << -1;
+    QTest::newRow("multiframe, frame numbers, partial extent, first slice to load") << true << reversedFrameNumbers << partialExtent << 5;
+}
+
+void test_VtkDcmtkImageReader::update_InParallelShouldReturnSameOutputAsSerially()
+{
+    QFETCH(bool, multiframe);
+    QFETCH(QList<int>, frameNumbers);
+    QFETCH(QVector<int>, updateExtent);
+    QFETCH(int, firstSliceToLoad);
+
+    QTemporaryDir directory;
+    QStringList files;
+
+    if (multiframe)
+    {
+        files << directory.path() + "/multiframe.dcm";
+        QVERIFY(DICOMFileTestHelper::createMultiframeImage(files.first(), NumberOfSlices, ImageSize));
+    }
+    else
+    {
+        files = DICOMFileTestHelper::createCTSeries(directory.path(), "1.2.3.4.5.6", NumberOfSlices, ImageSize);
+        QVERIFY(!files.isEmpty());
+    }
+
+    vtkSmartPointer<vtkImageData> serialOutput = read(files, frameNumbers, updateExtent, firstSliceToLoad, 1);
+    vtkSmartPointer<vtkImageData> parallelOutput = read(files, frameNumbers, updateExtent, firstSliceToLoad, 4);
+
+    int serialExtent[6], parallelExtent[6];
+    serialOutput->GetExtent(serialExtent);
+    parallelOutput->GetExtent(parallelExtent);
+
+    for (int i = 0; i < 6; i++)
+    {
+        QCOMPARE(parallelExtent[i], serialExtent[i]);
+
+        if (!updateExtent.isEmpty())
+        {
+            QCOMPARE(serialExtent[i], updateExtent.at(i));
+        }
+    }
+
+    QCOMPARE(parallelOutput->GetScalarType(), serialOutput->GetScalarType());
+
+    size_t size = static_cast<size_t>(serialOutput->GetNumberOfPoints()) * serialOutput->GetNumberOfScalarComponents() * serialOutput->GetScalarSize();
+    QVERIFY(std::memcmp(parallelOutput->GetScalarPointer(), serialOutput->GetScalarPointer(), size) == 0);
+}
+
+vtkSmartPointer<vtkImageData> test_VtkDcmtkImageReader::read(const QStringList &files, const QList<int> &frameNumbers, const QVector<int> &updateExtent,
+                                                             int firstSliceToLoad, int numberOfDecodingThreads, QVector<int> *notifiedSlices)
+{
+    vtkSmartPointer<VtkDcmtkImageReader> reader = vtkSmartPointer<VtkDcmtkImageReader>::New();
+
+    if (notifiedSlices)
+    {
+        vtkSmartPointer<vtkCallbackCommand> callback = vtkSmartPointer<vtkCallbackCommand>::New();
+        callback->SetCallback(appendNotifiedSlice);
+        callback->SetClientData(notifiedSlices);
+        reader->AddObserver(VtkDcmtkImageReader::SliceLoadedEvent, callback);
+    }
+
+    if (files.size() > 1)
+    {
+        vtkSmartPointer<vtkStringArray> fileNames = vtkSmartPointer<vtkStringArray>::New();
+
+        foreach (const QString &file, files)
+        {
+            fileNames->InsertNextValue(file.toStdString());
+        }
+
+        reader->SetFileNames(fileNames);
+    }
+    else
+    {
+        reader->SetFileName(qPrintable(files.first()));
+    }
+
+    reader->setFrameNumbers(frameNumbers);
+    reader->setFirstSliceToLoad(firstSliceToLoad);
+    reader->setNumberOfDecodingThreads(numberOfDecodingThreads);
+
+    if (!updateExtent.isEmpty())
+    {
+        reader->UpdateInformation();
+        vtkStreamingDemandDrivenPipeline::SafeDownCast(reader->GetExecutive())->SetUpdateExtent(0, const_cast<int*>(updateExtent.constData()));
+    }
+
+    reader->Update();
+
+    return reader->GetOutput();
+}
+
+void test_VtkDcmtkImageReader::appendNotifiedSlice(vtkObject *caller, unsigned long eventId, void *clientData, void *callData)
+{
+    Q_UNUSED(caller)
+    Q_UNUSED(eventId)
+
+    static_cast<QVector<int>*>(clientData)->append(*static_cast<int*>(callData));
+}
+
+DECLARE_TEST(test_VtkDcmtkImageReader)
+
+#include "test_vtkdcmtkimagereader.moc"
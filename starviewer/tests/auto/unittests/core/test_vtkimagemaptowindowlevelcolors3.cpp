@@ -0,0 +1,199 @@
+#include "autotest.h"
+#include "vtkImageMapToWindowLevelColors3.h"
+
+#include <QProcessEnvironment>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <cstring>
+
+class test_vtkImageMapToWindowLevelColors3 : public QObject {
+Q_OBJECT
+
+private slots:
+    void update_ShouldGiveTheSameOutputWithAndWithoutTheWindowLevelTable_data();
+    void update_ShouldGiveTheSameOutputWithAndWithoutTheWindowLevelTable();
+
+    void update_ShouldRebuildTheWindowLevelTableWhenTheWindowLevelChanges();
+
+    void update_Benchmark_data();
+    void update_Benchmark();
+
+private:
+    /// Creates an image of the given size and scalar type filled with pseudo-random values that cover the whole range of the type.
+    vtkSmartPointer<vtkImageData> createImage(int width, int height, int scalarType, int numberOfComponents);
+
+    /// Maps the given image with the given parameters and returns a copy of the output.
+    vtkSmartPointer<vtkImageData> map(vtkImageData *image, double window, double level, int outputFormat, bool useWindowLevelTable);
+
+    /// Returns true if both images have the same scalars.
+    bool haveSameScalars(vtkImageData *image1, vtkImageData *image2);
+};
+
+vtkSmartPointer<vtkImageData> test_vtkImageMapToWindowLevelColors3::createImage(int width, int height, int scalarType, int numberOfComponents)
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, width - 1, 0, height - 1, 0, 0);
+    image->AllocateScalars(scalarType, numberOfComponents);
+
+    unsigned char *bytes = static_cast<unsigned char*>(image->GetScalarPointer());
+    int numberOfBytes = width * height * numberOfComponents * image->GetScalarSize();
+    quint32 state = 12345;
+    for (int i = 0; i < numberOfBytes; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        bytes[i] = state >> 24;
+    }
+
+    return image;
+}
+
+vtkSmartPointer<vtkImageData> test_vtkImageMapToWindowLevelColors3::map(vtkImageData *image, double window, double level, int outputFormat,
+                                                                        bool useWindowLevelTable)
+{
+    vtkSmartPointer<vtkImageMapToWindowLevelColors3> filter = vtkSmartPointer<vtkImageMapToWindowLevelColors3>::New();
+    filter->SetInputData(image);
+    filter->SetWindow(window);
+    filter->SetLevel(level);
+    filter->SetOutputFormat(outputFormat);
+    filter->SetUseWindowLevelTable(useWindowLevelTable);
+    filter->Update();
+
+    vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+    output->DeepCopy(filter->GetOutput());
+    return output;
+}
+
+bool test_vtkImageMapToWindowLevelColors3::haveSameScalars(vtkImageData *image1, vtkImageData *image2)
+{
+    int size1 = image1->GetNumberOfPoints() * image1->GetNumberOfScalarComponents();
+    int size2 = image2->GetNumberOfPoints() * image2->GetNumberOfScalarComponents();
+
+    return size1 == size2 && std::memcmp(image1->GetScalarPointer(), image2->GetScalarPointer(), size1) == 0;
+}
+
+void test_vtkImageMapToWindowLevelColors3::update_ShouldGiveTheSameOutputWithAndWithoutTheWindowLevelTable_data()
+{
+    QTest::addColumn<int>("scalarType");
+    QTest::addColumn<int>("numberOfComponents");
+    QTest::addColumn<double>("window");
+    QTest::addColumn<double>("level");
+    QTest::addColumn<int>("outputFormat");
+
+    QTest::newRow("short, CT window") << VTK_SHORT << 1 << 400.0 << 40.0 << VTK_LUMINANCE;
+    QTest::newRow("short, negative window") << VTK_SHORT << 1 << -400.0 << 40.0 << VTK_LUMINANCE;
+    QTest::newRow("short, level out of range") << VTK_SHORT << 1 << 100.0 << 40000.0 << VTK_LUMINANCE;
+    QTest::newRow("short, wide window") << VTK_SHORT << 1 << 100000.0 << 0.0 << VTK_LUMINANCE;
+    QTest::newRow("short, fractional window") << VTK_SHORT << 1 << 0.5 << 10.25 << VTK_LUMINANCE;
+    QTest::newRow("unsigned short, mammography window") << VTK_UNSIGNED_SHORT << 1 << 1500.0 << 2200.0 << VTK_LUMINANCE;
+    QTest::newRow("unsigned short, RGBA") << VTK_UNSIGNED_SHORT << 1 << 4096.0 << 2048.0 << VTK_RGBA;
+    QTest::newRow("unsigned short, luminance alpha") << VTK_UNSIGNED_SHORT << 1 << 4096.0 << 2048.0 << VTK_LUMINANCE_ALPHA;
+    QTest::newRow("unsigned char, RGB input and output") << VTK_UNSIGNED_CHAR << 3 << 128.0 << 100.0 << VTK_RGB;
+    QTest::newRow("unsigned char, RGB input, luminance") << VTK_UNSIGNED_CHAR << 3 << 128.0 << 100.0 << VTK_LUMINANCE;
+    QTest::newRow("char") << VTK_CHAR << 1 << 50.0 << 0.0 << VTK_RGB;
+    QTest::newRow("signed char") << VTK_SIGNED_CHAR << 1 << 50.0 << -20.0 << VTK_LUMINANCE;
+    QTest::newRow("int, without table") << VTK_INT << 1 << 1000.0 << 0.0 << VTK_LUMINANCE;
+    QTest::newRow("float, without table") << VTK_FLOAT << 1 << 1000.0 << 0.0 << VTK_RGBA;
+}
+
+void test_vtkImageMapToWindowLevelColors3::update_ShouldGiveTheSameOutputWithAndWithoutTheWindowLevelTable()
+{
+    QFETCH(int, scalarType);
+    QFETCH(int, numberOfComponents);
+    QFETCH(double, window);
+    QFETCH(double, level);
+    QFETCH(int, outputFormat);
+
+    vtkSmartPointer<vtkImageData> image = createImage(257, 255, scalarType, numberOfComponents);
+    if (scalarType == VTK_FLOAT)
+    {
+        // Random bytes are not valid floats
+        float *values = static_cast<float*>(image->GetScalarPointer());
+        for (int i = 0; i < image->GetNumberOfPoints(); i++)
+        {
+            values[i] = (i % 5000) - 2500.0f;
+        }
+    }
+
+    vtkSmartPointer<vtkImageData> expectedOutput = map(image, window, level, outputFormat, false);
+    vtkSmartPointer<vtkImageData> output = map(image, window, level, outputFormat, true);
+
+    QVERIFY(haveSameScalars(output, expectedOutput));
+}
+
+void test_vtkImageMapToWindowLevelColors3::update_ShouldRebuildTheWindowLevelTableWhenTheWindowLevelChanges()
+{
+    vtkSmartPointer<vtkImageData> image = createImage(64, 64, VTK_SHORT, 1);
+
+    vtkSmartPointer<vtkImageMapToWindowLevelColors3> filter = vtkSmartPointer<vtkImageMapToWindowLevelColors3>::New();
+    filter->SetInputData(image);
+    filter->SetOutputFormat(VTK_LUMINANCE);
+    filter->SetWindow(400.0);
+    filter->SetLevel(40.0);
+    filter->Update();
+
+    filter->SetWindow(2000.0);
+    filter->SetLevel(-500.0);
+    filter->Update();
+    QVERIFY(haveSameScalars(filter->GetOutput(), map(image, 2000.0, -500.0, VTK_LUMINANCE, false)));
+
+    // A different scalar type with the same window level
+    vtkSmartPointer<vtkImageData> unsignedImage = createImage(64, 64, VTK_UNSIGNED_SHORT, 1);
+    filter->SetInputData(unsignedImage);
+    filter->Update();
+    QVERIFY(haveSameScalars(filter->GetOutput(), map(unsignedImage, 2000.0, -500.0, VTK_LUMINANCE, false)));
+}
+
+void test_vtkImageMapToWindowLevelColors3::update_Benchmark_data()
+{
+    // Mapping a whole mammography repeatedly takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Window level benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QTest::addColumn<bool>("useWindowLevelTable");
+    QTest::addColumn<int>("outputFormat");
+
+    QTest::newRow("per pixel, luminance") << false << VTK_LUMINANCE;
+    QTest::newRow("table, luminance") << true << VTK_LUMINANCE;
+    QTest::newRow("per pixel, RGBA") << false << VTK_RGBA;
+    QTest::newRow("table, RGBA") << true << VTK_RGBA;
+}
+
+void test_vtkImageMapToWindowLevelColors3::update_Benchmark()
+{
+    QFETCH(bool, useWindowLevelTable);
+    QFETCH(int, outputFormat);
+
+    // A 12 bit mammography
+    vtkSmartPointer<vtkImageData> image = createImage(3328, 4096, VTK_UNSIGNED_SHORT, 1);
+    unsigned short *values = static_cast<unsigned short*>(image->GetScalarPointer());
+    for (int i = 0; i < image->GetNumberOfPoints(); i++)
+    {
+        values[i] &= 0x0FFF;
+    }
+
+    vtkSmartPointer<vtkImageMapToWindowLevelColors3> filter = vtkSmartPointer<vtkImageMapToWindowLevelColors3>::New();
+    filter->SetInputData(image);
+    filter->SetOutputFormat(outputFormat);
+    filter->SetUseWindowLevelTable(useWindowLevelTable);
+
+    // Each iteration simulates the events of a window level drag
+    const int NumberOfEvents = 10;
+
+    QBENCHMARK
+    {
+        for (int i = 0; i < NumberOfEvents; i++)
+        {
+            filter->SetWindow(1000.0 + i * 10.0);
+            filter->SetLevel(2000.0 - i * 5.0);
+            filter->Update();
+        }
+    }
+}
+
+DECLARE_TEST(test_vtkImageMapToWindowLevelColors3)
+
+#include "test_vtkimagemaptowindowlevelcolors3.moc"
@@ -0,0 +1,466 @@
+#include "autotest.h"
+#include "vtkProjectionImageFilter.h"
+
+#include "vtkimagedatacreator.h"
+
+#include <QProcessEnvironment>
+#include <QVector>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+
+using namespace udg;
+
+class test_vtkProjectionImageFilter : public QObject {
+Q_OBJECT
+
+private slots:
+    void update_ShouldReturnExpectedProjection_data();
+    void update_ShouldReturnExpectedProjection();
+
+    void update_ShouldReturnSameResultAsLegacyAccumulators_data();
+    void update_ShouldReturnSameResultAsLegacyAccumulators();
+
+    void update_WithIncrementalUpdateShouldReturnSameResultAsFullProjection_data();
+    void update_WithIncrementalUpdateShouldReturnSameResultAsFullProjection();
+
+    void update_WithIncrementalUpdateShouldNotKeepStateOverMemoryLimit();
+
+    void setters_ShouldReleaseIncrementalUpdateState();
+
+    void update_Benchmark_data();
+    void update_Benchmark();
+
+    void scroll_Benchmark_data();
+    void scroll_Benchmark();
+
+private:
+    static void setupProjectionData();
+    static vtkSmartPointer<vtkImageData> createVolume(int width, int height, int depth);
+    static double computeExpectedValue(vtkImageData *volume, int axis, AccumulatorFactory::AccumulatorType type, int firstSlice,
+                                       int numberOfSlices, int step, int index0, int index1);
+};
+
+Q_DECLARE_METATYPE(AccumulatorFactory::AccumulatorType)
+Q_DECLARE_METATYPE(QList<int>)
+
+void test_vtkProjectionImageFilter::update_ShouldReturnExpectedProjection_data()
+{
+    setupProjectionData();
+}
+
+void test_vtkProjectionImageFilter::update_ShouldReturnExpectedProjection()
+{
+    QFETCH(int, axis);
+    QFETCH(AccumulatorFactory::AccumulatorType, accumulatorType);
+    QFETCH(int, firstSlice);
+    QFETCH(int, numberOfSlices);
+    QFETCH(int, step);
+
+    vtkSmartPointer<vtkImageData> volume = createVolume(37, 21, 13);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filter = vtkSmartPointer<vtkProjectionImageFilter>::New();
+    filter->SetInputData(volume);
+    filter->SetProjectionDimension(axis);
+    filter->SetAccumulatorType(accumulatorType);
+    filter->SetFirstSlice(firstSlice);
+    filter->SetNumberOfSlicesToProject(numberOfSlices);
+    filter->SetStep(step);
+    filter->SetNumberOfThreads(3);
+    filter->Update();
+
+    vtkImageData *output = filter->GetOutput();
+    int extent[6];
+    output->GetExtent(extent);
+    int i0 = (axis + 1) % 3, i1 = (axis + 2) % 3;
+
+    QCOMPARE(extent[2 * axis], firstSlice);
+    QCOMPARE(extent[2 * axis + 1], firstSlice);
+
+    for (int index0 = extent[2 * i0]; index0 <= extent[2 * i0 + 1]; index0++)
+    {
+        for (int index1 = extent[2 * i1]; index1 <= extent[2 * i1 + 1]; index1++)
+        {
+            int index[3];
+            index[axis] = firstSlice;
+            index[i0] = index0;
+            index[i1] = index1;
+
+            double expectedValue = computeExpectedValue(volume, axis, accumulatorType, firstSlice, numberOfSlices, step, index0, index1);
+            QCOMPARE(output->GetScalarComponentAsDouble(index[0], index[1], index[2], 0), expectedValue);
+        }
+    }
+}
+
+void test_vtkProjectionImageFilter::update_ShouldReturnSameResultAsLegacyAccumulators_data()
+{
+    setupProjectionData();
+}
+
+void test_vtkProjectionImageFilter::update_ShouldReturnSameResultAsLegacyAccumulators()
+{
+    QFETCH(int, axis);
+    QFETCH(AccumulatorFactory::AccumulatorType, accumulatorType);
+    QFETCH(int, firstSlice);
+    QFETCH(int, numberOfSlices);
+    QFETCH(int, step);
+
+    vtkSmartPointer<vtkImageData> volume = createVolume(37, 21, 13);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filters[2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        filters[i] = vtkSmartPointer<vtkProjectionImageFilter>::New();
+        filters[i]->SetInputData(volume);
+        filters[i]->SetProjectionDimension(axis);
+        filters[i]->SetAccumulatorType(accumulatorType);
+        filters[i]->SetFirstSlice(firstSlice);
+        filters[i]->SetNumberOfSlicesToProject(numberOfSlices);
+        filters[i]->SetStep(step);
+        filters[i]->SetUseLegacyAccumulators(i == 1);
+        filters[i]->Update();
+    }
+
+    vtkImageData *output = filters[0]->GetOutput();
+    vtkImageData *legacyOutput = filters[1]->GetOutput();
+    int extent[6];
+    output->GetExtent(extent);
+
+    for (int z = extent[4]; z <= extent[5]; z++)
+    {
+        for (int y = extent[2]; y <= extent[3]; y++)
+        {
+            for (int x = extent[0]; x <= extent[1]; x++)
+            {
+                // The legacy average accumulates value / size, so its rounding can differ by one unit
+                QVERIFY(std::abs(output->GetScalarComponentAsDouble(x, y, z, 0) - legacyOutput->GetScalarComponentAsDouble(x, y, z, 0))
+                        <= (accumulatorType == AccumulatorFactory::Average ? 1.0 : 0.0));
+            }
+        }
+    }
+}
+
+void test_vtkProjectionImageFilter::update_WithIncrementalUpdateShouldReturnSameResultAsFullProjection_data()
+{
+    QTest::addColumn<int>("axis");
+    QTest::addColumn<AccumulatorFactory::AccumulatorType>("accumulatorType");
+    QTest::addColumn<int>("numberOfSlices");
+    QTest::addColumn<int>("step");
+    QTest::addColumn< QList<int> >("firstSlices");
+
+    const char *names[3] = { "maximum", "minimum", "average" };
+    QList<int> scrolling;
+    scrolling << 0 << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 6 << 5 << 4 << 3 << 2 << 1 << 0;
+    QList<int> jumping;
+    jumping << 2 << 4 << 3 << 8 << 1 << 1 << 5 << 6 << 0;
+    QList<int> scrollingWithPhases;
+    scrollingWithPhases << 1 << 3 << 5 << 7 << 5 << 4 << 6 << 8 << 6 << 4 << 2;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (int type = 0; type < 3; type++)
+        {
+            AccumulatorFactory::AccumulatorType accumulatorType = static_cast<AccumulatorFactory::AccumulatorType>(type);
+
+            QTest::newRow(qPrintable(QString("%1, axis %2, scrolling").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 4 << 1 << scrolling;
+            QTest::newRow(qPrintable(QString("%1, axis %2, jumping").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 3 << 1 << jumping;
+            QTest::newRow(qPrintable(QString("%1, axis %2, scrolling with phases").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 2 << 2 << scrollingWithPhases;
+        }
+    }
+}
+
+void test_vtkProjectionImageFilter::update_WithIncrementalUpdateShouldReturnSameResultAsFullProjection()
+{
+    QFETCH(int, axis);
+    QFETCH(AccumulatorFactory::AccumulatorType, accumulatorType);
+    QFETCH(int, numberOfSlices);
+    QFETCH(int, step);
+    QFETCH(QList<int>, firstSlices);
+
+    vtkSmartPointer<vtkImageData> volume = createVolume(13, 12, 11);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filter = vtkSmartPointer<vtkProjectionImageFilter>::New();
+    filter->SetInputData(volume);
+    filter->SetProjectionDimension(axis);
+    filter->SetAccumulatorType(accumulatorType);
+    filter->SetNumberOfSlicesToProject(numberOfSlices);
+    filter->SetStep(step);
+    filter->SetNumberOfThreads(2);
+    filter->IncrementalUpdateOn();
+
+    int i0 = (axis + 1) % 3, i1 = (axis + 2) % 3;
+
+    foreach (int firstSlice, firstSlices)
+    {
+        filter->SetFirstSlice(firstSlice);
+        filter->Update();
+
+        vtkImageData *output = filter->GetOutput();
+        int extent[6];
+        output->GetExtent(extent);
+
+        for (int index0 = extent[2 * i0]; index0 <= extent[2 * i0 + 1]; index0++)
+        {
+            for (int index1 = extent[2 * i1]; index1 <= extent[2 * i1 + 1]; index1++)
+            {
+                int index[3];
+                index[axis] = firstSlice;
+                index[i0] = index0;
+                index[i1] = index1;
+
+                double expectedValue = computeExpectedValue(volume, axis, accumulatorType, firstSlice, numberOfSlices, step, index0, index1);
+                QCOMPARE(output->GetScalarComponentAsDouble(index[0], index[1], index[2], 0), expectedValue);
+            }
+        }
+    }
+}
+
+void test_vtkProjectionImageFilter::update_WithIncrementalUpdateShouldNotKeepStateOverMemoryLimit()
+{
+    vtkSmartPointer<vtkImageData> volume = createVolume(13, 12, 11);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filter = vtkSmartPointer<vtkProjectionImageFilter>::New();
+    filter->SetInputData(volume);
+    filter->SetAccumulatorType(AccumulatorFactory::Maximum);
+    filter->SetNumberOfSlicesToProject(4);
+    filter->IncrementalUpdateOn();
+
+    // 4 planes of 13x12 shorts
+    filter->Update();
+    QCOMPARE(filter->GetIncrementalUpdateMemorySize(), static_cast<vtkIdType>(4 * 13 * 12 * sizeof(short)));
+
+    filter->SetIncrementalUpdateMemoryLimit(4 * 13 * 12 * sizeof(short) - 1);
+
+    for (int firstSlice = 1; firstSlice < 4; firstSlice++)
+    {
+        filter->SetFirstSlice(firstSlice);
+        filter->Update();
+        QCOMPARE(filter->GetIncrementalUpdateMemorySize(), static_cast<vtkIdType>(0));
+
+        vtkImageData *output = filter->GetOutput();
+        for (int y = 0; y < 12; y++)
+        {
+            for (int x = 0; x < 13; x++)
+            {
+                double expectedValue = computeExpectedValue(volume, 2, AccumulatorFactory::Maximum, firstSlice, 4, 1, x, y);
+                QCOMPARE(output->GetScalarComponentAsDouble(x, y, firstSlice, 0), expectedValue);
+            }
+        }
+    }
+}
+
+void test_vtkProjectionImageFilter::setters_ShouldReleaseIncrementalUpdateState()
+{
+    vtkSmartPointer<vtkImageData> volume = createVolume(13, 12, 11);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filter = vtkSmartPointer<vtkProjectionImageFilter>::New();
+    filter->SetInputData(volume);
+    filter->SetAccumulatorType(AccumulatorFactory::Maximum);
+    filter->SetNumberOfSlicesToProject(4);
+    filter->IncrementalUpdateOn();
+    filter->Update();
+    QVERIFY(filter->GetIncrementalUpdateMemorySize() > 0);
+
+    // Moving the slab keeps the state
+    filter->SetFirstSlice(1);
+    filter->Update();
+    QVERIFY(filter->GetIncrementalUpdateMemorySize() > 0);
+
+    filter->SetNumberOfSlicesToProject(5);
+    QCOMPARE(filter->GetIncrementalUpdateMemorySize(), static_cast<vtkIdType>(0));
+    filter->Update();
+
+    filter->SetProjectionDimension(1);
+    QCOMPARE(filter->GetIncrementalUpdateMemorySize(), static_cast<vtkIdType>(0));
+    filter->Update();
+
+    filter->ReleaseIncrementalUpdateState();
+    QCOMPARE(filter->GetIncrementalUpdateMemorySize(), static_cast<vtkIdType>(0));
+    filter->SetFirstSlice(2);
+    filter->Update();
+
+    filter->IncrementalUpdateOff();
+    QCOMPARE(filter->GetIncrementalUpdateMemorySize(), static_cast<vtkIdType>(0));
+}
+
+void test_vtkProjectionImageFilter::update_Benchmark_data()
+{
+    // Projecting 512x512x128 volumes takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Update benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QTest::addColumn<AccumulatorFactory::AccumulatorType>("accumulatorType");
+    QTest::addColumn<bool>("useLegacyAccumulators");
+
+    QTest::newRow("maximum, legacy") << AccumulatorFactory::Maximum << true;
+    QTest::newRow("maximum, kernel") << AccumulatorFactory::Maximum << false;
+    QTest::newRow("minimum, legacy") << AccumulatorFactory::Minimum << true;
+    QTest::newRow("minimum, kernel") << AccumulatorFactory::Minimum << false;
+    QTest::newRow("average, legacy") << AccumulatorFactory::Average << true;
+    QTest::newRow("average, kernel") << AccumulatorFactory::Average << false;
+}
+
+void test_vtkProjectionImageFilter::update_Benchmark()
+{
+    QFETCH(AccumulatorFactory::AccumulatorType, accumulatorType);
+    QFETCH(bool, useLegacyAccumulators);
+
+    // 512x512 axial slices of a CT angiography, with a slab of 64 slices
+    vtkSmartPointer<vtkImageData> volume = createVolume(512, 512, 128);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filter = vtkSmartPointer<vtkProjectionImageFilter>::New();
+    filter->SetInputData(volume);
+    filter->SetProjectionDimension(2);
+    filter->SetAccumulatorType(accumulatorType);
+    filter->SetNumberOfSlicesToProject(64);
+    filter->SetUseLegacyAccumulators(useLegacyAccumulators);
+
+    int firstSlice = 0;
+
+    QBENCHMARK
+    {
+        // Change the slab position in each iteration to force a new execution, as when scrolling
+        filter->SetFirstSlice(firstSlice);
+        filter->Update();
+        firstSlice = (firstSlice + 1) % 64;
+    }
+}
+
+void test_vtkProjectionImageFilter::scroll_Benchmark_data()
+{
+    // Scrolling slabs of 512x512x128 volumes takes too long for the default run
+    if (!QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Scroll benchmark only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QTest::addColumn<AccumulatorFactory::AccumulatorType>("accumulatorType");
+    QTest::addColumn<bool>("incrementalUpdate");
+
+    QTest::newRow("maximum, full") << AccumulatorFactory::Maximum << false;
+    QTest::newRow("maximum, incremental") << AccumulatorFactory::Maximum << true;
+    QTest::newRow("average, full") << AccumulatorFactory::Average << false;
+    QTest::newRow("average, incremental") << AccumulatorFactory::Average << true;
+}
+
+void test_vtkProjectionImageFilter::scroll_Benchmark()
+{
+    QFETCH(AccumulatorFactory::AccumulatorType, accumulatorType);
+    QFETCH(bool, incrementalUpdate);
+
+    vtkSmartPointer<vtkImageData> volume = createVolume(512, 512, 128);
+
+    vtkSmartPointer<vtkProjectionImageFilter> filter = vtkSmartPointer<vtkProjectionImageFilter>::New();
+    filter->SetInputData(volume);
+    filter->SetProjectionDimension(2);
+    filter->SetAccumulatorType(accumulatorType);
+    filter->SetNumberOfSlicesToProject(64);
+    filter->SetIncrementalUpdate(incrementalUpdate);
+
+    // Scroll the slab over half of the volume one slice at a time
+    QBENCHMARK
+    {
+        for (int firstSlice = 0; firstSlice < 64; firstSlice++)
+        {
+            filter->SetFirstSlice(firstSlice);
+            filter->Update();
+        }
+    }
+}
+
+void test_vtkProjectionImageFilter::setupProjectionData()
+{
+    QTest::addColumn<int>("axis");
+    QTest::addColumn<AccumulatorFactory::AccumulatorType>("accumulatorType");
+    QTest::addColumn<int>("firstSlice");
+    QTest::addColumn<int>("numberOfSlices");
+    QTest::addColumn<int>("step");
+
+    const char *names[3] = { "maximum", "minimum", "average" };
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (int type = 0; type < 3; type++)
+        {
+            AccumulatorFactory::AccumulatorType accumulatorType = static_cast<AccumulatorFactory::AccumulatorType>(type);
+
+            QTest::newRow(qPrintable(QString("%1, axis %2, whole").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 0 << 13 << 1;
+            QTest::newRow(qPrintable(QString("%1, axis %2, slab").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 3 << 5 << 1;
+            QTest::newRow(qPrintable(QString("%1, axis %2, single slice").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 4 << 1 << 1;
+            QTest::newRow(qPrintable(QString("%1, axis %2, step").arg(names[type]).arg(axis)))
+                    << axis << accumulatorType << 1 << 4 << 3;
+        }
+    }
+}
+
+vtkSmartPointer<vtkImageData> test_vtkProjectionImageFilter::createVolume(int width, int height, int depth)
+{
+    QVector<short> data(width * height * depth);
+
+    // Pseudo-random values, including negative ones, that don't depend on the platform
+    unsigned int seed = 12345;
+
+    for (int i = 0; i < data.size(); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = static_cast<short>((seed >> 16) % 4096) - 1024;
+    }
+
+    VtkImageDataCreator imageDataCreator;
+    return imageDataCreator.createVtkImageData(width, height, depth, data.constData());
+}
+
+double test_vtkProjectionImageFilter::computeExpectedValue(vtkImageData *volume, int axis, AccumulatorFactory::AccumulatorType type,
+                                                           int firstSlice, int numberOfSlices, int step, int index0, int index1)
+{
+    int i0 = (axis + 1) % 3, i1 = (axis + 2) % 3;
+    double result = 0.0;
+
+    for (int i = 0; i < numberOfSlices; i++)
+    {
+        int index[3];
+        index[axis] = firstSlice + i * step;
+        index[i0] = index0;
+        index[i1] = index1;
+        double value = volume->GetScalarComponentAsDouble(index[0], index[1], index[2], 0);
+
+        if (i == 0)
+        {
+            result = value;
+        }
+        else if (type == AccumulatorFactory::Maximum)
+        {
+            result = qMax(result, value);
+        }
+        else if (type == AccumulatorFactory::Minimum)
+        {
+            result = qMin(result, value);
+        }
+        else
+        {
+            result += value;
+        }
+    }
+
+    if (type == AccumulatorFactory::Average)
+    {
+        result = std::floor(result / numberOfSlices + 0.5);
+    }
+
+    return result;
+}
+
+DECLARE_TEST(test_vtkProjectionImageFilter)
+
+#include "test_vtkprojectionimagefilter.moc"
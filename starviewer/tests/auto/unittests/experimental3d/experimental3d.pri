@@ -0,0 +1 @@
+SOURCES += $$PWD/test_experimental3dvolume.cpp
@@ -0,0 +1,262 @@
+#include "autotest.h"
+#include "experimental3dvolume.h"
+
+#include "ambientvoxelshader2.h"
+#include "contourvoxelshader.h"
+#include "directilluminationvoxelshader2.h"
+#include "fuzzycomparetesthelper.h"
+#include "obscurance.h"
+#include "obscurancevoxelshader.h"
+#include "transferfunction.h"
+#include "voxelshadertesthelper.h"
+#include "vtkVolumeRayCastVoxelShaderCompositeFunction.h"
+
+#include <vtkDirectionEncoder.h>
+#include <vtkFiniteDifferenceGradientEstimator.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <cmath>
+
+using namespace udg;
+using namespace testing;
+
+namespace {
+
+/// Volume of size³ voxels with a textured sphere, its normals, obscurances and the voxel shaders and fused chains that Experimental3DVolume deploys.
+class TestVolume {
+
+public:
+    TestVolume(int size)
+        : m_size(size), m_obscurance(size * size * size)
+    {
+        m_image = vtkSmartPointer<vtkImageData>::New();
+        m_image->SetExtent(0, size - 1, 0, size - 1, 0, size - 1);
+        m_image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+        unsigned short *data = static_cast<unsigned short*>(m_image->GetScalarPointer());
+
+        double center = (size - 1) / 2.0;
+        double radius = size / 3.0;
+        int i = 0;
+
+        for (int z = 0; z < size; z++)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                for (int x = 0; x < size; x++, i++)
+                {
+                    double distance2 = (x - center) * (x - center) + (y - center) * (y - center) + (z - center) * (z - center);
+                    data[i] = distance2 <= radius * radius ? 500 + (7 * x + 13 * y + 3 * z) % 500 : 0;
+                    m_obscurance.setObscurance(i, (i % 97) / 96.0);
+                }
+            }
+        }
+
+        m_gradientEstimator = vtkSmartPointer<vtkFiniteDifferenceGradientEstimator>::New();
+        m_gradientEstimator->SetInputData(m_image);
+        createShadingTables();
+
+        TransferFunction transferFunction;
+        transferFunction.set(0.0, Qt::black, 0.0);
+        transferFunction.set(499.0, Qt::black, 0.0);
+        transferFunction.set(500.0, Qt::red, 0.05);
+        transferFunction.set(999.0, Qt::white, 0.2);
+
+        m_ambientVoxelShader.setData(data, 999);
+        m_ambientVoxelShader.setTransferFunction(transferFunction);
+        m_directIlluminationVoxelShader.setData(data, 999);
+        m_directIlluminationVoxelShader.setTransferFunction(transferFunction);
+        m_directIlluminationVoxelShader.setEncodedNormals(m_gradientEstimator->GetEncodedNormals());
+        m_directIlluminationVoxelShader.setDiffuseShadingTables(m_diffuseShadingTables[0].constData(), m_diffuseShadingTables[1].constData(),
+                                                                m_diffuseShadingTables[2].constData());
+        m_directIlluminationVoxelShader.setSpecularShadingTables(m_specularShadingTables[0].constData(), m_specularShadingTables[1].constData(),
+                                                                 m_specularShadingTables[2].constData());
+        m_contourVoxelShader.setGradientEstimator(m_gradientEstimator);
+        m_contourVoxelShader.setThreshold(0.3);
+        m_obscuranceVoxelShader.setData(data, 999);
+        m_obscuranceVoxelShader.setTransferFunction(transferFunction);
+        m_obscuranceVoxelShader.setObscurance(&m_obscurance);
+        m_obscuranceVoxelShader.setFactor(0.8);
+
+        m_ambientObscuranceVoxelShader.setVoxelShaders(&m_ambientVoxelShader, &m_obscuranceVoxelShader);
+        m_directIlluminationObscuranceVoxelShader.setVoxelShaders(&m_directIlluminationVoxelShader, &m_obscuranceVoxelShader);
+        m_ambientContourObscuranceVoxelShader.setVoxelShaders(&m_ambientVoxelShader, &m_contourVoxelShader, &m_obscuranceVoxelShader);
+        m_directIlluminationContourObscuranceVoxelShader.setVoxelShaders(&m_directIlluminationVoxelShader, &m_contourVoxelShader,
+                                                                        &m_obscuranceVoxelShader);
+    }
+
+    int m_size;
+    vtkSmartPointer<vtkImageData> m_image;
+    Obscurance m_obscurance;
+    vtkSmartPointer<vtkFiniteDifferenceGradientEstimator> m_gradientEstimator;
+    QVector<float> m_diffuseShadingTables[3];
+    QVector<float> m_specularShadingTables[3];
+    AmbientVoxelShader2 m_ambientVoxelShader;
+    DirectIlluminationVoxelShader2 m_directIlluminationVoxelShader;
+    ContourVoxelShader m_contourVoxelShader;
+    ObscuranceVoxelShader m_obscuranceVoxelShader;
+    Experimental3DVolume::AmbientObscuranceVoxelShader m_ambientObscuranceVoxelShader;
+    Experimental3DVolume::DirectIlluminationObscuranceVoxelShader m_directIlluminationObscuranceVoxelShader;
+    Experimental3DVolume::AmbientContourObscuranceVoxelShader m_ambientContourObscuranceVoxelShader;
+    Experimental3DVolume::DirectIlluminationContourObscuranceVoxelShader m_directIlluminationContourObscuranceVoxelShader;
+
+private:
+    /// Fills the shading tables, indexed by the encoded normals, with a light along the z axis.
+    void createShadingTables()
+    {
+        vtkDirectionEncoder *directionEncoder = m_gradientEstimator->GetDirectionEncoder();
+        int numberOfDirections = directionEncoder->GetNumberOfEncodedDirections();
+
+        for (int channel = 0; channel < 3; channel++)
+        {
+            m_diffuseShadingTables[channel].resize(numberOfDirections);
+            m_specularShadingTables[channel].resize(numberOfDirections);
+
+            for (int i = 0; i < numberOfDirections; i++)
+            {
+                float diffuse = std::fabs(directionEncoder->GetDecodedGradient(i)[2]);
+                m_diffuseShadingTables[channel][i] = 0.2f + (0.8f - 0.1f * channel) * diffuse;
+                m_specularShadingTables[channel][i] = 0.1f * std::pow(diffuse, 8.0f);
+            }
+        }
+    }
+
+};
+
+}
+
+class test_Experimental3DVolume : public QObject {
+Q_OBJECT
+
+public:
+    /// Fused voxel shader chains of Experimental3DVolume.
+    enum FusedChain { AmbientObscurance, DirectIlluminationObscurance, AmbientContourObscurance, DirectIlluminationContourObscurance };
+
+private slots:
+    void fusedVoxelShaderChain_ShouldGiveTheSameImageAsTheVoxelShaderListFunction_data();
+    void fusedVoxelShaderChain_ShouldGiveTheSameImageAsTheVoxelShaderListFunction();
+
+private:
+    /// Casts a frame with the composite function that calls the voxel shaders of the given chain through a list of virtual voxel shaders.
+    static QVector<float> castListFrame(TestVolume &volume, FusedChain chain, bool interpolation, bool classifyFirst);
+    /// Casts a frame with the composite function that calls the voxel shaders of the given chain through the fused chain.
+    static QVector<float> castFusedFrame(TestVolume &volume, FusedChain chain, bool interpolation, bool classifyFirst);
+
+    /// Casts a frame with the composite function of the given fused chain.
+    template <class VS>
+    static QVector<float> castChainFrame(VS *voxelShaderChain, int size, bool interpolation, bool classifyFirst);
+
+    /// Sets the composite method of the given composite function.
+    template <class F>
+    static void setCompositeMethod(F *function, bool classifyFirst);
+};
+
+Q_DECLARE_METATYPE(test_Experimental3DVolume::FusedChain)
+
+void test_Experimental3DVolume::fusedVoxelShaderChain_ShouldGiveTheSameImageAsTheVoxelShaderListFunction_data()
+{
+    QTest::addColumn<FusedChain>("chain");
+    QTest::addColumn<bool>("interpolation");
+    QTest::addColumn<bool>("classifyFirst");
+
+    QList<FusedChain> chains;
+    chains << AmbientObscurance << DirectIlluminationObscurance << AmbientContourObscurance << DirectIlluminationContourObscurance;
+    QStringList chainNames;
+    chainNames << "ambient, obscurance" << "direct illumination, obscurance" << "ambient, contour, obscurance"
+               << "direct illumination, contour, obscurance";
+
+    for (int i = 0; i < chains.size(); i++)
+    {
+        QTest::newRow(qPrintable(chainNames.at(i) + "; nearest")) << chains.at(i) << false << false;
+        QTest::newRow(qPrintable(chainNames.at(i) + "; linear, classify first")) << chains.at(i) << true << true;
+        QTest::newRow(qPrintable(chainNames.at(i) + "; linear, interpolate first")) << chains.at(i) << true << false;
+    }
+}
+
+void test_Experimental3DVolume::fusedVoxelShaderChain_ShouldGiveTheSameImageAsTheVoxelShaderListFunction()
+{
+    QFETCH(FusedChain, chain);
+    QFETCH(bool, interpolation);
+    QFETCH(bool, classifyFirst);
+
+    TestVolume volume(32);
+    QVector<float> expectedColors = castListFrame(volume, chain, interpolation, classifyFirst);
+    QVector<float> colors = castFusedFrame(volume, chain, interpolation, classifyFirst);
+
+    QCOMPARE(colors.size(), expectedColors.size());
+
+    for (int i = 0; i < colors.size(); i++)
+    {
+        QVERIFY(FuzzyCompareTestHelper::fuzzyCompare(colors.at(i), expectedColors.at(i), 1e-5));
+    }
+}
+
+QVector<float> test_Experimental3DVolume::castListFrame(TestVolume &volume, FusedChain chain, bool interpolation, bool classifyFirst)
+{
+    vtkSmartPointer<vtkVolumeRayCastVoxelShaderCompositeFunction> function = vtkSmartPointer<vtkVolumeRayCastVoxelShaderCompositeFunction>::New();
+
+    // The same order as the one Experimental3DVolume::useFusedVoxelShaders() expects
+    if (chain == AmbientObscurance || chain == AmbientContourObscurance)
+    {
+        function->AddVoxelShader(&volume.m_ambientVoxelShader);
+    }
+    else
+    {
+        function->AddVoxelShader(&volume.m_directIlluminationVoxelShader);
+    }
+    if (chain == AmbientContourObscurance || chain == DirectIlluminationContourObscurance)
+    {
+        function->AddVoxelShader(&volume.m_contourVoxelShader);
+    }
+    function->AddVoxelShader(&volume.m_obscuranceVoxelShader);
+
+    setCompositeMethod(function.GetPointer(), classifyFirst);
+
+    return VoxelShaderTestHelper::castFrame(function, volume.m_size, interpolation);
+}
+
+QVector<float> test_Experimental3DVolume::castFusedFrame(TestVolume &volume, FusedChain chain, bool interpolation, bool classifyFirst)
+{
+    switch (chain)
+    {
+        case AmbientObscurance:
+            return castChainFrame(&volume.m_ambientObscuranceVoxelShader, volume.m_size, interpolation, classifyFirst);
+        case DirectIlluminationObscurance:
+            return castChainFrame(&volume.m_directIlluminationObscuranceVoxelShader, volume.m_size, interpolation, classifyFirst);
+        case AmbientContourObscurance:
+            return castChainFrame(&volume.m_ambientContourObscuranceVoxelShader, volume.m_size, interpolation, classifyFirst);
+        case DirectIlluminationContourObscurance:
+            return castChainFrame(&volume.m_directIlluminationContourObscuranceVoxelShader, volume.m_size, interpolation, classifyFirst);
+    }
+
+    return QVector<float>();
+}
+
+template <class VS>
+QVector<float> test_Experimental3DVolume::castChainFrame(VS *voxelShaderChain, int size, bool interpolation, bool classifyFirst)
+{
+    typedef vtkVolumeRayCastSingleVoxelShaderCompositeFunction<VS> CompositeFunction;
+
+    vtkSmartPointer<CompositeFunction> function = vtkSmartPointer<CompositeFunction>::New();
+    function->SetVoxelShader(voxelShaderChain);
+    setCompositeMethod(function.GetPointer(), classifyFirst);
+
+    return VoxelShaderTestHelper::castFrame(function, size, interpolation);
+}
+
+template <class F>
+void test_Experimental3DVolume::setCompositeMethod(F *function, bool classifyFirst)
+{
+    if (classifyFirst)
+    {
+        function->SetCompositeMethodToClassifyFirst();
+    }
+    else
+    {
+        function->SetCompositeMethodToInterpolateFirst();
+    }
+}
+
+DECLARE_TEST(test_Experimental3DVolume)
+
+#include "test_experimental3dvolume.moc"
@@ -11,4 +11,9 @@ SOURCES += $$PWD/test_dicommask.cpp \
            $$PWD/test_cachetest.cpp \
            $$PWD/test_senddicomfilestopacs.cpp \
            $$PWD/test_databaseconnection.cpp \
-           $$PWD/test_localdatabasebasedal.cpp
+           $$PWD/test_localdatabasebasedal.cpp \
+           $$PWD/test_localdatabaseimagedal.cpp \
+           $$PWD/test_localdatabasemanager.cpp \
+           $$PWD/test_localdatabasequeryplans.cpp \
+           $$PWD/test_localdatabasestudydal.cpp \
+           $$PWD/test_retrievedicomfilesfrompacs.cpp
@@ -1,9 +1,17 @@
 #include "autotest.h"
 #include "databaseconnection.h"
 
+#include "databaseinstallation.h"
 #include "databasetesthelper.h"
+#include "inputoutputsettings.h"
+#include "settings.h"
 
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
 
 using namespace udg;
 using namespace testing;
@@ -15,6 +23,19 @@ class test_DatabaseConnection : public QObject {
 private slots:
     void getConnection_ShouldReturnOpenDatabase();
 
+    void getPreparedQuery_ShouldReuseStatementForSameSql();
+    void getPreparedQuery_ShouldNotReuseStatementPositionedOnARow();
+
+    void reinstallDatabase_ShouldCloseConnectionsOfOtherThreads();
+
+    void closePooledConnections_ShouldKeepConnectionsInUseUntilReleased();
+
+private:
+    /// Creates a table with the given name in the database of the settings. Returns the thread where it has been executed.
+    static QThread* createTable(const QString &tableName);
+    /// Returns the tables of the database of the settings.
+    static QStringList getTables();
+
 };
 
 void test_DatabaseConnection::getConnection_ShouldReturnOpenDatabase()
@@ -25,6 +46,117 @@ void test_DatabaseConnection::getConnection_ShouldReturnOpenDatabase()
     QVERIFY(connection.isOpen());
 }
 
+void test_DatabaseConnection::getPreparedQuery_ShouldReuseStatementForSameSql()
+{
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getEmptyDatabase());
+
+    QSqlQuery query = databaseConnection->getPreparedQuery("SELECT :value");
+    query.bindValue(":value", 1);
+    QVERIFY(query.exec());
+    QVERIFY(query.next());
+    QVERIFY(!query.next());
+
+    QSqlQuery sameQuery = databaseConnection->getPreparedQuery("SELECT :value");
+    QCOMPARE(sameQuery.result(), query.result());
+
+    sameQuery.bindValue(":value", 2);
+    QVERIFY(sameQuery.exec());
+    QVERIFY(sameQuery.next());
+    QCOMPARE(sameQuery.value(0).toInt(), 2);
+
+    QSqlQuery otherQuery = databaseConnection->getPreparedQuery("SELECT :value + 1");
+    QVERIFY(otherQuery.result() != query.result());
+}
+
+void test_DatabaseConnection::getPreparedQuery_ShouldNotReuseStatementPositionedOnARow()
+{
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getEmptyDatabase());
+
+    QSqlQuery outerQuery = databaseConnection->getPreparedQuery("SELECT 1 UNION ALL SELECT 2");
+    QVERIFY(outerQuery.exec());
+    QVERIFY(outerQuery.next());
+
+    QSqlQuery innerQuery = databaseConnection->getPreparedQuery("SELECT 1 UNION ALL SELECT 2");
+    QVERIFY(innerQuery.result() != outerQuery.result());
+    QVERIFY(innerQuery.exec());
+    QVERIFY(innerQuery.next());
+
+    QCOMPARE(outerQuery.value(0).toInt(), 1);
+    QVERIFY(outerQuery.next());
+    QCOMPARE(outerQuery.value(0).toInt(), 2);
+}
+
+void test_DatabaseConnection::reinstallDatabase_ShouldCloseConnectionsOfOtherThreads()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    Settings settings;
+    QVariant databaseFilePath = settings.getValue(InputOutputSettings::DatabaseAbsoluteFilePath);
+    settings.setValue(InputOutputSettings::DatabaseAbsoluteFilePath, directory.path() + "/database.sdf");
+
+    // A worker thread that keeps its pooled connection open while the database is reinstalled
+    QThreadPool workerThread;
+    workerThread.setMaxThreadCount(1);
+    workerThread.setExpiryTimeout(-1);
+
+    QThread *thread = QtConcurrent::run(&workerThread, &test_DatabaseConnection::createTable, QString("OldTable")).result();
+    QVERIFY(thread != QThread::currentThread());
+    QVERIFY(getTables().contains("OldTable"));
+
+    bool reinstalled = DatabaseInstallation().reinstallDatabase();
+
+    // The worker thread must see the new database, not the removed one
+    QFuture<QStringList> workerTables = QtConcurrent::run(&workerThread, &test_DatabaseConnection::getTables);
+    QStringList tables = workerTables.result();
+    workerThread.waitForDone();
+    DatabaseConnection::closePooledConnections();
+    settings.setValue(InputOutputSettings::DatabaseAbsoluteFilePath, databaseFilePath);
+
+    QVERIFY(reinstalled);
+    QVERIFY(!tables.contains("OldTable"));
+    QVERIFY(tables.contains("Study"));
+}
+
+void test_DatabaseConnection::closePooledConnections_ShouldKeepConnectionsInUseUntilReleased()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    DatabaseConnection databaseConnection;
+    databaseConnection.setDatabasePath(directory.path() + "/database.sdf");
+    QVERIFY(QSqlQuery(databaseConnection.getConnection()).exec("CREATE TABLE SomeTable (a)"));
+    QString connectionName = databaseConnection.getConnection().connectionName();
+
+    DatabaseConnection::closePooledConnections();
+
+    // The connection in use still works, but new objects get a new one
+    QVERIFY(databaseConnection.getConnection().isOpen());
+    QCOMPARE(databaseConnection.getConnection().connectionName(), connectionName);
+
+    {
+        DatabaseConnection otherDatabaseConnection;
+        otherDatabaseConnection.setDatabasePath(directory.path() + "/database.sdf");
+        QVERIFY(otherDatabaseConnection.getConnection().connectionName() != connectionName);
+        QVERIFY(otherDatabaseConnection.getConnection().tables().contains("SomeTable"));
+    }
+
+    DatabaseConnection::closePooledConnections();
+}
+
+QThread* test_DatabaseConnection::createTable(const QString &tableName)
+{
+    DatabaseConnection databaseConnection;
+    QSqlQuery(databaseConnection.getConnection()).exec(QString("CREATE TABLE %1 (a)").arg(tableName));
+    return QThread::currentThread();
+}
+
+QStringList test_DatabaseConnection::getTables()
+{
+    DatabaseConnection databaseConnection;
+    return databaseConnection.getConnection().tables();
+}
+
 DECLARE_TEST(test_DatabaseConnection)
 
 #include "test_databaseconnection.moc"
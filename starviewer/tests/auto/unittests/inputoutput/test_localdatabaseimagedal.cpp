@@ -0,0 +1,283 @@
+#include "autotest.h"
+#include "localdatabaseimagedal.h"
+
+#include "databaseconnection.h"
+#include "databasetesthelper.h"
+#include "dicommask.h"
+#include "displayshutter.h"
+#include "image.h"
+#include "localdatabasedisplayshutterdal.h"
+#include "localdatabasevoilutdal.h"
+#include "series.h"
+#include "study.h"
+#include "voilut.h"
+
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+
+using namespace udg;
+using namespace testing;
+
+class test_LocalDatabaseImageDAL : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void query_ShouldReturnImagesWithTheirDisplayShuttersAndVoiLuts();
+
+    void query_Benchmark_data();
+    void query_Benchmark();
+
+    void insertList_ShouldInsertAllImages_data();
+    void insertList_ShouldInsertAllImages();
+
+    void insertList_ShouldStopAtBatchWithExistingImage();
+
+    void insert_Benchmark_data();
+    void insert_Benchmark();
+
+private:
+    /// Creates a study with one series with the given number of images, without inserting them.
+    Study* createStudy(int numberOfImages);
+
+    /// Creates a study with one series with the given number of images and inserts them in the given database.
+    /// Every image whose index is a multiple of the given step gets a display shutter and a VOI LUT.
+    Study* insertStudy(DatabaseConnection &databaseConnection, int numberOfImages, int stepBetweenImagesWithShuttersAndVoiLuts);
+};
+
+Study* test_LocalDatabaseImageDAL::createStudy(int numberOfImages)
+{
+    Study *study = new Study();
+    study->setInstanceUID("1.2.3");
+    Series *series = new Series();
+    series->setInstanceUID("1.2.3.4");
+    study->addSeries(series);
+
+    for (int i = 0; i < numberOfImages; i++)
+    {
+        Image *image = new Image();
+        image->setSOPInstanceUID(QString("1.2.3.4.%1").arg(i));
+        image->setFrameNumber(0);
+        image->setOrderNumberInVolume(i);
+        series->addImage(image);
+    }
+
+    return study;
+}
+
+Study* test_LocalDatabaseImageDAL::insertStudy(DatabaseConnection &databaseConnection, int numberOfImages, int stepBetweenImagesWithShuttersAndVoiLuts)
+{
+    Study *study = createStudy(numberOfImages);
+
+    LocalDatabaseImageDAL imageDAL(databaseConnection);
+    LocalDatabaseDisplayShutterDAL shutterDAL(databaseConnection);
+    LocalDatabaseVoiLutDAL voiLutDAL(databaseConnection);
+
+    databaseConnection.beginTransaction();
+
+    for (int i = 0; i < numberOfImages; i++)
+    {
+        Image *image = study->getSeries().first()->getImages().at(i);
+        imageDAL.insert(image);
+
+        if (i % stepBetweenImagesWithShuttersAndVoiLuts == 0)
+        {
+            DisplayShutter shutter;
+            shutter.setShape(DisplayShutter::RectangularShape);
+            shutter.setPoints(QPoint(i, i), QPoint(i + 10, i + 10));
+            shutterDAL.insert(shutter, image);
+
+            TransferFunction lut;
+            lut.set(i, Qt::black, 1.0);
+            lut.set(i + 100, Qt::white, 1.0);
+            voiLutDAL.insert(VoiLut(lut), image);
+        }
+    }
+
+    databaseConnection.commitTransaction();
+
+    return study;
+}
+
+void test_LocalDatabaseImageDAL::query_ShouldReturnImagesWithTheirDisplayShuttersAndVoiLuts()
+{
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    QScopedPointer<Study> study(insertStudy(*databaseConnection, 10, 3));
+
+    DicomMask mask;
+    mask.setSeriesInstanceUID("1.2.3.4");
+    QList<Image*> images = LocalDatabaseImageDAL(*databaseConnection).query(mask);
+
+    QCOMPARE(images.size(), 10);
+
+    for (int i = 0; i < images.size(); i++)
+    {
+        Image *image = images.at(i);
+        QCOMPARE(image->getSOPInstanceUID(), QString("1.2.3.4.%1").arg(i));
+
+        if (i % 3 == 0)
+        {
+            QCOMPARE(image->getDisplayShutters().size(), 1);
+            DisplayShutter expectedShutter;
+            expectedShutter.setPoints(QPoint(i, i), QPoint(i + 10, i + 10));
+            QCOMPARE(image->getDisplayShutters().first().getPointsAsString(), expectedShutter.getPointsAsString());
+            QCOMPARE(image->getNumberOfVoiLuts(), 1);
+            QVERIFY(image->getVoiLut().isLut());
+            QCOMPARE(image->getVoiLut().getLut().keys().first(), static_cast<double>(i));
+        }
+        else
+        {
+            QVERIFY(image->getDisplayShutters().isEmpty());
+            QCOMPARE(image->getNumberOfVoiLuts(), 0);
+        }
+    }
+
+    qDeleteAll(images);
+}
+
+void test_LocalDatabaseImageDAL::query_Benchmark_data()
+{
+    QTest::addColumn<int>("numberOfImages");
+
+    QTest::newRow("1k images") << 1000;
+    QTest::newRow("5k images") << 5000;
+    QTest::newRow("20k images") << 20000;
+}
+
+void test_LocalDatabaseImageDAL::query_Benchmark()
+{
+    QFETCH(int, numberOfImages);
+
+    // Inserting and querying this many images takes too long for the default run, the 1k images row is enough to detect regressions
+    if (numberOfImages > 1000 && !QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Querying more than 1k images only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    QScopedPointer<Study> study(insertStudy(*databaseConnection, numberOfImages, 10));
+
+    DicomMask mask;
+    mask.setStudyInstanceUID("1.2.3");
+    mask.setSeriesInstanceUID("1.2.3.4");
+
+    QBENCHMARK
+    {
+        QList<Image*> images = LocalDatabaseImageDAL(*databaseConnection).query(mask);
+        QCOMPARE(images.size(), numberOfImages);
+        qDeleteAll(images);
+    }
+}
+
+void test_LocalDatabaseImageDAL::insertList_ShouldInsertAllImages_data()
+{
+    QTest::addColumn<int>("numberOfImages");
+
+    QTest::newRow("empty list") << 0;
+    QTest::newRow("one image") << 1;
+    QTest::newRow("less than one batch") << 10;
+    QTest::newRow("several batches and a partial one") << 123;
+}
+
+void test_LocalDatabaseImageDAL::insertList_ShouldInsertAllImages()
+{
+    QFETCH(int, numberOfImages);
+
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    QScopedPointer<Study> study(createStudy(numberOfImages));
+    QList<Image*> imagesToInsert = study->getSeries().first()->getImages();
+
+    LocalDatabaseImageDAL imageDAL(*databaseConnection);
+    QCOMPARE(imageDAL.insert(imagesToInsert), numberOfImages);
+
+    DicomMask mask;
+    mask.setSeriesInstanceUID("1.2.3.4");
+    QCOMPARE(imageDAL.count(mask), numberOfImages);
+
+    QList<Image*> images = imageDAL.query(mask);
+
+    for (int i = 0; i < images.size(); i++)
+    {
+        QCOMPARE(images.at(i)->getSOPInstanceUID(), imagesToInsert.at(i)->getSOPInstanceUID());
+        QCOMPARE(images.at(i)->getOrderNumberInVolume(), i);
+    }
+
+    qDeleteAll(images);
+}
+
+void test_LocalDatabaseImageDAL::insertList_ShouldStopAtBatchWithExistingImage()
+{
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    QScopedPointer<Study> study(createStudy(100));
+    QList<Image*> imagesToInsert = study->getSeries().first()->getImages();
+
+    LocalDatabaseImageDAL imageDAL(*databaseConnection);
+    QVERIFY(imageDAL.insert(imagesToInsert.last()));
+
+    int numberOfInsertedImages = imageDAL.insert(imagesToInsert);
+
+    QVERIFY(numberOfInsertedImages < imagesToInsert.size());
+    QCOMPARE(imageDAL.getLastError().nativeErrorCode().toInt(), static_cast<int>(DatabaseConnection::SqliteConstraint));
+
+    DicomMask mask;
+    mask.setSeriesInstanceUID("1.2.3.4");
+    QCOMPARE(imageDAL.count(mask), numberOfInsertedImages + 1);
+}
+
+void test_LocalDatabaseImageDAL::insert_Benchmark_data()
+{
+    QTest::addColumn<int>("numberOfImages");
+    QTest::addColumn<bool>("bulkInsert");
+
+    QTest::newRow("1k images one by one") << 1000 << false;
+    QTest::newRow("1k images in batches") << 1000 << true;
+    QTest::newRow("10k images one by one") << 10000 << false;
+    QTest::newRow("10k images in batches") << 10000 << true;
+}
+
+void test_LocalDatabaseImageDAL::insert_Benchmark()
+{
+    QFETCH(int, numberOfImages);
+    QFETCH(bool, bulkInsert);
+
+    // Inserting this many images takes too long for the default run
+    if (numberOfImages > 1000 && !QProcessEnvironment::systemEnvironment().contains("STARVIEWER_LARGE_BENCHMARKS"))
+    {
+        QSKIP("Inserting more than 1k images only runs when STARVIEWER_LARGE_BENCHMARKS is defined");
+    }
+
+    QScopedPointer<Study> study(createStudy(numberOfImages));
+    QList<Image*> images = study->getSeries().first()->getImages();
+
+    // The database is created outside of the measured time, so only the inserts and the commit are measured
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    LocalDatabaseImageDAL imageDAL(*databaseConnection);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    databaseConnection->beginTransaction();
+
+    if (bulkInsert)
+    {
+        QCOMPARE(imageDAL.insert(images), numberOfImages);
+    }
+    else
+    {
+        foreach (const Image *image, images)
+        {
+            QVERIFY(imageDAL.insert(image));
+        }
+    }
+
+    databaseConnection->commitTransaction();
+
+    qint64 elapsedNanoseconds = qMax(timer.nsecsElapsed(), static_cast<qint64>(1));
+
+    // Inserted rows per second. QtTest has no metric for rows, so they are reported as frames per second
+    QTest::setBenchmarkResult(numberOfImages * 1e9 / elapsedNanoseconds, QTest::FramesPerSecond);
+}
+
+DECLARE_TEST(test_LocalDatabaseImageDAL)
+
+#include "test_localdatabaseimagedal.moc"
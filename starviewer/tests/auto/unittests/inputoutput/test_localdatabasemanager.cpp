@@ -0,0 +1,217 @@
+#include "autotest.h"
+#include "localdatabasemanager.h"
+
+#include "coresettings.h"
+#include "databaseconnection.h"
+#include "databaseinstallation.h"
+#include "decodedvolumecache.h"
+#include "inputoutputsettings.h"
+#include "patient.h"
+#include "patienttesthelper.h"
+#include "settings.h"
+#include "volumepixeldata.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <cstring>
+
+using namespace udg;
+using namespace testing;
+
+class test_LocalDatabaseManager : public QObject {
+Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void save_ShouldNotKeepPartialRowsWhenItFailsAndLetTheNextSaveCommit();
+
+    void deleteSeries_ShouldRemoveCachedVolumeThatIsLoaded();
+
+private:
+    /// Executes the given SQL in the test database through a connection of its own, outside of the connection pool. Returns true if it succeeds.
+    bool execute(const QString &sql);
+    /// Returns the number of rows of the given table of the test database, read through a connection of its own, outside of the connection pool,
+    /// so that only committed rows are counted. Returns -1 in case of error.
+    int countRows(const QString &table);
+    /// Writes the given number of files in the given directory and returns their paths.
+    static QStringList createFiles(const QString &directory, int numberOfFiles);
+
+private:
+    QTemporaryDir *m_directory;
+    QString m_databasePath;
+    QVariant m_previousDatabasePath;
+    QVariant m_previousCachePath;
+    QVariant m_previousEnableDecodedVolumeCache;
+};
+
+void test_LocalDatabaseManager::init()
+{
+    m_directory = new QTemporaryDir();
+    m_databasePath = QDir::toNativeSeparators(m_directory->path() + "/database.sdf");
+
+    Settings settings;
+    m_previousDatabasePath = settings.getValue(InputOutputSettings::DatabaseAbsoluteFilePath);
+    m_previousCachePath = settings.getValue(InputOutputSettings::CachePath);
+    settings.setValue(InputOutputSettings::DatabaseAbsoluteFilePath, m_databasePath);
+    settings.setValue(InputOutputSettings::CachePath, m_directory->path() + "/");
+    m_previousEnableDecodedVolumeCache = settings.getValue(CoreSettings::EnableDecodedVolumeCache);
+    settings.setValue(CoreSettings::EnableDecodedVolumeCache, true);
+    DecodedVolumeCache::setCacheableDirectory(LocalDatabaseManager::getCachePath());
+
+    DatabaseConnection databaseConnection;
+    DatabaseInstallation().createDatabase(databaseConnection);
+}
+
+void test_LocalDatabaseManager::cleanup()
+{
+    DatabaseConnection::closePooledConnections();
+
+    Settings settings;
+    settings.setValue(InputOutputSettings::DatabaseAbsoluteFilePath, m_previousDatabasePath);
+    settings.setValue(InputOutputSettings::CachePath, m_previousCachePath);
+    settings.setValue(CoreSettings::EnableDecodedVolumeCache, m_previousEnableDecodedVolumeCache);
+    DecodedVolumeCache::setCacheableDirectory(QString());
+
+    delete m_directory;
+}
+
+void test_LocalDatabaseManager::save_ShouldNotKeepPartialRowsWhenItFailsAndLetTheNextSaveCommit()
+{
+    // Images, series and patient are saved before the study, so the missing Study table makes the save fail after inserting them
+    QVERIFY(execute("ALTER TABLE Study RENAME TO HiddenStudy"));
+
+    LocalDatabaseManager localDatabaseManager;
+    QScopedPointer<Patient> failedPatient(PatientTestHelper::create(1, 1, 2));
+    localDatabaseManager.save(failedPatient.data());
+    QVERIFY(localDatabaseManager.getLastError() != LocalDatabaseManager::Ok);
+
+    // It must not keep the database locked
+    QVERIFY(execute("ALTER TABLE HiddenStudy RENAME TO Study"));
+    QCOMPARE(countRows("Patient"), 0);
+    QCOMPARE(countRows("Series"), 0);
+    QCOMPARE(countRows("Image"), 0);
+
+    QScopedPointer<Patient> patient(PatientTestHelper::create(1, 1, 2));
+    localDatabaseManager.save(patient.data());
+    QCOMPARE(localDatabaseManager.getLastError(), LocalDatabaseManager::Ok);
+
+    // Committed without any row of the failed save
+    QCOMPARE(countRows("Patient"), 1);
+    QCOMPARE(countRows("Study"), 1);
+    QCOMPARE(countRows("Series"), 1);
+    QCOMPARE(countRows("Image"), 2);
+}
+
+void test_LocalDatabaseManager::deleteSeries_ShouldRemoveCachedVolumeThatIsLoaded()
+{
+    // Study "0" with series "0" and "1", so that deleting a series doesn't delete the whole study
+    LocalDatabaseManager localDatabaseManager;
+    QScopedPointer<Patient> patient(PatientTestHelper::create(1, 2, 1));
+    localDatabaseManager.save(patient.data());
+    QCOMPARE(localDatabaseManager.getLastError(), LocalDatabaseManager::Ok);
+
+    QString seriesDirectory = LocalDatabaseManager::getStudyPath("0") + "/0";
+    QVERIFY(QDir().mkpath(seriesDirectory));
+    QStringList files = createFiles(seriesDirectory, 2);
+
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetExtent(0, 7, 0, 7, 0, 1);
+    imageData->AllocateScalars(VTK_SHORT, 1);
+    short *scalars = static_cast<short*>(imageData->GetScalarPointer());
+    for (vtkIdType i = 0; i < imageData->GetNumberOfPoints(); i++)
+    {
+        scalars[i] = static_cast<short>(i);
+    }
+
+    DecodedVolumeCache cache("0", files, QList<int>());
+    QVERIFY(cache.store(imageData));
+    QScopedPointer<VolumePixelData> pixelData(cache.load());
+    QVERIFY(pixelData);
+    QVERIFY(pixelData->isMemoryMapped());
+
+    // As a volume of the series being read while it is deleted
+    DecodedVolumeCache cacheBeingRead("0", files, QList<int>());
+
+    localDatabaseManager.deleteSeries("0", "0");
+    QCOMPARE(localDatabaseManager.getLastError(), LocalDatabaseManager::Ok);
+
+    // The mapped blob doesn't prevent deleting the directory, and the loaded volume keeps its data
+    QVERIFY(!QFile::exists(cache.getCacheFilePath()));
+    QVERIFY(!QDir(seriesDirectory).exists());
+    QVERIFY(!pixelData->isMemoryMapped());
+    QVERIFY(std::memcmp(pixelData->getScalarPointer(), imageData->GetScalarPointer(), imageData->GetNumberOfPoints() * imageData->GetScalarSize()) == 0);
+
+    // The volume read before the deletion is not stored in a recreated directory
+    QVERIFY(QDir().mkpath(seriesDirectory));
+    files = createFiles(seriesDirectory, 2);
+    QVERIFY(!cacheBeingRead.store(imageData));
+    QVERIFY(!QFile::exists(cacheBeingRead.getCacheFilePath()));
+}
+
+bool test_LocalDatabaseManager::execute(const QString &sql)
+{
+    bool ok;
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "test_LocalDatabaseManager");
+        database.setDatabaseName(m_databasePath);
+        ok = database.open() && QSqlQuery(database).exec(sql);
+    }
+
+    QSqlDatabase::removeDatabase("test_LocalDatabaseManager");
+    return ok;
+}
+
+int test_LocalDatabaseManager::countRows(const QString &table)
+{
+    int count = -1;
+
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "test_LocalDatabaseManager");
+        database.setDatabaseName(m_databasePath);
+
+        if (database.open())
+        {
+            QSqlQuery query(database);
+
+            if (query.exec("SELECT COUNT(*) FROM " + table) && query.next())
+            {
+                count = query.value(0).toInt();
+            }
+        }
+    }
+
+    QSqlDatabase::removeDatabase("test_LocalDatabaseManager");
+    return count;
+}
+
+QStringList test_LocalDatabaseManager::createFiles(const QString &directory, int numberOfFiles)
+{
+    QStringList files;
+
+    for (int i = 0; i < numberOfFiles; i++)
+    {
+        QFile file(QDir(directory).filePath(QString("%1.dcm").arg(i)));
+
+        if (file.open(QIODevice::WriteOnly))
+        {
+            file.write(QByteArray(100 + i, 'x'));
+            files << file.fileName();
+        }
+    }
+
+    return files;
+}
+
+DECLARE_TEST(test_LocalDatabaseManager)
+
+#include "test_localdatabasemanager.moc"
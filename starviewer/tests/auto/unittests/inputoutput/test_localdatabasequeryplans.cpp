@@ -0,0 +1,248 @@
+#include "autotest.h"
+
+#include "databaseconnection.h"
+#include "databasetesthelper.h"
+#include "dicommask.h"
+#include "localdatabasedisplayshutterdal.h"
+#include "localdatabaseencapsulateddocumentdal.h"
+#include "localdatabaseimagedal.h"
+#include "localdatabasepacsretrievedimagesdal.h"
+#include "localdatabasepatientdal.h"
+#include "localdatabaseseriesdal.h"
+#include "localdatabasestudydal.h"
+#include "localdatabasevoilutdal.h"
+
+#include <QRegularExpression>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+using namespace udg;
+using namespace testing;
+
+/**
+ * Checks with EXPLAIN QUERY PLAN that the queries done by the local database DALs use the indexes of the schema instead of scanning whole tables or
+ * sorting their results. The SQL is the one prepared by the DALs themselves.
+ */
+class test_LocalDatabaseQueryPlans : public QObject {
+
+    Q_OBJECT
+
+public:
+    /// Queries done by the DALs that are checked.
+    enum DALQuery { PatientStudyByStudyInstanceUID, PatientStudyByStudyDate, PatientStudyByLastAccessDate, PatientStudyPage, PatientStudyPageByLastAccessDate,
+                    StudiesAccessedBefore, StudiesOrderedByLastAccessDate, PatientIDOfStudy, PatientsByDICOMPatientID, SeriesOfStudy, ImagesOfSeries,
+                    ImagesOfSeriesWithoutStudy, CountOfImagesOfStudy, DisplayShuttersOfImage, DisplayShuttersOfSeries, VoiLutsOfImage, VoiLutsOfSeries,
+                    VoiLutsOfStudy, EncapsulatedDocumentsOfSeries, PACSByAETitleAddressAndPort };
+
+private slots:
+    void query_ShouldNotScanNorSortWholeTables_data();
+    void query_ShouldNotScanNorSortWholeTables();
+
+private:
+    /// Executes the given query with the DAL that does it.
+    static void executeDALQuery(DALQuery dalQuery, DatabaseConnection &databaseConnection);
+
+    /// Returns the details of the query plan of the given SQL. All its placeholders are bound to the same value, since it doesn't change the plan.
+    static QStringList getQueryPlan(DatabaseConnection &databaseConnection, const QString &sql);
+};
+
+Q_DECLARE_METATYPE(test_LocalDatabaseQueryPlans::DALQuery)
+
+void test_LocalDatabaseQueryPlans::query_ShouldNotScanNorSortWholeTables_data()
+{
+    QTest::addColumn<DALQuery>("dalQuery");
+    QTest::addColumn<QStringList>("forbiddenSteps");
+
+    QStringList scanOrSort;
+    scanOrSort << "SCAN" << "TEMP B-TREE";
+
+    QTest::newRow("studies and patients by study UID") << PatientStudyByStudyInstanceUID << scanOrSort;
+    QTest::newRow("studies and patients by study date") << PatientStudyByStudyDate << scanOrSort;
+    QTest::newRow("studies and patients by last access date") << PatientStudyByLastAccessDate << scanOrSort;
+    QTest::newRow("page of studies and patients") << PatientStudyPage << scanOrSort;
+    QTest::newRow("page of studies and patients by last access date") << PatientStudyPageByLastAccessDate << scanOrSort;
+    QTest::newRow("studies accessed before") << StudiesAccessedBefore << scanOrSort;
+    // Listing all the studies necessarily reads the whole table, but in the order of the index
+    QTest::newRow("studies ordered by last access date") << StudiesOrderedByLastAccessDate << (QStringList() << "TEMP B-TREE");
+    QTest::newRow("patient id of study") << PatientIDOfStudy << scanOrSort;
+    QTest::newRow("patients by DICOM patient id") << PatientsByDICOMPatientID << scanOrSort;
+    QTest::newRow("series of study") << SeriesOfStudy << scanOrSort;
+    QTest::newRow("images of series") << ImagesOfSeries << scanOrSort;
+    QTest::newRow("images of series without study") << ImagesOfSeriesWithoutStudy << scanOrSort;
+    QTest::newRow("count of images of study") << CountOfImagesOfStudy << scanOrSort;
+    QTest::newRow("display shutters of image") << DisplayShuttersOfImage << scanOrSort;
+    QTest::newRow("display shutters of series") << DisplayShuttersOfSeries << scanOrSort;
+    QTest::newRow("VOI LUTs of image") << VoiLutsOfImage << scanOrSort;
+    QTest::newRow("VOI LUTs of series") << VoiLutsOfSeries << scanOrSort;
+    QTest::newRow("VOI LUTs of study") << VoiLutsOfStudy << scanOrSort;
+    QTest::newRow("encapsulated documents of series") << EncapsulatedDocumentsOfSeries << scanOrSort;
+    QTest::newRow("PACS by AE title, address and port") << PACSByAETitleAddressAndPort << scanOrSort;
+}
+
+void test_LocalDatabaseQueryPlans::query_ShouldNotScanNorSortWholeTables()
+{
+    QFETCH(DALQuery, dalQuery);
+    QFETCH(QStringList, forbiddenSteps);
+
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    QSet<QString> previousSql = databaseConnection->getPreparedQueriesSql().toSet();
+
+    executeDALQuery(dalQuery, *databaseConnection);
+
+    QSet<QString> dalSql = databaseConnection->getPreparedQueriesSql().toSet() - previousSql;
+    QVERIFY(!dalSql.isEmpty());
+
+    foreach (const QString &sql, dalSql)
+    {
+        QStringList queryPlan = getQueryPlan(*databaseConnection, sql);
+        QVERIFY2(!queryPlan.isEmpty(), qPrintable(QString("%1: %2").arg(sql).arg(databaseConnection->getLastErrorMessage())));
+
+        foreach (const QString &step, queryPlan)
+        {
+            foreach (const QString &forbiddenStep, forbiddenSteps)
+            {
+                QVERIFY2(!step.contains(forbiddenStep), qPrintable(QString("%1 in the query plan of %2: %3").arg(forbiddenStep).arg(sql)
+                                                                                                            .arg(queryPlan.join("; "))));
+            }
+        }
+    }
+}
+
+void test_LocalDatabaseQueryPlans::executeDALQuery(DALQuery dalQuery, DatabaseConnection &databaseConnection)
+{
+    DicomMask mask;
+    LocalDatabaseStudyDAL::PatientStudyCursor cursor;
+
+    switch (dalQuery)
+    {
+        case PatientStudyByStudyInstanceUID:
+            mask.setStudyInstanceUID("1.2.3");
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryPatientStudy(mask));
+            break;
+
+        case PatientStudyByStudyDate:
+            mask.setStudyDate(QDate(2015, 1, 1), QDate(2015, 12, 31));
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryPatientStudy(mask));
+            break;
+
+        case PatientStudyByLastAccessDate:
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryPatientStudy(mask, QDate(), QDate(2015, 1, 1)));
+            break;
+
+        case PatientStudyPage:
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryPatientStudyPage(mask, cursor, 200));
+            break;
+
+        case PatientStudyPageByLastAccessDate:
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryPatientStudyPage(mask, cursor, 200, QDate(), QDate(2015, 1, 1)));
+            break;
+
+        case StudiesAccessedBefore:
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryOrderByLastAccessDate(mask, QDate(2015, 1, 1)));
+            break;
+
+        case StudiesOrderedByLastAccessDate:
+            qDeleteAll(LocalDatabaseStudyDAL(databaseConnection).queryOrderByLastAccessDate(mask));
+            break;
+
+        case PatientIDOfStudy:
+            LocalDatabaseStudyDAL(databaseConnection).getPatientIDFromStudyInstanceUID("1.2.3");
+            break;
+
+        case PatientsByDICOMPatientID:
+            mask.setPatientID("123");
+            qDeleteAll(LocalDatabasePatientDAL(databaseConnection).query(mask));
+            break;
+
+        case SeriesOfStudy:
+            mask.setStudyInstanceUID("1.2.3");
+            qDeleteAll(LocalDatabaseSeriesDAL(databaseConnection).query(mask));
+            break;
+
+        case ImagesOfSeries:
+            mask.setStudyInstanceUID("1.2.3");
+            mask.setSeriesInstanceUID("1.2.3.4");
+            qDeleteAll(LocalDatabaseImageDAL(databaseConnection).query(mask));
+            break;
+
+        case ImagesOfSeriesWithoutStudy:
+            mask.setSeriesInstanceUID("1.2.3.4");
+            qDeleteAll(LocalDatabaseImageDAL(databaseConnection).query(mask));
+            break;
+
+        case CountOfImagesOfStudy:
+            mask.setStudyInstanceUID("1.2.3");
+            LocalDatabaseImageDAL(databaseConnection).count(mask);
+            break;
+
+        case DisplayShuttersOfImage:
+            mask.setSOPInstanceUID("1.2.3.4.5");
+            mask.setImageNumber("0");
+            LocalDatabaseDisplayShutterDAL(databaseConnection).query(mask);
+            break;
+
+        case DisplayShuttersOfSeries:
+            mask.setSeriesInstanceUID("1.2.3.4");
+            LocalDatabaseDisplayShutterDAL(databaseConnection).queryGroupedByImage(mask);
+            break;
+
+        case VoiLutsOfImage:
+            mask.setSOPInstanceUID("1.2.3.4.5");
+            mask.setImageNumber("0");
+            LocalDatabaseVoiLutDAL(databaseConnection).query(mask);
+            break;
+
+        case VoiLutsOfSeries:
+            mask.setSeriesInstanceUID("1.2.3.4");
+            LocalDatabaseVoiLutDAL(databaseConnection).queryGroupedByImage(mask);
+            break;
+
+        case VoiLutsOfStudy:
+            mask.setStudyInstanceUID("1.2.3");
+            LocalDatabaseVoiLutDAL(databaseConnection).queryGroupedByImage(mask);
+            break;
+
+        case EncapsulatedDocumentsOfSeries:
+            mask.setStudyInstanceUID("1.2.3");
+            mask.setSeriesInstanceUID("1.2.3.4");
+            qDeleteAll(LocalDatabaseEncapsulatedDocumentDAL(databaseConnection).query(mask));
+            break;
+
+        case PACSByAETitleAddressAndPort:
+            LocalDatabasePACSRetrievedImagesDAL(databaseConnection).query("PACS", "localhost", 104);
+            break;
+    }
+}
+
+QStringList test_LocalDatabaseQueryPlans::getQueryPlan(DatabaseConnection &databaseConnection, const QString &sql)
+{
+    QSqlQuery query(databaseConnection.getConnection());
+    QStringList details;
+
+    if (!query.prepare("EXPLAIN QUERY PLAN " + sql))
+    {
+        return details;
+    }
+
+    QRegularExpressionMatchIterator placeholders = QRegularExpression(":\\w+").globalMatch(sql);
+    while (placeholders.hasNext())
+    {
+        query.bindValue(placeholders.next().captured(), "1");
+    }
+
+    if (query.exec())
+    {
+        while (query.next())
+        {
+            // The detail is the last column in all SQLite versions
+            details << query.value(query.record().count() - 1).toString();
+        }
+    }
+
+    return details;
+}
+
+DECLARE_TEST(test_LocalDatabaseQueryPlans)
+
+#include "test_localdatabasequeryplans.moc"
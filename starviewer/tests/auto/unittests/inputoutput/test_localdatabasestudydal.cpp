@@ -0,0 +1,196 @@
+#include "autotest.h"
+#include "localdatabasestudydal.h"
+
+#include "databaseconnection.h"
+#include "databasetesthelper.h"
+#include "dicommask.h"
+#include "localdatabasepatientdal.h"
+#include "patient.h"
+#include "study.h"
+
+using namespace udg;
+using namespace testing;
+
+class test_LocalDatabaseStudyDAL : public QObject {
+
+    Q_OBJECT
+
+private slots:
+    void queryPatientStudyPage_ShouldReturnAllStudiesOnceInOrder_data();
+    void queryPatientStudyPage_ShouldReturnAllStudiesOnceInOrder();
+
+    void queryPatientStudyPage_ShouldApplyMask();
+
+    void queryPatientStudyPage_ShouldNotRepeatNorSkipStudiesWhenDatabaseChanges();
+
+private:
+    /// Inserts in the given database the given number of patients, some of them without name, each one with the given number of studies.
+    void insertPatientsAndStudies(DatabaseConnection &databaseConnection, int numberOfPatients, int studiesPerPatient);
+
+    /// Inserts in the given database a new patient with a study with the given UID.
+    void insertStudy(DatabaseConnection &databaseConnection, const QString &studyInstanceUID);
+
+    /// Returns the study instance UIDs of the given patients and deletes them.
+    QStringList takeStudyInstanceUIDs(QList<Patient*> patients);
+};
+
+void test_LocalDatabaseStudyDAL::insertPatientsAndStudies(DatabaseConnection &databaseConnection, int numberOfPatients, int studiesPerPatient)
+{
+    LocalDatabasePatientDAL patientDAL(databaseConnection);
+    LocalDatabaseStudyDAL studyDAL(databaseConnection);
+
+    for (int i = 0; i < numberOfPatients; i++)
+    {
+        Patient patient;
+        patient.setID(QString::number(i));
+        // Every third patient has no name, to check that the join doesn't depend on it
+        if (i % 3 != 0)
+        {
+            patient.setFullName(QString("Patient^%1").arg(numberOfPatients - i, 4, 10, QChar('0')));
+        }
+        QVERIFY(patientDAL.insert(&patient));
+
+        for (int j = 0; j < studiesPerPatient; j++)
+        {
+            Study *study = new Study();
+            study->setInstanceUID(QString("1.2.%1.%2").arg(j).arg(i));
+            study->setID(QString::number(j));
+            study->addModality(j % 2 == 0 ? "CT" : "MR");
+            patient.addStudy(study);
+            QVERIFY(studyDAL.insert(study, QDate::currentDate()));
+        }
+    }
+}
+
+void test_LocalDatabaseStudyDAL::insertStudy(DatabaseConnection &databaseConnection, const QString &studyInstanceUID)
+{
+    Patient patient;
+    patient.setID(studyInstanceUID);
+    patient.setFullName("Inserted^Patient");
+    QVERIFY(LocalDatabasePatientDAL(databaseConnection).insert(&patient));
+
+    Study *study = new Study();
+    study->setInstanceUID(studyInstanceUID);
+    study->setID("1");
+    patient.addStudy(study);
+    QVERIFY(LocalDatabaseStudyDAL(databaseConnection).insert(study, QDate::currentDate()));
+}
+
+QStringList test_LocalDatabaseStudyDAL::takeStudyInstanceUIDs(QList<Patient*> patients)
+{
+    QStringList studyInstanceUIDs;
+
+    foreach (Patient *patient, patients)
+    {
+        foreach (Study *study, patient->getStudies())
+        {
+            studyInstanceUIDs << study->getInstanceUID();
+        }
+    }
+
+    qDeleteAll(patients);
+    return studyInstanceUIDs;
+}
+
+void test_LocalDatabaseStudyDAL::queryPatientStudyPage_ShouldReturnAllStudiesOnceInOrder_data()
+{
+    QTest::addColumn<int>("numberOfPatients");
+    QTest::addColumn<int>("pageSize");
+
+    QTest::newRow("empty database") << 0 << 10;
+    QTest::newRow("less than one page") << 3 << 10;
+    QTest::newRow("exactly one page") << 5 << 10;
+    QTest::newRow("several pages and a partial one") << 37 << 10;
+    QTest::newRow("pages of one study") << 7 << 1;
+}
+
+void test_LocalDatabaseStudyDAL::queryPatientStudyPage_ShouldReturnAllStudiesOnceInOrder()
+{
+    QFETCH(int, numberOfPatients);
+    QFETCH(int, pageSize);
+
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    insertPatientsAndStudies(*databaseConnection, numberOfPatients, 2);
+
+    LocalDatabaseStudyDAL studyDAL(*databaseConnection);
+    QStringList expectedStudyInstanceUIDs = takeStudyInstanceUIDs(studyDAL.queryPatientStudy(DicomMask()));
+    QCOMPARE(expectedStudyInstanceUIDs.size(), numberOfPatients * 2);
+    expectedStudyInstanceUIDs.sort();
+
+    QStringList studyInstanceUIDs;
+    LocalDatabaseStudyDAL::PatientStudyCursor cursor;
+    int numberOfPages = 0;
+
+    while (!cursor.atEnd)
+    {
+        QList<Patient*> page = studyDAL.queryPatientStudyPage(DicomMask(), cursor, pageSize);
+        QVERIFY(page.size() <= pageSize);
+        QVERIFY(!studyDAL.getLastError().isValid());
+        studyInstanceUIDs << takeStudyInstanceUIDs(page);
+        QVERIFY(++numberOfPages <= expectedStudyInstanceUIDs.size() / pageSize + 1);
+    }
+
+    QCOMPARE(studyInstanceUIDs, expectedStudyInstanceUIDs);
+    QCOMPARE(studyDAL.queryPatientStudyPage(DicomMask(), cursor, pageSize).size(), 0);
+}
+
+void test_LocalDatabaseStudyDAL::queryPatientStudyPage_ShouldApplyMask()
+{
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    insertPatientsAndStudies(*databaseConnection, 20, 2);
+
+    DicomMask mask;
+    mask.setSeriesModality("MR");
+
+    LocalDatabaseStudyDAL studyDAL(*databaseConnection);
+    QStringList expectedStudyInstanceUIDs = takeStudyInstanceUIDs(studyDAL.queryPatientStudy(mask));
+    QCOMPARE(expectedStudyInstanceUIDs.size(), 20);
+    expectedStudyInstanceUIDs.sort();
+
+    QStringList studyInstanceUIDs;
+    LocalDatabaseStudyDAL::PatientStudyCursor cursor;
+
+    while (!cursor.atEnd)
+    {
+        studyInstanceUIDs << takeStudyInstanceUIDs(studyDAL.queryPatientStudyPage(mask, cursor, 6));
+    }
+
+    QCOMPARE(studyInstanceUIDs, expectedStudyInstanceUIDs);
+}
+
+void test_LocalDatabaseStudyDAL::queryPatientStudyPage_ShouldNotRepeatNorSkipStudiesWhenDatabaseChanges()
+{
+    QScopedPointer<DatabaseConnection> databaseConnection(DatabaseTestHelper::getCreatedDatabase());
+    insertPatientsAndStudies(*databaseConnection, 10, 2);
+
+    LocalDatabaseStudyDAL studyDAL(*databaseConnection);
+    QStringList expectedStudyInstanceUIDs = takeStudyInstanceUIDs(studyDAL.queryPatientStudy(DicomMask()));
+    expectedStudyInstanceUIDs.sort();
+
+    LocalDatabaseStudyDAL::PatientStudyCursor cursor;
+    QStringList studyInstanceUIDs = takeStudyInstanceUIDs(studyDAL.queryPatientStudyPage(DicomMask(), cursor, 5));
+    QCOMPARE(studyInstanceUIDs, expectedStudyInstanceUIDs.mid(0, 5));
+
+    // Studies inserted and deleted before and after the cursor
+    insertStudy(*databaseConnection, expectedStudyInstanceUIDs.at(0) + "0");
+    insertStudy(*databaseConnection, "1.2.9.0");
+    DicomMask deletedStudyMask;
+    deletedStudyMask.setStudyInstanceUID(expectedStudyInstanceUIDs.at(1));
+    QVERIFY(studyDAL.del(deletedStudyMask));
+    deletedStudyMask.setStudyInstanceUID(expectedStudyInstanceUIDs.at(15));
+    QVERIFY(studyDAL.del(deletedStudyMask));
+
+    while (!cursor.atEnd)
+    {
+        studyInstanceUIDs << takeStudyInstanceUIDs(studyDAL.queryPatientStudyPage(DicomMask(), cursor, 5));
+    }
+
+    // Only the studies inserted after the cursor are returned, and only the studies deleted before the cursor had been returned
+    expectedStudyInstanceUIDs.removeAt(15);
+    expectedStudyInstanceUIDs << "1.2.9.0";
+    QCOMPARE(studyInstanceUIDs, expectedStudyInstanceUIDs);
+}
+
+DECLARE_TEST(test_LocalDatabaseStudyDAL)
+
+#include "test_localdatabasestudydal.moc"
@@ -0,0 +1,204 @@
+#include "autotest.h"
+#include "retrievedicomfilesfrompacs.h"
+
+#include "dicomtagreader.h"
+#include "pacsdevice.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <dcfilefo.h>
+#include <ofcond.h>
+
+using namespace udg;
+
+class TestingRetrieveDICOMFilesFromPACS : public RetrieveDICOMFilesFromPACS {
+public:
+    /// Files whose save fails
+    QSet<QString> m_filesThatFailToSave;
+    /// If true, each save waits for a release of m_saveAllowed
+    bool m_waitForSaveAllowed;
+    QSemaphore m_saveAllowed;
+    QAtomicInt m_numberOfSavesStarted;
+
+    TestingRetrieveDICOMFilesFromPACS()
+        : RetrieveDICOMFilesFromPACS(PacsDevice()), m_waitForSaveAllowed(false)
+    {
+    }
+
+    using RetrieveDICOMFilesFromPACS::enqueueStore;
+    using RetrieveDICOMFilesFromPACS::waitForPendingStores;
+
+protected:
+    virtual OFCondition save(DcmFileFormat *fileRetrieved, QString dicomFileAbsolutePath)
+    {
+        Q_UNUSED(fileRetrieved);
+
+        m_numberOfSavesStarted.ref();
+
+        if (m_waitForSaveAllowed)
+        {
+            m_saveAllowed.acquire();
+        }
+
+        return OFCondition(0, 0, m_filesThatFailToSave.contains(dicomFileAbsolutePath) ? OF_failure : OF_ok, "");
+    }
+};
+
+Q_DECLARE_METATYPE(PACSRequestStatus::RetrieveRequestStatus)
+
+class test_RetrieveDICOMFilesFromPACS : public QObject {
+Q_OBJECT
+
+private slots:
+    void enqueueStore_ShouldNotifyFilesInOrderFromStoreThread();
+
+    void waitForPendingStores_ShouldReturnExpectedStatus_data();
+    void waitForPendingStores_ShouldReturnExpectedStatus();
+
+    void enqueueStore_ShouldBlockWhenTooManyFilesArePending();
+
+private:
+    /// Connects to the DICOMFileRetrieved signal of the given object and records each notified file, its number and the thread it's notified from
+    void recordNotifications(RetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS);
+
+    /// Enqueues the given number of files named with their index
+    static void enqueueFiles(TestingRetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS, int numberOfFiles, QAtomicInt *numberOfFilesEnqueued = 0);
+
+private:
+    QMutex m_notificationsMutex;
+    QStringList m_notifiedFiles;
+    QList<int> m_notifiedNumbers;
+    QSet<QThread*> m_notificationThreads;
+};
+
+void test_RetrieveDICOMFilesFromPACS::enqueueStore_ShouldNotifyFilesInOrderFromStoreThread()
+{
+    const int NumberOfFiles = 100;
+
+    TestingRetrieveDICOMFilesFromPACS retrieveDICOMFilesFromPACS;
+    recordNotifications(&retrieveDICOMFilesFromPACS);
+
+    enqueueFiles(&retrieveDICOMFilesFromPACS, NumberOfFiles);
+
+    // Once it returns all the files have been notified
+    QCOMPARE(retrieveDICOMFilesFromPACS.waitForPendingStores(PACSRequestStatus::RetrieveOk), PACSRequestStatus::RetrieveOk);
+    QCOMPARE(m_notifiedFiles.size(), NumberOfFiles);
+    QCOMPARE(retrieveDICOMFilesFromPACS.getNumberOfDICOMFilesRetrieved(), NumberOfFiles);
+
+    for (int i = 0; i < NumberOfFiles; i++)
+    {
+        QCOMPARE(m_notifiedFiles.at(i), QString::number(i));
+        QCOMPARE(m_notifiedNumbers.at(i), i + 1);
+    }
+
+    // Receivers connected directly run in the store thread, always the same one
+    QCOMPARE(m_notificationThreads.size(), 1);
+    QVERIFY(!m_notificationThreads.contains(QThread::currentThread()));
+}
+
+void test_RetrieveDICOMFilesFromPACS::waitForPendingStores_ShouldReturnExpectedStatus_data()
+{
+    QTest::addColumn<QStringList>("filesThatFailToSave");
+    QTest::addColumn<PACSRequestStatus::RetrieveRequestStatus>("retrieveRequestStatus");
+    QTest::addColumn<PACSRequestStatus::RetrieveRequestStatus>("expectedRetrieveRequestStatus");
+    QTest::addColumn<QStringList>("expectedNotifiedFiles");
+
+    QStringList allFiles;
+    allFiles << "0" << "1" << "2" << "3" << "4";
+
+    QTest::newRow("all saved") << QStringList() << PACSRequestStatus::RetrieveOk << PACSRequestStatus::RetrieveOk << allFiles;
+    QTest::newRow("one not saved") << (QStringList() << "2") << PACSRequestStatus::RetrieveOk << PACSRequestStatus::RetrieveSomeDICOMFilesFailed
+                                   << (QStringList() << "0" << "1" << "3" << "4");
+    QTest::newRow("none saved") << allFiles << PACSRequestStatus::RetrieveOk << PACSRequestStatus::RetrieveSomeDICOMFilesFailed << QStringList();
+    QTest::newRow("failed retrieve") << (QStringList() << "0") << PACSRequestStatus::RetrieveFailureOrRefused << PACSRequestStatus::RetrieveFailureOrRefused
+                                     << (QStringList() << "1" << "2" << "3" << "4");
+}
+
+void test_RetrieveDICOMFilesFromPACS::waitForPendingStores_ShouldReturnExpectedStatus()
+{
+    QFETCH(QStringList, filesThatFailToSave);
+    QFETCH(PACSRequestStatus::RetrieveRequestStatus, retrieveRequestStatus);
+    QFETCH(PACSRequestStatus::RetrieveRequestStatus, expectedRetrieveRequestStatus);
+    QFETCH(QStringList, expectedNotifiedFiles);
+
+    TestingRetrieveDICOMFilesFromPACS retrieveDICOMFilesFromPACS;
+    retrieveDICOMFilesFromPACS.m_filesThatFailToSave = filesThatFailToSave.toSet();
+    recordNotifications(&retrieveDICOMFilesFromPACS);
+
+    enqueueFiles(&retrieveDICOMFilesFromPACS, 5);
+
+    QCOMPARE(retrieveDICOMFilesFromPACS.waitForPendingStores(retrieveRequestStatus), expectedRetrieveRequestStatus);
+    QCOMPARE(m_notifiedFiles, expectedNotifiedFiles);
+    QCOMPARE(retrieveDICOMFilesFromPACS.getNumberOfDICOMFilesRetrieved(), expectedNotifiedFiles.size());
+}
+
+void test_RetrieveDICOMFilesFromPACS::enqueueStore_ShouldBlockWhenTooManyFilesArePending()
+{
+    // MaximumNumberOfPendingStores in retrievedicomfilesfrompacs.cpp
+    const int MaximumNumberOfPendingStores = 32;
+    const int NumberOfFiles = MaximumNumberOfPendingStores + 8;
+
+    TestingRetrieveDICOMFilesFromPACS retrieveDICOMFilesFromPACS;
+    retrieveDICOMFilesFromPACS.m_waitForSaveAllowed = true;
+    recordNotifications(&retrieveDICOMFilesFromPACS);
+
+    // As the association thread while the disk doesn't save anything
+    QAtomicInt numberOfFilesEnqueued;
+    QFuture<void> association = QtConcurrent::run(&test_RetrieveDICOMFilesFromPACS::enqueueFiles, &retrieveDICOMFilesFromPACS, NumberOfFiles,
+                                                  &numberOfFilesEnqueued);
+
+    QTRY_COMPARE(numberOfFilesEnqueued.load(), MaximumNumberOfPendingStores);
+    QTest::qWait(100);
+    QCOMPARE(numberOfFilesEnqueued.load(), MaximumNumberOfPendingStores);
+    QCOMPARE(retrieveDICOMFilesFromPACS.m_numberOfSavesStarted.load(), 1);
+    QVERIFY(!association.isFinished());
+
+    // Each saved file lets another one be enqueued
+    retrieveDICOMFilesFromPACS.m_saveAllowed.release(NumberOfFiles - MaximumNumberOfPendingStores);
+    association.waitForFinished();
+    QCOMPARE(numberOfFilesEnqueued.load(), NumberOfFiles);
+
+    retrieveDICOMFilesFromPACS.m_saveAllowed.release(MaximumNumberOfPendingStores);
+    QCOMPARE(retrieveDICOMFilesFromPACS.waitForPendingStores(PACSRequestStatus::RetrieveOk), PACSRequestStatus::RetrieveOk);
+    QCOMPARE(m_notifiedFiles.size(), NumberOfFiles);
+}
+
+void test_RetrieveDICOMFilesFromPACS::recordNotifications(RetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS)
+{
+    m_notifiedFiles.clear();
+    m_notifiedNumbers.clear();
+    m_notificationThreads.clear();
+
+    connect(retrieveDICOMFilesFromPACS, &RetrieveDICOMFilesFromPACS::DICOMFileRetrieved, this, [this](DICOMTagReader *dicomTagReader, int numberOfImagesRetrieved)
+    {
+        QMutexLocker locker(&m_notificationsMutex);
+        m_notifiedFiles << dicomTagReader->getFileName();
+        m_notifiedNumbers << numberOfImagesRetrieved;
+        m_notificationThreads << QThread::currentThread();
+        delete dicomTagReader;
+    }, Qt::DirectConnection);
+}
+
+void test_RetrieveDICOMFilesFromPACS::enqueueFiles(TestingRetrieveDICOMFilesFromPACS *retrieveDICOMFilesFromPACS, int numberOfFiles,
+                                                   QAtomicInt *numberOfFilesEnqueued)
+{
+    for (int i = 0; i < numberOfFiles; i++)
+    {
+        retrieveDICOMFilesFromPACS->enqueueStore(new DcmFileFormat(), QString::number(i));
+
+        if (numberOfFilesEnqueued)
+        {
+            numberOfFilesEnqueued->ref();
+        }
+    }
+}
+
+DECLARE_TEST(test_RetrieveDICOMFilesFromPACS)
+
+#include "test_retrievedicomfilesfrompacs.moc"
@@ -4,3 +4,9 @@ include(core/core.pri)
 include(inputoutput/inputoutput.pri)
 include(interface/interface.pri)
 include(q3dviewer/q3dviewer.pri)
+
+# Les extensions playground només s'enllacen quan no es fa una release oficial
+include($$PWD/../../../src/extensions.pri)
+contains(PLAYGROUND_EXTENSIONS, experimental3d) {
+    include(experimental3d/experimental3d.pri)
+}